@@ -0,0 +1,144 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Parse-throughput benchmark of aio::http_request_parser.
+//
+// Usage: http_parser_benchmark [seconds per case]
+//
+// Every case parses a buffer of pipelined requests over and over and reports bytes and requests
+// per second. The "partial" cases feed the same buffer in small reads, each followed by a
+// parse() of the unconsumed data, which is how a connection that reads into a buffer drives it.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <aio/http.hpp>
+
+namespace {
+  using bench_clock = std::chrono::steady_clock;
+
+  constexpr std::string_view minimal_request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+  constexpr std::string_view browser_request =
+      "GET /wp-content/uploads/2010/03/hello-kitty-darth-vader-pink.jpg HTTP/1.1\r\n"
+      "Host: www.kittyhell.com\r\n"
+      "User-Agent: Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10.6; ja-JP-mac; rv:1.9.2.3) Gecko/20100401 Firefox/3.6.3 "
+      "Pathtraq/0.9\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+      "Accept-Language: ja,en-us;q=0.7,en;q=0.3\r\n"
+      "Accept-Encoding: gzip,deflate\r\n"
+      "Accept-Charset: Shift_JIS,utf-8;q=0.7,*;q=0.7\r\n"
+      "Keep-Alive: 115\r\n"
+      "Connection: keep-alive\r\n"
+      "Cookie: wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx; "
+      "__utma=xxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.x; "
+      "__utmz=xxxxxxxxx.xxxxxxxxxx.x.x.utmccn=(referral)|utmcsr=reader.livedoor.com|utmcct=/reader/|utmcmd=referral\r\n"
+      "\r\n";
+
+  constexpr std::string_view post_body = "{\"item\":\"widget\",\"quantity\":3,\"express\":false}\n";
+
+  auto post_request() -> std::string {
+    return "POST /api/v1/orders HTTP/1.1\r\n"
+           "Host: orders.internal\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " +
+           std::to_string(post_body.size()) +
+           "\r\n"
+           "X-Request-Id: 6f1c2a9e-3b7d-4e0a-9c55-1d2e3f405162\r\n"
+           "\r\n" +
+           std::string(post_body);
+  }
+
+  struct outcome {
+    double seconds = 0;
+    std::size_t bytes = 0;
+    std::size_t requests = 0;
+  };
+
+  auto pipelined(std::string_view request, std::size_t count) -> std::string {
+    std::string buffer;
+    buffer.reserve(request.size() * count);
+    for (std::size_t i = 0; i < count; ++i) buffer += request;
+    return buffer;
+  }
+
+  // Parses `buffer` in `read_size` pieces (all of it at once if zero) until `seconds` have passed.
+  auto run(const std::string &buffer, std::size_t read_size, double seconds) -> outcome {
+    aio::http_request_parser parser;
+    outcome result{};
+    const auto start = bench_clock::now();
+    const auto deadline = start + std::chrono::duration<double>(seconds);
+    while (bench_clock::now() < deadline) {
+      for (int round = 0; round < 64; ++round) {
+        std::size_t begin = 0;
+        std::size_t end = read_size == 0 ? buffer.size() : 0;
+        while (begin < buffer.size()) {
+          if (read_size != 0) end = std::min(end + read_size, buffer.size());
+          auto parsed = parser.parse(std::string_view(buffer).substr(begin, end - begin));
+          if (!parsed) {
+            std::fprintf(stderr, "parse error: %s\n", parsed.error().message().c_str());
+            std::exit(1);
+          }
+          if (*parsed == 0 && end == buffer.size()) {
+            std::fprintf(stderr, "incomplete request at offset %zu\n", begin);
+            std::exit(1);
+          }
+          begin += *parsed;
+          result.requests += parser.messages().size();
+        }
+        result.bytes += buffer.size();
+      }
+    }
+    result.seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return result;
+  }
+
+  auto report(const char *name, const outcome &result) -> void {
+    std::printf("%-28s %10.1f MB/s %10.2f Mreq/s %8.1f ns/req\n", name, static_cast<double>(result.bytes) / result.seconds / 1e6,
+                static_cast<double>(result.requests) / result.seconds / 1e6,
+                result.seconds * 1e9 / static_cast<double>(result.requests));
+  }
+}  // namespace
+
+int main(int argc, char **argv) {
+  const auto seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+
+  report("minimal, 1 per read", run(std::string(minimal_request), 0, seconds));
+  report("minimal, 64 pipelined", run(pipelined(minimal_request, 64), 0, seconds));
+  report("browser, 1 per read", run(std::string(browser_request), 0, seconds));
+  report("browser, 16 pipelined", run(pipelined(browser_request, 16), 0, seconds));
+  report("post, 32 pipelined", run(pipelined(post_request(), 32), 0, seconds));
+  report("browser, partial 64 B reads", run(pipelined(browser_request, 16), 64, seconds));
+  report("browser, partial 1 KiB reads", run(pipelined(browser_request, 16), 1024, seconds));
+  return 0;
+}
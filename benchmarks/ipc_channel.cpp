@@ -0,0 +1,180 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Round-trip latency of aio::ipc_channel between two processes.
+//
+// Usage: ipc_channel_benchmark [--round-trips N] [--size BYTES] [--spin MICROSECONDS] [--async]
+//
+// The benchmark forks an echo process joined by a pair of channels and times each message
+// there and back: by default with both processes blocking on the futex, with --async with both
+// sides awaiting through their schedulers. A spin of a few microseconds lets the processes hand
+// messages over without sleeping when each has a core of its own.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <aio/ipc_channel.hpp>
+#include <aio/scheduler.hpp>
+
+namespace {
+  using bench_clock = std::chrono::steady_clock;
+
+  struct options {
+    std::size_t round_trips = 100'000;
+    std::size_t size = 64;
+    std::chrono::microseconds spin{0};
+    bool async = false;
+  };
+
+  auto echo_blocking(aio::ipc_channel &in, aio::ipc_channel &out) -> void {
+    std::vector<std::byte> message(in.max_message_size());
+    while (auto size = in.receive_blocking(message)) {
+      if (!out.send_blocking(std::span(message.data(), *size))) break;
+    }
+  }
+
+  auto echo_async(aio::ipc_channel &in, aio::ipc_channel &out) -> aio::task<void> {
+    std::vector<std::byte> message(in.max_message_size());
+    while (true) {
+      auto size = co_await in.receive(message);
+      if (!size) break;
+      auto sent = co_await out.send(std::span(message.data(), *size));
+      if (!sent) break;
+    }
+  }
+
+  auto ping_blocking(aio::ipc_channel &out, aio::ipc_channel &in, std::span<const std::byte> message, std::vector<double> &samples) -> bool {
+    std::vector<std::byte> reply(in.max_message_size());
+    for (auto &sample : samples) {
+      const auto start = bench_clock::now();
+      if (!out.send_blocking(message) || !in.receive_blocking(reply)) return false;
+      sample = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+    }
+    return true;
+  }
+
+  auto ping_async(aio::ipc_channel &out, aio::ipc_channel &in, std::span<const std::byte> message, std::vector<double> &samples)
+      -> aio::task<bool> {
+    std::vector<std::byte> reply(in.max_message_size());
+    for (auto &sample : samples) {
+      const auto start = bench_clock::now();
+      auto sent = co_await out.send(message);
+      if (!sent) co_return false;
+      auto received = co_await in.receive(reply);
+      if (!received) co_return false;
+      sample = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+    }
+    co_return true;
+  }
+
+  auto parse(int argc, char **argv) -> options {
+    options parsed;
+    for (int i = 1; i < argc; ++i) {
+      const auto has_value = i + 1 < argc;
+      if (std::strcmp(argv[i], "--round-trips") == 0 && has_value) {
+        parsed.round_trips = std::strtoull(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--size") == 0 && has_value) {
+        parsed.size = std::strtoull(argv[++i], nullptr, 10);
+      } else if (std::strcmp(argv[i], "--spin") == 0 && has_value) {
+        parsed.spin = std::chrono::microseconds(std::strtoll(argv[++i], nullptr, 10));
+      } else if (std::strcmp(argv[i], "--async") == 0) {
+        parsed.async = true;
+      } else {
+        std::fprintf(stderr, "usage: %s [--round-trips N] [--size BYTES] [--spin MICROSECONDS] [--async]\n", argv[0]);
+        std::exit(2);
+      }
+    }
+    return parsed;
+  }
+
+  auto create_channel(const options &parsed) -> aio::ipc_channel {
+    auto channel = aio::ipc_channel::create({.slot_size = (parsed.size + 16 + 63) / 64 * 64, .capacity = 64});
+    if (!channel) {
+      std::fprintf(stderr, "ipc_channel: %s\n", channel.error().message().c_str());
+      std::exit(1);
+    }
+    channel->set_spin(parsed.spin);
+    return AIO_MOV(*channel);
+  }
+}  // namespace
+
+int main(int argc, char **argv) {
+  const auto parsed = parse(argc, argv);
+  auto requests = create_channel(parsed);
+  auto replies = create_channel(parsed);
+
+  // The echo process inherits the mappings and descriptors across fork().
+  const auto child = ::fork();
+  if (child < 0) {
+    std::perror("fork");
+    return 1;
+  }
+  if (child == 0) {
+    if (parsed.async) {
+      aio::scheduler scheduler;
+      aio::sync_wait(scheduler, echo_async(requests, replies));
+    } else {
+      echo_blocking(requests, replies);
+    }
+    std::_Exit(0);
+  }
+
+  const std::vector<std::byte> message(parsed.size, std::byte{0x5a});
+  std::vector<double> samples(parsed.round_trips);
+  const auto start = bench_clock::now();
+  bool completed;
+  if (parsed.async) {
+    aio::scheduler scheduler;
+    completed = aio::sync_wait(scheduler, ping_async(requests, replies, message, samples));
+  } else {
+    completed = ping_blocking(requests, replies, message, samples);
+  }
+  const auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+  requests.shutdown();
+  ::waitpid(child, nullptr, 0);
+  if (!completed || samples.empty()) {
+    std::fprintf(stderr, "ipc_channel: round trip failed\n");
+    return 1;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  const auto percentile = [&](double p) { return samples[static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1))]; };
+  std::printf("%s, %zu B, spin %lld us: %.0f round trips/s, p50 %.2f us, p99 %.2f us, p99.9 %.2f us\n", parsed.async ? "async" : "blocking",
+              parsed.size, static_cast<long long>(parsed.spin.count()), static_cast<double>(samples.size()) / elapsed, percentile(0.5),
+              percentile(0.99), percentile(0.999));
+  return 0;
+}
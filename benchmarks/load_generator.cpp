@@ -0,0 +1,511 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Loopback HTTP/1.1 load generator in the style of wrk, built on aio.
+//
+// Usage: load_generator [options] address
+//
+//   address              host:port, [host]:port or unix:path of the server
+//   --threads n          threads, each with its own scheduler and pinned to a CPU (default 1)
+//   --connections n      connections, spread evenly over the threads (default 16)
+//   --duration seconds   length of the run (default 10)
+//   --pipeline n         closed loop: requests kept in flight per connection (default 1)
+//   --rate n             open loop: total requests per second, on a fixed schedule
+//   --path path          request target (default /)
+//
+// In closed-loop mode every connection keeps `--pipeline` requests in flight and sends one new
+// request per response, all the requests a read completes going out in one send; latency is
+// measured from the send. In open-loop mode every connection sends on a fixed schedule
+// regardless of how fast responses come back, and latency is measured from the time a request
+// was due rather than when it was sent, so a stalled server is charged for the requests it kept
+// from being sent (coordinated omission). Latencies go into a log-linear histogram with three
+// significant digits whose percentiles are reported like HdrHistogram's.
+//
+// Threads are pinned starting from the highest CPU the process may use, so a server started
+// alongside and pinned from CPU 0 upwards does not share cores with the generator until the
+// two overlap.
+
+#include <sched.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <aio/http.hpp>
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/socket.hpp>
+#include <aio/stream.hpp>
+#include <aio/task.hpp>
+
+namespace {
+  using clock = aio::clock;
+
+  struct load_config {
+    aio::socket_address address{};
+    unsigned threads = 1;
+    unsigned connections = 16;
+    unsigned duration = 10;
+    unsigned pipeline = 1;
+    std::uint64_t rate = 0;
+    std::string path = "/";
+  };
+
+  // Log-linear histogram of nanosecond values: exact below 2048, above that 1024 buckets per
+  // power of two, i.e. a relative error of at most 1/1024. Values of an hour and more saturate.
+  class latency_histogram {
+   public:
+    latency_histogram() : _counts(bucket_count) {}
+
+    auto record(std::uint64_t value) noexcept -> void {
+      ++_counts[index_of(std::min(value, max_value))];
+      ++_total;
+      _sum += value;
+      _max = std::max(_max, value);
+    }
+
+    auto merge(const latency_histogram &other) noexcept -> void {
+      for (std::size_t i = 0; i < bucket_count; ++i) _counts[i] += other._counts[i];
+      _total += other._total;
+      _sum += other._sum;
+      _max = std::max(_max, other._max);
+    }
+
+    [[nodiscard]] auto count() const noexcept -> std::uint64_t { return _total; }
+    [[nodiscard]] auto max() const noexcept -> std::uint64_t { return _max; }
+    [[nodiscard]] auto mean() const noexcept -> double { return _total == 0 ? 0.0 : static_cast<double>(_sum) / static_cast<double>(_total); }
+
+    // Returns the highest value equivalent to the one at `percentile`, as HdrHistogram does.
+    [[nodiscard]] auto percentile(double percentile) const noexcept -> std::uint64_t {
+      if (_total == 0) return 0;
+      const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(_total) + 0.5));
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < bucket_count; ++i) {
+        seen += _counts[i];
+        if (seen >= rank) return std::min(highest_equivalent(i), _max);
+      }
+      return _max;
+    }
+
+   private:
+    static constexpr unsigned sub_bits = 11;
+    static constexpr std::uint64_t half = std::uint64_t{1} << (sub_bits - 1);
+    static constexpr std::uint64_t max_value = std::uint64_t{3600} * 1'000'000'000;
+    static constexpr std::size_t bucket_count = (std::bit_width(max_value) - sub_bits + 2) * half;
+
+    [[nodiscard]] static auto index_of(std::uint64_t value) noexcept -> std::size_t {
+      const auto magnitude = static_cast<unsigned>(std::max(static_cast<unsigned>(std::bit_width(value)), sub_bits) - sub_bits);
+      return static_cast<std::size_t>(magnitude * half + (value >> magnitude));
+    }
+
+    [[nodiscard]] static auto highest_equivalent(std::size_t index) noexcept -> std::uint64_t {
+      const auto magnitude = index < 2 * half ? 0u : static_cast<unsigned>(index / half - 1);
+      const auto sub = index - magnitude * half;
+      return ((sub + 1) << magnitude) - 1;
+    }
+
+    std::vector<std::uint64_t> _counts;
+    std::uint64_t _total = 0;
+    std::uint64_t _sum = 0;
+    std::uint64_t _max = 0;
+  };
+
+  struct thread_stats {
+    latency_histogram latency{};
+    std::uint64_t responses = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t connect_errors = 0;
+    std::uint64_t io_errors = 0;
+    std::uint64_t protocol_errors = 0;
+    std::uint64_t bad_status = 0;
+  };
+
+  auto as_text(std::span<const std::byte> bytes) noexcept -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+  // Takes complete responses off the front of a read buffer, skipping their bodies, which may
+  // span several reads.
+  class response_reader {
+   public:
+    // Consumes what it can from `input`; produces the number of responses completed.
+    auto consume(aio::buffered_read_stream<aio::socket_stream> &input, thread_stats &stats) -> aio::result<std::size_t, std::error_code> {
+      std::size_t completed = 0;
+      while (true) {
+        const auto data = as_text(input.buffered());
+        if (_body_remaining != 0) {
+          const auto skipped = std::min(_body_remaining, data.size());
+          input.consume(skipped);
+          _body_remaining -= skipped;
+          if (_body_remaining != 0) return completed;
+          ++completed;
+          continue;
+        }
+        if (_chunked) {
+          auto decoded = _decoder.decode(data, _pieces);
+          if (!decoded) return aio::failure<std::error_code>(decoded.error());
+          _pieces.clear();
+          input.consume(*decoded);
+          if (!_decoder.done()) return completed;
+          _decoder.reset();
+          _chunked = false;
+          ++completed;
+          continue;
+        }
+
+        auto parsed = _parser.parse(data);
+        if (!parsed) return aio::failure<std::error_code>(parsed.error());
+        const auto responses = _parser.messages();
+        if (responses.empty()) return completed;
+        for (const auto &response : responses) {
+          if (response.status < 200 || response.status >= 400) ++stats.bad_status;
+          if (response.until_close) return aio::failure<std::error_code>(aio::make_error_code(aio::http_errc::bad_content_length));
+        }
+        completed += responses.size() - 1;
+        const auto &last = responses.back();
+        if (last.body_pending != 0) {
+          _body_remaining = last.body_pending;
+        } else if (last.chunked) {
+          _chunked = true;
+        } else {
+          ++completed;
+        }
+        input.consume(*parsed);
+      }
+    }
+
+   private:
+    aio::http_response_parser _parser{};
+    aio::http_chunked_decoder _decoder{};
+    std::vector<std::string_view> _pieces{};
+    std::size_t _body_remaining = 0;
+    bool _chunked = false;
+  };
+
+  // One thread of the generator with its share of the connections.
+  class load_thread {
+   public:
+    load_thread(const load_config &config, unsigned cpu, unsigned connections, unsigned first_connection)
+        : _config(&config), _cpu(cpu), _connections(connections), _first_connection(first_connection),
+          _loop(aio::scheduler_options{.timer_resolution = std::chrono::microseconds(10)}) {
+      const auto copies = std::max<std::size_t>(config.pipeline, 64);
+      const auto request = "GET " + config.path + " HTTP/1.1\r\nHost: " + config.address.to_string() + "\r\n\r\n";
+      _request_size = request.size();
+      _requests.reserve(request.size() * copies);
+      for (std::size_t i = 0; i < copies; ++i) _requests += request;
+    }
+
+    auto run(clock::time_point start, clock::time_point end) -> void {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(_cpu, &set);
+      (void)::sched_setaffinity(0, sizeof(set), &set);
+      _start = start;
+      _end = end;
+      aio::sync_wait(_loop, run_connections());
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> const thread_stats & { return _stats; }
+
+   private:
+    struct connection {
+      aio::socket_stream socket{};
+      std::deque<clock::time_point> in_flight{};
+      bool failed = false;
+    };
+
+    auto run_connections() -> aio::task<void> {
+      aio::latch done(_connections);
+      std::vector<connection> connections(_connections);
+      for (unsigned i = 0; i < _connections; ++i) _loop.spawn(drive(connections[i], _first_connection + i, done));
+      co_await _loop.sleep_until(_end);
+      _stopping = true;
+      // Outstanding receives complete with end of stream, which ends every connection.
+      for (auto &conn : connections) {
+        if (conn.socket) (void)conn.socket.shutdown();
+      }
+      co_await done.wait();
+    }
+
+    auto drive(connection &conn, unsigned index, aio::latch &done) -> aio::task<void> {
+      co_await _loop.sleep_until(_start);
+      auto connected = co_await aio::socket_stream::connect(_config->address);
+      if (!connected) {
+        ++_stats.connect_errors;
+      } else if (!_stopping) {
+        conn.socket = std::move(*connected);
+        if (_config->rate == 0) {
+          co_await closed_loop(conn);
+        } else {
+          aio::latch sent(1);
+          _loop.spawn(open_loop_sender(conn, index, sent));
+          co_await receive(conn, false);
+          co_await sent.wait();
+        }
+      }
+      done.count_down();
+    }
+
+    auto closed_loop(connection &conn) -> aio::task<void> {
+      conn.in_flight.assign(_config->pipeline, clock::now());
+      const bool sent = co_await send(conn, _config->pipeline);
+      if (sent) co_await receive(conn, true);
+    }
+
+    // Sends `count` requests in as few writes as possible; the caller has queued their start times.
+    auto send(connection &conn, std::size_t count) -> aio::task<bool> {
+      while (count != 0) {
+        const auto batch = std::min(count, _requests.size() / _request_size);
+        const auto bytes = std::as_bytes(std::span(_requests.data(), batch * _request_size));
+        if (!co_await aio::write_all(conn.socket, bytes)) {
+          if (!_stopping) ++_stats.io_errors;
+          conn.failed = true;
+          co_return false;
+        }
+        count -= batch;
+      }
+      co_return true;
+    }
+
+    // Receives responses until the run ends; with `refill`, replaces every response with a new request.
+    auto receive(connection &conn, bool refill) -> aio::task<void> {
+      aio::buffered_read_stream input(conn.socket, 64 * 1024);
+      response_reader reader;
+      while (!_stopping && !conn.failed) {
+        auto read = co_await input.fill();
+        if (!read || *read == 0) {
+          if (!_stopping) ++_stats.io_errors;
+          break;
+        }
+        const auto now = clock::now();
+        _stats.bytes += *read;
+        auto completed = reader.consume(input, _stats);
+        if (!completed) {
+          ++_stats.protocol_errors;
+          break;
+        }
+        for (std::size_t i = 0; i < *completed && !conn.in_flight.empty(); ++i) {
+          _stats.latency.record(static_cast<std::uint64_t>(std::chrono::nanoseconds(now - conn.in_flight.front()).count()));
+          conn.in_flight.pop_front();
+        }
+        _stats.responses += *completed;
+        if (refill && *completed != 0 && !_stopping) {
+          conn.in_flight.insert(conn.in_flight.end(), *completed, clock::now());
+          if (!co_await send(conn, *completed)) break;
+        }
+      }
+      conn.failed = true;
+    }
+
+    // Sends on a fixed per-connection schedule, staggered across connections. Requests that fall
+    // due while a send is in progress go out together, still recorded at the time they were due.
+    auto open_loop_sender(connection &conn, unsigned index, aio::latch &sent) -> aio::task<void> {
+      const auto interval = std::chrono::duration_cast<clock::duration>(
+          std::chrono::duration<double>(static_cast<double>(_config->connections) / static_cast<double>(_config->rate)));
+      auto due = _start + interval * index / _config->connections;
+      while (!_stopping && !conn.failed) {
+        co_await _loop.sleep_until(std::min(due, _end));
+        const auto now = clock::now();
+        if (_stopping || conn.failed || now >= _end) break;
+        std::size_t count = 0;
+        for (; due <= now; due += interval) {
+          conn.in_flight.push_back(due);
+          ++count;
+        }
+        if (!co_await send(conn, count)) break;
+      }
+      sent.count_down();
+    }
+
+    const load_config *_config;
+    unsigned _cpu;
+    unsigned _connections;
+    unsigned _first_connection;
+    aio::scheduler _loop;
+    std::string _requests{};
+    std::size_t _request_size = 0;
+    clock::time_point _start{};
+    clock::time_point _end{};
+    bool _stopping = false;
+    thread_stats _stats{};
+  };
+}  // namespace
+
+namespace {
+  auto parse_number(std::string_view text, auto &value) -> bool {
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc() && value != 0;
+  }
+
+  auto parse_arguments(int argc, char **argv, load_config &config) -> bool {
+    if (argc < 2) return false;
+    for (int i = 1; i + 1 < argc; i += 2) {
+      const std::string_view option = argv[i];
+      const std::string_view value = argv[i + 1];
+      bool valid = true;
+      if (option == "--threads") {
+        valid = parse_number(value, config.threads);
+      } else if (option == "--connections") {
+        valid = parse_number(value, config.connections);
+      } else if (option == "--duration") {
+        valid = parse_number(value, config.duration);
+      } else if (option == "--pipeline") {
+        valid = parse_number(value, config.pipeline);
+      } else if (option == "--rate") {
+        valid = parse_number(value, config.rate);
+      } else if (option == "--path") {
+        config.path = value;
+      } else {
+        valid = false;
+      }
+      if (!valid) return false;
+    }
+    auto address = aio::socket_address::parse(argv[argc - 1]);
+    if (!address || argc % 2 != 0) return false;
+    config.address = *address;
+    config.threads = std::min(config.threads, config.connections);
+    return true;
+  }
+
+  auto allowed_cpus() -> std::vector<unsigned> {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<unsigned> cpus;
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+      }
+    }
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+  }
+
+  auto format_duration(std::uint64_t nanoseconds) -> std::string {
+    char text[32];
+    if (nanoseconds < 1'000'000) {
+      std::snprintf(text, sizeof(text), "%.2fus", static_cast<double>(nanoseconds) / 1e3);
+    } else if (nanoseconds < 1'000'000'000) {
+      std::snprintf(text, sizeof(text), "%.2fms", static_cast<double>(nanoseconds) / 1e6);
+    } else {
+      std::snprintf(text, sizeof(text), "%.2fs", static_cast<double>(nanoseconds) / 1e9);
+    }
+    return text;
+  }
+
+  auto format_bytes(double bytes) -> std::string {
+    char text[32];
+    if (bytes < 1024.0 * 1024.0) {
+      std::snprintf(text, sizeof(text), "%.2fKB", bytes / 1024.0);
+    } else if (bytes < 1024.0 * 1024.0 * 1024.0) {
+      std::snprintf(text, sizeof(text), "%.2fMB", bytes / (1024.0 * 1024.0));
+    } else {
+      std::snprintf(text, sizeof(text), "%.2fGB", bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+    return text;
+  }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  load_config config;
+  if (!parse_arguments(argc, argv, config)) {
+    std::fprintf(stderr,
+                 "usage: %s [--threads n] [--connections n] [--duration seconds] [--pipeline n] [--rate requests/s] [--path path] "
+                 "address\n",
+                 argv[0]);
+    return 2;
+  }
+
+  const auto cpus = allowed_cpus();
+  std::vector<std::unique_ptr<load_thread>> threads;
+  unsigned first_connection = 0;
+  for (unsigned i = 0; i < config.threads; ++i) {
+    const auto connections = config.connections / config.threads + (i < config.connections % config.threads ? 1 : 0);
+    threads.push_back(std::make_unique<load_thread>(config, cpus[cpus.size() - 1 - i % cpus.size()], connections, first_connection));
+    first_connection += connections;
+  }
+
+  if (config.rate == 0) {
+    std::printf("Running %us test @ %s, closed loop, pipeline %u\n", config.duration, config.address.to_string().c_str(), config.pipeline);
+  } else {
+    std::printf("Running %us test @ %s, open loop at %llu requests/s\n", config.duration, config.address.to_string().c_str(),
+                static_cast<unsigned long long>(config.rate));
+  }
+  std::printf("  %u threads and %u connections\n", config.threads, config.connections);
+  std::fflush(stdout);
+
+  // Give every thread time to start and connect before the clock starts.
+  const auto start = clock::now() + std::chrono::milliseconds(100);
+  const auto end = start + std::chrono::seconds(config.duration);
+  std::vector<std::thread> workers;
+  for (auto &thread : threads) workers.emplace_back([&thread, start, end] { thread->run(start, end); });
+  for (auto &worker : workers) worker.join();
+  const auto elapsed = std::chrono::duration<double>(end - start).count();
+
+  thread_stats total;
+  for (const auto &thread : threads) {
+    const auto &stats = thread->stats();
+    total.latency.merge(stats.latency);
+    total.responses += stats.responses;
+    total.bytes += stats.bytes;
+    total.connect_errors += stats.connect_errors;
+    total.io_errors += stats.io_errors;
+    total.protocol_errors += stats.protocol_errors;
+    total.bad_status += stats.bad_status;
+  }
+
+  std::printf("  Latency   mean %s, max %s\n", format_duration(static_cast<std::uint64_t>(total.latency.mean())).c_str(),
+              format_duration(total.latency.max()).c_str());
+  std::printf("  Latency distribution\n");
+  for (const auto percentile : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0}) {
+    std::printf("  %8.3f%%  %s\n", percentile, format_duration(total.latency.percentile(percentile)).c_str());
+  }
+  std::printf("  %llu requests in %.2fs, %s read\n", static_cast<unsigned long long>(total.responses), elapsed,
+              format_bytes(static_cast<double>(total.bytes)).c_str());
+  std::printf("Requests/sec: %.2f\n", static_cast<double>(total.responses) / elapsed);
+  std::printf("Transfer/sec: %s\n", format_bytes(static_cast<double>(total.bytes) / elapsed).c_str());
+  const auto errors = total.connect_errors + total.io_errors + total.protocol_errors;
+  if (errors != 0 || total.bad_status != 0) {
+    std::printf("Errors: connect %llu, read/write %llu, protocol %llu; non-2xx/3xx responses: %llu\n",
+                static_cast<unsigned long long>(total.connect_errors), static_cast<unsigned long long>(total.io_errors),
+                static_cast<unsigned long long>(total.protocol_errors), static_cast<unsigned long long>(total.bad_status));
+  }
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Latency benchmark of the logger's producer path.
+//
+// Usage: logger_benchmark [records per case] [producer threads]
+//
+// Each case runs a logger writing to /dev/null, drained on a scheduler of its own thread, while
+// producer threads call log() in bursts of back-to-back calls. Between bursts the producers pause,
+// untimed, long enough for the drain loop to empty their rings, so the figure is the cost of a
+// record that is kept, in a warm ring, rather than of one dropped because the ring was full;
+// drops are reported all the same. It reports the mean cost of one call as seen by the producer.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <aio/buffer_pool.hpp>
+#include <aio/latch.hpp>
+#include <aio/logger.hpp>
+#include <aio/scheduler.hpp>
+
+namespace {
+  using bench_clock = std::chrono::steady_clock;
+
+  // Records per burst; a burst fits in a producer's ring with room to spare.
+  constexpr std::size_t burst = 4096;
+
+  struct outcome {
+    double nanoseconds_per_record = 0;
+    std::uint64_t dropped = 0;
+  };
+
+  // Logs `records` records per producer with `emit`; produces the mean producer-side latency.
+  template <class Emit>
+  auto measure(aio::logger &log, Emit emit, std::size_t records, int producers, aio::latch &done) -> double {
+    std::vector<std::thread> threads;
+    std::vector<double> totals(static_cast<std::size_t>(producers));
+    for (int p = 0; p < producers; ++p) {
+      threads.emplace_back([&, p] {
+        double total = 0;
+        for (std::size_t first = 0; first < records; first += burst) {
+          const auto last = std::min(first + burst, records);
+          const auto start = bench_clock::now();
+          for (auto i = first; i < last; ++i) emit(log, i);
+          total += std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        totals[static_cast<std::size_t>(p)] = total;
+        done.count_down();
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    double sum = 0;
+    for (const auto total : totals) sum += total;
+    return sum / static_cast<double>(records * static_cast<std::size_t>(producers));
+  }
+
+  template <class Emit>
+  auto run_case(aio::scheduler &scheduler, aio::buffer_pool &pool, int fd, Emit emit, std::size_t records, int producers,
+                outcome &result) -> aio::task<void> {
+    aio::logger log(scheduler, fd, pool, {.ring_size = 1 << 20});
+    aio::latch done(producers);
+    std::thread driver([&] { result.nanoseconds_per_record = measure(log, emit, records, producers, done); });
+    co_await done.wait();
+    (void)co_await log.close();
+    driver.join();
+    result.dropped = log.dropped();
+  }
+
+  template <class Emit>
+  auto report(const char *name, Emit emit, std::size_t records, int producers) -> void {
+    aio::scheduler scheduler;
+    aio::buffer_pool pool(64 * 1024, 16);
+    const int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) std::abort();
+    outcome result;
+    aio::sync_wait(scheduler, run_case(scheduler, pool, fd, emit, records, producers, result));
+    ::close(fd);
+    std::printf("%-14s %6.1f ns/record  %llu dropped\n", name, result.nanoseconds_per_record,
+                static_cast<unsigned long long>(result.dropped));
+  }
+}  // namespace
+
+int main(int argc, char **argv) {
+  const auto records = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 400'000;
+  const auto producers = argc > 2 ? std::atoi(argv[2]) : 1;
+
+  report("no arguments", [](aio::logger &log, std::size_t) { log.info("request served"); }, records, producers);
+  report("two integers", [](aio::logger &log, std::size_t i) { log.info("request {} took {} us", i, 42); }, records, producers);
+  report("string", [](aio::logger &log, std::size_t) { log.info("GET {} -> {}", std::string_view("/index.html"), 200); },
+         records, producers);
+  report("filtered", [](aio::logger &log, std::size_t i) { log.debug("debug {}", i); }, records, producers);
+  return 0;
+}
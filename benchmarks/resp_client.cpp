@@ -0,0 +1,183 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+
+// Throughput benchmark of aio::resp_client against a Redis-compatible server.
+//
+// Usage: resp_client [options] [address]
+//
+//   address              host:port, [host]:port or unix:path of the server (default 127.0.0.1:6379)
+//   --connections n      clients, each one connection (default 1)
+//   --concurrency n      coroutines issuing commands per connection (default 64)
+//   --duration seconds   length of the run (default 5)
+//   --value-size n       bytes per value (default 32)
+//
+// Every coroutine sets and gets its own key in a loop, awaiting each reply before sending the
+// next command. All coroutines of a connection share its client, which pipelines whatever they
+// have outstanding, so `--concurrency` is the pipeline depth the server sees. Runs on one thread
+// with examples/resp_server or a real Redis.
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <aio/latch.hpp>
+#include <aio/resp_client.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/socket.hpp>
+#include <aio/task.hpp>
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+  struct benchmark_config {
+    aio::socket_address address = aio::socket_address::loopback(6379);
+    unsigned connections = 1;
+    unsigned concurrency = 64;
+    clock::duration duration = std::chrono::seconds(5);
+    std::size_t value_size = 32;
+  };
+
+  struct benchmark_stats {
+    std::uint64_t commands = 0;
+    std::uint64_t errors = 0;
+  };
+
+  class benchmark {
+   public:
+    explicit benchmark(const benchmark_config &config) : _config(&config), _value(config.value_size, 'x') {}
+
+    auto run() -> bool { return aio::sync_wait(_loop, run_clients()); }
+
+    [[nodiscard]] auto stats() const noexcept -> const benchmark_stats & { return _stats; }
+
+   private:
+    auto run_clients() -> aio::task<bool> {
+      std::vector<aio::resp_client> clients;
+      for (unsigned i = 0; i < _config->connections; ++i) {
+        auto connected = co_await aio::resp_client::connect(_config->address);
+        if (!connected) {
+          std::fprintf(stderr, "connect %s: %s\n", _config->address.to_string().c_str(), connected.error().message().c_str());
+          co_return false;
+        }
+        clients.push_back(std::move(*connected));
+      }
+
+      aio::latch done(static_cast<std::ptrdiff_t>(_config->connections) * _config->concurrency);
+      for (unsigned i = 0; i < _config->connections; ++i) {
+        for (unsigned j = 0; j < _config->concurrency; ++j) _loop.spawn(drive(clients[i], i * _config->concurrency + j, done));
+      }
+      co_await _loop.sleep_for(_config->duration);
+      _stopping = true;
+      co_await done.wait();
+      for (auto &client : clients) client.close();
+      co_return true;
+    }
+
+    auto drive(aio::resp_client &client, unsigned index, aio::latch &done) -> aio::task<void> {
+      const auto key = "key:" + std::to_string(index);
+      while (!_stopping) {
+        auto set = co_await client.execute("SET", key, _value);
+        auto get = co_await client.execute("GET", key);
+        _stats.commands += 2;
+        if (!set || !get) {
+          ++_stats.errors;
+          break;
+        }
+        if ((*set)->type != aio::resp_type::simple_string || (*get)->text != _value) ++_stats.errors;
+      }
+      done.count_down();
+    }
+
+    const benchmark_config *_config;
+    std::string _value;
+    aio::scheduler _loop;
+    benchmark_stats _stats;
+    bool _stopping = false;
+  };
+
+  auto parse_arguments(int argc, char **argv, benchmark_config &config) -> bool {
+    bool address_seen = false;
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view option = argv[i];
+      if (!option.starts_with("--")) {
+        auto address = aio::socket_address::parse(option);
+        if (!address || address_seen) return false;
+        config.address = *address;
+        address_seen = true;
+        continue;
+      }
+      if (i + 1 == argc) return false;
+      const std::string_view value = argv[++i];
+      const auto number = [&](auto &target) {
+        return std::from_chars(value.data(), value.data() + value.size(), target).ec == std::errc() && target != 0;
+      };
+      if (option == "--connections") {
+        if (!number(config.connections)) return false;
+      } else if (option == "--concurrency") {
+        if (!number(config.concurrency)) return false;
+      } else if (option == "--value-size") {
+        if (!number(config.value_size)) return false;
+      } else if (option == "--duration") {
+        unsigned seconds = 0;
+        if (!number(seconds)) return false;
+        config.duration = std::chrono::seconds(seconds);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  benchmark_config config;
+  if (!parse_arguments(argc, argv, config)) {
+    std::fprintf(stderr, "usage: %s [--connections n] [--concurrency n] [--duration seconds] [--value-size n] [address]\n", argv[0]);
+    return 2;
+  }
+
+  benchmark bench(config);
+  const auto start = clock::now();
+  if (!bench.run()) return 1;
+  const auto elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+  const auto &stats = bench.stats();
+  std::printf("%u connections x %u coroutines, %zu byte values, %s\n", config.connections, config.concurrency, config.value_size,
+              config.address.to_string().c_str());
+  std::printf("  %llu commands in %.2fs, %llu errors\n", static_cast<unsigned long long>(stats.commands), elapsed,
+              static_cast<unsigned long long>(stats.errors));
+  std::printf("Commands/sec: %.0f\n", static_cast<double>(stats.commands) / elapsed);
+  return stats.errors == 0 ? 0 : 1;
+}
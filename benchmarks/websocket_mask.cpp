@@ -0,0 +1,97 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+
+// Throughput benchmark of WebSocket payload masking.
+//
+// Usage: websocket_mask_benchmark [seconds per case]
+//
+// Every case XORs a payload of the given size with a masking key over and over, once with the
+// byte-at-a-time loop a naive implementation would use and once with each available kernel of
+// aio::detail::xor_mask, and reports bytes per second.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <aio/websocket.hpp>
+
+namespace {
+  using bench_clock = std::chrono::steady_clock;
+
+  constexpr std::uint32_t key = 0x5a3c96e1;
+
+  auto xor_bytewise(std::byte *data, std::size_t size, std::uint32_t mask) noexcept -> std::uint32_t {
+    std::byte bytes[4];
+    std::memcpy(bytes, &mask, sizeof(mask));
+    for (std::size_t i = 0; i < size; ++i) data[i] ^= bytes[i % 4];
+    return aio::detail::rotate_mask(mask, size);
+  }
+
+  // Masks a `size`-byte payload with `kernel` until `seconds` have passed; produces bytes per second.
+  template <class Kernel>
+  auto run(Kernel kernel, std::size_t size, double seconds) -> double {
+    std::vector<std::byte> payload(size, std::byte{0x42});
+    std::size_t bytes = 0;
+    std::uint32_t mask = key;
+    const auto start = bench_clock::now();
+    const auto deadline = start + std::chrono::duration<double>(seconds);
+    while (bench_clock::now() < deadline) {
+      for (int round = 0; round < 256; ++round) mask = kernel(payload.data(), payload.size(), mask);
+      bytes += 256 * size;
+    }
+    // Keep the work observable.
+    if (std::to_integer<int>(payload[0]) == 0x100) std::abort();
+    return static_cast<double>(bytes) / std::chrono::duration<double>(bench_clock::now() - start).count();
+  }
+
+  template <class Kernel>
+  auto report(const char *name, Kernel kernel, std::size_t size, double seconds) -> void {
+    std::printf("%-10s %8zu B %10.2f GB/s\n", name, size, run(kernel, size, seconds) / 1e9);
+  }
+}  // namespace
+
+int main(int argc, char **argv) {
+  const auto seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+
+  constexpr std::size_t sizes[] = {16, 125, 1024, 16 * 1024, 1024 * 1024};
+  for (const auto size : sizes) {
+    report("bytewise", xor_bytewise, size, seconds);
+    report("scalar", aio::detail::xor_mask_scalar, size, seconds);
+#if AIO_SIMD_X86
+    report("sse2", aio::detail::xor_mask_sse2, size, seconds);
+    if (aio::detail::simd_has_avx2()) report("avx2", aio::detail::xor_mask_avx2, size, seconds);
+#endif
+  }
+  return 0;
+}
@@ -0,0 +1,446 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Minimal HTTP/1.1 server on aio, used as the end-to-end reference for performance regressions.
+//
+// Usage: http_server [--address host:port | --address unix:path] [--threads n] [--idle-timeout seconds]
+//
+// One scheduler per thread, each thread pinned to its own CPU. TCP listeners are opened once per
+// thread with SO_REUSEPORT so the kernel spreads connections over the threads without any
+// cross-thread handoff; a Unix domain socket is shared, each thread accepting from its own
+// descriptor of it. Connections are accepted with a multishot accept and served by one coroutine
+// each: requests are parsed in batches straight from the read buffer, the responses to a batch
+// of pipelined requests are coalesced into one send, and a timer on the scheduler's wheel closes
+// connections that stay idle. `GET /` and `GET /plaintext` answer "Hello, World!", anything else
+// gets a 404. SIGINT or SIGTERM drains the connections and prints per-thread request counts.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <aio/http.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/socket.hpp>
+#include <aio/stream.hpp>
+#include <aio/task.hpp>
+#include <aio/timer_wheel.hpp>
+
+namespace {
+  constexpr std::size_t read_buffer_size = 16 * 1024;
+  constexpr std::string_view hello_body = "Hello, World!";
+
+  struct server_config {
+    aio::socket_address address = aio::socket_address::loopback(8080);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    aio::clock::duration idle_timeout = std::chrono::seconds(30);
+  };
+
+  auto as_text(std::span<const std::byte> bytes) noexcept -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+  auto as_bytes(std::string_view text) noexcept -> std::span<const std::byte> {
+    return std::as_bytes(std::span(text.data(), text.size()));
+  }
+
+  class worker;
+
+  // A served connection. Its idle timer is armed once and pushed back lazily: when it fires
+  // before the connection has been idle for the whole timeout, it is re-armed for the rest.
+  struct connection : aio::timer_node {
+    connection(worker &owner, aio::socket_stream stream);
+    ~connection();
+
+    connection(const connection &) = delete;
+    auto operator=(const connection &) -> connection & = delete;
+
+    worker *owner;
+    aio::socket_stream socket;
+    aio::clock::time_point last_active;
+    std::size_t index = 0;
+  };
+
+  // One thread: its scheduler, its listener and the connections accepted from it.
+  class worker {
+   public:
+    worker(unsigned cpu, aio::acceptor listener, const server_config &config)
+        : _cpu(cpu), _listener(std::move(listener)), _config(&config) {
+      _date_timer.fire = &on_date_timer;
+      _date_timer.owner = this;
+    }
+
+    auto run() -> void {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(_cpu, &set);
+      (void)::sched_setaffinity(0, sizeof(set), &set);
+      _loop.spawn(start());
+      _loop.run();
+    }
+
+    // Called from another thread: stops accepting and shuts down every connection's receiving
+    // side, so their coroutines finish; run() returns once all of them have.
+    auto stop() -> void { _loop.spawn(drain()); }
+
+    [[nodiscard]] auto requests() const noexcept -> std::uint64_t { return _requests; }
+    [[nodiscard]] auto accepted() const noexcept -> std::uint64_t { return _accepted; }
+
+    [[nodiscard]] auto loop() noexcept -> aio::scheduler & { return _loop; }
+    [[nodiscard]] auto idle_timeout() const noexcept -> aio::clock::duration { return _config->idle_timeout; }
+
+    auto attach(connection &conn) -> void {
+      conn.index = _connections.size();
+      _connections.push_back(&conn);
+    }
+
+    auto detach(connection &conn) -> void {
+      _connections[conn.index] = _connections.back();
+      _connections[conn.index]->index = conn.index;
+      _connections.pop_back();
+      finish_if_drained();
+    }
+
+   private:
+    auto start() -> aio::task<void> {
+      refresh_date();
+      _loop.add_timer(&_date_timer, _loop.now() + std::chrono::seconds(1));
+      co_await accept_loop();
+    }
+
+    auto accept_loop() -> aio::task<void> {
+      while (true) {
+        auto accepted = co_await _listener.accept();
+        if (!accepted) {
+          // Once draining has closed the listener every error (EBADF included) means stop.
+          if (_stopping || accepted.error() == std::errc::operation_canceled) break;
+          // Typically EMFILE: back off instead of spinning until descriptors are freed.
+          std::fprintf(stderr, "accept: %s\n", accepted.error().message().c_str());
+          co_await _loop.sleep_for(std::chrono::milliseconds(10));
+          // drain() may have run during the sleep; don't accept on a closed listener.
+          if (_stopping) break;
+          continue;
+        }
+        ++_accepted;
+        _loop.spawn(serve(std::move(*accepted)));
+      }
+      _accepting = false;
+      finish_if_drained();
+    }
+
+    auto drain() -> aio::task<void> {
+      _stopping = true;
+      _loop.cancel_timer(&_date_timer);
+      _listener.close();
+      for (auto *conn : _connections) (void)conn->socket.shutdown(SHUT_RD);
+      finish_if_drained();
+      co_return;
+    }
+
+    auto finish_if_drained() -> void {
+      if (_stopping && !_accepting && _connections.empty()) _loop.request_stop();
+    }
+
+    auto serve(aio::socket_stream stream) -> aio::task<void> {
+      connection conn(*this, std::move(stream));
+      aio::buffered_read_stream input(conn.socket, read_buffer_size);
+      aio::http_request_parser parser(aio::http_parser_options{.max_head_size = 8 * 1024, .max_headers = 64});
+      std::string output;
+      output.reserve(4096);
+
+      bool open = true;
+      while (open) {
+        auto parsed = parser.parse(as_text(input.buffered()));
+        if (!parsed) {
+          output += parsed.error() == aio::http_errc::head_too_large ? "HTTP/1.1 431 Request Header Fields Too Large\r\n"
+                                                                      : "HTTP/1.1 400 Bad Request\r\n";
+          output += "Connection: close\r\nContent-Length: 0\r\n\r\n";
+          break;
+        }
+
+        const auto requests = parser.messages();
+        std::size_t body_pending = 0;
+        bool chunked = false;
+        for (const auto &request : requests) {
+          respond(request, output);
+          ++_requests;
+          body_pending = request.body_pending;
+          chunked = request.chunked;
+          if (!request.keep_alive) {
+            open = false;
+            break;
+          }
+        }
+        input.consume(*parsed);
+        if (!open) break;
+        if (body_pending != 0 || chunked) {
+          // Bodies are not used by any route; skip them to reach the next request.
+          if (!co_await flush(conn, output) || !co_await discard_body(conn, input, body_pending, chunked)) break;
+          continue;
+        }
+        // A batch ends at an incomplete request or a deferred error; parse again to tell which.
+        if (!requests.empty()) continue;
+
+        if (!co_await flush(conn, output) || !co_await fill(conn, input)) break;
+      }
+      co_await flush(conn, output);
+    }
+
+    // Sends the responses gathered so far in one write.
+    auto flush(connection &conn, std::string &output) -> aio::task<bool> {
+      if (output.empty()) co_return true;
+      auto written = co_await aio::write_all(conn.socket, as_bytes(output));
+      output.clear();
+      co_return written.has_value();
+    }
+
+    auto fill(connection &conn, aio::buffered_read_stream<aio::socket_stream> &input) -> aio::task<bool> {
+      auto read = co_await input.fill();
+      conn.last_active = _loop.now();
+      co_return read && *read != 0;
+    }
+
+    auto discard_body(connection &conn, aio::buffered_read_stream<aio::socket_stream> &input, std::size_t pending, bool chunked)
+        -> aio::task<bool> {
+      aio::http_chunked_decoder decoder;
+      std::vector<std::string_view> pieces;
+      while (true) {
+        const auto data = as_text(input.buffered());
+        if (chunked) {
+          auto decoded = decoder.decode(data, pieces);
+          if (!decoded) co_return false;
+          pieces.clear();
+          input.consume(*decoded);
+          if (decoder.done()) co_return true;
+        } else {
+          const auto skipped = std::min(pending, data.size());
+          input.consume(skipped);
+          pending -= skipped;
+          if (pending == 0) co_return true;
+        }
+        if (!co_await fill(conn, input)) co_return false;
+      }
+    }
+
+    auto respond(const aio::http_request &request, std::string &output) const -> void {
+      const bool found = request.target == "/" || request.target == "/plaintext";
+      const bool head = request.method == "HEAD";
+      const bool allowed = request.method == "GET" || head;
+      if (found && allowed) {
+        output += request.minor_version == 0 ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.1 200 OK\r\n";
+      } else if (found) {
+        output += request.minor_version == 0 ? "HTTP/1.0 405 Method Not Allowed\r\n" : "HTTP/1.1 405 Method Not Allowed\r\n";
+      } else {
+        output += request.minor_version == 0 ? "HTTP/1.0 404 Not Found\r\n" : "HTTP/1.1 404 Not Found\r\n";
+      }
+      output += "Server: aio\r\nDate: ";
+      output += _date;
+      if (!request.keep_alive) {
+        output += "\r\nConnection: close";
+      } else if (request.minor_version == 0) {
+        output += "\r\nConnection: keep-alive";
+      }
+      const auto body = found && allowed ? hello_body : std::string_view{};
+      output += "\r\nContent-Type: text/plain\r\nContent-Length: ";
+      char length[24];
+      const auto end = std::to_chars(length, length + sizeof(length), body.size()).ptr;
+      output.append(length, end);
+      output += "\r\n\r\n";
+      if (!head) output += body;
+    }
+
+    auto refresh_date() -> void {
+      const auto now = std::time(nullptr);
+      std::tm utc{};
+      ::gmtime_r(&now, &utc);
+      char text[64];
+      const auto size = std::strftime(text, sizeof(text), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+      _date.assign(text, size);
+    }
+
+    struct date_timer : aio::timer_node {
+      worker *owner = nullptr;
+    };
+
+    static auto on_date_timer(aio::timer_node *node) noexcept -> void {
+      auto *self = static_cast<date_timer *>(node)->owner;
+      self->refresh_date();
+      self->_loop.add_timer(node, self->_loop.now() + std::chrono::seconds(1));
+    }
+
+    unsigned _cpu;
+    aio::scheduler _loop{};
+    aio::acceptor _listener;
+    const server_config *_config;
+    std::vector<connection *> _connections{};
+    date_timer _date_timer{};
+    std::string _date{};
+    bool _accepting = true;
+    bool _stopping = false;
+    std::uint64_t _requests = 0;
+    std::uint64_t _accepted = 0;
+  };
+
+  connection::connection(worker &owner, aio::socket_stream stream)
+      : owner(&owner), socket(std::move(stream)), last_active(owner.loop().now()) {
+    fire = [](aio::timer_node *node) noexcept {
+      auto *self = static_cast<connection *>(node);
+      const auto expiry = self->last_active + self->owner->idle_timeout();
+      if (expiry <= self->owner->loop().now()) {
+        // The pending receive completes with end of stream and the connection winds down.
+        (void)self->socket.shutdown();
+      } else {
+        self->owner->loop().add_timer(self, expiry);
+      }
+    };
+    owner.loop().add_timer(this, last_active + owner.idle_timeout());
+    owner.attach(*this);
+  }
+
+  connection::~connection() {
+    if (armed()) owner->loop().cancel_timer(this);
+    owner->detach(*this);
+  }
+
+  auto parse_arguments(int argc, char **argv, server_config &config) -> bool {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      const std::string_view option = argv[i];
+      const std::string_view value = argv[i + 1];
+      if (option == "--address") {
+        auto address = aio::socket_address::parse(value);
+        if (!address) return false;
+        config.address = *address;
+      } else if (option == "--threads") {
+        if (std::from_chars(value.data(), value.data() + value.size(), config.threads).ec != std::errc() || config.threads == 0) return false;
+      } else if (option == "--idle-timeout") {
+        unsigned seconds = 0;
+        if (std::from_chars(value.data(), value.data() + value.size(), seconds).ec != std::errc()) return false;
+        config.idle_timeout = std::chrono::seconds(seconds);
+      } else {
+        return false;
+      }
+    }
+    return argc % 2 == 1;
+  }
+
+  auto allowed_cpus() -> std::vector<unsigned> {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<unsigned> cpus;
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+      }
+    }
+    if (cpus.empty()) cpus.push_back(0);
+    return cpus;
+  }
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  server_config config;
+  if (!parse_arguments(argc, argv, config)) {
+    std::fprintf(stderr, "usage: %s [--address host:port | --address unix:path] [--threads n] [--idle-timeout seconds]\n", argv[0]);
+    return 2;
+  }
+
+  // Block the stop signals before any thread starts, so only sigwait() below sees them.
+  sigset_t stop_signals;
+  ::sigemptyset(&stop_signals);
+  ::sigaddset(&stop_signals, SIGINT);
+  ::sigaddset(&stop_signals, SIGTERM);
+  ::pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+  const bool local = config.address.family() == AF_UNIX;
+  if (const auto path = config.address.to_string().substr(5); local && path.front() != '@') ::unlink(path.c_str());
+
+  const auto cpus = allowed_cpus();
+  std::vector<std::unique_ptr<worker>> workers;
+  aio::acceptor shared;
+  for (unsigned i = 0; i < config.threads; ++i) {
+    aio::acceptor listener;
+    if (local) {
+      if (!shared) {
+        auto opened = aio::acceptor::listen(config.address);
+        if (!opened) {
+          std::fprintf(stderr, "listen %s: %s\n", config.address.to_string().c_str(), opened.error().message().c_str());
+          return 1;
+        }
+        shared = std::move(*opened);
+      }
+      listener = aio::acceptor(::fcntl(shared.native_handle(), F_DUPFD_CLOEXEC, 0));
+    } else {
+      auto opened = aio::acceptor::listen(config.address, {.reuse_port = true});
+      if (!opened) {
+        std::fprintf(stderr, "listen %s: %s\n", config.address.to_string().c_str(), opened.error().message().c_str());
+        return 1;
+      }
+      listener = std::move(*opened);
+    }
+    workers.push_back(std::make_unique<worker>(cpus[i % cpus.size()], std::move(listener), config));
+  }
+  shared.close();
+
+  std::printf("listening on %s with %u threads\n", config.address.to_string().c_str(), config.threads);
+  std::fflush(stdout);
+
+  std::vector<std::thread> threads;
+  for (auto &w : workers) threads.emplace_back([&w] { w->run(); });
+
+  int signal = 0;
+  ::sigwait(&stop_signals, &signal);
+  for (auto &w : workers) w->stop();
+  for (auto &thread : threads) thread.join();
+
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    std::printf("thread %zu: %llu connections, %llu requests\n", i, static_cast<unsigned long long>(workers[i]->accepted()),
+                static_cast<unsigned long long>(workers[i]->requests()));
+    total += workers[i]->requests();
+  }
+  std::printf("total: %llu requests\n", static_cast<unsigned long long>(total));
+  return 0;
+}
@@ -0,0 +1,339 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+
+// Stand-in for a Redis server, enough to exercise aio::resp_client and RESP tooling end to end.
+//
+// Usage: resp_server [--address host:port | --address unix:path]
+//
+// One thread and one scheduler. Each connection is served by one coroutine: the commands of a
+// pipelined batch are parsed in one pass straight from the read buffer and their replies sent in
+// one write. Keys and values live in a single hash map. Supported commands: PING, ECHO, GET, SET,
+// DEL, EXISTS, INCR, INCRBY, MGET, MSET, DBSIZE, FLUSHALL, HELLO [2|3], COMMAND, CLIENT, SELECT
+// and QUIT. HELLO 3 switches the connection to RESP3. SIGINT or SIGTERM closes all connections.
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <aio/resp.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/socket.hpp>
+#include <aio/stream.hpp>
+#include <aio/task.hpp>
+
+namespace {
+  constexpr std::size_t read_buffer_size = 256 * 1024;
+  constexpr std::size_t max_value_size = 128 * 1024;
+
+  auto as_text(std::span<const std::byte> bytes) noexcept -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+  auto equals_ignore_case(std::string_view text, std::string_view upper) noexcept -> bool {
+    return text.size() == upper.size() && std::equal(text.begin(), text.end(), upper.begin(), [](char a, char b) {
+             return (a >= 'a' && a <= 'z' ? static_cast<char>(a - 'a' + 'A') : a) == b;
+           });
+  }
+
+  auto parse_integer(std::string_view text, std::int64_t &value) noexcept -> bool {
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+  }
+
+  struct string_hash {
+    using is_transparent = void;
+    auto operator()(std::string_view text) const noexcept -> std::size_t { return std::hash<std::string_view>{}(text); }
+  };
+
+  using key_space = std::unordered_map<std::string, std::string, string_hash, std::equal_to<>>;
+
+  struct session {
+    int protocol = 2;
+    bool quit = false;
+  };
+
+  class server {
+   public:
+    explicit server(aio::acceptor listener) : _listener(std::move(listener)) {}
+
+    auto run() -> void {
+      _loop.spawn(accept_loop());
+      _loop.run();
+    }
+
+    // Called from another thread: stops accepting and shuts down every connection.
+    auto stop() -> void { _loop.spawn(drain()); }
+
+    [[nodiscard]] auto commands() const noexcept -> std::uint64_t { return _commands; }
+
+   private:
+    auto accept_loop() -> aio::task<void> {
+      while (true) {
+        auto accepted = co_await _listener.accept();
+        if (!accepted) {
+          if (accepted.error() == std::errc::operation_canceled) break;
+          std::fprintf(stderr, "accept: %s\n", accepted.error().message().c_str());
+          co_await _loop.sleep_for(std::chrono::milliseconds(10));
+          continue;
+        }
+        _loop.spawn(serve(std::move(*accepted)));
+      }
+      _accepting = false;
+      finish_if_drained();
+    }
+
+    auto drain() -> aio::task<void> {
+      _stopping = true;
+      _listener.close();
+      for (auto *socket : _connections) (void)socket->shutdown(SHUT_RD);
+      finish_if_drained();
+      co_return;
+    }
+
+    auto finish_if_drained() -> void {
+      if (_stopping && !_accepting && _connections.empty()) _loop.request_stop();
+    }
+
+    auto serve(aio::socket_stream socket) -> aio::task<void> {
+      _connections.push_back(&socket);
+      aio::buffered_read_stream input(socket, read_buffer_size);
+      aio::resp_parser parser(aio::resp_parser_options{.max_bulk_length = max_value_size, .max_elements = 64 * 1024, .max_depth = 1});
+      aio::resp_encoder output;
+      session state;
+      std::vector<std::string_view> args;
+
+      while (!state.quit) {
+        auto parsed = parser.parse(as_text(input.buffered()));
+        if (!parsed) {
+          output.error("ERR Protocol error: " + parsed.error().message());
+          break;
+        }
+        for (const auto &command : parser.values()) {
+          args.clear();
+          if (command.type == aio::resp_type::array) {
+            for (const auto &arg : command.elements) args.push_back(arg.text);
+          }
+          execute(args, state, output);
+          ++_commands;
+          if (state.quit) break;
+        }
+        input.consume(*parsed);
+        if (state.quit) break;
+        // A batch ends at an incomplete command or a deferred error; parse again to tell which.
+        if (!parser.values().empty()) continue;
+
+        if (!output.empty() && !(co_await output.write(socket)).has_value()) break;
+        auto read = co_await input.fill();
+        if (!read || *read == 0) break;
+      }
+      if (!output.empty()) (void)co_await output.write(socket);
+
+      std::erase(_connections, &socket);
+      finish_if_drained();
+    }
+
+    auto execute(std::span<const std::string_view> args, session &state, aio::resp_encoder &output) -> void {
+      if (args.empty()) {
+        output.error("ERR Protocol error: expected an array of bulk strings");
+        return;
+      }
+      const auto name = args[0];
+      const auto arity = args.size();
+      const auto null = [&] { state.protocol == 3 ? output.null() : output.null_bulk_string(); };
+      const auto wrong_arity = [&] { output.error("ERR wrong number of arguments for '" + std::string(name) + "' command"); };
+
+      if (equals_ignore_case(name, "GET")) {
+        if (arity != 2) return wrong_arity();
+        const auto entry = _keys.find(args[1]);
+        if (entry == _keys.end()) return null();
+        output.bulk_string(entry->second);
+      } else if (equals_ignore_case(name, "SET")) {
+        if (arity != 3) return wrong_arity();
+        store(args[1], args[2]);
+        output.simple_string("OK");
+      } else if (equals_ignore_case(name, "PING")) {
+        if (arity > 2) return wrong_arity();
+        arity == 2 ? output.bulk_string(args[1]) : output.simple_string("PONG");
+      } else if (equals_ignore_case(name, "ECHO")) {
+        if (arity != 2) return wrong_arity();
+        output.bulk_string(args[1]);
+      } else if (equals_ignore_case(name, "DEL") || equals_ignore_case(name, "EXISTS")) {
+        if (arity < 2) return wrong_arity();
+        const bool erase = equals_ignore_case(name, "DEL");
+        std::int64_t count = 0;
+        for (const auto key : args.subspan(1)) {
+          const auto entry = _keys.find(key);
+          if (entry == _keys.end()) continue;
+          ++count;
+          if (erase) _keys.erase(entry);
+        }
+        output.integer(count);
+      } else if (equals_ignore_case(name, "INCR") || equals_ignore_case(name, "INCRBY")) {
+        const bool by = equals_ignore_case(name, "INCRBY");
+        if (arity != (by ? 3u : 2u)) return wrong_arity();
+        std::int64_t increment = 1;
+        if (by && !parse_integer(args[2], increment)) return output.error("ERR value is not an integer or out of range");
+        auto &value = _keys[std::string(args[1])];
+        std::int64_t current = 0;
+        if (!value.empty() && !parse_integer(value, current)) return output.error("ERR value is not an integer or out of range");
+        if (__builtin_add_overflow(current, increment, &current)) return output.error("ERR increment or decrement would overflow");
+        value = std::to_string(current);
+        output.integer(current);
+      } else if (equals_ignore_case(name, "MGET")) {
+        if (arity < 2) return wrong_arity();
+        output.aggregate(aio::resp_type::array, arity - 1);
+        for (const auto key : args.subspan(1)) {
+          const auto entry = _keys.find(key);
+          entry == _keys.end() ? null() : output.bulk_string(entry->second);
+        }
+      } else if (equals_ignore_case(name, "MSET")) {
+        if (arity < 3 || arity % 2 == 0) return wrong_arity();
+        for (std::size_t i = 1; i < arity; i += 2) store(args[i], args[i + 1]);
+        output.simple_string("OK");
+      } else if (equals_ignore_case(name, "DBSIZE")) {
+        output.integer(static_cast<std::int64_t>(_keys.size()));
+      } else if (equals_ignore_case(name, "FLUSHALL") || equals_ignore_case(name, "FLUSHDB")) {
+        _keys.clear();
+        output.simple_string("OK");
+      } else if (equals_ignore_case(name, "HELLO")) {
+        hello(args, state, output);
+      } else if (equals_ignore_case(name, "COMMAND")) {
+        output.aggregate(aio::resp_type::array, 0);
+      } else if (equals_ignore_case(name, "CLIENT") || equals_ignore_case(name, "SELECT")) {
+        output.simple_string("OK");
+      } else if (equals_ignore_case(name, "QUIT")) {
+        output.simple_string("OK");
+        state.quit = true;
+      } else {
+        output.error("ERR unknown command '" + std::string(name) + "'");
+      }
+    }
+
+    // HELLO [protover [AUTH username password] [SETNAME name]]: options are accepted and ignored.
+    auto hello(std::span<const std::string_view> args, session &state, aio::resp_encoder &output) -> void {
+      if (args.size() >= 2) {
+        std::int64_t version = 0;
+        if (!parse_integer(args[1], version)) return output.error("ERR Protocol version is not an integer or out of range");
+        if (version != 2 && version != 3) return output.error("NOPROTO unsupported protocol version");
+        state.protocol = static_cast<int>(version);
+      }
+      // RESP2 has no maps: the same fields go out as a flat array of keys and values.
+      if (state.protocol == 3) {
+        output.aggregate(aio::resp_type::map, 7);
+      } else {
+        output.aggregate(aio::resp_type::array, 14);
+      }
+      output.bulk_string("server");
+      output.bulk_string("aio");
+      output.bulk_string("version");
+      output.bulk_string("7.0.0");
+      output.bulk_string("proto");
+      output.integer(state.protocol);
+      output.bulk_string("id");
+      output.integer(1);
+      output.bulk_string("mode");
+      output.bulk_string("standalone");
+      output.bulk_string("role");
+      output.bulk_string("master");
+      output.bulk_string("modules");
+      output.aggregate(aio::resp_type::array, 0);
+    }
+
+    auto store(std::string_view key, std::string_view value) -> void {
+      const auto entry = _keys.find(key);
+      if (entry != _keys.end()) {
+        entry->second.assign(value);
+      } else {
+        _keys.emplace(key, value);
+      }
+    }
+
+    aio::scheduler _loop;
+    aio::acceptor _listener;
+    key_space _keys;
+    std::vector<aio::socket_stream *> _connections;
+    std::uint64_t _commands = 0;
+    bool _accepting = true;
+    bool _stopping = false;
+  };
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  auto address = aio::socket_address::loopback(6379);
+  if (argc == 3 && std::string_view(argv[1]) == "--address") {
+    auto parsed = aio::socket_address::parse(argv[2]);
+    if (parsed) address = *parsed;
+    argc = parsed ? 1 : argc;
+  }
+  if (argc != 1) {
+    std::fprintf(stderr, "usage: %s [--address host:port | --address unix:path]\n", argv[0]);
+    return 2;
+  }
+
+  // Block the stop signals before the server thread starts, so only sigwait() below sees them.
+  sigset_t stop_signals;
+  ::sigemptyset(&stop_signals);
+  ::sigaddset(&stop_signals, SIGINT);
+  ::sigaddset(&stop_signals, SIGTERM);
+  ::pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+  if (const auto path = address.to_string().substr(5); address.family() == AF_UNIX && path.front() != '@') ::unlink(path.c_str());
+  auto listener = aio::acceptor::listen(address);
+  if (!listener) {
+    std::fprintf(stderr, "listen %s: %s\n", address.to_string().c_str(), listener.error().message().c_str());
+    return 1;
+  }
+
+  server instance(std::move(*listener));
+  std::printf("listening on %s\n", address.to_string().c_str());
+  std::fflush(stdout);
+  std::thread thread([&instance] { instance.run(); });
+
+  int signal = 0;
+  ::sigwait(&stop_signals, &signal);
+  instance.stop();
+  thread.join();
+  std::printf("total: %llu commands\n", static_cast<unsigned long long>(instance.commands()));
+  return 0;
+}
@@ -0,0 +1,470 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_ASYNC_CACHE_HPP
+#define AIO_ASYNC_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "coroutine.hpp"
+#include "detail/epoch.hpp"
+#include "detail/macros.hpp"
+#include "detail/waiter.hpp"
+#include "lane.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
+namespace aio {
+  /// \ingroup coroutine
+  ///
+  /// \brief Sizing and expiry options of an async_cache
+  struct async_cache_options {
+    /// Maximum number of entries across all shards.
+    std::size_t capacity = 1024;
+
+    /// Number of independently locked shards; rounded up to a power of two.
+    std::size_t shards = 16;
+
+    /// Time-to-live of an entry after it was inserted; zero disables expiry.
+    clock::duration ttl = clock::duration::zero();
+  };
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Counters of an async_cache, summed over its shards
+  struct async_cache_stats {
+    std::uint64_t hits = 0;        ///< Lookups answered from the table
+    std::uint64_t misses = 0;      ///< Lookups that started a load
+    std::uint64_t coalesced = 0;   ///< Lookups that joined a load already in flight
+    std::uint64_t evictions = 0;   ///< Entries evicted by the CLOCK hand to make room
+    std::uint64_t expirations = 0; ///< Entries removed because their TTL passed
+  };
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Sharded asynchronous cache that coalesces concurrent misses ("single flight")
+  ///
+  /// get() looks the key up without taking any lock; readers are protected by epoch-based
+  /// reclamation, so entries replaced or evicted concurrently are only freed once no reader
+  /// can observe them. On a miss the first caller runs the loader while every other caller
+  /// asking for the same key suspends on that one load: their waiter nodes live in their own
+  /// coroutine frames and are all released together when the load completes. Failed loads are
+  /// reported to every waiter and are not cached.
+  ///
+  /// Each shard evicts with the CLOCK (second chance) algorithm. When a TTL is configured,
+  /// expired entries are never returned, and a timer owned by the cache fires on the given
+  /// scheduler's wheel at the next expiry to reclaim them. That scheduler may be destroyed
+  /// before or after the cache, but the cache must be constructed and destroyed on the thread
+  /// running it, or while it is not running.
+  ///
+  /// \tparam Key Key type; must be copyable
+  /// \tparam Value Cached value type; copied out on every hit, so prefer cheap-to-copy handles
+  template <class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+  class async_cache {
+   public:
+    using key_type = Key;
+    using value_type = Value;
+    using result_type = aio::result<Value, std::exception_ptr>;
+
+    /// \param options Sizing and TTL
+    /// \param expiry_scheduler Scheduler whose timer wheel drives TTL sweeps; may be null, in
+    ///        which case expired entries are only reclaimed when their slot is reused
+    explicit async_cache(async_cache_options options = {}, scheduler *expiry_scheduler = nullptr, Hash hash = {},
+                         KeyEqual equal = {})
+        : _hash(AIO_MOV(hash)), _equal(AIO_MOV(equal)), _ttl(options.ttl) {
+      const auto shard_count = std::bit_ceil(options.shards == 0 ? std::size_t{1} : options.shards);
+      _shard_shift = 64 - static_cast<unsigned>(std::countr_zero(shard_count));
+      const auto per_shard = (std::max<std::size_t>(options.capacity, 1) + shard_count - 1) / shard_count;
+      _shards.reserve(shard_count);
+      for (std::size_t i = 0; i < shard_count; ++i) _shards.push_back(std::make_unique<shard>(per_shard));
+
+      if (_ttl > clock::duration::zero() && expiry_scheduler) {
+        _expiry_scheduler = expiry_scheduler;
+        _sweep_timer.fire = &on_sweep;
+        _sweep_timer.owner = this;
+        _expiry_scheduler->add_timer(&_sweep_timer, clock::now() + _ttl);
+      }
+    }
+
+    async_cache(const async_cache &) = delete;
+    auto operator=(const async_cache &) -> async_cache & = delete;
+
+    /// Loads still in flight must have completed before the cache is destroyed.
+    ~async_cache() {
+      // A destroyed scheduler has disarmed the timer already.
+      if (_sweep_timer.armed()) _expiry_scheduler->cancel_timer(&_sweep_timer);
+      for (auto &s : _shards) {
+        for (auto *e : s->ring) delete e;
+      }
+    }
+
+    /// \brief Returns the cached value for `key` without suspending or locking
+    [[nodiscard]] auto try_get(const Key &key) const -> std::optional<Value> {
+      const auto hash = _hash(key);
+      auto &s = shard_for(hash);
+      auto guard = detail::epoch_domain::global().pin();
+      if (auto *e = find(s, hash, key, clock::now())) {
+        s.hits.fetch_add(1, std::memory_order_relaxed);
+        return e->value;
+      }
+      return std::nullopt;
+    }
+
+    /// \brief Returns the value for `key`, loading it with `loader(key)` on a miss
+    ///
+    /// `loader` is invoked at most once per miss across all concurrent callers and must return
+    /// an awaitable producing something convertible to `Value`. Exceptions thrown by the loader
+    /// are returned as the error of the result to every caller that waited for it.
+    template <class Loader>
+    auto get(Key key, Loader loader) -> task<result_type> {
+      const auto hash = _hash(key);
+      auto &s = shard_for(hash);
+      {
+        auto guard = detail::epoch_domain::global().pin();
+        if (auto *e = find(s, hash, key, clock::now())) {
+          s.hits.fetch_add(1, std::memory_order_relaxed);
+          co_return result_type(std::in_place, e->value);
+        }
+      }
+
+      flight own{hash, &key};
+      const auto role = co_await join_awaiter{this, &s, &own};
+      if (role == join_role::hit) {
+        s.hits.fetch_add(1, std::memory_order_relaxed);
+        co_return AIO_MOV(*own.outcome);
+      }
+      if (role == join_role::joined) {
+        s.coalesced.fetch_add(1, std::memory_order_relaxed);
+        co_return AIO_MOV(*own.outcome);
+      }
+
+      s.misses.fetch_add(1, std::memory_order_relaxed);
+      std::optional<result_type> outcome;
+      try {
+        outcome.emplace(std::in_place, co_await std::invoke(loader, std::as_const(key)));
+      } catch (...) {
+        outcome.emplace(failure<std::exception_ptr>(std::current_exception()));
+      }
+      complete(s, own, *outcome);
+      co_return AIO_MOV(*outcome);
+    }
+
+    /// \brief Inserts or replaces the value for `key`
+    auto insert(Key key, Value value) -> void {
+      const auto hash = _hash(key);
+      auto &s = shard_for(hash);
+      std::lock_guard lock(s.mutex);
+      store(s, hash, AIO_MOV(key), AIO_MOV(value), clock::now());
+    }
+
+    /// \brief Removes `key`; returns true if it was present
+    auto erase(const Key &key) -> bool {
+      const auto hash = _hash(key);
+      auto &s = shard_for(hash);
+      std::lock_guard lock(s.mutex);
+      for (auto *e = s.bucket(hash).load(std::memory_order_relaxed); e; e = e->chain.load(std::memory_order_relaxed)) {
+        if (e->hash == hash && _equal(e->key, key)) {
+          remove(s, e);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /// \brief Returns the number of entries currently stored, including expired ones not yet reclaimed
+    [[nodiscard]] auto size() const -> std::size_t {
+      std::size_t total = 0;
+      for (const auto &s : _shards) {
+        std::lock_guard lock(s->mutex);
+        total += s->size;
+      }
+      return total;
+    }
+
+    [[nodiscard]] auto stats() const noexcept -> async_cache_stats {
+      async_cache_stats total;
+      for (const auto &s : _shards) {
+        total.hits += s->hits.load(std::memory_order_relaxed);
+        total.misses += s->misses.load(std::memory_order_relaxed);
+        total.coalesced += s->coalesced.load(std::memory_order_relaxed);
+        total.evictions += s->evictions.load(std::memory_order_relaxed);
+        total.expirations += s->expirations.load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+
+   private:
+    struct entry {
+      entry(std::size_t h, Key k, Value v, clock::time_point e)
+          : hash(h), expires(e), key(AIO_MOV(k)), value(AIO_MOV(v)) {}
+
+      std::atomic<entry *> chain{nullptr};
+      entry *older = nullptr;
+      entry *newer = nullptr;
+      std::size_t hash;
+      std::size_t slot = 0;
+      clock::time_point expires;
+      std::atomic<bool> referenced{false};
+      const Key key;
+      const Value value;
+    };
+
+    // Waiter of a load in flight; lives in the frame of the get() call that waits.
+    struct flight_waiter : detail::waiter {
+      std::optional<result_type> *outcome;
+    };
+
+    // A load in flight; lives in the frame of the get() call that runs the loader.
+    struct flight {
+      std::size_t hash;
+      const Key *key;
+      flight *next = nullptr;
+      detail::node_queue waiters{};
+      std::optional<result_type> outcome{};
+    };
+
+    struct shard {
+      explicit shard(std::size_t cap)
+          : mask(std::bit_ceil(cap * 2) - 1),
+            buckets(std::make_unique<std::atomic<entry *>[]>(mask + 1)),
+            ring(cap, nullptr),
+            capacity(cap) {
+        free_slots.reserve(cap);
+        for (auto i = cap; i-- > 0;) free_slots.push_back(i);
+      }
+
+      [[nodiscard]] auto bucket(std::size_t hash) const noexcept -> std::atomic<entry *> & { return buckets[hash & mask]; }
+
+      mutable std::mutex mutex{};
+      std::size_t mask;
+      std::unique_ptr<std::atomic<entry *>[]> buckets;
+      std::vector<entry *> ring;
+      std::vector<std::size_t> free_slots{};
+      std::size_t hand = 0;
+      std::size_t size = 0;
+      std::size_t capacity;
+      entry *oldest = nullptr;
+      entry *newest = nullptr;
+      flight *flights = nullptr;
+      mutable std::atomic<std::uint64_t> hits{0};
+      std::atomic<std::uint64_t> misses{0};
+      std::atomic<std::uint64_t> coalesced{0};
+      std::atomic<std::uint64_t> evictions{0};
+      std::atomic<std::uint64_t> expirations{0};
+    };
+
+    enum class join_role { hit, joined, leader };
+
+    // Decides, under the shard lock and with the caller's handle in hand, whether the caller found
+    // the value after all, joins a load in flight (and suspends), or becomes the loader.
+    struct join_awaiter {
+      async_cache *cache;
+      shard *s;
+      flight *own;
+      flight_waiter node{};
+      join_role role = join_role::leader;
+
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+        std::lock_guard lock(s->mutex);
+        if (auto *e = cache->find(*s, own->hash, *own->key, clock::now())) {
+          own->outcome.emplace(std::in_place, e->value);
+          role = join_role::hit;
+          return false;
+        }
+        for (auto *f = s->flights; f; f = f->next) {
+          if (f->hash == own->hash && cache->_equal(*f->key, *own->key)) {
+            node.prepare(coro);
+            node.outcome = &own->outcome;
+            f->waiters.push_back(&node);
+            role = join_role::joined;
+            return true;
+          }
+        }
+        own->next = s->flights;
+        s->flights = own;
+        role = join_role::leader;
+        return false;
+      }
+
+      [[nodiscard]] auto await_resume() const noexcept -> join_role { return role; }
+    };
+
+    [[nodiscard]] auto shard_for(std::size_t hash) const noexcept -> shard & {
+      const auto mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+      return *_shards[_shard_shift == 64 ? 0 : static_cast<std::size_t>(mixed >> _shard_shift)];
+    }
+
+    [[nodiscard]] auto expired(const entry &e, clock::time_point now) const noexcept -> bool {
+      return _ttl > clock::duration::zero() && e.expires <= now;
+    }
+
+    // Lock-free lookup; the caller holds an epoch guard or the shard lock.
+    auto find(shard &s, std::size_t hash, const Key &key, clock::time_point now) const -> entry * {
+      for (auto *e = s.bucket(hash).load(std::memory_order_acquire); e; e = e->chain.load(std::memory_order_acquire)) {
+        if (e->hash != hash || !_equal(e->key, key)) continue;
+        if (expired(*e, now)) return nullptr;
+        if (!e->referenced.load(std::memory_order_relaxed)) e->referenced.store(true, std::memory_order_relaxed);
+        return e;
+      }
+      return nullptr;
+    }
+
+    auto complete(shard &s, flight &own, const result_type &outcome) -> void {
+      detail::node_queue waiters;
+      {
+        std::lock_guard lock(s.mutex);
+        for (auto **link = &s.flights; *link; link = &(*link)->next) {
+          if (*link == &own) {
+            *link = own.next;
+            break;
+          }
+        }
+        if (outcome.has_value()) store(s, own.hash, *own.key, outcome.value(), clock::now());
+        waiters.splice_back(own.waiters);
+      }
+      for (auto *node = waiters.front(); node; node = node->next) {
+        static_cast<flight_waiter *>(node)->outcome->emplace(outcome);
+      }
+      detail::resume_waiters(waiters);
+    }
+
+    // Inserts under the shard lock, replacing an existing entry for the key and evicting if full.
+    auto store(shard &s, std::size_t hash, Key key, Value value, clock::time_point now) -> void {
+      for (auto *e = s.bucket(hash).load(std::memory_order_relaxed); e; e = e->chain.load(std::memory_order_relaxed)) {
+        if (e->hash == hash && _equal(e->key, key)) {
+          remove(s, e);
+          break;
+        }
+      }
+      if (s.size == s.capacity) evict_one(s, now);
+
+      auto *e = new entry(hash, AIO_MOV(key), AIO_MOV(value), now + _ttl);
+      e->slot = s.free_slots.back();
+      s.free_slots.pop_back();
+      s.ring[e->slot] = e;
+      ++s.size;
+
+      e->older = s.newest;
+      if (s.newest) {
+        s.newest->newer = e;
+      } else {
+        s.oldest = e;
+      }
+      s.newest = e;
+
+      auto &bucket = s.bucket(hash);
+      e->chain.store(bucket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      bucket.store(e, std::memory_order_release);
+    }
+
+    // CLOCK: sweep the hand, giving referenced entries a second chance; expired entries go first.
+    auto evict_one(shard &s, clock::time_point now) -> void {
+      if (s.oldest && expired(*s.oldest, now)) {
+        remove(s, s.oldest);
+        s.expirations.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      while (true) {
+        auto *e = s.ring[s.hand];
+        s.hand = (s.hand + 1) % s.capacity;
+        if (!e) continue;
+        if (e->referenced.exchange(false, std::memory_order_relaxed)) continue;
+        remove(s, e);
+        s.evictions.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+
+    // Unlinks under the shard lock and defers deletion until concurrent readers are done.
+    auto remove(shard &s, entry *e) -> void {
+      auto *link = &s.bucket(e->hash);
+      while (link->load(std::memory_order_relaxed) != e) link = &link->load(std::memory_order_relaxed)->chain;
+      link->store(e->chain.load(std::memory_order_relaxed), std::memory_order_release);
+
+      (e->older ? e->older->newer : s.oldest) = e->newer;
+      (e->newer ? e->newer->older : s.newest) = e->older;
+
+      s.ring[e->slot] = nullptr;
+      s.free_slots.push_back(e->slot);
+      --s.size;
+      detail::epoch_domain::global().retire(e, [](void *p) noexcept { delete static_cast<entry *>(p); });
+    }
+
+    // Removes expired entries; returns when the next sweep is due.
+    auto sweep_expired(clock::time_point now) -> clock::time_point {
+      auto next = now + _ttl;
+      for (auto &s : _shards) {
+        std::lock_guard lock(s->mutex);
+        while (s->oldest && expired(*s->oldest, now)) {
+          remove(*s, s->oldest);
+          s->expirations.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (s->oldest && s->oldest->expires < next) next = s->oldest->expires;
+      }
+      return next;
+    }
+
+    struct sweep_timer : timer_node {
+      async_cache *owner = nullptr;
+    };
+
+    static auto on_sweep(timer_node *node) noexcept -> void {
+      auto *self = static_cast<sweep_timer *>(node)->owner;
+      self->_expiry_scheduler->add_timer(node, self->sweep_expired(clock::now()));
+    }
+
+    std::vector<std::unique_ptr<shard>> _shards{};
+    unsigned _shard_shift = 64;
+    Hash _hash;
+    KeyEqual _equal;
+    clock::duration _ttl;
+    scheduler *_expiry_scheduler = nullptr;
+    sweep_timer _sweep_timer{};
+  };
+}  // namespace aio
+
+#endif  // AIO_ASYNC_CACHE_HPP
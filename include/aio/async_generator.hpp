@@ -0,0 +1,169 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_ASYNC_GENERATOR_HPP
+#define AIO_ASYNC_GENERATOR_HPP
+
+#include <concepts>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "task.hpp"
+
+namespace aio {
+  template <class T>
+  class async_generator;
+
+  namespace detail {
+    template <class T>
+    class async_generator_promise final : public task_promise_base {
+     public:
+      using value_type = std::remove_cvref_t<T>;
+
+      // Suspends the generator and transfers control straight back to the consumer.
+      struct yield_awaiter {
+        [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+        auto await_suspend(std::coroutine_handle<async_generator_promise> coro) const noexcept -> std::coroutine_handle<> {
+          return coro.promise().continuation();
+        }
+
+        constexpr auto await_resume() const noexcept -> void {}
+      };
+
+      auto get_return_object() noexcept -> async_generator<T>;
+
+      auto yield_value(value_type &value) noexcept -> yield_awaiter {
+        _current = std::addressof(value);
+        return {};
+      }
+
+      auto yield_value(value_type &&value) noexcept -> yield_awaiter {
+        _current = std::addressof(value);
+        return {};
+      }
+
+      constexpr auto return_void() noexcept -> void {}
+
+      // The yielded object lives in the generator frame until the generator is resumed again.
+      [[nodiscard]] auto take() -> std::optional<value_type> {
+        rethrow_if_exception();
+        if (!_current) return std::nullopt;
+        return std::optional<value_type>(std::in_place, AIO_MOV(*std::exchange(_current, nullptr)));
+      }
+
+     private:
+      value_type *_current = nullptr;
+    };
+  }  // namespace detail
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Lazy, asynchronous sequence of values
+  ///
+  /// The body runs only while the consumer awaits next(), and may itself co_await (I/O, timers,
+  /// other tasks) between values. Control passes between consumer and generator by symmetric
+  /// transfer, so producing a value costs no scheduling round trip; the generator inherits the
+  /// consumer's lane and deadline like an awaited task, and its frame comes from the frame
+  /// allocator.
+  ///
+  /// \code
+  /// while (auto batch = co_await events.next()) handle(*batch);
+  /// \endcode
+  ///
+  /// An exception escaping the body is rethrown from the next() that was waiting for a value.
+  template <class T>
+  class async_generator {
+   public:
+    using promise_type = detail::async_generator_promise<T>;
+    using value_type = typename promise_type::value_type;
+
+    constexpr async_generator() noexcept = default;
+    async_generator(async_generator &&other) noexcept : _coro(std::exchange(other._coro, nullptr)) {}
+    auto operator=(async_generator other) noexcept -> async_generator & {
+      std::swap(_coro, other._coro);
+      return *this;
+    }
+
+    ~async_generator() {
+      if (_coro) _coro.destroy();
+    }
+
+    class next_awaiter {
+     public:
+      explicit next_awaiter(std::coroutine_handle<promise_type> coro) noexcept : _coro(coro) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return !_coro || _coro.done(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> consumer) noexcept -> std::coroutine_handle<> {
+        auto &promise = _coro.promise();
+        promise.set_continuation(consumer);
+        if constexpr (std::derived_from<Promise, detail::task_promise_base>) promise.inherit_from(consumer.promise());
+        return _coro;
+      }
+
+      auto await_resume() -> std::optional<value_type> {
+        if (!_coro) return std::nullopt;
+        return _coro.promise().take();
+      }
+
+     private:
+      std::coroutine_handle<promise_type> _coro;
+    };
+
+    /// \brief Returns an awaitable that runs the generator up to its next value
+    ///
+    /// Produces the value, or `std::nullopt` once the generator has finished.
+    [[nodiscard]] auto next() noexcept -> next_awaiter { return next_awaiter(_coro); }
+
+    [[nodiscard]] auto done() const noexcept -> bool { return !_coro || _coro.done(); }
+
+   private:
+    friend promise_type;
+
+    explicit async_generator(std::coroutine_handle<promise_type> coro) noexcept : _coro(coro) {}
+
+    std::coroutine_handle<promise_type> _coro{};
+  };
+
+  template <class T>
+  auto detail::async_generator_promise<T>::get_return_object() noexcept -> async_generator<T> {
+    return async_generator<T>(std::coroutine_handle<async_generator_promise>::from_promise(*this));
+  }
+
+  static_assert(aio::awaitable_of<async_generator<int>::next_awaiter, std::optional<int>>);
+}  // namespace aio
+
+#endif  // AIO_ASYNC_GENERATOR_HPP
@@ -0,0 +1,142 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_BARRIER_HPP
+#define AIO_BARRIER_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+
+namespace aio {
+  namespace detail {
+    struct no_completion {
+      constexpr auto operator()() const noexcept -> void {}
+    };
+  }  // namespace detail
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Reusable phase barrier for coroutines
+  ///
+  /// Each phase completes when `expected` participants have arrived. The last arrival runs the
+  /// completion function, starts the next phase and resumes every waiter of the finished phase
+  /// as one batch per scheduler, without suspending itself. Waiters are intrusive nodes in their
+  /// own frames. Participants that leave with arrive_and_drop() reduce the expected count of all
+  /// following phases.
+  ///
+  /// \tparam Completion Nullary callable run once per phase, before any waiter is resumed
+  template <class Completion = detail::no_completion>
+  class barrier {
+   public:
+    class awaiter;
+
+    explicit barrier(std::ptrdiff_t expected, Completion completion = Completion())
+        : _completion(AIO_MOV(completion)), _expected(expected), _remaining(expected) {}
+
+    barrier(const barrier &) = delete;
+    auto operator=(const barrier &) -> barrier & = delete;
+
+    /// \brief Returns an awaitable that arrives at the barrier and waits for the phase to complete
+    [[nodiscard]] auto arrive_and_wait() noexcept -> awaiter { return awaiter(*this); }
+
+    /// \brief Arrives at the barrier without waiting and leaves it for all following phases
+    auto arrive_and_drop() -> void {
+      detail::node_queue wake;
+      {
+        std::lock_guard lock(_mutex);
+        --_expected;
+        if (--_remaining == 0) complete_phase(wake);
+      }
+      detail::resume_waiters(wake);
+    }
+
+    /// \brief Returns the number of completed phases
+    [[nodiscard]] auto phase() const -> std::uint64_t {
+      std::lock_guard lock(_mutex);
+      return _phase;
+    }
+
+   private:
+    // Called with `_mutex` held by the last arrival of the current phase.
+    auto complete_phase(detail::node_queue &wake) -> void {
+      _completion();
+      ++_phase;
+      _remaining = _expected;
+      wake.splice_back(_waiters);
+    }
+
+    Completion _completion;
+    mutable std::mutex _mutex{};
+    std::ptrdiff_t _expected;
+    std::ptrdiff_t _remaining;
+    std::uint64_t _phase = 0;
+    detail::node_queue _waiters{};
+  };
+
+  template <class Completion>
+  class barrier<Completion>::awaiter : detail::waiter {
+   public:
+    explicit awaiter(barrier &barrier) noexcept : _barrier(&barrier) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+      detail::node_queue wake;
+      {
+        std::lock_guard lock(_barrier->_mutex);
+        if (--_barrier->_remaining != 0) {
+          prepare(coro);
+          _barrier->_waiters.push_back(this);
+          return true;
+        }
+        _barrier->complete_phase(wake);
+      }
+      detail::resume_waiters(wake);
+      return false;
+    }
+
+    constexpr auto await_resume() const noexcept -> void {}
+
+   private:
+    barrier *_barrier;
+  };
+
+  static_assert(aio::awaitable_of<barrier<>::awaiter, void>);
+}  // namespace aio
+
+#endif  // AIO_BARRIER_HPP
@@ -0,0 +1,594 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_BLOCK_CACHE_HPP
+#define AIO_BLOCK_CACHE_HPP
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "detail/macros.hpp"
+#include "detail/profiling.hpp"
+#include "detail/waiter.hpp"
+#include "io.hpp"
+#include "result.hpp"
+#include "task.hpp"
+
+namespace aio {
+  class block_cache;
+  class cached_file;
+
+  /// \ingroup io
+  ///
+  /// \brief Sizing options of a block_cache
+  struct block_cache_options {
+    /// Size of a cached block; a multiple of the device's logical block size for O_DIRECT files.
+    std::size_t block_size = 64 * 1024;
+
+    /// Total memory for block data; rounded down to whole blocks per shard.
+    std::size_t capacity = 256 * 1024 * 1024;
+
+    /// Number of independently locked shards; rounded up to a power of two.
+    std::size_t shards = 16;
+
+    /// Back the block memory with huge pages: explicit (hugetlbfs) pages if reserved, transparent ones otherwise.
+    bool huge_pages = true;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Counters of a block_cache, summed over its shards
+  struct block_cache_stats {
+    std::uint64_t hits = 0;      ///< Reads served from a resident block
+    std::uint64_t misses = 0;    ///< Reads that loaded the block from the file
+    std::uint64_t coalesced = 0; ///< Reads that joined a load already in flight
+    std::uint64_t evictions = 0; ///< Blocks evicted to make room
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Pinned reference to a resident block of a block_cache
+  ///
+  /// While a reference exists its block cannot be evicted. References may be released on any
+  /// thread; the cache must outlive them.
+  class block_ref {
+   public:
+    constexpr block_ref() noexcept = default;
+
+    block_ref(const block_ref &) = delete;
+    block_ref(block_ref &&other) noexcept
+        : _pins(std::exchange(other._pins, nullptr)), _data(other._data), _size(other._size) {}
+
+    auto operator=(const block_ref &) -> block_ref & = delete;
+    auto operator=(block_ref &&other) noexcept -> block_ref & {
+      if (this != &other) {
+        reset();
+        _pins = std::exchange(other._pins, nullptr);
+        _data = other._data;
+        _size = other._size;
+      }
+      return *this;
+    }
+
+    ~block_ref() { reset(); }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _pins != nullptr; }
+
+    /// \brief Returns the block's bytes; shorter than the block size for the last block of a file
+    [[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte> { return {_data, _size}; }
+
+    /// \brief Unpins the block
+    auto reset() noexcept -> void {
+      if (_pins) std::exchange(_pins, nullptr)->fetch_sub(1, std::memory_order_release);
+    }
+
+   private:
+    friend class block_cache;
+
+    block_ref(std::atomic<std::uint32_t> *pins, const std::byte *data, std::size_t size) noexcept
+        : _pins(pins), _data(data), _size(size) {}
+
+    std::atomic<std::uint32_t> *_pins = nullptr;
+    const std::byte *_data = nullptr;
+    std::size_t _size = 0;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief A file descriptor read through a block_cache
+  ///
+  /// Cheap to copy; does not own the descriptor, which must stay open while reads are in flight.
+  class cached_file {
+   public:
+    /// \brief Returns block `index` (bytes `[index * block_size, (index + 1) * block_size)`), pinned
+    [[nodiscard]] inline auto read_block(std::uint64_t index) const -> task<result<block_ref, std::error_code>>;
+
+    /// \brief Copies bytes starting at `offset` into `out`; produces the number copied, short only at the end of the file
+    [[nodiscard]] inline auto read(std::uint64_t offset, std::span<std::byte> out) const -> task<result<std::size_t, std::error_code>>;
+
+    /// \brief Drops the file's unpinned blocks, e.g. after it was written through another path
+    inline auto invalidate() const -> void;
+
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+   private:
+    friend class block_cache;
+
+    cached_file(block_cache *cache, int fd, std::uint64_t id) noexcept : _cache(cache), _fd(fd), _id(id) {}
+
+    block_cache *_cache;
+    int _fd;
+    std::uint64_t _id;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Sharded userspace cache of fixed-size file blocks, for files opened with O_DIRECT
+  ///
+  /// Files are attached to the cache and read through the returned cached_file. Blocks are keyed
+  /// by (file, block index) and live in a single slab mapped up front, preferably on huge pages,
+  /// so memory use is fixed and the slab costs few TLB entries. The slab is page-aligned and
+  /// every block starts at a multiple of the block size, which satisfies O_DIRECT alignment.
+  ///
+  /// Concurrent misses on one block are coalesced: the first reader issues the read through its
+  /// scheduler's io_uring and the others suspend until it completes. Each shard evicts with
+  /// S3-FIFO: new blocks enter a small probationary FIFO and are only promoted to the main FIFO
+  /// if they are read again before reaching its end, so one-off scans cannot flush the hot set.
+  /// Blocks evicted from the small FIFO are remembered in a ghost table (an approximate,
+  /// direct-mapped set of key fingerprints); a miss on a remembered block goes straight to main.
+  ///
+  /// Blocks referenced by a block_ref are pinned and skipped by eviction; when every block of a
+  /// shard is pinned, reads that need a new block fail with `std::errc::no_buffer_space`. Failed
+  /// reads are reported to every coalesced reader and not cached; if the loading reader's read
+  /// throws, the others fail with `std::errc::operation_canceled`. Either way the next read of
+  /// the block loads it again.
+  ///
+  /// Counters are available from stats(), and as Tracy plots when built with TRACY_ENABLE: plot()
+  /// publishes them and is called after every load.
+  class block_cache {
+   public:
+    explicit block_cache(block_cache_options options = {}) : _block_size(std::max<std::size_t>(options.block_size, 1)) {
+      const auto shard_count = std::bit_ceil(options.shards == 0 ? std::size_t{1} : options.shards);
+      _shard_shift = 64 - static_cast<unsigned>(std::countr_zero(shard_count));
+      const auto per_shard = std::max<std::size_t>(options.capacity / _block_size / shard_count, 1);
+      map_slab(per_shard * shard_count * _block_size, options.huge_pages);
+      _shards.reserve(shard_count);
+      for (std::size_t i = 0; i < shard_count; ++i) {
+        _shards.push_back(std::make_unique<shard>(per_shard, _slab + i * per_shard * _block_size));
+      }
+    }
+
+    block_cache(const block_cache &) = delete;
+    auto operator=(const block_cache &) -> block_cache & = delete;
+
+    /// Reads in flight and block references must be gone before the cache is destroyed.
+    ~block_cache() { ::munmap(_slab, _slab_size); }
+
+    /// \brief Returns a handle reading `fd` through this cache under a fresh file identity
+    [[nodiscard]] auto attach(int fd) -> cached_file {
+      return {this, fd, _next_file.fetch_add(1, std::memory_order_relaxed)};
+    }
+
+    [[nodiscard]] auto block_size() const noexcept -> std::size_t { return _block_size; }
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return _shards.size() * _shards.front()->frames_count; }
+
+    /// \brief Returns true if the block memory ended up on huge pages (explicit or transparent)
+    [[nodiscard]] auto huge_pages() const noexcept -> bool { return _huge_pages; }
+
+    [[nodiscard]] auto stats() const noexcept -> block_cache_stats {
+      block_cache_stats total;
+      for (const auto &s : _shards) {
+        total.hits += s->hits.load(std::memory_order_relaxed);
+        total.misses += s->misses.load(std::memory_order_relaxed);
+        total.coalesced += s->coalesced.load(std::memory_order_relaxed);
+        total.evictions += s->evictions.load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+
+    /// \brief Publishes the counters as Tracy plots; a no-op without TRACY_ENABLE
+    auto plot() const noexcept -> void {
+      [[maybe_unused]] const auto total = stats();
+      AIO_PLOT("aio::block_cache hits", static_cast<std::int64_t>(total.hits));
+      AIO_PLOT("aio::block_cache misses", static_cast<std::int64_t>(total.misses));
+      AIO_PLOT("aio::block_cache coalesced", static_cast<std::int64_t>(total.coalesced));
+      AIO_PLOT("aio::block_cache evictions", static_cast<std::int64_t>(total.evictions));
+    }
+
+   private:
+    friend class cached_file;
+
+    enum class frame_state : std::uint8_t {
+      free,    // on the free list
+      loading, // read in flight; indexed
+      ready,   // resident; indexed
+      failed,  // read failed; unindexed, reclaimed once unpinned
+      stale    // invalidated; unindexed, reclaimed once unpinned
+    };
+
+    struct frame {
+      std::uint64_t file = 0;
+      std::uint64_t block = 0;
+      std::uint64_t hash = 0;
+      std::int32_t chain = -1;
+      frame_state state = frame_state::free;
+      std::uint8_t frequency = 0;
+      std::atomic<std::uint32_t> pins{0};
+      std::uint32_t size = 0;
+      int error = 0;
+      detail::node_queue waiters{};
+    };
+
+    // FIFO of frame indices; holds at most every frame of the shard once.
+    class frame_fifo {
+     public:
+      explicit frame_fifo(std::size_t capacity) : _slots(capacity) {}
+
+      [[nodiscard]] auto size() const noexcept -> std::size_t { return _count; }
+      auto push(std::uint32_t index) noexcept -> void { _slots[(_head + _count++) % _slots.size()] = index; }
+      auto pop() noexcept -> std::uint32_t {
+        const auto index = _slots[_head];
+        _head = (_head + 1) % _slots.size();
+        --_count;
+        return index;
+      }
+
+     private:
+      std::vector<std::uint32_t> _slots;
+      std::size_t _head = 0;
+      std::size_t _count = 0;
+    };
+
+    struct shard {
+      shard(std::size_t count, std::byte *memory)
+          : frames(std::make_unique<frame[]>(count)),
+            frames_count(count),
+            data(memory),
+            buckets(std::bit_ceil(count * 2), -1),
+            ghosts(std::bit_ceil(count), 0),
+            small(count),
+            main(count),
+            small_target(std::max<std::size_t>(count / 10, 1)) {
+        free.reserve(count);
+        for (auto i = count; i-- > 0;) free.push_back(static_cast<std::uint32_t>(i));
+      }
+
+      std::mutex mutex{};
+      std::unique_ptr<frame[]> frames;
+      std::size_t frames_count;
+      std::byte *data;
+      std::vector<std::int32_t> buckets;
+      std::vector<std::uint64_t> ghosts;
+      std::vector<std::uint32_t> free{};
+      frame_fifo small;
+      frame_fifo main;
+      std::size_t small_target;
+      std::atomic<std::uint64_t> hits{0};
+      std::atomic<std::uint64_t> misses{0};
+      std::atomic<std::uint64_t> coalesced{0};
+      std::atomic<std::uint64_t> evictions{0};
+    };
+
+    enum class claim_role { hit, joined, leader, full };
+
+    // Under the shard lock: pins a resident block, joins a load in flight (and suspends), or claims
+    // a frame and becomes the loader.
+    struct claim_awaiter {
+      block_cache *cache;
+      shard *s;
+      std::uint64_t file;
+      std::uint64_t block;
+      std::uint64_t hash;
+      detail::waiter node{};
+      frame *target = nullptr;
+      claim_role role = claim_role::leader;
+
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+        std::lock_guard lock(s->mutex);
+        if (auto *f = cache->find(*s, file, block, hash)) {
+          f->pins.fetch_add(1, std::memory_order_relaxed);
+          target = f;
+          if (f->state == frame_state::ready) {
+            f->frequency = static_cast<std::uint8_t>(std::min(f->frequency + 1, 3));
+            s->hits.fetch_add(1, std::memory_order_relaxed);
+            role = claim_role::hit;
+            return false;
+          }
+          node.prepare(coro);
+          f->waiters.push_back(&node);
+          s->coalesced.fetch_add(1, std::memory_order_relaxed);
+          role = claim_role::joined;
+          return true;
+        }
+        target = cache->claim(*s, file, block, hash);
+        role = target ? claim_role::leader : claim_role::full;
+        return false;
+      }
+
+      [[nodiscard]] auto await_resume() const noexcept -> claim_role { return role; }
+    };
+
+    [[nodiscard]] static auto block_hash(std::uint64_t file, std::uint64_t block) noexcept -> std::uint64_t {
+      auto h = (file * 0x9E3779B97F4A7C15ull) ^ (block + 0x632BE59BD9B4E019ull + (file << 6) + (file >> 2));
+      h ^= h >> 29;
+      h *= 0xBF58476D1CE4E5B9ull;
+      return h ^ (h >> 32);
+    }
+
+    [[nodiscard]] auto shard_for(std::uint64_t hash) const noexcept -> shard & {
+      return *_shards[_shard_shift == 64 ? 0 : static_cast<std::size_t>(hash >> _shard_shift)];
+    }
+
+    [[nodiscard]] auto frame_data(const shard &s, const frame &f) const noexcept -> std::byte * {
+      return s.data + static_cast<std::size_t>(&f - s.frames.get()) * _block_size;
+    }
+
+    auto find(shard &s, std::uint64_t file, std::uint64_t block, std::uint64_t hash) const noexcept -> frame * {
+      for (auto i = s.buckets[hash & (s.buckets.size() - 1)]; i >= 0; i = s.frames[i].chain) {
+        auto &f = s.frames[i];
+        if (f.hash == hash && f.file == file && f.block == block) return &f;
+      }
+      return nullptr;
+    }
+
+    auto unindex(shard &s, frame &f) noexcept -> void {
+      auto *link = &s.buckets[f.hash & (s.buckets.size() - 1)];
+      const auto index = static_cast<std::int32_t>(&f - s.frames.get());
+      while (*link != index) link = &s.frames[*link].chain;
+      *link = f.chain;
+      f.chain = -1;
+    }
+
+    [[nodiscard]] static auto ghost_slot(shard &s, std::uint64_t hash) noexcept -> std::uint64_t & {
+      return s.ghosts[(hash >> 7) & (s.ghosts.size() - 1)];
+    }
+
+    // Takes a free frame, evicting one if needed, and indexes it as loading for the caller.
+    auto claim(shard &s, std::uint64_t file, std::uint64_t block, std::uint64_t hash) -> frame * {
+      std::uint32_t index;
+      if (!s.free.empty()) {
+        index = s.free.back();
+        s.free.pop_back();
+      } else if (!evict(s, index)) {
+        return nullptr;
+      }
+      auto &f = s.frames[index];
+      f.file = file;
+      f.block = block;
+      f.hash = hash;
+      f.state = frame_state::loading;
+      f.frequency = 0;
+      f.size = 0;
+      f.error = 0;
+      f.pins.store(1, std::memory_order_relaxed);
+      auto &bucket = s.buckets[hash & (s.buckets.size() - 1)];
+      f.chain = bucket;
+      bucket = static_cast<std::int32_t>(index);
+      auto &ghost = ghost_slot(s, hash);
+      if (ghost == (hash | 1)) {
+        ghost = 0;
+        s.main.push(index);
+      } else {
+        s.small.push(index);
+      }
+      s.misses.fetch_add(1, std::memory_order_relaxed);
+      return &f;
+    }
+
+    // S3-FIFO eviction. Pinned (including loading) frames are rotated past; once a full lap of both
+    // queues found nothing but pinned frames, or the visit budget is spent, eviction fails.
+    auto evict(shard &s, std::uint32_t &victim) -> bool {
+      std::size_t small_pinned = 0;
+      std::size_t main_pinned = 0;
+      for (auto budget = 4 * s.frames_count + 8; budget-- > 0;) {
+        const bool small_exhausted = small_pinned >= s.small.size();
+        const bool main_exhausted = main_pinned >= s.main.size();
+        if (small_exhausted && main_exhausted) return false;
+        const bool from_small = !small_exhausted && (s.small.size() > s.small_target || main_exhausted);
+        auto &queue = from_small ? s.small : s.main;
+        const auto index = queue.pop();
+        auto &f = s.frames[index];
+        if (f.pins.load(std::memory_order_acquire) != 0) {
+          queue.push(index);
+          ++(from_small ? small_pinned : main_pinned);
+          continue;
+        }
+        if (f.state == frame_state::failed || f.state == frame_state::stale) {
+          // Already unindexed; reclaim as is.
+        } else if (from_small) {
+          if (f.frequency > 0) {
+            f.frequency = 0;
+            s.main.push(index);
+            continue;
+          }
+          ghost_slot(s, f.hash) = f.hash | 1;
+          unindex(s, f);
+          s.evictions.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          if (f.frequency > 0) {
+            --f.frequency;
+            s.main.push(index);
+            continue;
+          }
+          unindex(s, f);
+          s.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        f.state = frame_state::free;
+        victim = index;
+        return true;
+      }
+      return false;
+    }
+
+    // Publishes the outcome of a load and resumes the readers that joined it.
+    auto finish_load(shard &s, frame &f, const result<std::size_t, std::error_code> &outcome) -> void {
+      detail::node_queue waiters;
+      {
+        std::lock_guard lock(s.mutex);
+        if (outcome) {
+          f.state = frame_state::ready;
+          f.size = static_cast<std::uint32_t>(*outcome);
+        } else {
+          f.state = frame_state::failed;
+          f.error = outcome.error().value();
+          unindex(s, f);
+        }
+        waiters.splice_back(f.waiters);
+      }
+      detail::resume_waiters(waiters);
+      plot();
+    }
+
+    auto reference(shard &s, frame &f) const -> result<block_ref, std::error_code> {
+      if (f.state == frame_state::failed) {
+        const auto error = f.error;
+        f.pins.fetch_sub(1, std::memory_order_release);
+        return failure<std::error_code>(std::error_code(error, std::system_category()));
+      }
+      return block_ref(&f.pins, frame_data(s, f), f.size);
+    }
+
+    auto read_block(int fd, std::uint64_t file, std::uint64_t block) -> task<result<block_ref, std::error_code>> {
+      const auto hash = block_hash(file, block);
+      auto &s = shard_for(hash);
+      claim_awaiter claim{this, &s, file, block, hash};
+      const auto role = co_await claim;
+      if (role == claim_role::full) co_return failure<std::error_code>(std::make_error_code(std::errc::no_buffer_space));
+      auto &f = *claim.target;
+      if (role == claim_role::leader) {
+        result<std::size_t, std::error_code> outcome = failure<std::error_code>(std::make_error_code(std::errc::operation_canceled));
+        try {
+          outcome = co_await async_read(fd, {frame_data(s, f), _block_size}, block * _block_size);
+        } catch (...) {
+          // Fail the load rather than leave it loading: joined readers get an error, later ones retry.
+          finish_load(s, f, outcome);
+          f.pins.fetch_sub(1, std::memory_order_release);
+          throw;
+        }
+        finish_load(s, f, outcome);
+      }
+      co_return reference(s, f);
+    }
+
+    auto invalidate(std::uint64_t file) -> void {
+      for (auto &s : _shards) {
+        std::lock_guard lock(s->mutex);
+        for (std::size_t i = 0; i < s->frames_count; ++i) {
+          auto &f = s->frames[i];
+          if (f.file == file && f.state == frame_state::ready) {
+            unindex(*s, f);
+            f.state = frame_state::stale;
+          }
+        }
+      }
+    }
+
+    // Maps the slab on explicit huge pages if any are reserved, else 2 MiB-aligned with a
+    // transparent huge page hint, else on regular pages.
+    auto map_slab(std::size_t size, bool huge) -> void {
+      constexpr std::size_t huge_page = 2 * 1024 * 1024;
+      if (huge) {
+        const auto rounded = (size + huge_page - 1) & ~(huge_page - 1);
+        void *memory = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+          _slab = static_cast<std::byte *>(memory);
+          _slab_size = rounded;
+          _huge_pages = true;
+          return;
+        }
+        memory = ::mmap(nullptr, rounded + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) throw std::bad_alloc();
+        auto *base = static_cast<std::byte *>(memory);
+        auto *aligned = reinterpret_cast<std::byte *>((reinterpret_cast<std::uintptr_t>(base) + huge_page - 1) & ~(huge_page - 1));
+        if (aligned != base) ::munmap(base, static_cast<std::size_t>(aligned - base));
+        const auto tail = static_cast<std::size_t>((base + rounded + huge_page) - (aligned + rounded));
+        if (tail != 0) ::munmap(aligned + rounded, tail);
+        _slab = aligned;
+        _slab_size = rounded;
+        _huge_pages = ::madvise(_slab, _slab_size, MADV_HUGEPAGE) == 0;
+        return;
+      }
+      void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (memory == MAP_FAILED) throw std::bad_alloc();
+      _slab = static_cast<std::byte *>(memory);
+      _slab_size = size;
+    }
+
+    std::size_t _block_size;
+    unsigned _shard_shift = 64;
+    std::byte *_slab = nullptr;
+    std::size_t _slab_size = 0;
+    bool _huge_pages = false;
+    std::vector<std::unique_ptr<shard>> _shards{};
+    std::atomic<std::uint64_t> _next_file{1};
+  };
+
+  inline auto cached_file::read_block(std::uint64_t index) const -> task<result<block_ref, std::error_code>> {
+    return _cache->read_block(_fd, _id, index);
+  }
+
+  inline auto cached_file::read(std::uint64_t offset, std::span<std::byte> out) const -> task<result<std::size_t, std::error_code>> {
+    const auto block_size = _cache->block_size();
+    std::size_t copied = 0;
+    while (copied < out.size()) {
+      const auto position = offset + copied;
+      auto block = co_await read_block(position / block_size);
+      if (!block) co_return failure<std::error_code>(block.error());
+      const auto bytes = block->bytes();
+      const auto within = static_cast<std::size_t>(position % block_size);
+      if (within >= bytes.size()) break;
+      const auto count = std::min(bytes.size() - within, out.size() - copied);
+      std::memcpy(out.data() + copied, bytes.data() + within, count);
+      copied += count;
+      if (bytes.size() < block_size) break;
+    }
+    co_return copied;
+  }
+
+  inline auto cached_file::invalidate() const -> void { _cache->invalidate(_id); }
+}  // namespace aio
+
+#endif  // AIO_BLOCK_CACHE_HPP
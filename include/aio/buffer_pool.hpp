@@ -0,0 +1,170 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_BUFFER_POOL_HPP
+#define AIO_BUFFER_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "numa.hpp"
+
+namespace aio {
+  class buffer_pool;
+
+  /// \ingroup numa
+  ///
+  /// \brief Move-only handle to a buffer borrowed from a buffer_pool
+  ///
+  /// The buffer returns to its pool when the handle is destroyed or reset. Handles may be
+  /// released on any thread.
+  class pooled_buffer {
+   public:
+    constexpr pooled_buffer() noexcept = default;
+
+    pooled_buffer(const pooled_buffer &) = delete;
+    pooled_buffer(pooled_buffer &&other) noexcept
+        : _pool(std::exchange(other._pool, nullptr)), _data(std::exchange(other._data, nullptr)) {}
+
+    auto operator=(const pooled_buffer &) -> pooled_buffer & = delete;
+    auto operator=(pooled_buffer &&other) noexcept -> pooled_buffer & {
+      if (this != &other) {
+        reset();
+        _pool = std::exchange(other._pool, nullptr);
+        _data = std::exchange(other._data, nullptr);
+      }
+      return *this;
+    }
+
+    ~pooled_buffer() { reset(); }
+
+    [[nodiscard]] constexpr explicit operator bool() const noexcept { return _data != nullptr; }
+    [[nodiscard]] constexpr auto data() const noexcept -> std::byte * { return _data; }
+    [[nodiscard]] inline auto size() const noexcept -> std::size_t;
+    [[nodiscard]] auto span() const noexcept -> std::span<std::byte> { return {_data, size()}; }
+
+    /// \brief Returns the buffer to its pool
+    inline auto reset() noexcept -> void;
+
+   private:
+    friend class buffer_pool;
+
+    pooled_buffer(buffer_pool *pool, std::byte *data) noexcept : _pool(pool), _data(data) {}
+
+    buffer_pool *_pool = nullptr;
+    std::byte *_data = nullptr;
+  };
+
+  /// \ingroup numa
+  ///
+  /// \brief Pool of fixed-size I/O buffers placed in NUMA-local memory
+  ///
+  /// Buffers are carved out of page-aligned chunks that are mapped on demand. Unless a node is
+  /// given explicitly, a chunk is placed on the home node of the thread that maps it (see
+  /// aio::bind_this_thread), which is the thread of the scheduler or pool worker calling
+  /// acquire(). Buffer sizes that are a multiple of the page size yield page-aligned buffers.
+  ///
+  /// acquire() must not be called concurrently from several threads; buffers may be released
+  /// from any thread. Memory is returned to the system when the pool is destroyed, which must
+  /// happen after every buffer has been released.
+  class buffer_pool {
+   public:
+    explicit buffer_pool(std::size_t buffer_size, std::size_t buffers_per_chunk = 64, numa_node_id node = any_node)
+        : _buffer_size(buffer_size < sizeof(free_block) ? sizeof(free_block) : buffer_size),
+          _buffers_per_chunk(buffers_per_chunk == 0 ? 1 : buffers_per_chunk),
+          _node(node) {}
+
+    buffer_pool(const buffer_pool &) = delete;
+    auto operator=(const buffer_pool &) -> buffer_pool & = delete;
+
+    ~buffer_pool() {
+      for (auto *chunk : _chunks) deallocate_on_node(chunk, chunk_bytes());
+    }
+
+    [[nodiscard]] auto buffer_size() const noexcept -> std::size_t { return _buffer_size; }
+    [[nodiscard]] auto allocated() const noexcept -> std::size_t { return _chunks.size() * _buffers_per_chunk; }
+
+    /// \brief Borrows a buffer, mapping a new chunk if none is free
+    ///
+    /// Throws std::bad_alloc if no memory can be mapped.
+    [[nodiscard]] auto acquire() -> pooled_buffer {
+      if (!_local) _local = take_released();
+      if (!_local) refill();
+      auto *block = _local;
+      _local = block->next;
+      return {this, reinterpret_cast<std::byte *>(block)};
+    }
+
+   private:
+    friend class pooled_buffer;
+
+    struct free_block {
+      free_block *next;
+    };
+
+    [[nodiscard]] auto chunk_bytes() const noexcept -> std::size_t { return _buffer_size * _buffers_per_chunk; }
+
+    auto release(std::byte *data) noexcept -> void {
+      auto *block = ::new (data) free_block{_released.load(std::memory_order_relaxed)};
+      while (!_released.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+    }
+
+    auto take_released() noexcept -> free_block * { return _released.exchange(nullptr, std::memory_order_acquire); }
+
+    auto refill() -> void {
+      _chunks.reserve(_chunks.size() + 1);
+      auto *chunk = static_cast<std::byte *>(allocate_on_node(chunk_bytes(), _node == any_node ? this_thread_node() : _node));
+      _chunks.push_back(chunk);
+      for (auto i = _buffers_per_chunk; i-- > 0;) {
+        _local = ::new (chunk + i * _buffer_size) free_block{_local};
+      }
+    }
+
+    std::size_t _buffer_size;
+    std::size_t _buffers_per_chunk;
+    numa_node_id _node;
+    free_block *_local = nullptr;
+    std::atomic<free_block *> _released{nullptr};
+    std::vector<void *> _chunks{};
+  };
+
+  inline auto pooled_buffer::size() const noexcept -> std::size_t { return _pool ? _pool->buffer_size() : 0; }
+
+  inline auto pooled_buffer::reset() noexcept -> void {
+    if (_data) _pool->release(std::exchange(_data, nullptr));
+    _pool = nullptr;
+  }
+}  // namespace aio
+
+#endif  // AIO_BUFFER_POOL_HPP
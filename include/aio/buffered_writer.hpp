@@ -0,0 +1,436 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_BUFFERED_WRITER_HPP
+#define AIO_BUFFERED_WRITER_HPP
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "buffer_pool.hpp"
+#include "detail/io_ring.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+#include "io.hpp"
+#include "lane.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Tuning knobs of a buffered_writer
+  struct buffered_writer_options {
+    /// Vectored writes kept in flight at once. Forced to one for descriptors opened with O_APPEND,
+    /// whose writes ignore the offset and would otherwise land in completion order.
+    std::size_t max_in_flight = 4;
+
+    /// Filled buffers gathered into one vectored write.
+    std::size_t buffers_per_write = 16;
+
+    /// Filled buffers that may wait for a write slot before write() starts suspending.
+    std::size_t max_buffered = 64;
+
+    /// Upper bound on how long written bytes sit in a partially filled buffer; zero flushes
+    /// partial buffers only on flush(), sync() or when they fill up.
+    clock::duration flush_interval = clock::duration::zero();
+
+    /// File offset of the first byte written; by default the current end of the file.
+    std::uint64_t offset = current_position;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Write-behind buffered file writer
+  ///
+  /// write() copies into buffers borrowed from a buffer_pool and normally completes without
+  /// suspending. Every buffer that fills up is queued and written behind the caller: up to
+  /// `buffers_per_write` queued buffers go out as one IORING_OP_WRITEV at an explicit offset, with
+  /// up to `max_in_flight` such writes outstanding, so even tiny records reach the device in large
+  /// sequential writes. When `max_buffered` filled buffers are already queued, writers suspend
+  /// (in arrival order) until a write completes; memory use is bounded by
+  /// `max_buffered + max_in_flight * buffers_per_write + 1` buffers.
+  ///
+  /// flush() writes out the partial buffer and resumes once everything accepted so far has been
+  /// written; sync() additionally fsyncs. Short writes are continued. The first write error is
+  /// sticky: data not yet written is dropped, and it is reported by every later operation.
+  ///
+  /// A writer is used from the scheduler given to the constructor. flush() before destroying it;
+  /// no write may be in flight at destruction.
+  class buffered_writer {
+   public:
+    class write_awaiter;
+    class flush_awaiter;
+
+    buffered_writer(scheduler &loop, int fd, buffer_pool &pool, buffered_writer_options options = {})
+        : _loop(&loop),
+          _pool(&pool),
+          _fd(fd),
+          _options(options),
+          _sealed(std::max<std::size_t>(options.max_buffered, 1) + 1) {
+      _options.max_buffered = _sealed.size() - 1;
+      _options.buffers_per_write = std::clamp<std::size_t>(options.buffers_per_write, 1, IOV_MAX);
+      _options.max_in_flight = std::max<std::size_t>(options.max_in_flight, 1);
+      if (const auto flags = ::fcntl(fd, F_GETFL); flags >= 0 && (flags & O_APPEND)) _options.max_in_flight = 1;
+      if (_options.offset == current_position) {
+        struct stat info{};
+        _options.offset = ::fstat(fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+      }
+      _next_offset = _accepted = _options.offset;
+      _slots = std::make_unique<write_slot[]>(_options.max_in_flight);
+      for (std::size_t i = 0; i < _options.max_in_flight; ++i) {
+        _slots[i].complete = &on_written;
+        _slots[i].writer = this;
+        _slots[i].iov.reserve(_options.buffers_per_write);
+        _slots[i].buffers.reserve(_options.buffers_per_write);
+      }
+      _timer.fire = &on_timer;
+      _timer.writer = this;
+    }
+
+    buffered_writer(const buffered_writer &) = delete;
+    auto operator=(const buffered_writer &) -> buffered_writer & = delete;
+
+    ~buffered_writer() {
+      assert(_in_flight == 0 && "buffered_writer destroyed with writes in flight");
+      if (_timer.armed()) _loop->cancel_timer(&_timer);
+    }
+
+    /// \brief Appends `bytes`; completes immediately unless too many filled buffers are queued
+    ///
+    /// The awaitable produces an error if an earlier write failed. `bytes` must stay alive until
+    /// it completes.
+    [[nodiscard]] auto write(std::span<const std::byte> bytes) noexcept -> write_awaiter;
+    [[nodiscard]] auto write(std::string_view text) noexcept -> write_awaiter;
+
+    /// \brief Writes out everything accepted so far and resumes once it has reached the file
+    [[nodiscard]] auto flush() -> flush_awaiter;
+
+    /// \brief flush(), then fsync(2) the file; only its data (and the metadata needed to read it back) if `data_only`
+    [[nodiscard]] auto sync(bool data_only = true) -> task<result<void, std::error_code>>;
+
+    /// \brief Returns the file offset following the last byte accepted by write()
+    [[nodiscard]] auto position() const noexcept -> std::uint64_t { return _accepted; }
+
+    /// \brief Returns the sticky write error, if any
+    [[nodiscard]] auto error() const noexcept -> std::error_code { return _error; }
+
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+   private:
+    struct sealed_buffer {
+      pooled_buffer buffer{};
+      std::size_t size = 0;
+    };
+
+    struct write_slot : detail::io_completion {
+      buffered_writer *writer = nullptr;
+      std::vector<iovec> iov{};
+      std::vector<pooled_buffer> buffers{};
+      std::size_t first_iov = 0;
+      std::uint64_t offset = 0;
+      std::size_t length = 0;
+      std::size_t written = 0;
+      bool busy = false;
+    };
+
+    struct flush_timer : timer_node {
+      buffered_writer *writer = nullptr;
+    };
+
+    // Copies as much of `bytes` as buffer space allows; returns false if it has to wait for a write.
+    auto append(std::span<const std::byte> &bytes) -> bool {
+      while (!bytes.empty()) {
+        if (!_current) {
+          if (_sealed_count == _options.max_buffered) return false;
+          _current = _pool->acquire();
+          _fill = 0;
+        }
+        if (_fill == 0 && _options.flush_interval > clock::duration::zero() && !_timer.armed()) {
+          _loop->add_timer(&_timer, clock::now() + _options.flush_interval);
+        }
+        const auto count = std::min(bytes.size(), _current.size() - _fill);
+        std::memcpy(_current.data() + _fill, bytes.data(), count);
+        _fill += count;
+        _accepted += count;
+        bytes = bytes.subspan(count);
+        if (_fill == _current.size()) seal();
+      }
+      return true;
+    }
+
+    // Queues the current buffer for writing and starts writes if slots are free.
+    auto seal() -> void {
+      if (!_current || _fill == 0) return;
+      _sealed[(_sealed_head + _sealed_count++) % _sealed.size()] = {AIO_MOV(_current), _fill};
+      _fill = 0;
+      start_writes();
+    }
+
+    // Submissions may reap completions re-entrantly; a nested call only asks the outer loop for another round.
+    auto start_writes() -> void {
+      if (_starting) {
+        _start_again = true;
+        return;
+      }
+      _starting = true;
+      do {
+        _start_again = false;
+        while (_sealed_count != 0 && _in_flight < _options.max_in_flight) {
+          if (_error) {
+            drop_sealed();
+            break;
+          }
+          auto &slot = free_slot();
+          slot.iov.clear();
+          slot.first_iov = 0;
+          slot.offset = _next_offset;
+          slot.length = 0;
+          slot.written = 0;
+          while (_sealed_count != 0 && slot.buffers.size() < _options.buffers_per_write) {
+            auto &sealed = _sealed[_sealed_head];
+            slot.iov.push_back({sealed.buffer.data(), sealed.size});
+            slot.length += sealed.size;
+            slot.buffers.push_back(AIO_MOV(sealed.buffer));
+            _sealed_head = (_sealed_head + 1) % _sealed.size();
+            --_sealed_count;
+          }
+          _next_offset += slot.length;
+          slot.busy = true;
+          ++_in_flight;
+          submit(slot);
+        }
+      } while (_start_again);
+      _starting = false;
+    }
+
+    auto submit(write_slot &slot) -> void {
+      auto *sqe = _loop->submission_entry();
+      sqe->opcode = IORING_OP_WRITEV;
+      sqe->fd = _fd;
+      sqe->addr = reinterpret_cast<std::uint64_t>(slot.iov.data() + slot.first_iov);
+      sqe->len = static_cast<std::uint32_t>(slot.iov.size() - slot.first_iov);
+      sqe->off = slot.offset + slot.written;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<detail::io_completion *>(&slot));
+    }
+
+    [[nodiscard]] auto free_slot() noexcept -> write_slot & {
+      for (std::size_t i = 0;; ++i) {
+        if (!_slots[i].busy) return _slots[i];
+      }
+    }
+
+    auto drop_sealed() noexcept -> void {
+      while (_sealed_count != 0) {
+        _sealed[_sealed_head].buffer.reset();
+        _sealed_head = (_sealed_head + 1) % _sealed.size();
+        --_sealed_count;
+      }
+    }
+
+    // Offset up to which every accepted byte has reached the file.
+    [[nodiscard]] auto written_through() const noexcept -> std::uint64_t {
+      auto through = _next_offset;
+      for (std::size_t i = 0; i < _options.max_in_flight; ++i) {
+        if (_slots[i].busy) through = std::min(through, _slots[i].offset);
+      }
+      return through;
+    }
+
+    static auto on_written(detail::io_completion *completion, std::int32_t result, std::uint32_t) noexcept -> void {
+      auto &slot = *static_cast<write_slot *>(completion);
+      auto &self = *slot.writer;
+      if (result > 0) {
+        slot.written += static_cast<std::size_t>(result);
+        if (slot.written < slot.length) {
+          // Short write: skip the iovecs that went out and resubmit the rest.
+          auto skip = static_cast<std::size_t>(result);
+          while (skip >= slot.iov[slot.first_iov].iov_len) skip -= slot.iov[slot.first_iov++].iov_len;
+          auto &partial = slot.iov[slot.first_iov];
+          partial.iov_base = static_cast<std::byte *>(partial.iov_base) + skip;
+          partial.iov_len -= skip;
+          self.submit(slot);
+          return;
+        }
+      } else if (!self._error) {
+        self._error = std::error_code(result < 0 ? -result : EIO, std::system_category());
+      }
+      slot.buffers.clear();
+      slot.busy = false;
+      --self._in_flight;
+      self.start_writes();
+      self.resume_writers();
+      self.resume_flushers();
+    }
+
+    static auto on_timer(timer_node *node) noexcept -> void {
+      auto &self = *static_cast<flush_timer *>(node)->writer;
+      self.seal();
+    }
+
+    inline auto resume_writers() -> void;
+    inline auto resume_flushers() -> void;
+
+    scheduler *_loop;
+    buffer_pool *_pool;
+    int _fd;
+    buffered_writer_options _options;
+    pooled_buffer _current{};
+    std::size_t _fill = 0;
+    std::vector<sealed_buffer> _sealed;
+    std::size_t _sealed_head = 0;
+    std::size_t _sealed_count = 0;
+    std::unique_ptr<write_slot[]> _slots{};
+    std::size_t _in_flight = 0;
+    std::uint64_t _next_offset = 0;
+    std::uint64_t _accepted = 0;
+    std::error_code _error{};
+    bool _starting = false;
+    bool _start_again = false;
+    flush_timer _timer{};
+    detail::node_queue _writers{};
+    detail::node_queue _flushers{};
+  };
+
+  /// \brief Awaitable returned by buffered_writer::write()
+  class buffered_writer::write_awaiter : detail::waiter {
+   public:
+    write_awaiter(buffered_writer &writer, std::span<const std::byte> bytes) noexcept : _writer(&writer), _bytes(bytes) {}
+
+    // Writers queued behind a full buffer keep their turn: later writes line up behind them.
+    [[nodiscard]] auto await_ready() -> bool {
+      if (_writer->_error) return true;
+      return _writer->_writers.empty() && _writer->append(_bytes);
+    }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+      prepare(coro);
+      _writer->_writers.push_back(this);
+    }
+
+    auto await_resume() const -> result<void, std::error_code> {
+      if (_writer->_error) return failure<std::error_code>(_writer->_error);
+      return {};
+    }
+
+   private:
+    friend class buffered_writer;
+
+    buffered_writer *_writer;
+    std::span<const std::byte> _bytes;
+  };
+
+  /// \brief Awaitable returned by buffered_writer::flush()
+  class buffered_writer::flush_awaiter : detail::waiter {
+   public:
+    flush_awaiter(buffered_writer &writer, std::uint64_t target) noexcept : _writer(&writer), _target(target) {}
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool {
+      return _writer->_error || _writer->written_through() >= _target;
+    }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+      prepare(coro);
+      _writer->_flushers.push_back(this);
+    }
+
+    auto await_resume() const -> result<void, std::error_code> {
+      if (_writer->_error) return failure<std::error_code>(_writer->_error);
+      return {};
+    }
+
+   private:
+    friend class buffered_writer;
+
+    buffered_writer *_writer;
+    std::uint64_t _target;
+  };
+
+  inline auto buffered_writer::write(std::span<const std::byte> bytes) noexcept -> write_awaiter { return {*this, bytes}; }
+
+  inline auto buffered_writer::write(std::string_view text) noexcept -> write_awaiter {
+    return {*this, std::as_bytes(std::span(text.data(), text.size()))};
+  }
+
+  inline auto buffered_writer::flush() -> flush_awaiter {
+    // Bytes of writers still queued for buffer space are not accepted yet and not covered.
+    seal();
+    return {*this, _accepted};
+  }
+
+  inline auto buffered_writer::sync(bool data_only) -> task<result<void, std::error_code>> {
+    if (auto flushed = co_await flush(); !flushed) co_return flushed;
+    co_return co_await async_fsync(_fd, data_only);
+  }
+
+  // Feeds queued writers into the buffers freed by a completed write, oldest first.
+  inline auto buffered_writer::resume_writers() -> void {
+    detail::node_queue ready;
+    while (!_writers.empty()) {
+      auto *writer = static_cast<write_awaiter *>(_writers.front());
+      if (!_error && !append(writer->_bytes)) break;
+      ready.push_back(_writers.pop_front());
+    }
+    detail::resume_waiters(ready);
+  }
+
+  inline auto buffered_writer::resume_flushers() -> void {
+    const auto through = written_through();
+    detail::node_queue ready;
+    detail::node_queue waiting;
+    while (auto *node = _flushers.pop_front()) {
+      auto *flusher = static_cast<flush_awaiter *>(node);
+      (_error || through >= flusher->_target ? ready : waiting).push_back(node);
+    }
+    _flushers.splice_back(waiting);
+    detail::resume_waiters(ready);
+  }
+}  // namespace aio
+
+#endif  // AIO_BUFFERED_WRITER_HPP
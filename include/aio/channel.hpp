@@ -0,0 +1,254 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_CHANNEL_HPP
+#define AIO_CHANNEL_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+
+namespace aio {
+  /// \ingroup coroutine
+  ///
+  /// \brief Bounded multi-producer, multi-consumer queue between coroutines
+  ///
+  /// Holds at most `capacity` values in a fixed ring allocated up front. Senders suspend while
+  /// the channel is full and receivers while it is empty, which propagates backpressure from slow
+  /// consumers to producers. Values are handed directly to a suspended receiver when there is
+  /// one, so a channel of capacity zero is a rendezvous point.
+  ///
+  /// Suspended senders and receivers wait on intrusive lists in their own frames. Closing the
+  /// channel releases all of them at once: pending sends fail, and receivers drain the values
+  /// still buffered before seeing the end of the stream. Channels may be used from coroutines on
+  /// any number of threads.
+  template <class T>
+  class channel {
+   public:
+    using value_type = T;
+
+    class send_awaiter;
+    class receive_awaiter;
+
+    explicit channel(std::size_t capacity) : _ring(capacity) {}
+
+    channel(const channel &) = delete;
+    auto operator=(const channel &) -> channel & = delete;
+
+    /// \brief Returns an awaitable that enqueues `value`, suspending while the channel is full
+    ///
+    /// The awaitable produces false if the channel was closed before the value was accepted.
+    [[nodiscard]] auto send(T value) noexcept(std::is_nothrow_move_constructible_v<T>) -> send_awaiter {
+      return send_awaiter(*this, AIO_MOV(value));
+    }
+
+    /// \brief Returns an awaitable that dequeues a value, suspending while the channel is empty
+    ///
+    /// The awaitable produces `std::nullopt` once the channel is closed and drained.
+    [[nodiscard]] auto receive() noexcept -> receive_awaiter { return receive_awaiter(*this); }
+
+    /// \brief Enqueues `value` if that is possible without suspending
+    [[nodiscard]] auto try_send(T &value) -> bool {
+      detail::node_queue wake;
+      bool sent;
+      {
+        std::lock_guard lock(_mutex);
+        sent = !_closed && offer(value, wake);
+      }
+      detail::resume_waiters(wake);
+      return sent;
+    }
+
+    /// \brief Dequeues a value if one is available without suspending
+    [[nodiscard]] auto try_receive() -> std::optional<T> {
+      detail::node_queue wake;
+      std::optional<T> value;
+      {
+        std::lock_guard lock(_mutex);
+        value = take(wake);
+      }
+      detail::resume_waiters(wake);
+      return value;
+    }
+
+    /// \brief Closes the channel, failing pending and future sends and waking all receivers
+    auto close() -> void {
+      detail::node_queue wake;
+      {
+        std::lock_guard lock(_mutex);
+        if (_closed) return;
+        _closed = true;
+        wake.splice_back(_senders);
+        wake.splice_back(_receivers);
+      }
+      detail::resume_waiters(wake);
+    }
+
+    [[nodiscard]] auto closed() const -> bool {
+      std::lock_guard lock(_mutex);
+      return _closed;
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t {
+      std::lock_guard lock(_mutex);
+      return _size;
+    }
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return _ring.size(); }
+
+   private:
+    // Hands `value` to a waiting receiver or buffers it; called with `_mutex` held.
+    auto offer(T &value, detail::node_queue &wake) -> bool {
+      if (auto *node = _receivers.pop_front()) {
+        static_cast<receive_awaiter *>(node)->_value.emplace(AIO_MOV(value));
+        wake.push_back(node);
+        return true;
+      }
+      if (_size == _ring.size()) return false;
+      _ring[(_head + _size) % _ring.size()].emplace(AIO_MOV(value));
+      ++_size;
+      return true;
+    }
+
+    // Takes the oldest value, refilling the ring from a waiting sender; called with `_mutex` held.
+    auto take(detail::node_queue &wake) -> std::optional<T> {
+      std::optional<T> value;
+      if (_size != 0) {
+        value.emplace(AIO_MOV(*_ring[_head]));
+        _ring[_head].reset();
+        _head = (_head + 1) % _ring.size();
+        --_size;
+        if (auto *node = _senders.pop_front()) {
+          auto *sender = static_cast<send_awaiter *>(node);
+          _ring[(_head + _size) % _ring.size()].emplace(AIO_MOV(sender->_value));
+          ++_size;
+          sender->_sent = true;
+          wake.push_back(node);
+        }
+      } else if (auto *node = _senders.pop_front()) {
+        auto *sender = static_cast<send_awaiter *>(node);
+        value.emplace(AIO_MOV(sender->_value));
+        sender->_sent = true;
+        wake.push_back(node);
+      }
+      return value;
+    }
+
+    mutable std::mutex _mutex{};
+    std::vector<std::optional<T>> _ring;
+    std::size_t _head = 0;
+    std::size_t _size = 0;
+    bool _closed = false;
+    detail::node_queue _senders{};
+    detail::node_queue _receivers{};
+  };
+
+  template <class T>
+  class channel<T>::send_awaiter : detail::waiter {
+   public:
+    send_awaiter(channel &ch, T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : _channel(&ch), _value(AIO_MOV(value)) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+      detail::node_queue wake;
+      {
+        std::lock_guard lock(_channel->_mutex);
+        if (_channel->_closed) return false;
+        if (!_channel->offer(_value, wake)) {
+          prepare(coro);
+          _channel->_senders.push_back(this);
+          return true;
+        }
+        _sent = true;
+      }
+      detail::resume_waiters(wake);
+      return false;
+    }
+
+    [[nodiscard]] auto await_resume() const noexcept -> bool { return _sent; }
+
+   private:
+    friend class channel;
+
+    channel *_channel;
+    T _value;
+    bool _sent = false;
+  };
+
+  template <class T>
+  class channel<T>::receive_awaiter : detail::waiter {
+   public:
+    explicit receive_awaiter(channel &ch) noexcept : _channel(&ch) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+      detail::node_queue wake;
+      {
+        std::lock_guard lock(_channel->_mutex);
+        _value = _channel->take(wake);
+        if (!_value && !_channel->_closed) {
+          prepare(coro);
+          _channel->_receivers.push_back(this);
+          return true;
+        }
+      }
+      detail::resume_waiters(wake);
+      return false;
+    }
+
+    [[nodiscard]] auto await_resume() noexcept(std::is_nothrow_move_constructible_v<T>) -> std::optional<T> {
+      return AIO_MOV(_value);
+    }
+
+   private:
+    friend class channel;
+
+    channel *_channel;
+    std::optional<T> _value{};
+  };
+
+  static_assert(aio::awaitable_of<channel<int>::send_awaiter, bool>);
+  static_assert(aio::awaitable_of<channel<int>::receive_awaiter, std::optional<int>>);
+}  // namespace aio
+
+#endif  // AIO_CHANNEL_HPP
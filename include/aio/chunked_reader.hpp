@@ -0,0 +1,318 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_CHUNKED_READER_HPP
+#define AIO_CHUNKED_READER_HPP
+
+#include <linux/io_uring.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "async_generator.hpp"
+#include "buffer_pool.hpp"
+#include "detail/io_ring.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "lane.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief A range of a file read by read_chunks()
+  ///
+  /// The buffer is borrowed from the reader's pool and returns to it when the chunk is destroyed.
+  struct file_chunk {
+    std::uint64_t offset = 0; ///< File offset of the first byte
+    std::size_t size = 0;     ///< Number of valid bytes in `buffer`
+    pooled_buffer buffer{};
+
+    [[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte> { return {buffer.data(), size}; }
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Tuning knobs for read_chunks()
+  struct chunked_read_options {
+    /// First byte to read.
+    std::uint64_t offset = 0;
+
+    /// Number of bytes to read; by default everything up to the end of the file.
+    std::uint64_t length = ~std::uint64_t{0};
+
+    /// Deliver chunks in file order. When false, chunks are delivered as their reads complete.
+    bool ordered = true;
+
+    /// Reads kept in flight at the start.
+    std::size_t initial_depth = 4;
+
+    /// Upper bound on chunks held by the reader, both in flight and completed but not yet delivered.
+    std::size_t max_depth = 64;
+  };
+
+  namespace detail {
+    // Hill-climbing readahead depth: the depth doubles while each doubling still buys noticeably more
+    // throughput and halves when throughput collapses, so the queue grows until the device (or the
+    // consumer) is saturated and no further.
+    class readahead_controller {
+     public:
+      readahead_controller(std::size_t initial, std::size_t maximum) noexcept
+          : _depth(std::clamp<std::size_t>(initial, 1, std::max<std::size_t>(maximum, 1))),
+            _maximum(std::max<std::size_t>(maximum, 1)),
+            _window_start(clock::now()) {}
+
+      [[nodiscard]] auto depth() const noexcept -> std::size_t { return _depth; }
+
+      // Accounts a delivered chunk; re-evaluates the depth once per `depth` chunks.
+      auto delivered(std::size_t bytes) noexcept -> void {
+        _window_bytes += bytes;
+        if (++_window_chunks < _depth) return;
+        const auto now = clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - _window_start).count();
+        if (elapsed > 0) {
+          const auto rate = static_cast<double>(_window_bytes) / elapsed;
+          if (rate > _best_rate * 1.1) {
+            _best_rate = rate;
+            _depth = std::min(_depth * 2, _maximum);
+          } else if (rate < _best_rate * 0.5) {
+            _best_rate = rate;
+            _depth = std::max<std::size_t>(_depth / 2, 1);
+          }
+        }
+        _window_start = now;
+        _window_bytes = 0;
+        _window_chunks = 0;
+      }
+
+     private:
+      std::size_t _depth;
+      std::size_t _maximum;
+      clock::time_point _window_start;
+      std::size_t _window_bytes = 0;
+      std::size_t _window_chunks = 0;
+      double _best_rate = 0;
+    };
+
+    struct chunked_read_state;
+
+    // One read slot. While its read is in flight the slot keeps the state alive, so a generator
+    // destroyed mid-read does not free memory the kernel is still writing to.
+    struct chunk_read : io_completion {
+      std::shared_ptr<chunked_read_state> keep_alive{};
+      pooled_buffer buffer{};
+      std::uint64_t offset = 0;
+      std::uint64_t sequence = 0;
+      std::size_t want = 0;
+      std::size_t filled = 0;
+      std::int32_t last = 0;
+      bool in_flight = false;
+    };
+
+    struct chunked_read_state {
+      explicit chunked_read_state(std::size_t slots) : reads(slots), by_sequence(slots, nullptr), ready(slots, nullptr) {
+        free.reserve(slots);
+        for (auto &read : reads) free.push_back(&read);
+      }
+
+      auto push_ready(chunk_read *read) noexcept -> void {
+        ready[(ready_head + ready_count++) % ready.size()] = read;
+      }
+
+      auto pop_ready() noexcept -> chunk_read * {
+        if (ready_count == 0) return nullptr;
+        auto *read = ready[ready_head];
+        ready_head = (ready_head + 1) % ready.size();
+        --ready_count;
+        return read;
+      }
+
+      std::vector<chunk_read> reads;
+      std::vector<chunk_read *> free{};
+      std::vector<chunk_read *> by_sequence;
+      std::vector<chunk_read *> ready;
+      std::size_t ready_head = 0;
+      std::size_t ready_count = 0;
+      schedule_node waiter{};
+      bool waiting = false;
+      bool closed = false;
+    };
+
+    // Marks the state closed when the generator's frame goes away, so reads still in flight
+    // complete without touching the waiter of a coroutine that no longer exists.
+    struct chunked_read_closer {
+      chunked_read_state &state;
+
+      ~chunked_read_closer() {
+        state.closed = true;
+        state.waiting = false;
+      }
+    };
+
+    inline auto on_chunk_read(io_completion *completion, std::int32_t result, std::uint32_t) noexcept -> void {
+      auto *read = static_cast<chunk_read *>(completion);
+      auto keep_alive = AIO_MOV(read->keep_alive);
+      read->in_flight = false;
+      read->last = result;
+      if (result > 0) read->filled += static_cast<std::size_t>(result);
+      auto &state = *keep_alive;
+      if (state.closed) return;  // the generator is gone; the last completion to get here frees the state
+      state.push_ready(read);
+      if (state.waiting) {
+        state.waiting = false;
+        scheduler::current()->enqueue(&state.waiter);
+      }
+    }
+
+    inline auto submit_chunk_read(const std::shared_ptr<chunked_read_state> &state, chunk_read &read, int fd) -> void {
+      read.complete = &on_chunk_read;
+      read.keep_alive = state;
+      read.in_flight = true;
+      auto *sqe = scheduler::current()->submission_entry();
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<std::uint64_t>(read.buffer.data() + read.filled);
+      sqe->len = static_cast<std::uint32_t>(read.want - read.filled);
+      sqe->off = read.offset + read.filled;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<io_completion *>(&read));
+    }
+
+    // Suspends the reader until the next read completes.
+    struct chunk_completion_awaiter {
+      chunked_read_state &state;
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return state.ready_count != 0; }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+        state.waiter.handle = coro;
+        state.waiter.lane = coro.promise().lane();
+        state.waiter.deadline = coro.promise().deadline();
+        state.waiting = true;
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+    };
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Reads a range of `fd` as a stream of pool-sized chunks with many reads in flight
+  ///
+  /// The range is split into chunks of `pool.buffer_size()` bytes, each read into a buffer
+  /// borrowed from `pool` with IORING_OP_READ. The number of chunks held by the reader (in flight
+  /// plus completed but undelivered) starts at `initial_depth` and adapts to the observed
+  /// throughput, up to `max_depth`: it keeps doubling while that yields more bytes per second. A
+  /// single sequential stream thereby reaches the queue depth the device needs.
+  ///
+  /// With `ordered`, chunks are delivered by ascending offset; otherwise as they complete. Short
+  /// reads are continued, and a read failure is thrown as `std::system_error` from next(). The
+  /// stream ends at the end of the range or of the file, whichever comes first.
+  ///
+  /// Must be consumed on a scheduler. `fd` and `pool` must outlive the generator and any reads it
+  /// still has in flight when it is destroyed; chunks may be kept and released on any thread. For
+  /// O_DIRECT descriptors, use a page-multiple buffer size and an aligned offset.
+  [[nodiscard]] inline auto read_chunks(int fd, buffer_pool &pool, chunked_read_options options = {})
+      -> async_generator<file_chunk> {
+    assert(scheduler::current() && "read_chunks() must be consumed on a scheduler");
+    auto end = options.length == ~std::uint64_t{0} ? ~std::uint64_t{0} : options.offset + options.length;
+    if (struct stat info{}; ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+      end = std::min(end, static_cast<std::uint64_t>(info.st_size));
+    }
+    const auto chunk_size = pool.buffer_size();
+    const auto slots = std::max<std::size_t>(options.max_depth, 1);
+    auto state = std::make_shared<detail::chunked_read_state>(slots);
+    const detail::chunked_read_closer closer{*state};
+    detail::readahead_controller readahead(options.initial_depth, slots);
+
+    std::uint64_t next_offset = options.offset;
+    std::uint64_t next_issue = 0;
+    std::uint64_t next_delivery = 0;
+    std::size_t held = 0;
+
+    while (true) {
+      while (held < readahead.depth() && next_offset < end) {
+        auto *read = state->free.back();
+        state->free.pop_back();
+        read->buffer = pool.acquire();
+        read->offset = next_offset;
+        read->sequence = next_issue++;
+        read->want = static_cast<std::size_t>(std::min<std::uint64_t>(chunk_size, end - next_offset));
+        read->filled = 0;
+        if (options.ordered) state->by_sequence[read->sequence % slots] = read;
+        next_offset += read->want;
+        ++held;
+        detail::submit_chunk_read(state, *read, fd);
+      }
+      if (held == 0) break;
+
+      // Drain completions; continue short reads that have not hit the end of the file.
+      while (auto *read = state->pop_ready()) {
+        if (read->last > 0 && read->filled < read->want) detail::submit_chunk_read(state, *read, fd);
+        else if (read->last < 0) throw std::system_error(-read->last, std::system_category(), "read_chunks");
+      }
+
+      detail::chunk_read *deliver = nullptr;
+      if (options.ordered) {
+        auto *candidate = state->by_sequence[next_delivery % slots];
+        if (candidate && candidate->sequence == next_delivery && !candidate->in_flight) deliver = candidate;
+      } else {
+        for (auto &read : state->reads) {
+          if (read.buffer && !read.in_flight && (!deliver || read.sequence < deliver->sequence)) deliver = &read;
+        }
+      }
+      if (!deliver) {
+        co_await detail::chunk_completion_awaiter{*state};
+        continue;
+      }
+
+      if (deliver->sequence == next_delivery) ++next_delivery;
+      if (deliver->filled < deliver->want) end = std::min(end, deliver->offset + deliver->filled);
+      file_chunk chunk{deliver->offset, deliver->filled, AIO_MOV(deliver->buffer)};
+      if (options.ordered) state->by_sequence[deliver->sequence % slots] = nullptr;
+      state->free.push_back(deliver);
+      --held;
+      readahead.delivered(chunk.size);
+      if (chunk.size != 0) co_yield AIO_MOV(chunk);
+    }
+  }
+}  // namespace aio
+
+#endif  // AIO_CHUNKED_READER_HPP
@@ -0,0 +1,247 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_EPOCH_HPP
+#define AIO_DETAIL_EPOCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace aio::detail {
+  // Epoch-based memory reclamation for lock-free readers.
+  //
+  // Readers pin the current epoch for the duration of a read-side critical section; writers retire
+  // unlinked objects instead of deleting them. An object retired in epoch e is freed once the global
+  // epoch has reached e + 2, which requires every pinned thread to have observed a later epoch, so no
+  // reader can still hold a pointer to it. Pinning costs one store and one fence and never blocks.
+  //
+  // A thread gets one participant record per domain it uses, found through a small thread-local
+  // table keyed by domain. Destroying a domain frees everything still retired in it; it must not be
+  // pinned or retired into concurrently.
+  class epoch_domain {
+    struct participant;
+
+   public:
+    using deleter_type = void (*)(void *) noexcept;
+
+    epoch_domain() {
+      auto &r = registry();
+      std::lock_guard lock(r.mutex);
+      _id = ++r.last_id;
+      r.live.push_back(this);
+    }
+
+    epoch_domain(const epoch_domain &) = delete;
+    auto operator=(const epoch_domain &) -> epoch_domain & = delete;
+
+    ~epoch_domain() {
+      {
+        auto &r = registry();
+        std::lock_guard lock(r.mutex);
+        std::erase(r.live, this);
+      }
+      for (auto &item : _orphans) item.deleter(item.object);
+      auto *p = _participants.load(std::memory_order_acquire);
+      while (p) {
+        for (auto &item : p->limbo) item.deleter(item.object);
+        delete std::exchange(p, p->next);
+      }
+    }
+
+    class guard {
+     public:
+      explicit guard(epoch_domain &domain) noexcept : _participant(&domain.local()) {
+        if (_participant->nesting++ == 0) {
+          _participant->epoch.store(domain._epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+      }
+
+      guard(const guard &) = delete;
+      auto operator=(const guard &) -> guard & = delete;
+
+      ~guard() {
+        if (--_participant->nesting == 0) _participant->epoch.store(inactive, std::memory_order_release);
+      }
+
+     private:
+      participant *_participant;
+    };
+
+    [[nodiscard]] static auto global() noexcept -> epoch_domain & {
+      static epoch_domain domain;
+      return domain;
+    }
+
+    [[nodiscard]] auto pin() noexcept -> guard { return guard(*this); }
+
+    // Frees `object` with `deleter` once no pinned reader can still observe it.
+    auto retire(void *object, deleter_type deleter) -> void {
+      auto &self = local();
+      self.limbo.push_back({object, deleter, _epoch.load(std::memory_order_acquire)});
+      if (self.limbo.size() >= collect_threshold) collect(self);
+    }
+
+   private:
+    friend class guard;
+
+    static constexpr std::uint64_t inactive = ~std::uint64_t{0};
+    static constexpr std::size_t collect_threshold = 64;
+
+    struct retired {
+      void *object;
+      deleter_type deleter;
+      std::uint64_t epoch;
+    };
+
+    struct participant {
+      std::atomic<std::uint64_t> epoch{inactive};
+      std::atomic<bool> in_use{true};
+      participant *next = nullptr;
+      unsigned nesting = 0;
+      std::vector<retired> limbo{};
+    };
+
+    // The domains alive in the process. Threads exiting after a domain was destroyed find it missing
+    // here and leave its (already freed) records alone.
+    struct domain_registry {
+      std::mutex mutex{};
+      std::vector<epoch_domain *> live{};
+      std::uint64_t last_id = 0;
+    };
+
+    struct registration {
+      epoch_domain *domain;
+      std::uint64_t id;
+      participant *record;
+    };
+
+    // Releases the calling thread's participant records (and hands their limbo to their domains) on exit.
+    struct thread_registrations {
+      std::vector<registration> entries{};
+
+      ~thread_registrations() {
+        auto &r = registry();
+        std::lock_guard lock(r.mutex);
+        for (auto &entry : entries) {
+          if (alive(entry, r)) entry.domain->release(*entry.record);
+        }
+      }
+    };
+
+    [[nodiscard]] static auto registry() noexcept -> domain_registry & {
+      static domain_registry r;
+      return r;
+    }
+
+    // Whether the domain `entry` was made for still exists; the id guards against a new domain at
+    // the same address. Only dereferences domains found in the registry.
+    [[nodiscard]] static auto alive(const registration &entry, const domain_registry &r) noexcept -> bool {
+      return std::find(r.live.begin(), r.live.end(), entry.domain) != r.live.end() && entry.domain->_id == entry.id;
+    }
+
+    auto release(participant &record) -> void {
+      {
+        std::lock_guard lock(_orphans_mutex);
+        _orphans.insert(_orphans.end(), record.limbo.begin(), record.limbo.end());
+      }
+      record.limbo.clear();
+      record.in_use.store(false, std::memory_order_release);
+    }
+
+    auto local() noexcept -> participant & {
+      static thread_local thread_registrations registrations;
+      for (auto &entry : registrations.entries) {
+        if (entry.domain == this && entry.id == _id) return *entry.record;
+      }
+      auto &r = registry();
+      {
+        // Drop the entries of destroyed domains before adding this one.
+        std::lock_guard lock(r.mutex);
+        std::erase_if(registrations.entries, [&](const registration &entry) { return !alive(entry, r); });
+      }
+      registrations.entries.push_back({this, _id, acquire_participant()});
+      return *registrations.entries.back().record;
+    }
+
+    auto acquire_participant() -> participant * {
+      for (auto *p = _participants.load(std::memory_order_acquire); p; p = p->next) {
+        bool expected = false;
+        if (p->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) return p;
+      }
+      auto *p = new participant();
+      p->next = _participants.load(std::memory_order_relaxed);
+      while (!_participants.compare_exchange_weak(p->next, p, std::memory_order_release, std::memory_order_relaxed)) {
+      }
+      return p;
+    }
+
+    auto try_advance() noexcept -> std::uint64_t {
+      auto current = _epoch.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (auto *p = _participants.load(std::memory_order_acquire); p; p = p->next) {
+        const auto observed = p->epoch.load(std::memory_order_acquire);
+        if (observed != inactive && observed != current) return current;
+      }
+      _epoch.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel);
+      return _epoch.load(std::memory_order_acquire);
+    }
+
+    auto collect(participant &self) -> void {
+      const auto epoch = try_advance();
+      const auto reclaim = [epoch](std::vector<retired> &list) {
+        std::size_t kept = 0;
+        for (auto &item : list) {
+          if (item.epoch + 2 <= epoch) {
+            item.deleter(item.object);
+          } else {
+            list[kept++] = item;
+          }
+        }
+        list.resize(kept);
+      };
+      reclaim(self.limbo);
+      std::unique_lock lock(_orphans_mutex, std::try_to_lock);
+      if (lock.owns_lock()) reclaim(_orphans);
+    }
+
+    std::uint64_t _id = 0;
+    std::atomic<std::uint64_t> _epoch{0};
+    std::atomic<participant *> _participants{nullptr};
+    std::mutex _orphans_mutex{};
+    std::vector<retired> _orphans{};
+  };
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_EPOCH_HPP
@@ -0,0 +1,174 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_FRAME_ALLOCATOR_HPP
+#define AIO_DETAIL_FRAME_ALLOCATOR_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "../numa.hpp"
+
+namespace aio::detail {
+  // Recycling allocator for coroutine frames.
+  //
+  // Frames up to max_size bytes are served from per-thread free lists segregated by power-of-two size
+  // class. Lists are refilled from chunks mapped on the calling thread's home node (see
+  // aio::bind_this_thread), so frames created by a node's workers live in that node's memory. A frame
+  // freed on another thread joins that thread's list; a list that grows past two batches hands a batch
+  // to a global depot, where threads that run dry take batches from before mapping new chunks. Frames
+  // allocated on one thread and freed on another thus flow back through the depot instead of piling
+  // up, and memory stays bounded by the peak number of live frames. Chunks are never unmapped; the
+  // free lists of an exiting thread are handed to the depot as well.
+  class frame_allocator {
+   public:
+    static constexpr std::size_t min_size = 64;
+    static constexpr std::size_t max_size = 4096;
+    static constexpr std::size_t chunk_size = 256 * 1024;
+
+    [[nodiscard]] static auto allocate(std::size_t size) -> void * {
+      if (size > max_size) return ::operator new(size);
+      const auto c = size_class(size);
+      auto &list = local().lists[c];
+      if (!list.head) refill(c, list);
+      auto *block = list.head;
+      list.head = block->next;
+      --list.count;
+      return block;
+    }
+
+    static auto deallocate(void *memory, std::size_t size) noexcept -> void {
+      if (size > max_size) {
+        ::operator delete(memory);
+        return;
+      }
+      const auto c = size_class(size);
+      auto &list = local().lists[c];
+      list.head = ::new (memory) free_block{list.head};
+      if (++list.count > 2 * batch_size(c)) spill(c, list);
+    }
+
+   private:
+    static constexpr std::size_t class_count = std::bit_width(max_size / min_size);
+
+    // A free block; the first block of a batch in the depot also links the next batch.
+    struct free_block {
+      free_block *next;
+      free_block *next_batch = nullptr;
+      std::size_t batch_count = 0;
+    };
+
+    static_assert(sizeof(free_block) <= min_size);
+
+    struct free_list {
+      free_block *head = nullptr;
+      std::size_t count = 0;
+    };
+
+    struct depot {
+      std::mutex mutex{};
+      std::array<free_block *, class_count> batches{};
+    };
+
+    struct thread_cache {
+      std::array<free_list, class_count> lists{};
+
+      ~thread_cache() {
+        for (std::size_t c = 0; c < class_count; ++c) {
+          if (lists[c].head) give_batch(c, lists[c].head, lists[c].count);
+        }
+      }
+    };
+
+    [[nodiscard]] static constexpr auto size_class(std::size_t size) noexcept -> std::size_t {
+      return size <= min_size ? 0 : static_cast<std::size_t>(std::bit_width((size - 1) / min_size));
+    }
+
+    // Blocks moved to or from the depot at once: a quarter chunk's worth.
+    [[nodiscard]] static constexpr auto batch_size(std::size_t c) noexcept -> std::size_t {
+      return chunk_size / 4 / (min_size << c);
+    }
+
+    [[nodiscard]] static auto local() noexcept -> thread_cache & {
+      static thread_local thread_cache cache;
+      return cache;
+    }
+
+    [[nodiscard]] static auto global_depot() noexcept -> depot & {
+      static depot d;
+      return d;
+    }
+
+    static auto give_batch(std::size_t c, free_block *first, std::size_t count) noexcept -> void {
+      auto &d = global_depot();
+      std::lock_guard lock(d.mutex);
+      first->next_batch = d.batches[c];
+      first->batch_count = count;
+      d.batches[c] = first;
+    }
+
+    // Detaches the batch behind the head of `list`, which is the block freed last and still hot in
+    // cache, and hands it to the depot.
+    static auto spill(std::size_t c, free_list &list) noexcept -> void {
+      const auto count = batch_size(c);
+      auto *first = list.head->next;
+      auto *last = first;
+      for (std::size_t i = 1; i < count; ++i) last = last->next;
+      list.head->next = last->next;
+      list.count -= count;
+      last->next = nullptr;
+      give_batch(c, first, count);
+    }
+
+    static auto refill(std::size_t c, free_list &list) -> void {
+      {
+        auto &d = global_depot();
+        std::lock_guard lock(d.mutex);
+        if (auto *batch = d.batches[c]) {
+          d.batches[c] = batch->next_batch;
+          list.head = batch;
+          list.count = batch->batch_count;
+          return;
+        }
+      }
+      const auto block_size = min_size << c;
+      auto *chunk = static_cast<std::byte *>(allocate_on_node(chunk_size, aio::this_thread_node()));
+      for (auto offset = chunk_size; offset >= block_size; offset -= block_size) {
+        list.head = ::new (chunk + offset - block_size) free_block{list.head};
+      }
+      list.count = chunk_size / block_size;
+    }
+  };
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_FRAME_ALLOCATOR_HPP
@@ -0,0 +1,67 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_FUTEX_HPP
+#define AIO_DETAIL_FUTEX_HPP
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace aio::detail {
+  static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+  // Blocks while `*word == expected`, for at most `timeout` if given. Spurious returns are allowed.
+  // `shared` selects a futex usable across processes (e.g. in a shared memory mapping).
+  inline auto futex_wait(std::atomic<std::uint32_t> *word, std::uint32_t expected,
+                         std::optional<std::chrono::nanoseconds> timeout = std::nullopt, bool shared = false) noexcept -> void {
+    timespec ts{};
+    if (timeout) {
+      const auto ns = timeout->count() < 0 ? 0 : timeout->count();
+      ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+      ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+    }
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected,
+            timeout ? &ts : nullptr, nullptr, 0);
+  }
+
+  // Wakes up to `count` threads blocked in futex_wait on `word`.
+  inline auto futex_wake(std::atomic<std::uint32_t> *word, int count = 1, bool shared = false) noexcept -> void {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, count, nullptr,
+            nullptr, 0);
+  }
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_FUTEX_HPP
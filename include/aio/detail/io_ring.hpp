@@ -0,0 +1,245 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_IO_RING_HPP
+#define AIO_DETAIL_IO_RING_HPP
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace aio::detail {
+  // Target of an io_uring completion: the CQE's user_data points at one of these.
+  struct io_completion {
+    using callback_type = void (*)(io_completion *, std::int32_t result, std::uint32_t flags) noexcept;
+
+    callback_type complete = nullptr;
+  };
+
+  // Minimal io_uring instance driven with raw system calls.
+  //
+  // Submission entries are filled in place and published lazily: submit() hands everything queued
+  // since the last call to the kernel in one io_uring_enter, optionally waiting for completions.
+  // Not thread-safe; each scheduler owns at most one ring and uses it from the thread running it.
+  class io_ring {
+   public:
+    explicit io_ring(unsigned entries = 256) {
+      // Kernels reject setup flags newer than themselves with EINVAL; drop the optional ones in turn
+      // (SUBMIT_ALL needs 5.18, CLAMP 5.6). SINGLE_ISSUER is not used: it binds the ring to the
+      // first thread that submits, and a scheduler may be run by different threads over its life.
+      constexpr std::uint32_t flag_sets[] = {
+          IORING_SETUP_CLAMP | IORING_SETUP_SUBMIT_ALL,
+          IORING_SETUP_CLAMP,
+          0,
+      };
+      io_uring_params params{};
+      for (const auto flags : flag_sets) {
+        params = {};
+        params.flags = flags;
+        _fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (_fd >= 0 || errno != EINVAL) break;
+      }
+      if (_fd < 0) throw std::system_error(errno, std::system_category(), "io_uring_setup");
+      _features = params.features;
+      try {
+        map_rings(params);
+      } catch (...) {
+        release();
+        throw;
+      }
+    }
+
+    io_ring(const io_ring &) = delete;
+    auto operator=(const io_ring &) -> io_ring & = delete;
+
+    ~io_ring() { release(); }
+
+    // Returns a zeroed submission entry, flushing queued entries to the kernel first if the ring is full.
+    [[nodiscard]] auto get_sqe() -> io_uring_sqe * {
+      while (_local_tail - _sq_head->load(std::memory_order_acquire) == _sq_entries) {
+        submit(0, std::nullopt);
+        // The kernel refuses new work while its completion queue is overflowing.
+        if (_local_tail - _sq_head->load(std::memory_order_acquire) == _sq_entries) reap();
+      }
+      auto *sqe = &_sqes[_local_tail & _sq_mask];
+      std::memset(sqe, 0, sizeof(*sqe));
+      ++_local_tail;
+      return sqe;
+    }
+
+    // Entries queued but not yet consumed by the kernel, including any a short submit left behind.
+    [[nodiscard]] auto pending_submissions() const noexcept -> std::uint32_t {
+      return _local_tail - _sq_head->load(std::memory_order_acquire);
+    }
+
+    // Publishes queued entries and, if `wait_for` is non-zero, blocks until that many completions
+    // are available or `timeout` (if any) expires. Interruptions and timeouts are not errors.
+    auto submit(unsigned wait_for, std::optional<std::chrono::nanoseconds> timeout) -> void {
+      unsigned flags = 0;
+      __kernel_timespec ts{};
+      io_uring_getevents_arg arg{};
+      void *argp = nullptr;
+      std::size_t argsz = 0;
+      if (wait_for != 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout) {
+          const auto ns = std::max<std::int64_t>(timeout->count(), 0);
+          ts.tv_sec = ns / 1'000'000'000;
+          ts.tv_nsec = ns % 1'000'000'000;
+          if (_features & IORING_FEAT_EXT_ARG) {
+            arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+            argp = &arg;
+            argsz = sizeof(arg);
+            flags |= IORING_ENTER_EXT_ARG;
+          } else {
+            // Pre-5.11 kernels: a timeout request completing with no target bounds the wait instead.
+            auto *sqe = get_sqe();
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->addr = reinterpret_cast<std::uint64_t>(&ts);
+            sqe->len = 1;
+          }
+        }
+      }
+      _sq_tail->store(_local_tail, std::memory_order_release);
+      auto to_submit = pending_submissions();
+      if (to_submit == 0 && wait_for == 0) return;
+      while (true) {
+        const auto rc = ::syscall(__NR_io_uring_enter, _fd, to_submit, wait_for, flags, argp, argsz);
+        if (rc < 0) {
+          // EBUSY/EAGAIN signal a completion queue overflow, which the caller resolves by reaping.
+          if (errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+            throw std::system_error(errno, std::system_category(), "io_uring_enter");
+          }
+          return;
+        }
+        // Without IORING_SETUP_SUBMIT_ALL the kernel stops at the first entry that fails to submit,
+        // posting its completion and returning early (without waiting); hand it the rest.
+        if (rc == 0 || static_cast<std::uint32_t>(rc) >= to_submit) return;
+        to_submit = pending_submissions();
+        if (to_submit == 0) return;
+      }
+    }
+
+    // Invokes the completion target of every available completion; returns how many were reaped.
+    auto reap() noexcept -> unsigned {
+      auto head = _cq_head->load(std::memory_order_relaxed);
+      const auto tail = _cq_tail->load(std::memory_order_acquire);
+      unsigned count = 0;
+      for (; head != tail; ++head, ++count) {
+        const auto &cqe = _cqes[head & _cq_mask];
+        const auto user_data = cqe.user_data;
+        const auto res = cqe.res;
+        const auto flags = cqe.flags;
+        // Release the slot before running the callback, which may submit and reap recursively.
+        _cq_head->store(head + 1, std::memory_order_release);
+        if (auto *target = reinterpret_cast<io_completion *>(user_data)) target->complete(target, res, flags);
+      }
+      return count;
+    }
+
+    [[nodiscard]] auto has_completions() const noexcept -> bool {
+      return _cq_head->load(std::memory_order_relaxed) != _cq_tail->load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] auto fd() const noexcept -> int { return _fd; }
+
+   private:
+    auto map(std::size_t size, std::uint64_t offset) -> void * {
+      auto *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, static_cast<off_t>(offset));
+      if (p == MAP_FAILED) throw std::system_error(errno, std::system_category(), "io_uring mmap");
+      return p;
+    }
+
+    auto map_rings(const io_uring_params &params) -> void {
+      _sq_size = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+      _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      if (_features & IORING_FEAT_SINGLE_MMAP) _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+
+      _sq_ptr = map(_sq_size, IORING_OFF_SQ_RING);
+      _cq_ptr = (_features & IORING_FEAT_SINGLE_MMAP) ? _sq_ptr : map(_cq_size, IORING_OFF_CQ_RING);
+      _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+      _sqes = static_cast<io_uring_sqe *>(map(_sqes_size, IORING_OFF_SQES));
+
+      auto *sq = static_cast<char *>(_sq_ptr);
+      _sq_head = reinterpret_cast<std::atomic<std::uint32_t> *>(sq + params.sq_off.head);
+      _sq_tail = reinterpret_cast<std::atomic<std::uint32_t> *>(sq + params.sq_off.tail);
+      _sq_mask = *reinterpret_cast<std::uint32_t *>(sq + params.sq_off.ring_mask);
+      _sq_entries = params.sq_entries;
+      auto *array = reinterpret_cast<std::uint32_t *>(sq + params.sq_off.array);
+      for (std::uint32_t i = 0; i < _sq_entries; ++i) array[i] = i;
+
+      auto *cq = static_cast<char *>(_cq_ptr);
+      _cq_head = reinterpret_cast<std::atomic<std::uint32_t> *>(cq + params.cq_off.head);
+      _cq_tail = reinterpret_cast<std::atomic<std::uint32_t> *>(cq + params.cq_off.tail);
+      _cq_mask = *reinterpret_cast<std::uint32_t *>(cq + params.cq_off.ring_mask);
+      _cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+      _local_tail = _sq_tail->load(std::memory_order_relaxed);
+    }
+
+    // Unmaps whatever was mapped and closes the ring; also the cleanup of a failed constructor.
+    auto release() noexcept -> void {
+      if (_sqes) ::munmap(_sqes, _sqes_size);
+      if (_cq_ptr && _cq_ptr != _sq_ptr) ::munmap(_cq_ptr, _cq_size);
+      if (_sq_ptr) ::munmap(_sq_ptr, _sq_size);
+      if (_fd >= 0) ::close(_fd);
+    }
+
+    int _fd = -1;
+    std::uint32_t _features = 0;
+    void *_sq_ptr = nullptr;
+    void *_cq_ptr = nullptr;
+    std::size_t _sq_size = 0;
+    std::size_t _cq_size = 0;
+    std::size_t _sqes_size = 0;
+    io_uring_sqe *_sqes = nullptr;
+    std::atomic<std::uint32_t> *_sq_head = nullptr;
+    std::atomic<std::uint32_t> *_sq_tail = nullptr;
+    std::uint32_t _sq_mask = 0;
+    std::uint32_t _sq_entries = 0;
+    std::uint32_t _local_tail = 0;
+    std::atomic<std::uint32_t> *_cq_head = nullptr;
+    std::atomic<std::uint32_t> *_cq_tail = nullptr;
+    std::uint32_t _cq_mask = 0;
+    io_uring_cqe *_cqes = nullptr;
+  };
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_IO_RING_HPP
@@ -0,0 +1,282 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_PARALLEL_HPP
+#define AIO_DETAIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+
+#include "../result.hpp"
+#include "../scheduler.hpp"
+#include "../task.hpp"
+#include "macros.hpp"
+#include "schedule_node.hpp"
+
+namespace aio {
+  /// \ingroup scheduling
+  ///
+  /// \brief Chunking options for thread_pool::parallel_for and thread_pool::parallel_reduce
+  struct parallel_options {
+    /// Iterations run between two split decisions. Zero picks a grain from the range size and
+    /// the number of workers.
+    std::size_t grain = 0;
+  };
+
+  namespace detail {
+    // Completion and error bookkeeping shared by the jobs of one offloaded operation. Lives in the
+    // awaiter, i.e. in the suspended caller's frame, and resumes the caller on the loop it came from.
+    template <class Pool>
+    class offload_state {
+     public:
+      explicit offload_state(Pool &pool) noexcept : _pool(&pool) {}
+
+      [[nodiscard]] auto pool() const noexcept -> Pool & { return *_pool; }
+      [[nodiscard]] auto failed() const noexcept -> bool { return _failed.load(std::memory_order_relaxed); }
+      [[nodiscard]] auto error() const noexcept -> const std::exception_ptr & { return _error; }
+
+      template <class Promise>
+      auto start(std::coroutine_handle<Promise> caller) noexcept -> void {
+        _resume.handle = caller;
+        if constexpr (std::derived_from<Promise, task_promise_base>) {
+          _resume.lane = caller.promise().lane();
+          _resume.deadline = caller.promise().deadline();
+        }
+        _origin_scheduler = scheduler::current();
+        _origin_pool = Pool::current();
+      }
+
+      auto add_job() noexcept -> void { _pending.fetch_add(1, std::memory_order_relaxed); }
+
+      auto fail(std::exception_ptr error) noexcept -> void {
+        if (!_failed.exchange(true, std::memory_order_acq_rel)) _error = AIO_MOV(error);
+      }
+
+      // Called once by every job when it is done; the last one resumes the caller.
+      auto finish_job() noexcept -> void {
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        if (_origin_scheduler) {
+          _origin_scheduler->enqueue(&_resume);
+        } else if (_origin_pool) {
+          _origin_pool->enqueue(&_resume);
+        } else {
+          _resume.handle.resume();
+        }
+      }
+
+     private:
+      Pool *_pool;
+      scheduler *_origin_scheduler = nullptr;
+      Pool *_origin_pool = nullptr;
+      schedule_node _resume{};
+      std::atomic<std::size_t> _pending{0};
+      std::atomic<bool> _failed{false};
+      std::exception_ptr _error{};
+    };
+
+    template <class Pool, std::integral Index>
+    auto pick_grain(const Pool &pool, Index first, Index last, parallel_options options) noexcept -> std::size_t {
+      if (options.grain != 0) return options.grain;
+      if (!(first < last)) return 1;
+      const auto size = static_cast<std::size_t>(last - first);
+      return std::max<std::size_t>(1, size / (std::max<std::size_t>(1, pool.thread_count()) * 64));
+    }
+    template <class Pool, class F>
+    class run_awaitable {
+     public:
+      using value_type = std::invoke_result_t<F &>;
+      using result_type = aio::result<value_type, std::exception_ptr>;
+
+      run_awaitable(Pool &pool, F fn) : _state(pool), _fn(AIO_MOV(fn)) {}
+
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> caller) noexcept -> void {
+        _state.start(caller);
+        _state.add_job();
+        _state.pool().spawn(job(this));
+      }
+
+      auto await_resume() -> result_type {
+        if (_state.failed()) return result_type(failure<std::exception_ptr>(_state.error()));
+        if constexpr (std::is_void_v<value_type>) {
+          return result_type();
+        } else {
+          return result_type(std::in_place, AIO_MOV(*_value));
+        }
+      }
+
+     private:
+      static auto job(run_awaitable *self) -> task<void> {
+        try {
+          if constexpr (std::is_void_v<value_type>) {
+            std::invoke(self->_fn);
+          } else {
+            self->_value.emplace(std::invoke(self->_fn));
+          }
+        } catch (...) {
+          self->_state.fail(std::current_exception());
+        }
+        self->_state.finish_job();
+        co_return;
+      }
+
+      offload_state<Pool> _state;
+      F _fn;
+      std::optional<std::conditional_t<std::is_void_v<value_type>, char, value_type>> _value{};
+    };
+
+    // Lazy binary splitting: a job runs its range one grain at a time and, before each grain, splits
+    // off the upper half of what is left whenever its worker has nothing queued locally (a sign that
+    // other workers may be starving). Splits therefore only happen when there is someone to take them.
+    template <class Pool, std::integral Index, class Step>
+    auto split_range(offload_state<Pool> &state, Index first, Index last, std::size_t grain, Step &step) -> task<void> {
+      try {
+        while (first < last && !state.failed()) {
+          const auto remaining = static_cast<std::size_t>(last - first);
+          if (remaining > grain && state.pool().local_backlog() == 0) {
+            const auto middle = static_cast<Index>(first + static_cast<Index>(remaining / 2));
+            state.add_job();
+            state.pool().spawn(split_range(state, middle, last, grain, step));
+            last = middle;
+            continue;
+          }
+          const auto end = static_cast<Index>(first + static_cast<Index>(std::min(grain, remaining)));
+          step(first, end);
+          first = end;
+        }
+      } catch (...) {
+        state.fail(std::current_exception());
+      }
+      state.finish_job();
+      co_return;
+    }
+
+    template <class Pool, std::integral Index, class Body>
+    class parallel_for_awaitable {
+     public:
+      using result_type = aio::result<void, std::exception_ptr>;
+
+      parallel_for_awaitable(Pool &pool, Index first, Index last, Body body, parallel_options options)
+          : _state(pool), _first(first), _last(last), _grain(pick_grain(pool, first, last, options)), _step{AIO_MOV(body)} {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return !(_first < _last); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> caller) noexcept -> void {
+        _state.start(caller);
+        _state.add_job();
+        _state.pool().spawn(split_range(_state, _first, _last, _grain, _step));
+      }
+
+      auto await_resume() -> result_type {
+        if (_state.failed()) return result_type(failure<std::exception_ptr>(_state.error()));
+        return result_type();
+      }
+
+     private:
+      struct step {
+        Body body;
+
+        auto operator()(Index first, Index last) -> void {
+          for (auto i = first; i < last; ++i) std::invoke(body, i);
+        }
+      };
+
+      offload_state<Pool> _state;
+      Index _first;
+      Index _last;
+      std::size_t _grain;
+      step _step;
+    };
+
+    template <class Pool, std::integral Index, class T, class Map, class Reduce>
+    class parallel_reduce_awaitable {
+     public:
+      using result_type = aio::result<T, std::exception_ptr>;
+
+      parallel_reduce_awaitable(Pool &pool, Index first, Index last, T identity, Map map, Reduce reduce, parallel_options options)
+          : _state(pool),
+            _first(first),
+            _last(last),
+            _grain(pick_grain(pool, first, last, options)),
+            _step{identity, AIO_MOV(map), AIO_MOV(reduce), {}, identity} {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return !(_first < _last); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> caller) noexcept -> void {
+        _state.start(caller);
+        _state.add_job();
+        _state.pool().spawn(split_range(_state, _first, _last, _grain, _step));
+      }
+
+      auto await_resume() -> result_type {
+        if (_state.failed()) return result_type(failure<std::exception_ptr>(_state.error()));
+        return result_type(std::in_place, AIO_MOV(_step.total));
+      }
+
+     private:
+      // Each grain is folded locally and merged into the shared total under a lock, so the lock is
+      // taken once per grain rather than once per element.
+      struct step {
+        T identity;
+        Map map;
+        Reduce reduce;
+        std::mutex mutex;
+        T total;
+
+        auto operator()(Index first, Index last) -> void {
+          T partial = identity;
+          for (auto i = first; i < last; ++i) partial = std::invoke(reduce, AIO_MOV(partial), std::invoke(map, i));
+          std::lock_guard lock(mutex);
+          total = std::invoke(reduce, AIO_MOV(total), AIO_MOV(partial));
+        }
+      };
+
+      offload_state<Pool> _state;
+      Index _first;
+      Index _last;
+      std::size_t _grain;
+      step _step;
+    };
+
+  }  // namespace detail
+}  // namespace aio
+
+#endif  // AIO_DETAIL_PARALLEL_HPP
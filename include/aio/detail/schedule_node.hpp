@@ -0,0 +1,274 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_SCHEDULE_NODE_HPP
+#define AIO_DETAIL_SCHEDULE_NODE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstdint>
+
+#include "../lane.hpp"
+
+namespace aio::detail {
+  // Intrusive ready-queue entry. Every suspended coroutine that can be made runnable owns one of these,
+  // either in its promise (tasks) or in the awaiter living in its frame, so queueing never allocates.
+  struct schedule_node {
+    schedule_node *next = nullptr;
+    std::coroutine_handle<> handle{};
+    clock::time_point deadline = no_deadline;
+    aio::lane lane = aio::lane::normal;
+  };
+
+  // Singly linked FIFO of schedule_nodes.
+  class node_queue {
+   public:
+    [[nodiscard]] auto empty() const noexcept -> bool { return _head == nullptr; }
+    [[nodiscard]] auto front() const noexcept -> schedule_node * { return _head; }
+
+    auto push_back(schedule_node *node) noexcept -> void {
+      node->next = nullptr;
+      if (_tail) {
+        _tail->next = node;
+      } else {
+        _head = node;
+      }
+      _tail = node;
+    }
+
+    auto pop_front() noexcept -> schedule_node * {
+      auto *node = _head;
+      if (node) {
+        _head = node->next;
+        if (!_head) _tail = nullptr;
+        node->next = nullptr;
+      }
+      return node;
+    }
+
+    // Moves all nodes of `other` to the back of this queue in O(1).
+    auto splice_back(node_queue &other) noexcept -> void {
+      if (other.empty()) return;
+      if (_tail) {
+        _tail->next = other._head;
+      } else {
+        _head = other._head;
+      }
+      _tail = other._tail;
+      other._head = other._tail = nullptr;
+    }
+
+   private:
+    schedule_node *_head = nullptr;
+    schedule_node *_tail = nullptr;
+  };
+
+  // Lock-free multi-producer, single-consumer stack used as the cross-thread inbox of a scheduler.
+  class atomic_node_stack {
+   public:
+    [[nodiscard]] auto empty() const noexcept -> bool { return _top.load(std::memory_order_acquire) == nullptr; }
+
+    // Returns true if the stack was empty before the push.
+    auto push(schedule_node *node) noexcept -> bool {
+      auto *top = _top.load(std::memory_order_relaxed);
+      do {
+        node->next = top;
+      } while (!_top.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+      return top == nullptr;
+    }
+
+    // Pushes the pre-linked chain [first, last] with a single CAS.
+    auto push_chain(schedule_node *first, schedule_node *last) noexcept -> bool {
+      auto *top = _top.load(std::memory_order_relaxed);
+      do {
+        last->next = top;
+      } while (!_top.compare_exchange_weak(top, first, std::memory_order_release, std::memory_order_relaxed));
+      return top == nullptr;
+    }
+
+    // Takes every node pushed so far, in push order.
+    auto take_all() noexcept -> node_queue {
+      auto *node = _top.exchange(nullptr, std::memory_order_acquire);
+      schedule_node *reversed = nullptr;
+      while (node) {
+        auto *next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+      }
+      node_queue queue;
+      while (reversed) {
+        auto *next = reversed->next;
+        queue.push_back(reversed);
+        reversed = next;
+      }
+      return queue;
+    }
+
+   private:
+    std::atomic<schedule_node *> _top{nullptr};
+  };
+
+  // Bucketed earliest-deadline-first queue for a single lane.
+  //
+  // Deadlines are quantized to `granularity` ticks and hashed into a ring of 64 FIFO buckets whose
+  // occupancy is tracked in a bitmap, so both push and pop are O(1) for deadlines within the horizon
+  // (64 ticks past the earliest queued deadline). Work more urgent than the start of the ring moves the
+  // ring back, spilling buckets past the horizon, and work beyond the horizon waits in an overflow list
+  // that is redistributed as the ring advances. Work without a deadline is served FIFO after deadline
+  // work, but ages: once `fifo_interval` deadline nodes in a row were popped past a waiting one, the
+  // next pop serves it, so a steady stream of deadline work cannot starve the lane's other work.
+  class lane_queue {
+   public:
+    static constexpr std::size_t bucket_count = 64;
+    static constexpr std::size_t fifo_interval = 32;
+
+    lane_queue() noexcept = default;
+    explicit lane_queue(clock::duration granularity) noexcept
+        : _granularity(granularity.count() > 0 ? granularity.count() : 1) {}
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return _size == 0; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return _size; }
+
+    auto push(schedule_node *node) noexcept -> void {
+      ++_size;
+      if (node->deadline == no_deadline) {
+        _fifo.push_back(node);
+        return;
+      }
+      auto tick = to_tick(node->deadline);
+      if (_occupied == 0 && _overflow.empty()) {
+        _base = tick;
+      } else if (tick < _base) {
+        lower_base(tick);
+      }
+      if (tick - _base >= bucket_count) {
+        _overflow.push_back(node);
+        return;
+      }
+      insert(node, tick);
+    }
+
+    auto pop() noexcept -> schedule_node * {
+      if (!_fifo.empty() && _passed >= fifo_interval) return pop_fifo();
+      if (_occupied == 0 && !_overflow.empty()) rebase();
+      if (_occupied != 0) {
+        const auto offset = static_cast<std::uint64_t>(std::countr_zero(std::rotr(_occupied, slot(_base))));
+        if (offset != 0) {
+          _base += offset;
+          if (!_overflow.empty()) redistribute();
+        }
+        const auto index = slot(_base);
+        auto *node = _buckets[index].pop_front();
+        if (_buckets[index].empty()) _occupied &= ~(std::uint64_t{1} << index);
+        if (!_fifo.empty()) ++_passed;
+        --_size;
+        return node;
+      }
+      return pop_fifo();
+    }
+
+   private:
+    auto pop_fifo() noexcept -> schedule_node * {
+      auto *node = _fifo.pop_front();
+      _passed = 0;
+      if (node) --_size;
+      return node;
+    }
+
+    [[nodiscard]] auto to_tick(clock::time_point tp) const noexcept -> std::uint64_t {
+      const auto count = tp.time_since_epoch().count();
+      return count <= 0 ? 0 : static_cast<std::uint64_t>(count) / static_cast<std::uint64_t>(_granularity);
+    }
+
+    [[nodiscard]] static constexpr auto slot(std::uint64_t tick) noexcept -> unsigned {
+      return static_cast<unsigned>(tick % bucket_count);
+    }
+
+    auto insert(schedule_node *node, std::uint64_t tick) noexcept -> void {
+      const auto index = slot(tick);
+      _buckets[index].push_back(node);
+      _occupied |= std::uint64_t{1} << index;
+    }
+
+    // Moves the start of the ring back to `tick`; buckets pushed past the horizon spill into the overflow.
+    auto lower_base(std::uint64_t tick) noexcept -> void {
+      const auto shift = _base - tick;
+      auto spill = shift >= bucket_count ? _occupied : std::rotr(_occupied, slot(_base)) >> (bucket_count - shift);
+      const auto first_spilled = shift >= bucket_count ? 0 : bucket_count - shift;
+      while (spill != 0) {
+        const auto bit = static_cast<std::uint64_t>(std::countr_zero(spill));
+        spill &= spill - 1;
+        const auto index = shift >= bucket_count ? static_cast<unsigned>(bit) : slot(_base + first_spilled + bit);
+        _overflow.splice_back(_buckets[index]);
+        _occupied &= ~(std::uint64_t{1} << index);
+      }
+      _base = tick;
+    }
+
+    // The ring is empty: restart it at the earliest overflowing deadline.
+    auto rebase() noexcept -> void {
+      auto earliest = ~std::uint64_t{0};
+      for (auto *node = _overflow.front(); node; node = node->next) {
+        const auto tick = to_tick(node->deadline);
+        if (tick < earliest) earliest = tick;
+      }
+      _base = earliest;
+      redistribute();
+    }
+
+    // Moves overflow entries that now fall within the horizon into the ring.
+    auto redistribute() noexcept -> void {
+      node_queue remaining;
+      while (auto *node = _overflow.pop_front()) {
+        auto tick = to_tick(node->deadline);
+        if (tick < _base) tick = _base;
+        if (tick - _base < bucket_count) {
+          insert(node, tick);
+        } else {
+          remaining.push_back(node);
+        }
+      }
+      _overflow.splice_back(remaining);
+    }
+
+    std::array<node_queue, bucket_count> _buckets{};
+    node_queue _overflow{};
+    node_queue _fifo{};
+    std::uint64_t _occupied = 0;
+    std::uint64_t _base = 0;
+    std::size_t _size = 0;
+    std::size_t _passed = 0;
+    clock::rep _granularity = std::chrono::duration_cast<clock::duration>(std::chrono::milliseconds(1)).count();
+  };
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_SCHEDULE_NODE_HPP
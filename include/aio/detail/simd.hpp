@@ -0,0 +1,327 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_SIMD_HPP
+#define AIO_DETAIL_SIMD_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AIO_SIMD_X86 1
+#endif
+
+namespace aio::detail {
+  // Byte searches over [first, last). Each returns the position of the first match, or `last`.
+  // find_control() finds the first control character other than horizontal tab (bytes below 0x20
+  // and 0x7f), which both ends and validates a line of an HTTP head.
+  //
+  // On x86 the AVX2 kernels are selected at run time (or directly when compiled with -mavx2), with
+  // SSE2 as the baseline; other targets use the C library. Multi-byte needles use the
+  // first-and-last-byte filter: two vector compares mark the positions whose first and last bytes
+  // match, and only those candidates are compared in full, which keeps short delimiters such as
+  // "\r\n" or "\r\n\r\n" at one pass over the data.
+
+#if AIO_SIMD_X86
+  [[nodiscard]] inline auto simd_has_avx2() noexcept -> bool {
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#endif
+  }
+
+  [[nodiscard]] inline auto mask_position(const std::byte *base, std::uint32_t mask) noexcept -> const std::byte * {
+    return base + __builtin_ctz(mask);
+  }
+
+  // 16-byte block tests, shared by the SSE2 kernels and the tails of the AVX2 kernels.
+  [[nodiscard]] inline auto byte_mask(const std::byte *at, __m128i pattern) noexcept -> std::uint32_t {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+  }
+
+  [[nodiscard]] inline auto control_mask(const std::byte *at) noexcept -> std::uint32_t {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+    const auto low = _mm_andnot_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1f)), block));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(low, _mm_cmpeq_epi8(block, _mm_set1_epi8(0x7f)))));
+  }
+
+  [[nodiscard]] inline auto sequence_at(const std::byte *at, std::uint32_t mask, const std::byte *needle, std::size_t length) noexcept
+      -> const std::byte * {
+    for (; mask != 0; mask &= mask - 1) {
+      const auto *candidate = mask_position(at, mask);
+      if (std::memcmp(candidate + 1, needle + 1, length - 2) == 0) return candidate;
+    }
+    return nullptr;
+  }
+
+  [[nodiscard]] inline auto sequence_mask(const std::byte *at, __m128i head, __m128i tail, std::size_t length) noexcept -> std::uint32_t {
+    const auto starts = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+    const auto ends = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at + length - 1));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, head), _mm_cmpeq_epi8(ends, tail))));
+  }
+
+  // 32-byte block tests of the AVX2 kernels.
+  [[gnu::target("avx2")]] inline auto byte_matches(const std::byte *at, __m256i pattern) noexcept -> __m256i {
+    return _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(at)), pattern);
+  }
+
+  [[gnu::target("avx2")]] inline auto control_matches(const std::byte *at) noexcept -> __m256i {
+    const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(at));
+    const auto low = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')),
+                                         _mm256_cmpeq_epi8(_mm256_min_epu8(block, _mm256_set1_epi8(0x1f)), block));
+    return _mm256_or_si256(low, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x7f)));
+  }
+
+  [[gnu::target("avx2")]] inline auto sequence_candidates(const std::byte *at, __m256i head, __m256i tail, std::size_t length) noexcept
+      -> std::uint32_t {
+    const auto starts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(at));
+    const auto ends = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(at + length - 1));
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(starts, head), _mm256_cmpeq_epi8(ends, tail))));
+  }
+
+  // Position of the first match of a 64-byte block given as two 32-byte match vectors, or null.
+  [[gnu::target("avx2")]] inline auto first_match(const std::byte *at, __m256i low, __m256i high) noexcept -> const std::byte * {
+    const auto any = _mm256_or_si256(low, high);
+    if (_mm256_testz_si256(any, any)) return nullptr;
+    const auto mask = static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(low))) |
+                      static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(high))) << 32;
+    return at + __builtin_ctzll(mask);
+  }
+
+  // The SSE2 kernels search [first, last), knowing that [begin, first) holds no match: once less
+  // than a block is left, one last block that ends at `last` and overlaps the part already searched
+  // replaces a byte-by-byte tail whenever [begin, last) is long enough.
+  inline auto find_byte_sse2(const std::byte *begin, const std::byte *first, const std::byte *last, std::byte needle) noexcept
+      -> const std::byte * {
+    const auto pattern = _mm_set1_epi8(static_cast<char>(needle));
+    for (; last - first >= 16; first += 16) {
+      if (const auto mask = byte_mask(first, pattern)) return mask_position(first, mask);
+    }
+    if (first != last && last - begin >= 16) {
+      const auto mask = byte_mask(last - 16, pattern);
+      return mask ? mask_position(last - 16, mask) : last;
+    }
+    for (; first != last; ++first) {
+      if (*first == needle) return first;
+    }
+    return last;
+  }
+
+  [[gnu::target("avx2")]] inline auto find_byte_avx2(const std::byte *first, const std::byte *last, std::byte needle) noexcept
+      -> const std::byte * {
+    const auto *begin = first;
+    const auto pattern = _mm256_set1_epi8(static_cast<char>(needle));
+    for (; last - first >= 64; first += 64) {
+      const auto low = byte_matches(first, pattern);
+      const auto high = byte_matches(first + 32, pattern);
+      if (const auto *found = first_match(first, low, high)) return found;
+    }
+    if (last - first >= 32) {
+      if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(byte_matches(first, pattern)))) return mask_position(first, mask);
+      first += 32;
+    }
+    return find_byte_sse2(begin, first, last, needle);
+  }
+
+  inline auto find_sequence_sse2(const std::byte *begin, const std::byte *first, const std::byte *last, const std::byte *needle,
+                                 std::size_t length) noexcept -> const std::byte * {
+    const auto head = _mm_set1_epi8(static_cast<char>(needle[0]));
+    const auto tail = _mm_set1_epi8(static_cast<char>(needle[length - 1]));
+    const auto reach = static_cast<std::ptrdiff_t>(length + 15);
+    for (; last - first >= reach; first += 16) {
+      if (const auto *found = sequence_at(first, sequence_mask(first, head, tail, length), needle, length)) return found;
+    }
+    if (last - first >= static_cast<std::ptrdiff_t>(length) && last - begin >= reach) {
+      const auto *at = last - reach;
+      const auto *found = sequence_at(at, sequence_mask(at, head, tail, length), needle, length);
+      return found ? found : last;
+    }
+    for (; last - first >= static_cast<std::ptrdiff_t>(length); ++first) {
+      if (first[0] == needle[0] && std::memcmp(first + 1, needle + 1, length - 1) == 0) return first;
+    }
+    return last;
+  }
+
+  [[gnu::target("avx2")]] inline auto find_sequence_avx2(const std::byte *first, const std::byte *last, const std::byte *needle,
+                                                         std::size_t length) noexcept -> const std::byte * {
+    const auto *begin = first;
+    const auto head = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    const auto tail = _mm256_set1_epi8(static_cast<char>(needle[length - 1]));
+    for (; last - first >= static_cast<std::ptrdiff_t>(length + 63); first += 64) {
+      const auto low = sequence_candidates(first, head, tail, length);
+      const auto high = sequence_candidates(first + 32, head, tail, length);
+      if ((low | high) == 0) continue;
+      if (const auto *found = sequence_at(first, low, needle, length)) return found;
+      if (const auto *found = sequence_at(first + 32, high, needle, length)) return found;
+    }
+    if (last - first >= static_cast<std::ptrdiff_t>(length + 31)) {
+      if (const auto *found = sequence_at(first, sequence_candidates(first, head, tail, length), needle, length)) return found;
+      first += 32;
+    }
+    return find_sequence_sse2(begin, first, last, needle, length);
+  }
+#endif
+
+  [[nodiscard]] constexpr auto is_control(std::byte value) noexcept -> bool {
+    return (value < std::byte{0x20} && value != std::byte{'\t'}) || value == std::byte{0x7f};
+  }
+
+#if AIO_SIMD_X86
+  inline auto find_control_sse2(const std::byte *begin, const std::byte *first, const std::byte *last) noexcept -> const std::byte * {
+    for (; last - first >= 16; first += 16) {
+      if (const auto mask = control_mask(first)) return mask_position(first, mask);
+    }
+    if (first != last && last - begin >= 16) {
+      const auto mask = control_mask(last - 16);
+      return mask ? mask_position(last - 16, mask) : last;
+    }
+    for (; first != last; ++first) {
+      if (is_control(*first)) return first;
+    }
+    return last;
+  }
+
+  [[gnu::target("avx2")]] inline auto find_control_avx2(const std::byte *first, const std::byte *last) noexcept -> const std::byte * {
+    const auto *begin = first;
+    for (; last - first >= 64; first += 64) {
+      if (const auto *found = first_match(first, control_matches(first), control_matches(first + 32))) return found;
+    }
+    if (last - first >= 32) {
+      if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(control_matches(first)))) return mask_position(first, mask);
+      first += 32;
+    }
+    return find_control_sse2(begin, first, last);
+  }
+#endif
+
+  [[nodiscard]] inline auto find_byte(const std::byte *first, const std::byte *last, std::byte needle) noexcept -> const std::byte * {
+#if AIO_SIMD_X86
+    return simd_has_avx2() ? find_byte_avx2(first, last, needle) : find_byte_sse2(first, first, last, needle);
+#else
+    const auto *found = std::memchr(first, static_cast<int>(needle), static_cast<std::size_t>(last - first));
+    return found ? static_cast<const std::byte *>(found) : last;
+#endif
+  }
+
+  [[nodiscard]] inline auto find_control(const std::byte *first, const std::byte *last) noexcept -> const std::byte * {
+#if AIO_SIMD_X86
+    return simd_has_avx2() ? find_control_avx2(first, last) : find_control_sse2(first, first, last);
+#else
+    for (; first != last; ++first) {
+      if (is_control(*first)) return first;
+    }
+    return last;
+#endif
+  }
+
+  [[nodiscard]] inline auto find_sequence(const std::byte *first, const std::byte *last, const std::byte *needle,
+                                          std::size_t length) noexcept -> const std::byte * {
+    if (length == 0) return first;
+    if (length == 1) return find_byte(first, last, needle[0]);
+    if (last - first < static_cast<std::ptrdiff_t>(length)) return last;
+#if AIO_SIMD_X86
+    return simd_has_avx2() ? find_sequence_avx2(first, last, needle, length) : find_sequence_sse2(first, first, last, needle, length);
+#else
+    const auto *found = ::memmem(first, static_cast<std::size_t>(last - first), needle, length);
+    return found ? static_cast<const std::byte *>(found) : last;
+#endif
+  }
+
+  // XOR masking as used by WebSocket payloads. `key` holds the four mask bytes in memory order,
+  // starting with the byte applied to data[0]; the key for the bytes that follow data[size) is
+  // returned, so a payload can be unmasked piece by piece. Whole blocks are XORed with the key
+  // broadcast to a vector, which keeps its phase since blocks are a multiple of four bytes long;
+  // the tail goes eight bytes at a time, then byte by byte.
+  [[nodiscard]] constexpr auto rotate_mask(std::uint32_t key, std::size_t bytes) noexcept -> std::uint32_t {
+    const auto shift = static_cast<int>(bytes % 4 * 8);
+    return std::endian::native == std::endian::little ? std::rotr(key, shift) : std::rotl(key, shift);
+  }
+
+  inline auto xor_mask_scalar(std::byte *data, std::size_t size, std::uint32_t key) noexcept -> std::uint32_t {
+    const auto wide = std::uint64_t{key} << 32 | key;
+    std::size_t i = 0;
+    for (; size - i >= 8; i += 8) {
+      std::uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      word ^= wide;
+      std::memcpy(data + i, &word, sizeof(word));
+    }
+    std::byte bytes[4];
+    std::memcpy(bytes, &key, sizeof(key));
+    for (std::size_t j = 0; i < size; ++i, ++j) data[i] ^= bytes[j % 4];
+    return rotate_mask(key, size);
+  }
+
+#if AIO_SIMD_X86
+  inline auto xor_mask_sse2(std::byte *data, std::size_t size, std::uint32_t key) noexcept -> std::uint32_t {
+    const auto pattern = _mm_set1_epi32(static_cast<int>(key));
+    std::size_t i = 0;
+    for (; size - i >= 16; i += 16) {
+      auto *at = reinterpret_cast<__m128i *>(data + i);
+      _mm_storeu_si128(at, _mm_xor_si128(_mm_loadu_si128(at), pattern));
+    }
+    xor_mask_scalar(data + i, size - i, key);
+    return rotate_mask(key, size);
+  }
+
+  [[gnu::target("avx2")]] inline auto xor_mask_avx2(std::byte *data, std::size_t size, std::uint32_t key) noexcept -> std::uint32_t {
+    const auto pattern = _mm256_set1_epi32(static_cast<int>(key));
+    std::size_t i = 0;
+    for (; size - i >= 64; i += 64) {
+      auto *low = reinterpret_cast<__m256i *>(data + i);
+      auto *high = reinterpret_cast<__m256i *>(data + i + 32);
+      _mm256_storeu_si256(low, _mm256_xor_si256(_mm256_loadu_si256(low), pattern));
+      _mm256_storeu_si256(high, _mm256_xor_si256(_mm256_loadu_si256(high), pattern));
+    }
+    if (size - i >= 32) {
+      auto *at = reinterpret_cast<__m256i *>(data + i);
+      _mm256_storeu_si256(at, _mm256_xor_si256(_mm256_loadu_si256(at), pattern));
+      i += 32;
+    }
+    xor_mask_sse2(data + i, size - i, key);
+    return rotate_mask(key, size);
+  }
+#endif
+
+  inline auto xor_mask(std::byte *data, std::size_t size, std::uint32_t key) noexcept -> std::uint32_t {
+#if AIO_SIMD_X86
+    return simd_has_avx2() ? xor_mask_avx2(data, size, key) : xor_mask_sse2(data, size, key);
+#else
+    return xor_mask_scalar(data, size, key);
+#endif
+  }
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_SIMD_HPP
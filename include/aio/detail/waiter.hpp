@@ -0,0 +1,97 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_WAITER_HPP
+#define AIO_DETAIL_WAITER_HPP
+
+#include <concepts>
+#include <coroutine>
+
+#include "../scheduler.hpp"
+#include "../task.hpp"
+#include "schedule_node.hpp"
+
+namespace aio::detail {
+  // Ready-queue node of a coroutine suspended on a synchronization primitive. It lives in the awaiter,
+  // i.e. in the suspended coroutine's frame, and its `next` link threads the primitive's waiter list
+  // until the waiter is resumed.
+  struct waiter : schedule_node {
+    scheduler *owner = nullptr;
+
+    template <class Promise>
+    auto prepare(std::coroutine_handle<Promise> coro) noexcept -> void {
+      handle = coro;
+      if constexpr (std::derived_from<Promise, task_promise_base>) {
+        lane = coro.promise().lane();
+        deadline = coro.promise().deadline();
+      }
+      owner = scheduler::current();
+    }
+  };
+
+  // Resumes a FIFO queue of waiters. Consecutive waiters of the same scheduler are spliced into its
+  // ready queue as one batch; waiters that were not running on a scheduler are resumed inline, last.
+  inline auto resume_waiters(node_queue &waiters) noexcept -> void {
+    node_queue batch;
+    scheduler *batch_owner = nullptr;
+    node_queue inline_waiters;
+    while (auto *node = waiters.pop_front()) {
+      auto *owner = static_cast<waiter *>(node)->owner;
+      if (!owner) {
+        inline_waiters.push_back(node);
+        continue;
+      }
+      if (owner != batch_owner && batch_owner) batch_owner->enqueue_batch(batch);
+      batch_owner = owner;
+      batch.push_back(node);
+    }
+    if (batch_owner) batch_owner->enqueue_batch(batch);
+    while (auto *node = inline_waiters.pop_front()) node->handle.resume();
+  }
+
+  // Resumes a LIFO chain of waiters (as built by lock-free pushes) in arrival order.
+  inline auto resume_waiters(schedule_node *chain) noexcept -> void {
+    schedule_node *reversed = nullptr;
+    while (chain) {
+      auto *next = chain->next;
+      chain->next = reversed;
+      reversed = chain;
+      chain = next;
+    }
+    node_queue ordered;
+    while (reversed) {
+      auto *next = reversed->next;
+      ordered.push_back(reversed);
+      reversed = next;
+    }
+    resume_waiters(ordered);
+  }
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_WAITER_HPP
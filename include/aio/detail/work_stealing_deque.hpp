@@ -0,0 +1,113 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DETAIL_WORK_STEALING_DEQUE_HPP
+#define AIO_DETAIL_WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "schedule_node.hpp"
+
+namespace aio::detail {
+  // Bounded Chase-Lev deque of schedule_nodes: the owning worker pushes and pops at the bottom,
+  // other workers steal from the top. Follows the C11 formulation of Lê, Pop, Cohen and Zappa Nardelli.
+  class work_stealing_deque {
+   public:
+    explicit work_stealing_deque(std::size_t capacity)
+        : _mask(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          _buffer(std::make_unique<std::atomic<schedule_node *>[]>(_mask + 1)) {}
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return _mask + 1; }
+
+    // Approximate; exact only when called by the owner with no concurrent thieves.
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+      const auto bottom = _bottom.load(std::memory_order_relaxed);
+      const auto top = _top.load(std::memory_order_relaxed);
+      return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+
+    // Owner only. Returns false if the deque is full.
+    auto push(schedule_node *node) noexcept -> bool {
+      const auto bottom = _bottom.load(std::memory_order_relaxed);
+      const auto top = _top.load(std::memory_order_acquire);
+      if (bottom - top >= static_cast<std::int64_t>(_mask + 1)) return false;
+      _buffer[static_cast<std::size_t>(bottom) & _mask].store(node, std::memory_order_relaxed);
+      _bottom.store(bottom + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Owner only. Pops the most recently pushed node.
+    auto pop() noexcept -> schedule_node * {
+      const auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+      _bottom.store(bottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto top = _top.load(std::memory_order_relaxed);
+      if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      auto *node = _buffer[static_cast<std::size_t>(bottom) & _mask].load(std::memory_order_relaxed);
+      if (top == bottom) {
+        // Last element: race against thieves for it.
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+          node = nullptr;
+        }
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+      }
+      return node;
+    }
+
+    // Any thread. Takes the oldest node, or returns nullptr if empty or the race was lost.
+    auto steal() noexcept -> schedule_node * {
+      auto top = _top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const auto bottom = _bottom.load(std::memory_order_acquire);
+      if (top >= bottom) return nullptr;
+      auto *node = _buffer[static_cast<std::size_t>(top) & _mask].load(std::memory_order_relaxed);
+      if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      return node;
+    }
+
+   private:
+    alignas(64) std::atomic<std::int64_t> _top{0};
+    alignas(64) std::atomic<std::int64_t> _bottom{0};
+    alignas(64) std::size_t _mask;
+    std::unique_ptr<std::atomic<schedule_node *>[]> _buffer;
+  };
+}  // namespace aio::detail
+
+#endif  // AIO_DETAIL_WORK_STEALING_DEQUE_HPP
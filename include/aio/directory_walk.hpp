@@ -0,0 +1,371 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_DIRECTORY_WALK_HPP
+#define AIO_DIRECTORY_WALK_HPP
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "async_generator.hpp"
+#include "channel.hpp"
+#include "detail/io_ring.hpp"
+#include "io.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+#include "thread_pool.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief One entry of a directory tree produced by walk_directory()
+  ///
+  /// The views point into the batch that produced the entry and stay valid until the next batch
+  /// is requested.
+  struct directory_entry {
+    std::string_view directory{}; ///< Path of the containing directory, as derived from the walk's root
+    std::string_view name{};      ///< File name within `directory`; NUL-terminated
+    unsigned depth = 0;           ///< Zero for entries of the root directory
+    std::uint8_t type = DT_UNKNOWN; ///< `DT_*` type from the directory, or derived from `stat` if the file system does not report it
+    int error = 0;                ///< errno of the statx call; `stat` is only meaningful when zero
+    struct statx stat{};          ///< Metadata requested through directory_walk_options::stat_mask
+
+    [[nodiscard]] auto is_directory() const noexcept -> bool { return type == DT_DIR; }
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Tuning knobs for walk_directory()
+  struct directory_walk_options {
+    /// Maximum number of directories being read at once.
+    std::size_t max_in_flight = 16;
+
+    /// Size of each getdents64 buffer; one batch is produced per buffer read.
+    std::size_t buffer_size = 256 * 1024;
+
+    /// `STATX_*` fields to fetch for every entry; zero skips statx entirely.
+    unsigned stat_mask = STATX_BASIC_STATS;
+
+    /// Batches that may be read ahead of the consumer.
+    std::size_t read_ahead = 4;
+
+    /// Directories deeper than this are reported but not descended into.
+    unsigned max_depth = ~0u;
+
+    /// Pool to run the getdents64 calls on. Without one they run on the scheduler's thread,
+    /// which blocks the loop for as long as the file system takes to produce the entries.
+    thread_pool *pool = nullptr;
+  };
+
+  namespace detail {
+    struct walk_batch;
+
+    // Completion slot of one statx in a batch; counts down the batch and resumes its worker on the last one.
+    struct statx_slot : io_completion {
+      walk_batch *batch = nullptr;
+      directory_entry *entry = nullptr;
+    };
+
+    struct walk_batch {
+      explicit walk_batch(std::size_t buffer_size) : buffer(std::make_unique<std::byte[]>(buffer_size)) {}
+
+      std::string directory{};
+      std::unique_ptr<std::byte[]> buffer;
+      std::vector<directory_entry> entries{};
+      std::vector<statx_slot> slots{};
+      schedule_node node{};
+      std::size_t remaining = 0;
+    };
+
+    // Issues one statx per entry of `batch` and suspends until all of them have completed. The
+    // counter starts one above the number of entries so that completions reaped while later entries
+    // are still being queued cannot resume the worker early.
+    class statx_batch_awaiter {
+     public:
+      statx_batch_awaiter(walk_batch &batch, int dirfd, unsigned mask) noexcept : _batch(batch), _dirfd(dirfd), _mask(mask) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return _batch.entries.empty(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) -> bool {
+        auto *sched = scheduler::current();
+        _batch.node.handle = coro;
+        _batch.node.lane = coro.promise().lane();
+        _batch.node.deadline = coro.promise().deadline();
+        _batch.slots.resize(_batch.entries.size());
+        _batch.remaining = _batch.entries.size() + 1;
+        for (std::size_t i = 0; i < _batch.entries.size(); ++i) {
+          auto &slot = _batch.slots[i];
+          slot.complete = &on_complete;
+          slot.batch = &_batch;
+          slot.entry = &_batch.entries[i];
+          auto *sqe = sched->submission_entry();
+          sqe->opcode = IORING_OP_STATX;
+          sqe->fd = _dirfd;
+          sqe->addr = reinterpret_cast<std::uint64_t>(slot.entry->name.data());
+          sqe->len = _mask;
+          sqe->off = reinterpret_cast<std::uint64_t>(&slot.entry->stat);
+          sqe->statx_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+          sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<io_completion *>(&slot));
+        }
+        return --_batch.remaining != 0;
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+
+     private:
+      static auto on_complete(io_completion *completion, std::int32_t result, std::uint32_t) noexcept -> void {
+        auto *slot = static_cast<statx_slot *>(completion);
+        slot->entry->error = result < 0 ? -result : 0;
+        if (--slot->batch->remaining == 0) scheduler::current()->enqueue(&slot->batch->node);
+      }
+
+      walk_batch &_batch;
+      int _dirfd;
+      unsigned _mask;
+    };
+
+    struct pending_directory {
+      std::string path;
+      unsigned depth;
+    };
+
+    // Shared by the generator and its workers. Everything runs on the consumer's scheduler, so
+    // only the channel needs to be synchronised.
+    struct walk_state {
+      explicit walk_state(const directory_walk_options &options)
+          : options(options), output(std::max<std::size_t>(options.read_ahead, 1)) {}
+
+      auto acquire_batch() -> std::unique_ptr<walk_batch> {
+        if (free_batches.empty()) return std::make_unique<walk_batch>(options.buffer_size);
+        auto batch = AIO_MOV(free_batches.back());
+        free_batches.pop_back();
+        return batch;
+      }
+
+      auto recycle(std::unique_ptr<walk_batch> batch) -> void {
+        if (free_batches.size() < options.max_in_flight + options.read_ahead) free_batches.push_back(AIO_MOV(batch));
+      }
+
+      directory_walk_options options;
+      channel<std::unique_ptr<walk_batch>> output;
+      std::vector<std::unique_ptr<walk_batch>> free_batches{};
+      std::vector<pending_directory> pending{};
+      aio::lane lane{};
+      clock::time_point deadline{};
+      std::size_t active = 0;
+      bool cancelled = false;
+      std::exception_ptr error{};
+    };
+
+    // Closes a directory descriptor when the read of its directory ends, however it ends.
+    struct walk_fd_guard {
+      explicit walk_fd_guard(int descriptor) noexcept : fd(descriptor) {}
+      walk_fd_guard(const walk_fd_guard &) = delete;
+      auto operator=(const walk_fd_guard &) -> walk_fd_guard & = delete;
+
+      ~walk_fd_guard() { ::close(fd); }
+
+      int fd;
+    };
+
+    // Stops the workers when the generator is destroyed before the walk finished.
+    struct walk_cancel_guard {
+      ~walk_cancel_guard() {
+        state->cancelled = true;
+        state->output.close();
+      }
+
+      std::shared_ptr<walk_state> state;
+    };
+
+    inline auto walk_worker(std::shared_ptr<walk_state> state, pending_directory directory) -> task<void>;
+
+    inline auto walk_enqueue(const std::shared_ptr<walk_state> &state, pending_directory directory) -> void {
+      if (state->active < state->options.max_in_flight) {
+        ++state->active;
+        scheduler::current()->spawn(walk_worker(state, AIO_MOV(directory)).with_lane(state->lane).with_deadline(state->deadline));
+      } else {
+        state->pending.push_back(AIO_MOV(directory));
+      }
+    }
+
+    // Reads the next entries of `fd` into `buffer`; produces their size, zero at the end and -errno on failure.
+    inline auto read_directory(int fd, std::byte *buffer, std::size_t size) noexcept -> long {
+      const auto bytes = ::syscall(SYS_getdents64, fd, buffer, size);
+      return bytes < 0 ? -errno : bytes;
+    }
+
+    // Reads one directory in getdents64-sized batches, stats each batch through the ring and hands
+    // it to the generator. Subdirectories found on the way are queued for the other workers.
+    inline auto walk_read(const std::shared_ptr<walk_state> &state, const pending_directory &directory) -> task<void> {
+      const auto opened = co_await async_openat(AT_FDCWD, directory.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (!opened) {
+        if (directory.depth == 0) throw std::system_error(opened.error(), directory.path);
+        co_return;
+      }
+      const walk_fd_guard guard{*opened};
+      const int fd = guard.fd;
+      const auto &options = state->options;
+      while (!state->cancelled) {
+        auto batch = state->acquire_batch();
+        long bytes = 0;
+        if (options.pool) {
+          auto *const buffer = batch->buffer.get();
+          const auto size = options.buffer_size;
+          auto read = co_await options.pool->run([=] { return read_directory(fd, buffer, size); });
+          if (!read) std::rethrow_exception(read.error());
+          bytes = *read;
+        } else {
+          bytes = read_directory(fd, batch->buffer.get(), options.buffer_size);
+        }
+        if (bytes < 0) {
+          state->recycle(AIO_MOV(batch));
+          if (directory.depth == 0) throw std::system_error(static_cast<int>(-bytes), std::system_category(), directory.path);
+          break;
+        }
+        if (bytes == 0) {
+          state->recycle(AIO_MOV(batch));
+          break;
+        }
+
+        batch->directory = directory.path;
+        batch->entries.clear();
+        for (std::size_t offset = 0; offset < static_cast<std::size_t>(bytes);) {
+          // struct linux_dirent64: u64 d_ino, s64 d_off, u16 d_reclen, u8 d_type, char d_name[].
+          const auto *record = batch->buffer.get() + offset;
+          std::uint16_t length;
+          std::memcpy(&length, record + 16, sizeof(length));
+          offset += length;
+          const auto type = static_cast<std::uint8_t>(record[18]);
+          const std::string_view name(reinterpret_cast<const char *>(record + 19));
+          if (name == "." || name == "..") continue;
+          auto &entry = batch->entries.emplace_back();
+          entry.name = name;
+          entry.depth = directory.depth;
+          entry.type = type;
+        }
+
+        if (options.stat_mask != 0) co_await statx_batch_awaiter(*batch, fd, options.stat_mask);
+        for (auto &entry : batch->entries) {
+          entry.directory = batch->directory;
+          if (entry.type == DT_UNKNOWN && entry.error == 0 && (entry.stat.stx_mask & STATX_TYPE)) {
+            entry.type = static_cast<std::uint8_t>(IFTODT(entry.stat.stx_mode));
+          }
+          if (entry.is_directory() && directory.depth < options.max_depth) {
+            auto path = directory.path;
+            if (path.empty() || path.back() != '/') path += '/';
+            path += entry.name;
+            walk_enqueue(state, {AIO_MOV(path), directory.depth + 1});
+          }
+        }
+
+        if (batch->entries.empty()) {
+          state->recycle(AIO_MOV(batch));
+        } else if (!co_await state->output.send(AIO_MOV(batch))) {
+          break;
+        }
+      }
+    }
+
+    inline auto walk_worker(std::shared_ptr<walk_state> state, pending_directory directory) -> task<void> {
+      try {
+        while (true) {
+          co_await walk_read(state, directory);
+          if (state->cancelled || state->pending.empty()) break;
+          directory = AIO_MOV(state->pending.back());
+          state->pending.pop_back();
+        }
+      } catch (...) {
+        if (!state->error) state->error = std::current_exception();
+        state->cancelled = true;
+      }
+      // A worker only exits with an empty queue, so the last one out ends the walk.
+      if (--state->active == 0) state->output.close();
+    }
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Walks the directory tree under `root`, producing its entries in batches
+  ///
+  /// Up to directory_walk_options::max_in_flight directories are walked at once. Each reads its
+  /// entries with getdents64 into a large buffer (names are used in place, not copied) and then
+  /// queues one statx per entry on the scheduler's io_uring in a single batch, so the kernel
+  /// resolves the metadata of a whole buffer concurrently instead of one stat at a time.
+  /// io_uring has no getdents operation: the getdents64 calls themselves run on
+  /// directory_walk_options::pool if one is given, concurrently, and otherwise synchronously on
+  /// the scheduler's thread, one at a time and blocking the loop while they run. Every
+  /// non-empty buffer becomes one batch; batches from different directories interleave, so
+  /// the traversal order is unspecified. Symbolic links are reported but not followed.
+  ///
+  /// Subdirectories that cannot be opened or read are skipped; if `root` cannot be, a
+  /// `std::system_error` is thrown from next(). Workers inherit the consumer's lane and deadline. Must be consumed on a scheduler, by one
+  /// consumer; destroying the generator early stops the walk once the reads in flight finish.
+  [[nodiscard]] inline auto walk_directory(std::string root, directory_walk_options options = {})
+      -> async_generator<std::span<const directory_entry>> {
+    assert(scheduler::current() && "walk_directory() must be consumed on a scheduler");
+    options.max_in_flight = std::max<std::size_t>(options.max_in_flight, 1);
+    auto state = std::make_shared<detail::walk_state>(options);
+    detail::walk_cancel_guard guard{state};
+    const auto &self = co_await detail::this_promise{};
+    state->lane = self.lane();
+    state->deadline = self.deadline();
+    detail::walk_enqueue(state, {AIO_MOV(root), 0});
+
+    std::unique_ptr<detail::walk_batch> current;
+    while (auto batch = co_await state->output.receive()) {
+      if (current) state->recycle(AIO_MOV(current));
+      current = AIO_MOV(*batch);
+      co_yield std::span<const directory_entry>(current->entries);
+    }
+    if (state->error) std::rethrow_exception(state->error);
+  }
+}  // namespace aio
+
+#endif  // AIO_DIRECTORY_WALK_HPP
@@ -0,0 +1,217 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_FILE_WATCHER_HPP
+#define AIO_FILE_WATCHER_HPP
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "async_generator.hpp"
+#include "io.hpp"
+#include "lane.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief One file-system event reported by a file_watcher
+  ///
+  /// `name` points into the watcher's read buffer and is only valid until the next batch is requested.
+  struct watch_event {
+    int watch = -1;          ///< Watch descriptor returned by file_watcher::add(), or -1 for queue overflow
+    std::uint32_t mask = 0;  ///< `IN_*` flags; for coalesced events, the union of all of them
+    std::uint32_t cookie = 0; ///< Links the IN_MOVED_FROM and IN_MOVED_TO halves of a rename
+    std::string_view name{}; ///< Name of the entry inside a watched directory; empty for the watched object itself
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Tuning knobs for a file_watcher
+  struct file_watcher_options {
+    /// Size of the kernel event buffer read per batch; at least file_watcher::min_buffer_size.
+    std::size_t buffer_size = 64 * 1024;
+
+    /// Time to let events accumulate after the first one arrives. Bursts (an editor's truncate,
+    /// write, close sequence) then arrive as one batch and are coalesced. Zero reads immediately.
+    clock::duration coalesce_window = clock::duration::zero();
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Watches files and directories through inotify and streams the events asynchronously
+  ///
+  /// events() is an async_generator of batches: each batch is everything the kernel had queued
+  /// when the scheduler read the inotify descriptor (optionally after a short coalescing window).
+  /// Records are decoded in place from the read buffer, so names are views into it and no memory
+  /// is allocated per event. Within a batch, events for the same watch and name are merged into
+  /// the first of them, with their masks combined; renames (events with a cookie) and overflow
+  /// notifications are never merged.
+  ///
+  /// inotify is not recursive: to follow a tree, add each directory (and directories reported by
+  /// IN_CREATE | IN_ISDIR). fanotify, which can watch whole mounts, requires CAP_SYS_ADMIN and
+  /// is not used.
+  class file_watcher {
+   public:
+    /// \brief Smallest buffer that holds any single event: the kernel rejects reads into less
+    static constexpr std::size_t min_buffer_size = sizeof(inotify_event) + NAME_MAX + 1;
+
+    /// \brief Creates the inotify instance; throws std::system_error on failure or if the buffer is too small
+    explicit file_watcher(file_watcher_options options = {}) : _options(options) {
+      if (options.buffer_size < min_buffer_size) {
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), "file_watcher buffer_size");
+      }
+      _buffer = std::make_unique<std::byte[]>(options.buffer_size);
+      _fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (_fd < 0) throw std::system_error(errno, std::system_category(), "inotify_init1");
+    }
+
+    file_watcher(const file_watcher &) = delete;
+    auto operator=(const file_watcher &) -> file_watcher & = delete;
+
+    ~file_watcher() { ::close(_fd); }
+
+    /// \brief Starts watching `path` for the events in `mask`; produces the watch descriptor
+    ///
+    /// Adding a path that is already watched replaces its mask and returns the same descriptor.
+    auto add(const char *path, std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVE |
+                                                    IN_DELETE_SELF | IN_MOVE_SELF) -> result<int, std::error_code> {
+      const auto wd = ::inotify_add_watch(_fd, path, mask);
+      if (wd < 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      return wd;
+    }
+
+    /// \brief Stops watching; an IN_IGNORED event for the descriptor follows
+    auto remove(int watch) -> result<void, std::error_code> {
+      if (::inotify_rm_watch(_fd, watch) != 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      return {};
+    }
+
+    /// \brief Returns the stream of event batches
+    ///
+    /// Must be consumed on a scheduler, by one consumer at a time. The watcher must outlive the
+    /// generator. The stream ends only if reading the inotify descriptor fails; error() then
+    /// tells why.
+    [[nodiscard]] auto events() -> async_generator<std::span<const watch_event>> {
+      _error.clear();
+      while (true) {
+        const auto bytes = ::read(_fd, _buffer.get(), _options.buffer_size);
+        if (bytes < 0) {
+          if (errno == EINTR) continue;
+          if (errno != EAGAIN) {
+            _error = std::error_code(errno, std::system_category());
+            co_return;
+          }
+          if (auto ready = co_await async_poll(_fd, POLLIN); !ready) {
+            _error = ready.error();
+            co_return;
+          }
+          if (_options.coalesce_window > clock::duration::zero()) {
+            co_await scheduler::current()->sleep_for(_options.coalesce_window);
+          }
+          continue;
+        }
+        decode(std::span(_buffer.get(), static_cast<std::size_t>(bytes)));
+        co_yield std::span<const watch_event>(_batch);
+      }
+    }
+
+    /// \brief The error that ended the event stream, or no error while it runs
+    [[nodiscard]] auto error() const noexcept -> std::error_code { return _error; }
+
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+   private:
+    static constexpr std::uint32_t empty_slot = ~std::uint32_t{0};
+
+    // Decodes the kernel records into `_batch`, merging repeated (watch, name) pairs. The index is a
+    // reused open-addressing table of batch positions, so steady-state decoding does not allocate.
+    auto decode(std::span<const std::byte> bytes) -> void {
+      _batch.clear();
+      const auto upper_bound = bytes.size() / sizeof(inotify_event);
+      const auto table_size = std::bit_ceil(std::max<std::size_t>(upper_bound * 2, 16));
+      if (_index.size() < table_size) _index.resize(table_size);
+      std::fill_n(_index.begin(), table_size, empty_slot);
+      const auto mask = table_size - 1;
+
+      for (std::size_t offset = 0; offset + sizeof(inotify_event) <= bytes.size();) {
+        inotify_event header;
+        std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        const auto *name_start = reinterpret_cast<const char *>(bytes.data() + offset + sizeof(header));
+        const std::string_view name(name_start, header.len != 0 ? ::strnlen(name_start, header.len) : 0);
+        offset += sizeof(header) + header.len;
+
+        const watch_event event{header.wd, header.mask, header.cookie, name};
+        if (event.cookie != 0 || (event.mask & IN_Q_OVERFLOW)) {
+          _batch.push_back(event);
+          continue;
+        }
+        auto slot = (std::hash<std::string_view>{}(name) ^ (static_cast<std::size_t>(event.watch) * 0x9E3779B97F4A7C15ull)) & mask;
+        while (true) {
+          if (_index[slot] == empty_slot) {
+            _index[slot] = static_cast<std::uint32_t>(_batch.size());
+            _batch.push_back(event);
+            break;
+          }
+          auto &existing = _batch[_index[slot]];
+          if (existing.watch == event.watch && existing.cookie == 0 && existing.name == event.name) {
+            existing.mask |= event.mask;
+            break;
+          }
+          slot = (slot + 1) & mask;
+        }
+      }
+    }
+
+    file_watcher_options _options;
+    int _fd = -1;
+    std::unique_ptr<std::byte[]> _buffer{};
+    std::error_code _error{};
+    std::vector<watch_event> _batch{};
+    std::vector<std::uint32_t> _index{};
+  };
+}  // namespace aio
+
+#endif  // AIO_FILE_WATCHER_HPP
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_FOR_EACH_CONCURRENT_HPP
+#define AIO_FOR_EACH_CONCURRENT_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "latch.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+namespace aio {
+  namespace detail {
+    template <class Range, class Fn>
+    struct for_each_state {
+      for_each_state(Range &range, Fn &fn, std::size_t workers)
+          : next(std::ranges::begin(range)), end(std::ranges::end(range)), fn(&fn), done(static_cast<std::ptrdiff_t>(workers)) {}
+
+      std::ranges::iterator_t<Range> next;
+      std::ranges::sentinel_t<Range> end;
+      Fn *fn;
+      latch done;
+      std::exception_ptr error{};
+    };
+
+    // One of the `max_in_flight` loops of for_each_concurrent(); pulls items until the range is
+    // exhausted or an item failed. All loops run on one scheduler, so the shared iterator needs no lock.
+    // The loops are detached, so nothing thrown by the range or by `fn` may escape them.
+    template <class Range, class Fn>
+    auto for_each_worker(for_each_state<Range, Fn> &state) -> task<void> {
+      try {
+        while (!state.error && state.next != state.end) {
+          std::ranges::range_value_t<Range> item(*state.next);
+          ++state.next;
+          co_await std::invoke(*state.fn, AIO_MOV(item));
+        }
+      } catch (...) {
+        if (!state.error) state.error = std::current_exception();
+      }
+      state.done.count_down();
+    }
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Awaits `fn(item)` for every item of `range`, with at most `max_in_flight` calls running at once
+  ///
+  /// Exactly `max_in_flight` loop coroutines are started on the calling scheduler, each pulling
+  /// the next item when its previous call completes. Items are drawn from the range lazily, so
+  /// memory use is bounded by the concurrency rather than by the length of the range, and the
+  /// frames of the per-item calls are recycled by the frame allocator.
+  ///
+  /// The loops run in the lane and with the deadline of the awaiting task. Once a call (or the
+  /// range) throws, no further items are started; the first exception is rethrown after the calls
+  /// already in flight have finished. Must be awaited on a scheduler, and `range` must stay alive
+  /// until the returned task completes.
+  ///
+  /// \param range Input range of items; iterated from one thread only
+  /// \param max_in_flight Upper bound on concurrent calls; zero is treated as one
+  /// \param fn Callable taking an item (by value) and returning an awaitable
+  template <std::ranges::input_range Range, class Fn>
+    requires std::invocable<Fn &, std::ranges::range_value_t<Range>> &&
+             aio::awaitable<std::invoke_result_t<Fn &, std::ranges::range_value_t<Range>>>
+  auto for_each_concurrent(Range &&range, std::size_t max_in_flight, Fn fn) -> task<void> {
+    auto *sched = scheduler::current();
+    assert(sched && "for_each_concurrent() must be awaited on a scheduler");
+    const auto workers = std::max<std::size_t>(max_in_flight, 1);
+    detail::for_each_state<std::remove_reference_t<Range>, Fn> state(range, fn, workers);
+    const auto &self = co_await detail::this_promise{};
+    for (std::size_t i = 0; i < workers; ++i) {
+      sched->spawn(detail::for_each_worker(state).with_lane(self.lane()).with_deadline(self.deadline()));
+    }
+    co_await state.done.wait();
+    if (state.error) std::rethrow_exception(state.error);
+  }
+}  // namespace aio
+
+#endif  // AIO_FOR_EACH_CONCURRENT_HPP
@@ -0,0 +1,359 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_FRAMING_HPP
+#define AIO_FRAMING_HPP
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "detail/macros.hpp"
+#include "detail/simd.hpp"
+#include "result.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief A decoded frame's payload
+  using frame = std::span<const std::byte>;
+
+  /// \ingroup io
+  ///
+  /// \brief Where a codec found (or expects) the next frame at the start of the buffered data
+  ///
+  /// A complete frame has a non-zero `next`: the payload is `size` bytes at `begin`, and `next`
+  /// bytes (header, payload and trailer) are consumed. An incomplete frame has `next == 0`; if
+  /// `needed` is non-zero the whole frame takes `needed` bytes and `begin` and `size` already
+  /// describe it, otherwise its length is not known yet.
+  struct frame_match {
+    std::size_t begin = 0;
+    std::size_t size = 0;
+    std::size_t next = 0;
+    std::size_t needed = 0;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Concept of a framing codec used by frame_reader and frame_writer
+  ///
+  /// `decode(data)` matches a frame at the start of `data`. `encode(size, header)` writes the
+  /// header of a frame with a `size`-byte payload into `header` and produces its length;
+  /// `trailer()` is written after every payload. Codecs may keep state between decode() calls
+  /// on the same frame, e.g. how far they have scanned.
+  template <class C>
+  concept frame_codec = requires(C &codec, std::span<const std::byte> data, std::size_t size,
+                                 std::span<std::byte, C::max_header_size> header) {
+    { codec.decode(data) } -> std::same_as<result<frame_match, std::error_code>>;
+    { codec.encode(size, header) } -> std::same_as<result<std::size_t, std::error_code>>;
+    { codec.trailer() } -> std::same_as<std::span<const std::byte>>;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Frames prefixed with their payload length as an unsigned 32-bit integer
+  class length_prefix_codec {
+   public:
+    static constexpr std::size_t max_header_size = 4;
+
+    /// \brief Accepts payloads of at most `max_frame_size` bytes, with the length in byte order `order`
+    explicit length_prefix_codec(std::size_t max_frame_size = 16 * 1024 * 1024, std::endian order = std::endian::big) noexcept
+        : _max_frame_size(std::min<std::size_t>(max_frame_size, UINT32_MAX)), _order(order) {}
+
+    [[nodiscard]] auto decode(std::span<const std::byte> data) const noexcept -> result<frame_match, std::error_code> {
+      if (data.size() < max_header_size) return frame_match{.needed = max_header_size};
+      std::uint32_t length;
+      std::memcpy(&length, data.data(), sizeof(length));
+      if (_order != std::endian::native) length = __builtin_bswap32(length);
+      if (length > _max_frame_size) return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+      const auto total = max_header_size + length;
+      if (data.size() < total) return frame_match{.begin = max_header_size, .size = length, .needed = total};
+      return frame_match{.begin = max_header_size, .size = length, .next = total, .needed = total};
+    }
+
+    [[nodiscard]] auto encode(std::size_t size, std::span<std::byte, max_header_size> header) const noexcept
+        -> result<std::size_t, std::error_code> {
+      if (size > _max_frame_size) return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+      auto length = static_cast<std::uint32_t>(size);
+      if (_order != std::endian::native) length = __builtin_bswap32(length);
+      std::memcpy(header.data(), &length, sizeof(length));
+      return max_header_size;
+    }
+
+    [[nodiscard]] auto trailer() const noexcept -> std::span<const std::byte> { return {}; }
+
+   private:
+    std::size_t _max_frame_size;
+    std::endian _order;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Frames terminated by a delimiter, such as `"\n"` or `"\r\n"`
+  ///
+  /// The delimiter is not part of the payload, and payloads must not contain it. Scanning uses
+  /// the SIMD search of read_until() and resumes where the previous decode() of the same frame
+  /// stopped. The delimiter must outlive the codec.
+  class delimiter_codec {
+   public:
+    static constexpr std::size_t max_header_size = 0;
+
+    explicit delimiter_codec(std::string_view delimiter = "\n", std::size_t max_frame_size = 64 * 1024) noexcept
+        : _delimiter(std::as_bytes(std::span(delimiter.data(), delimiter.size()))), _max_frame_size(max_frame_size) {}
+
+    [[nodiscard]] auto decode(std::span<const std::byte> data) noexcept -> result<frame_match, std::error_code> {
+      const auto *first = data.data();
+      const auto *last = first + data.size();
+      const auto *found = detail::find_sequence(first + _scanned, last, _delimiter.data(), _delimiter.size());
+      if (found == last) {
+        if (data.size() > _max_frame_size + _delimiter.size()) {
+          return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+        }
+        _scanned = data.size() >= _delimiter.size() ? data.size() - _delimiter.size() + 1 : 0;
+        return frame_match{};
+      }
+      _scanned = 0;
+      const auto size = static_cast<std::size_t>(found - first);
+      if (size > _max_frame_size) return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+      return frame_match{.size = size, .next = size + _delimiter.size(), .needed = size + _delimiter.size()};
+    }
+
+    [[nodiscard]] auto encode(std::size_t size, std::span<std::byte, max_header_size>) const noexcept
+        -> result<std::size_t, std::error_code> {
+      if (size > _max_frame_size) return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+      return std::size_t{0};
+    }
+
+    [[nodiscard]] auto trailer() const noexcept -> std::span<const std::byte> { return _delimiter; }
+
+   private:
+    std::span<const std::byte> _delimiter;
+    std::size_t _max_frame_size;
+    std::size_t _scanned = 0;
+  };
+
+  static_assert(frame_codec<length_prefix_codec> && frame_codec<delimiter_codec>);
+
+  /// \ingroup io
+  ///
+  /// \brief Splits a buffered_read_stream into frames
+  ///
+  /// read() decodes every complete frame in the buffer at once and produces them as one batch,
+  /// so a read that delivers many small frames costs a single resume. Frames are views into the
+  /// stream's buffer; a frame that straddles the end of the buffer is completed in place after
+  /// the buffer moves its partial tail to the front. Frames too large for the buffer (only
+  /// possible when the codec knows the length up front) are assembled in a side buffer, with
+  /// the remainder read straight into it from the underlying stream.
+  ///
+  /// The frames of a batch are valid until the next operation on the stream. Both the stream
+  /// and the reader must outlive the operation.
+  template <async_read_stream Stream, frame_codec Codec>
+  class frame_reader {
+   public:
+    using batch_result = result<std::span<const frame>, std::error_code>;
+
+    /// \brief Reads frames from `stream`, whose capacity must hold at least a frame header
+    explicit frame_reader(buffered_read_stream<Stream> &stream, Codec codec = Codec()) : _stream(&stream), _codec(AIO_MOV(codec)) {
+      if (stream.capacity() < Codec::max_header_size) {
+        throw std::system_error(std::make_error_code(std::errc::invalid_argument), "frame_reader stream capacity");
+      }
+    }
+
+    [[nodiscard]] auto stream() noexcept -> buffered_read_stream<Stream> & { return *_stream; }
+    [[nodiscard]] auto codec() noexcept -> Codec & { return _codec; }
+
+    /// \brief Produces the next batch of at least one frame
+    ///
+    /// Fails with stream_errc::end_of_stream when the stream ends, also in the middle of a frame,
+    /// and with stream_errc::frame_too_large when the codec rejects a frame. Frames decoded before
+    /// a rejected one are produced first; the error comes with the next call.
+    [[nodiscard]] auto read() -> detail::ready_or_task<batch_result> {
+      auto decoded = decode_buffered();
+      if (!decoded) return detail::ready_or_task<batch_result>(batch_result(failure<std::error_code>(decoded.error())));
+      if (!_frames.empty()) return detail::ready_or_task<batch_result>(batch_result(std::in_place, _frames));
+      return detail::ready_or_task<batch_result>(read_slow());
+    }
+
+   private:
+    // Decodes all complete frames at the start of the buffer into _frames and consumes them. A
+    // codec error after some frames ends the batch; decoding the same bytes again reports it.
+    auto decode_buffered() -> result<frame_match, std::error_code> {
+      _frames.clear();
+      auto data = _stream->buffered();
+      std::size_t used = 0;
+      while (true) {
+        auto match = _codec.decode(data.subspan(used));
+        if (!match && _frames.empty()) return match;
+        if (!match || match->next == 0) {
+          _stream->consume(used);
+          return match ? *match : frame_match{};
+        }
+        _frames.push_back(data.subspan(used + match->begin, match->size));
+        used += match->next;
+      }
+    }
+
+    auto read_slow() -> task<batch_result> {
+      while (true) {
+        auto decoded = decode_buffered();
+        if (!decoded) co_return failure<std::error_code>(decoded.error());
+        if (!_frames.empty()) co_return std::span<const frame>(_frames);
+        if (decoded->needed > _stream->capacity()) co_return co_await read_large(*decoded);
+        auto read = co_await _stream->fill();
+        if (!read) {
+          if (read.error() == stream_errc::delimiter_not_found) co_return failure<std::error_code>(make_error_code(stream_errc::frame_too_large));
+          co_return failure<std::error_code>(read.error());
+        }
+        if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+      }
+    }
+
+    // The frame does not fit in the buffer: copy what is buffered of its payload, read the rest
+    // of the payload directly from the underlying stream and its trailer through the buffer.
+    auto read_large(frame_match match) -> task<batch_result> {
+      _large.resize(match.size);
+      const auto buffered = _stream->buffered();
+      const auto copied = std::min(buffered.size() - match.begin, match.size);
+      std::memcpy(_large.data(), buffered.data() + match.begin, copied);
+      _stream->consume(match.begin + copied);
+      if (auto read = co_await aio::read_exact(_stream->next_layer(), std::span(_large).subspan(copied)); !read) {
+        co_return failure<std::error_code>(read.error());
+      }
+      if (const auto trailer = match.needed - match.begin - match.size; trailer != 0) {
+        if (auto read = co_await _stream->read_exact(trailer); !read) co_return failure<std::error_code>(read.error());
+      }
+      _frames.push_back(_large);
+      co_return std::span<const frame>(_frames);
+    }
+
+    buffered_read_stream<Stream> *_stream;
+    Codec _codec;
+    std::vector<frame> _frames{};
+    std::vector<std::byte> _large{};
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Encodes frames onto an async_write_stream with gathered writes
+  ///
+  /// push() only records a frame: its header goes into the writer, and the payload is
+  /// referenced, not copied. flush() then sends all pending headers, payloads and trailers with
+  /// as few vectored writes as `IOV_MAX` allows. Streams without vectored writes get the frames
+  /// gathered into one contiguous buffer instead.
+  ///
+  /// Payloads must stay alive until the flush() that sends them completes.
+  template <async_write_stream Stream, frame_codec Codec>
+  class frame_writer {
+   public:
+    using void_result = result<void, std::error_code>;
+
+    explicit frame_writer(Stream &stream, Codec codec = Codec()) : _stream(&stream), _codec(AIO_MOV(codec)) {}
+
+    [[nodiscard]] auto stream() noexcept -> Stream & { return *_stream; }
+    [[nodiscard]] auto codec() noexcept -> Codec & { return _codec; }
+
+    /// \brief Returns the number of frames pushed but not yet flushed
+    [[nodiscard]] auto pending() const noexcept -> std::size_t { return _pending.size(); }
+
+    /// \brief Queues `payload` as a frame; fails if the codec rejects it
+    auto push(std::span<const std::byte> payload) -> void_result {
+      pending_frame pending{.payload = payload};
+      auto header = _codec.encode(payload.size(), std::span<std::byte, Codec::max_header_size>(pending.header));
+      if (!header) return failure<std::error_code>(header.error());
+      pending.header_size = static_cast<std::uint8_t>(*header);
+      _pending.push_back(pending);
+      return void_result();
+    }
+
+    auto push(std::string_view payload) -> void_result { return push(std::as_bytes(std::span(payload.data(), payload.size()))); }
+
+    /// \brief Writes all queued frames
+    auto flush() -> task<void_result> {
+      const auto trailer = _codec.trailer();
+      if constexpr (async_vectored_write_stream<Stream>) {
+        _iov.clear();
+        auto gather = [&](const void *data, std::size_t size) {
+          if (size != 0) _iov.push_back(iovec{const_cast<void *>(data), size});
+        };
+        for (auto &pending : _pending) {
+          gather(pending.header.data(), pending.header_size);
+          gather(pending.payload.data(), pending.payload.size());
+          gather(trailer.data(), trailer.size());
+        }
+        auto written = co_await aio::write_all(*_stream, std::span<iovec>(_iov));
+        _pending.clear();
+        co_return written;
+      } else {
+        _gathered.clear();
+        auto gather = [&](const std::byte *data, std::size_t size) { _gathered.insert(_gathered.end(), data, data + size); };
+        for (auto &pending : _pending) {
+          gather(pending.header.data(), pending.header_size);
+          gather(pending.payload.data(), pending.payload.size());
+          gather(trailer.data(), trailer.size());
+        }
+        auto written = co_await aio::write_all(*_stream, std::span<const std::byte>(_gathered));
+        _pending.clear();
+        co_return written;
+      }
+    }
+
+    /// \brief Queues `payload` and flushes
+    auto write(std::span<const std::byte> payload) -> task<void_result> {
+      if (auto pushed = push(payload); !pushed) co_return pushed;
+      co_return co_await flush();
+    }
+
+   private:
+    struct pending_frame {
+      std::array<std::byte, Codec::max_header_size> header{};
+      std::uint8_t header_size = 0;
+      std::span<const std::byte> payload{};
+    };
+
+    Stream *_stream;
+    Codec _codec;
+    std::vector<pending_frame> _pending{};
+    std::vector<iovec> _iov{};
+    std::vector<std::byte> _gathered{};
+  };
+}  // namespace aio
+
+#endif  // AIO_FRAMING_HPP
@@ -0,0 +1,362 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_FUTURE_HPP
+#define AIO_FUTURE_HPP
+
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+
+namespace aio {
+  template <class T, class E = std::exception_ptr>
+  class promise;
+  template <class T, class E = std::exception_ptr>
+  class future;
+  template <class T, class E = std::exception_ptr>
+  class shared_future;
+  template <class T, class E = std::exception_ptr>
+  class future_state;
+
+  namespace detail {
+    template <class E>
+    auto broken_promise_error() -> E {
+      if constexpr (std::same_as<E, std::exception_ptr>) {
+        return std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+      } else if constexpr (std::constructible_from<E, std::error_code>) {
+        return E(std::make_error_code(std::future_errc::broken_promise));
+      } else if constexpr (std::constructible_from<E, std::future_errc>) {
+        return E(std::future_errc::broken_promise);
+      } else {
+        std::terminate();
+      }
+    }
+  }  // namespace detail
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Shared state of a one-shot promise/future channel
+  ///
+  /// The state holds the eventual `aio::result<T, E>` and an atomic word that is either empty,
+  /// ready, or the head of an intrusive list of waiting coroutines. Setting the result is a
+  /// single atomic exchange, so producers are wait-free regardless of the number of waiters.
+  /// Waiters are resumed on the scheduler they awaited from, in one batch per scheduler.
+  ///
+  /// A future_state may be embedded in caller-owned memory, in which case get_promise() and
+  /// get_future() return non-owning handles and the caller keeps the state alive until the
+  /// result has been consumed. promise<T, E> allocates a reference-counted state instead.
+  template <class T, class E>
+  class future_state {
+   public:
+    using result_type = aio::result<T, E>;
+
+    future_state() noexcept = default;
+    future_state(const future_state &) = delete;
+    auto operator=(const future_state &) -> future_state & = delete;
+
+    /// \brief Returns true once a result has been set
+    [[nodiscard]] auto ready() const noexcept -> bool { return _waiters.load(std::memory_order_acquire) == ready_tag(); }
+
+    /// \brief Publishes the result and resumes every waiter
+    ///
+    /// Must be called at most once.
+    template <class... Args>
+    auto emplace(Args &&...args) -> void {
+      _value.emplace(AIO_FWD(args)...);
+      auto *waiters = _waiters.exchange(ready_tag(), std::memory_order_acq_rel);
+      if (waiters) detail::resume_waiters(waiters);
+    }
+
+    /// \brief Registers a waiter; returns false if the result is already available
+    auto add_waiter(detail::waiter *waiter) noexcept -> bool {
+      auto *head = _waiters.load(std::memory_order_acquire);
+      do {
+        if (head == ready_tag()) return false;
+        waiter->next = head;
+      } while (!_waiters.compare_exchange_weak(head, waiter, std::memory_order_acq_rel, std::memory_order_acquire));
+      return true;
+    }
+
+    [[nodiscard]] auto value() & noexcept -> result_type & { return *_value; }
+
+    /// \brief Returns a non-owning promise writing to this state
+    [[nodiscard]] auto get_promise() noexcept -> promise<T, E> { return promise<T, E>(this, false); }
+
+    /// \brief Returns a non-owning future reading from this state
+    [[nodiscard]] auto get_future() noexcept -> future<T, E> { return future<T, E>(this, false); }
+
+    auto add_ref() noexcept -> void { _refs.fetch_add(1, std::memory_order_relaxed); }
+
+    auto release() noexcept -> void {
+      if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+   private:
+    [[nodiscard]] auto ready_tag() const noexcept -> detail::waiter * {
+      return reinterpret_cast<detail::waiter *>(const_cast<future_state *>(this));
+    }
+
+    std::atomic<detail::waiter *> _waiters{nullptr};
+    std::atomic<std::uint32_t> _refs{1};
+    std::optional<result_type> _value{};
+  };
+
+  namespace detail {
+    // Owning or borrowing reference to a future_state.
+    template <class T, class E>
+    class future_state_ref {
+     public:
+      constexpr future_state_ref() noexcept = default;
+      future_state_ref(future_state<T, E> *state, bool owning) noexcept : _state(state), _owning(owning) {}
+
+      future_state_ref(const future_state_ref &other) noexcept : _state(other._state), _owning(other._owning) {
+        if (_state && _owning) _state->add_ref();
+      }
+
+      future_state_ref(future_state_ref &&other) noexcept
+          : _state(std::exchange(other._state, nullptr)), _owning(other._owning) {}
+
+      auto operator=(future_state_ref other) noexcept -> future_state_ref & {
+        std::swap(_state, other._state);
+        std::swap(_owning, other._owning);
+        return *this;
+      }
+
+      ~future_state_ref() {
+        if (_state && _owning) _state->release();
+      }
+
+      [[nodiscard]] auto get() const noexcept -> future_state<T, E> * { return _state; }
+      [[nodiscard]] auto owning() const noexcept -> bool { return _owning; }
+      auto operator->() const noexcept -> future_state<T, E> * { return _state; }
+      explicit operator bool() const noexcept { return _state != nullptr; }
+
+     private:
+      future_state<T, E> *_state = nullptr;
+      bool _owning = false;
+    };
+  }  // namespace detail
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Producer side of a one-shot channel into coroutine code
+  ///
+  /// Intended for bridging threads that are not coroutines (callbacks, C libraries): any thread
+  /// may complete the promise, and completion is wait-free. A default-constructed promise
+  /// allocates its shared state once; get_future() may be called once.
+  ///
+  /// Destroying a promise that was never completed stores a `broken_promise` error when `E`
+  /// can represent one (`std::exception_ptr`, `std::error_code` and types constructible from
+  /// them), and terminates otherwise.
+  template <class T, class E>
+  class promise {
+   public:
+    promise() : _state(new future_state<T, E>(), true) {}
+
+    promise(const promise &) = delete;
+    promise(promise &&) noexcept = default;
+    auto operator=(const promise &) -> promise & = delete;
+    auto operator=(promise &&other) noexcept -> promise & {
+      if (this != &other) {
+        abandon();
+        _state = AIO_MOV(other._state);
+        _satisfied = other._satisfied;
+      }
+      return *this;
+    }
+
+    ~promise() { abandon(); }
+
+    /// \brief Returns the future connected to this promise
+    [[nodiscard]] auto get_future() -> future<T, E> {
+      if (_state.owning()) _state->add_ref();
+      return future<T, E>(_state.get(), _state.owning());
+    }
+
+    /// \brief Completes the promise with a value constructed from `args`
+    template <class... Args>
+    auto set_value(Args &&...args) -> void {
+      complete(std::in_place, AIO_FWD(args)...);
+    }
+
+    /// \brief Completes the promise with an error
+    template <class G = E>
+    auto set_error(G &&error) -> void {
+      complete(failure<E>(AIO_FWD(error)));
+    }
+
+    /// \brief Completes the promise with a ready-made result
+    auto set_result(aio::result<T, E> value) -> void { complete(AIO_MOV(value)); }
+
+   private:
+    friend class future_state<T, E>;
+
+    promise(future_state<T, E> *state, bool owning) noexcept : _state(state, owning) {}
+
+    template <class... Args>
+    auto complete(Args &&...args) -> void {
+      _satisfied = true;
+      _state->emplace(AIO_FWD(args)...);
+    }
+
+    auto abandon() noexcept -> void {
+      if (_state && !_satisfied) {
+        _satisfied = true;
+        _state->emplace(failure<E>(detail::broken_promise_error<E>()));
+      }
+    }
+
+    detail::future_state_ref<T, E> _state{};
+    bool _satisfied = false;
+  };
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Single-consumer awaitable end of a one-shot channel
+  ///
+  /// Awaiting a future (as an rvalue) suspends until the promise is completed and produces
+  /// the `aio::result<T, E>` by value. The awaiting coroutine is resumed on the scheduler it
+  /// awaited from; coroutines not running on a scheduler are resumed on the completing thread.
+  /// Only a valid() future, one obtained from a promise or future_state, may be awaited.
+  template <class T, class E>
+  class future {
+   public:
+    using result_type = aio::result<T, E>;
+
+    constexpr future() noexcept = default;
+
+    /// \brief Returns true if the future refers to a shared state, i.e. came from get_future()
+    [[nodiscard]] auto valid() const noexcept -> bool { return static_cast<bool>(_state); }
+    [[nodiscard]] explicit operator bool() const noexcept { return valid(); }
+    [[nodiscard]] auto ready() const noexcept -> bool { return _state && _state->ready(); }
+
+    /// \brief Converts this future into a shared_future that any number of coroutines may await
+    [[nodiscard]] auto share() && noexcept -> shared_future<T, E> { return shared_future<T, E>(AIO_MOV(_state)); }
+
+    class awaiter : detail::waiter {
+     public:
+      explicit awaiter(future_state<T, E> *state) noexcept : _state(state) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return _state->ready(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+        prepare(coro);
+        return _state->add_waiter(this);
+      }
+
+      auto await_resume() -> result_type { return AIO_MOV(_state->value()); }
+
+     private:
+      future_state<T, E> *_state;
+    };
+
+    auto operator co_await() && noexcept -> awaiter {
+      assert(valid() && "awaiting a future without a shared state");
+      return awaiter(_state.get());
+    }
+
+   private:
+    friend class promise<T, E>;
+    friend class future_state<T, E>;
+
+    future(future_state<T, E> *state, bool owning) noexcept : _state(state, owning) {}
+
+    detail::future_state_ref<T, E> _state{};
+  };
+
+  /// \ingroup coroutine
+  ///
+  /// \brief Multi-consumer awaitable end of a one-shot channel
+  ///
+  /// Copies share the same state. Every awaiter receives a const reference to the stored
+  /// result; all waiters are released by a single atomic exchange when the promise completes.
+  template <class T, class E>
+  class shared_future {
+   public:
+    using result_type = aio::result<T, E>;
+
+    constexpr shared_future() noexcept = default;
+
+    /// \brief Returns true if the future refers to a shared state, i.e. came from share()
+    [[nodiscard]] auto valid() const noexcept -> bool { return static_cast<bool>(_state); }
+    [[nodiscard]] explicit operator bool() const noexcept { return valid(); }
+    [[nodiscard]] auto ready() const noexcept -> bool { return _state && _state->ready(); }
+
+    class awaiter : detail::waiter {
+     public:
+      explicit awaiter(future_state<T, E> *state) noexcept : _state(state) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return _state->ready(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+        prepare(coro);
+        return _state->add_waiter(this);
+      }
+
+      auto await_resume() const noexcept -> const result_type & { return _state->value(); }
+
+     private:
+      future_state<T, E> *_state;
+    };
+
+    auto operator co_await() const noexcept -> awaiter {
+      assert(valid() && "awaiting a shared_future without a shared state");
+      return awaiter(_state.get());
+    }
+
+   private:
+    friend class future<T, E>;
+
+    explicit shared_future(detail::future_state_ref<T, E> state) noexcept : _state(AIO_MOV(state)) {}
+
+    detail::future_state_ref<T, E> _state{};
+  };
+
+  static_assert(aio::awaitable_of<future<int>, aio::result<int, std::exception_ptr>>);
+  static_assert(aio::awaitable_of<const shared_future<int> &, const aio::result<int, std::exception_ptr> &>);
+}  // namespace aio
+
+#endif  // AIO_FUTURE_HPP
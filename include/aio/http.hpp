@@ -0,0 +1,586 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_HTTP_HPP
+#define AIO_HTTP_HPP
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/simd.hpp"
+#include "result.hpp"
+
+namespace aio {
+  /**
+   * \defgroup protocols protocols
+   * \brief The `protocols` module provides parsers and codecs for wire protocols spoken over the streams of `io`.
+   */
+
+  /// \ingroup protocols
+  ///
+  /// \brief Errors reported by the HTTP/1.1 parsers
+  enum class http_errc {
+    bad_start_line = 1,     ///< Malformed request or status line
+    bad_version,            ///< Protocol version other than HTTP/1.0 or HTTP/1.1
+    bad_header,             ///< Malformed header field, including obsolete line folding
+    too_many_headers,       ///< More header fields than http_parser_options::max_headers
+    head_too_large,         ///< Head larger than http_parser_options::max_head_size
+    bad_content_length,     ///< Invalid or conflicting Content-Length
+    bad_transfer_encoding,  ///< Transfer-Encoding that does not end in chunked, or together with Content-Length
+    bad_chunk               ///< Malformed chunked body
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Returns the error category of aio::http_errc
+  [[nodiscard]] inline auto http_category() noexcept -> const std::error_category & {
+    static const struct : std::error_category {
+      [[nodiscard]] auto name() const noexcept -> const char * override { return "aio.http"; }
+      [[nodiscard]] auto message(int value) const -> std::string override {
+        switch (static_cast<http_errc>(value)) {
+          case http_errc::bad_start_line: return "malformed start line";
+          case http_errc::bad_version: return "unsupported HTTP version";
+          case http_errc::bad_header: return "malformed header field";
+          case http_errc::too_many_headers: return "too many header fields";
+          case http_errc::head_too_large: return "message head too large";
+          case http_errc::bad_content_length: return "invalid content length";
+          case http_errc::bad_transfer_encoding: return "invalid transfer encoding";
+          case http_errc::bad_chunk: return "malformed chunked body";
+        }
+        return "unknown HTTP error";
+      }
+    } category;
+    return category;
+  }
+
+  [[nodiscard]] inline auto make_error_code(http_errc error) noexcept -> std::error_code {
+    return {static_cast<int>(error), http_category()};
+  }
+}  // namespace aio
+
+template <>
+struct std::is_error_code_enum<aio::http_errc> : std::true_type {};
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief A header field; name and value point into the parsed data, the value without surrounding whitespace
+  struct http_header {
+    std::string_view name;
+    std::string_view value;
+  };
+
+  namespace detail {
+    inline constexpr auto http_token_chars = [] {
+      std::array<bool, 256> table{};
+      for (auto c = '0'; c <= '9'; ++c) table[static_cast<unsigned char>(c)] = true;
+      for (auto c = 'a'; c <= 'z'; ++c) table[static_cast<unsigned char>(c)] = true;
+      for (auto c = 'A'; c <= 'Z'; ++c) table[static_cast<unsigned char>(c)] = true;
+      for (auto c : std::string_view("!#$%&'*+-.^_`|~")) table[static_cast<unsigned char>(c)] = true;
+      return table;
+    }();
+
+    [[nodiscard]] constexpr auto is_http_token(std::string_view text) noexcept -> bool {
+      if (text.empty()) return false;
+      for (auto c : text) {
+        if (!http_token_chars[static_cast<unsigned char>(c)]) return false;
+      }
+      return true;
+    }
+
+    [[nodiscard]] constexpr auto ascii_lower(char c) noexcept -> char { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c; }
+
+    [[nodiscard]] constexpr auto iequals(std::string_view a, std::string_view b) noexcept -> bool {
+      if (a.size() != b.size()) return false;
+      for (std::size_t i = 0; i < a.size(); ++i) {
+        if (ascii_lower(a[i]) != ascii_lower(b[i])) return false;
+      }
+      return true;
+    }
+
+    [[nodiscard]] constexpr auto trim_whitespace(std::string_view text) noexcept -> std::string_view {
+      while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+      while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+      return text;
+    }
+
+    // Calls `visit` with every non-empty element of a comma-separated header value.
+    template <class Visit>
+    constexpr auto for_each_element(std::string_view list, Visit visit) -> void {
+      while (!list.empty()) {
+        const auto comma = list.find(',');
+        if (auto element = trim_whitespace(list.substr(0, comma)); !element.empty()) visit(element);
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+      }
+    }
+
+    [[nodiscard]] constexpr auto parse_decimal(std::string_view text) noexcept -> std::optional<std::size_t> {
+      if (text.empty()) return std::nullopt;
+      std::size_t value = 0;
+      for (auto c : text) {
+        if (c < '0' || c > '9') return std::nullopt;
+        if (value > (std::numeric_limits<std::size_t>::max() - 9) / 10) return std::nullopt;
+        value = value * 10 + static_cast<std::size_t>(c - '0');
+      }
+      return value;
+    }
+
+    [[nodiscard]] inline auto find_header(std::span<const http_header> headers, std::string_view name) noexcept
+        -> std::optional<std::string_view> {
+      for (const auto &header : headers) {
+        if (iequals(header.name, name)) return header.value;
+      }
+      return std::nullopt;
+    }
+
+    // Parses "HTTP/1.x" into its minor version.
+    [[nodiscard]] constexpr auto parse_http_version(std::string_view text) noexcept -> std::optional<int> {
+      if (text.size() != 8 || text.substr(0, 7) != "HTTP/1." || (text[7] != '0' && text[7] != '1')) return std::nullopt;
+      return text[7] - '0';
+    }
+  }  // namespace detail
+
+  /// \ingroup protocols
+  ///
+  /// \brief A parsed HTTP/1.x request head and, when fully buffered, its Content-Length body
+  ///
+  /// All views point into the data given to http_parser::parse(). A body that was not entirely
+  /// in that data is left to the caller: `body_pending` bytes of it follow the parsed head. A
+  /// chunked body always follows the head and is decoded with http_chunked_decoder.
+  struct http_request {
+    std::string_view method{};
+    std::string_view target{};
+    int minor_version = 1;
+    std::span<const http_header> headers{};
+    std::size_t content_length = 0;
+    bool chunked = false;
+    bool keep_alive = true;
+    std::string_view body{};
+    std::size_t body_pending = 0;
+
+    /// \brief Returns the value of the first header field called `name`, compared case-insensitively
+    [[nodiscard]] auto header(std::string_view name) const noexcept -> std::optional<std::string_view> {
+      return detail::find_header(headers, name);
+    }
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief A parsed HTTP/1.x response head and, when fully buffered, its Content-Length body
+  ///
+  /// Follows the body rules of http_request. A response without Content-Length or chunked
+  /// coding that may have a body is delimited by the end of the connection (`until_close`).
+  /// 1xx, 204 and 304 responses never have a body; responses to HEAD requests are not
+  /// recognised as such, so their Content-Length must be ignored by the caller.
+  struct http_response {
+    int minor_version = 1;
+    int status = 0;
+    std::string_view reason{};
+    std::span<const http_header> headers{};
+    std::size_t content_length = 0;
+    bool chunked = false;
+    bool keep_alive = true;
+    bool until_close = false;
+    std::string_view body{};
+    std::size_t body_pending = 0;
+
+    /// \brief Returns the value of the first header field called `name`, compared case-insensitively
+    [[nodiscard]] auto header(std::string_view name) const noexcept -> std::optional<std::string_view> {
+      return detail::find_header(headers, name);
+    }
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Limits enforced by http_parser
+  struct http_parser_options {
+    std::size_t max_head_size = 64 * 1024;  ///< Largest accepted start line plus header fields
+    std::size_t max_headers = 100;          ///< Most header fields per message
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Incremental, zero-copy HTTP/1.x parser for requests (http_request) or responses (http_response)
+  ///
+  /// parse() takes the received data starting at a message boundary and parses every message
+  /// that is complete in it in one pass, so pipelined requests that arrive together come out as
+  /// one batch. The end of a head is located with the SIMD sequence search first; only complete
+  /// heads are parsed, line by line, with a SIMD scan that finds each line's end and rejects
+  /// control characters in the same pass. An incomplete head is not re-examined: the search
+  /// resumes where it stopped once more data has arrived, so the caller can `co_await` a read
+  /// and call parse() again with the unconsumed data plus the new bytes.
+  ///
+  /// Lines must end in CRLF; empty lines before a request line are skipped.
+  template <class Message>
+  class http_parser {
+    static_assert(std::same_as<Message, http_request> || std::same_as<Message, http_response>);
+
+   public:
+    explicit http_parser(http_parser_options options = {}) : _options(options) {}
+
+    /// \brief Parses all complete messages at the start of `data`; produces the number of bytes they take up
+    ///
+    /// The batch ends at the first incomplete message, or after a message whose body does not
+    /// follow in `data` (body_pending, chunked or until_close); the caller consumes its body
+    /// before the next call. Once at least one message was parsed, an error in a later message
+    /// ends the batch and is reported by the next call instead. The messages stay valid until
+    /// the next call and as long as `data`.
+    auto parse(std::string_view data) -> result<std::size_t, std::error_code> {
+      _messages.clear();
+      _headers.clear();
+      _header_ranges.clear();
+      std::size_t consumed = 0;
+      while (consumed != data.size()) {
+        Message message{};
+        auto parsed = parse_one(data.substr(consumed), message);
+        if (!parsed || *parsed == 0) {
+          if (!parsed && _messages.empty()) return failure<std::error_code>(parsed.error());
+          break;
+        }
+        consumed += *parsed;
+        _messages.push_back(message);
+        if (message.body_pending != 0 || message.chunked || body_until_close(message)) break;
+      }
+      for (std::size_t i = 0; i < _messages.size(); ++i) {
+        _messages[i].headers = std::span<const http_header>(_headers).subspan(_header_ranges[i].first, _header_ranges[i].second);
+      }
+      return consumed;
+    }
+
+    /// \brief Returns the messages of the last parse()
+    [[nodiscard]] auto messages() const noexcept -> std::span<const Message> { return _messages; }
+
+    /// \brief Forgets how far an incomplete head was searched; call when starting on unrelated data
+    auto reset() noexcept -> void { _scanned = 0; }
+
+   private:
+    static constexpr std::string_view head_end = "\r\n\r\n";
+
+    [[nodiscard]] static constexpr auto body_until_close(const Message &message) noexcept -> bool {
+      if constexpr (std::same_as<Message, http_response>) {
+        return message.until_close;
+      } else {
+        return false;
+      }
+    }
+
+    [[nodiscard]] static auto as_bytes(const char *text) noexcept -> const std::byte * { return reinterpret_cast<const std::byte *>(text); }
+
+    // Parses one message at the start of `data`; produces its length so far, or 0 if its head is incomplete.
+    auto parse_one(std::string_view data, Message &message) -> result<std::size_t, std::error_code> {
+      std::size_t skipped = 0;
+      if constexpr (std::same_as<Message, http_request>) {
+        while (data.substr(skipped, 2) == "\r\n") skipped += 2;
+      }
+      const auto *first = as_bytes(data.data()) + skipped;
+      const auto *last = as_bytes(data.data() + data.size());
+      const auto *found = detail::find_sequence(first + _scanned, last, as_bytes(head_end.data()), head_end.size());
+      if (found == last) {
+        const auto available = static_cast<std::size_t>(last - first);
+        if (available > _options.max_head_size) return failure<std::error_code>(make_error_code(http_errc::head_too_large));
+        _scanned = available >= head_end.size() ? available - head_end.size() + 1 : 0;
+        return std::size_t{0};
+      }
+      _scanned = 0;
+      const auto head_size = static_cast<std::size_t>(found - first) + head_end.size();
+      if (head_size > _options.max_head_size) return failure<std::error_code>(make_error_code(http_errc::head_too_large));
+
+      auto parsed = parse_head(data.substr(skipped, head_size), message);
+      if (!parsed) return failure<std::error_code>(parsed.error());
+
+      const auto available = data.size() - skipped - head_size;
+      if (message.content_length != 0 && !message.chunked) {
+        if (available < message.content_length) {
+          message.body_pending = message.content_length;
+          return skipped + head_size;
+        }
+        message.body = data.substr(skipped + head_size, message.content_length);
+      }
+      return skipped + head_size + message.body.size();
+    }
+
+    // Returns the line starting at `position` without its CRLF, and moves `position` past it.
+    [[nodiscard]] static auto next_line(std::string_view head, std::size_t &position) noexcept -> std::optional<std::string_view> {
+      const auto *first = as_bytes(head.data() + position);
+      const auto *last = as_bytes(head.data() + head.size());
+      const auto *end = detail::find_control(first, last);
+      if (last - end < 2 || end[0] != std::byte{'\r'} || end[1] != std::byte{'\n'}) return std::nullopt;
+      const auto line = head.substr(position, static_cast<std::size_t>(end - first));
+      position += line.size() + 2;
+      return line;
+    }
+
+    auto parse_head(std::string_view head, Message &message) -> result<void, std::error_code> {
+      std::size_t position = 0;
+      const auto start_line = next_line(head, position);
+      if (!start_line) return failure<std::error_code>(make_error_code(http_errc::bad_start_line));
+      if (auto parsed = parse_start_line(*start_line, message); !parsed) return parsed;
+
+      const auto header_begin = _headers.size();
+      std::optional<std::size_t> content_length{};
+      std::optional<std::string_view> transfer_encoding{};
+      std::optional<bool> connection_keep_alive{};
+      while (true) {
+        const auto line = next_line(head, position);
+        if (!line) return failure<std::error_code>(make_error_code(http_errc::bad_header));
+        if (line->empty()) break;
+        if (_headers.size() - header_begin == _options.max_headers) {
+          return failure<std::error_code>(make_error_code(http_errc::too_many_headers));
+        }
+        const auto colon = line->find(':');
+        if (colon == std::string_view::npos) return failure<std::error_code>(make_error_code(http_errc::bad_header));
+        const auto name = line->substr(0, colon);
+        if (!detail::is_http_token(name)) return failure<std::error_code>(make_error_code(http_errc::bad_header));
+        const auto value = detail::trim_whitespace(line->substr(colon + 1));
+        _headers.push_back(http_header{name, value});
+
+        if (detail::iequals(name, "content-length")) {
+          const auto length = detail::parse_decimal(value);
+          if (!length || (content_length && *content_length != *length)) {
+            return failure<std::error_code>(make_error_code(http_errc::bad_content_length));
+          }
+          content_length = length;
+        } else if (detail::iequals(name, "transfer-encoding")) {
+          if (transfer_encoding) return failure<std::error_code>(make_error_code(http_errc::bad_transfer_encoding));
+          transfer_encoding = value;
+        } else if (detail::iequals(name, "connection")) {
+          detail::for_each_element(value, [&](std::string_view option) {
+            if (detail::iequals(option, "close")) {
+              connection_keep_alive = false;
+            } else if (detail::iequals(option, "keep-alive") && !connection_keep_alive) {
+              connection_keep_alive = true;
+            }
+          });
+        }
+      }
+      _header_ranges.emplace_back(header_begin, _headers.size() - header_begin);
+      message.keep_alive = connection_keep_alive.value_or(message.minor_version == 1);
+
+      bool chunked = false;
+      if (transfer_encoding) {
+        std::string_view last_coding{};
+        detail::for_each_element(*transfer_encoding, [&](std::string_view coding) { last_coding = coding; });
+        chunked = detail::iequals(last_coding, "chunked");
+        // A request must be chunked if it has a transfer coding, and never carries both framings.
+        if constexpr (std::same_as<Message, http_request>) {
+          if (!chunked || content_length) return failure<std::error_code>(make_error_code(http_errc::bad_transfer_encoding));
+        }
+      }
+
+      if constexpr (std::same_as<Message, http_response>) {
+        if ((message.status >= 100 && message.status < 200) || message.status == 204 || message.status == 304) {
+          return result<void, std::error_code>();
+        }
+        if (transfer_encoding && !chunked) {
+          message.until_close = true;
+        } else if (!chunked && !content_length) {
+          message.until_close = true;
+        }
+        if (message.until_close) {
+          message.keep_alive = false;
+          return result<void, std::error_code>();
+        }
+      }
+      message.chunked = chunked;
+      if (!chunked) message.content_length = content_length.value_or(0);
+      return result<void, std::error_code>();
+    }
+
+    static auto parse_start_line(std::string_view line, http_request &request) -> result<void, std::error_code> {
+      const auto method_end = line.find(' ');
+      const auto target_end = line.rfind(' ');
+      if (method_end == std::string_view::npos || target_end == method_end) {
+        return failure<std::error_code>(make_error_code(http_errc::bad_start_line));
+      }
+      request.method = line.substr(0, method_end);
+      request.target = line.substr(method_end + 1, target_end - method_end - 1);
+      if (!detail::is_http_token(request.method) || request.target.empty() || request.target.find(' ') != std::string_view::npos) {
+        return failure<std::error_code>(make_error_code(http_errc::bad_start_line));
+      }
+      const auto version = detail::parse_http_version(line.substr(target_end + 1));
+      if (!version) return failure<std::error_code>(make_error_code(http_errc::bad_version));
+      request.minor_version = *version;
+      return result<void, std::error_code>();
+    }
+
+    static auto parse_start_line(std::string_view line, http_response &response) -> result<void, std::error_code> {
+      const auto version = detail::parse_http_version(line.substr(0, 8));
+      if (!version) return failure<std::error_code>(make_error_code(http_errc::bad_version));
+      // "HTTP/1.x 200" followed by " reason", where the reason may be empty
+      if (line.size() < 12 || line[8] != ' ' || (line.size() > 12 && line[12] != ' ')) {
+        return failure<std::error_code>(make_error_code(http_errc::bad_start_line));
+      }
+      const auto status = detail::parse_decimal(line.substr(9, 3));
+      if (!status || *status < 100) return failure<std::error_code>(make_error_code(http_errc::bad_start_line));
+      response.minor_version = *version;
+      response.status = static_cast<int>(*status);
+      response.reason = line.size() > 12 ? line.substr(13) : std::string_view();
+      return result<void, std::error_code>();
+    }
+
+    http_parser_options _options;
+    std::size_t _scanned = 0;
+    std::vector<Message> _messages{};
+    std::vector<http_header> _headers{};
+    std::vector<std::pair<std::size_t, std::size_t>> _header_ranges{};
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Parser of HTTP requests, as used by servers
+  using http_request_parser = http_parser<http_request>;
+
+  /// \ingroup protocols
+  ///
+  /// \brief Parser of HTTP responses, as used by clients
+  using http_response_parser = http_parser<http_response>;
+
+  /// \ingroup protocols
+  ///
+  /// \brief Incremental decoder of the chunked transfer coding
+  ///
+  /// decode() can be given the body in pieces of any size; it keeps its position within the
+  /// chunk framing, so no byte is examined twice. The payload comes out as views into the data
+  /// given, without copying. Chunk extensions and trailer fields are skipped.
+  class http_chunked_decoder {
+   public:
+    /// \brief Decodes from `data`, appending payload pieces to `out`; produces the number of bytes consumed
+    ///
+    /// Consumes all of `data` unless the body ends within it, in which case it stops right after
+    /// the final CRLF, where the next message starts.
+    auto decode(std::string_view data, std::vector<std::string_view> &out) -> result<std::size_t, std::error_code> {
+      std::size_t position = 0;
+      while (position < data.size() && _state != state::done) {
+        if (_state == state::data) {
+          const auto size = std::min(_remaining, data.size() - position);
+          out.push_back(data.substr(position, size));
+          position += size;
+          _remaining -= size;
+          if (_remaining == 0) _state = state::data_cr;
+          continue;
+        }
+        if (!step(data[position++])) return failure<std::error_code>(make_error_code(http_errc::bad_chunk));
+      }
+      return position;
+    }
+
+    /// \brief Returns whether the final chunk and the trailer have been decoded
+    [[nodiscard]] auto done() const noexcept -> bool { return _state == state::done; }
+
+    /// \brief Prepares the decoder for the next chunked body
+    auto reset() noexcept -> void { *this = http_chunked_decoder(); }
+
+   private:
+    enum class state : std::uint8_t { size, extension, size_lf, data, data_cr, data_lf, trailer, trailer_lf, done };
+
+    [[nodiscard]] static constexpr auto hex_value(char c) noexcept -> int {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    }
+
+    auto step(char c) noexcept -> bool {
+      switch (_state) {
+        case state::size:
+          if (const auto digit = hex_value(c); digit >= 0) {
+            if (_remaining > (std::numeric_limits<std::size_t>::max() >> 4)) return false;
+            _remaining = (_remaining << 4) | static_cast<std::size_t>(digit);
+            _digits = true;
+            return true;
+          }
+          if (!_digits) return false;
+          if (c == '\r') {
+            _state = state::size_lf;
+            return true;
+          }
+          if (c != ';' && c != ' ' && c != '\t') return false;
+          _state = state::extension;
+          return true;
+        case state::extension:
+          if (c == '\r') {
+            _state = state::size_lf;
+          } else if (detail::is_control(static_cast<std::byte>(c))) {
+            return false;
+          }
+          return true;
+        case state::size_lf:
+          if (c != '\n') return false;
+          _state = _remaining == 0 ? state::trailer : state::data;
+          _digits = false;
+          return true;
+        case state::data_cr:
+          if (c != '\r') return false;
+          _state = state::data_lf;
+          return true;
+        case state::data_lf:
+          if (c != '\n') return false;
+          _state = state::size;
+          return true;
+        case state::trailer:
+          if (c == '\r') {
+            _state = state::trailer_lf;
+          } else if (detail::is_control(static_cast<std::byte>(c))) {
+            return false;
+          } else {
+            _line_empty = false;
+          }
+          return true;
+        case state::trailer_lf:
+          if (c != '\n') return false;
+          _state = _line_empty ? state::done : state::trailer;
+          _line_empty = true;
+          return true;
+        case state::data:
+        case state::done: break;
+      }
+      return false;
+    }
+
+    state _state = state::size;
+    std::size_t _remaining = 0;
+    bool _digits = false;
+    bool _line_empty = true;
+  };
+}  // namespace aio
+
+#endif  // AIO_HTTP_HPP
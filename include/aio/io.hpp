@@ -0,0 +1,335 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_IO_HPP
+#define AIO_IO_HPP
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/io_ring.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /**
+   * \defgroup io io
+   * \brief The `io` module provides asynchronous system calls on the scheduler's io_uring.
+   */
+
+  /// \ingroup io
+  ///
+  /// \brief File offset meaning "the current file position" for reads and writes
+  inline constexpr std::uint64_t current_position = ~std::uint64_t{0};
+
+  namespace detail {
+    // Length of a transfer as the 32-bit field of a submission entry: larger buffers are clamped,
+    // making the operation a short transfer, which callers already handle, instead of wrapping.
+    [[nodiscard]] constexpr auto io_length(std::size_t size) noexcept -> std::uint32_t {
+      return size > UINT32_MAX ? UINT32_MAX : static_cast<std::uint32_t>(size);
+    }
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Awaitable io_uring operation
+  ///
+  /// `Prepare` fills in the submission entry when the awaiting coroutine suspends; the coroutine
+  /// is resumed on its scheduler once the completion is reaped, on the lane and with the deadline
+  /// of the awaiting task. Negative completion codes become a `std::error_code` error, others are
+  /// converted to `T`. Must be awaited on a scheduler; any buffers referenced by the entry must
+  /// stay alive until the awaitable completes.
+  template <class T, class Prepare>
+  class io_operation : detail::io_completion {
+   public:
+    using result_type = aio::result<T, std::error_code>;
+
+    explicit io_operation(Prepare prepare) noexcept(std::is_nothrow_move_constructible_v<Prepare>)
+        : _prepare(AIO_MOV(prepare)) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> void {
+      _scheduler = scheduler::current();
+      assert(_scheduler && "I/O operations must be awaited on a scheduler");
+      _node.handle = coro;
+      if constexpr (std::derived_from<Promise, detail::task_promise_base>) {
+        _node.lane = coro.promise().lane();
+        _node.deadline = coro.promise().deadline();
+      }
+      complete = &on_complete;
+      auto *sqe = _scheduler->submission_entry();
+      _prepare(*sqe);
+      sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<detail::io_completion *>(this));
+    }
+
+    auto await_resume() const -> result_type {
+      if (_result < 0) return failure<std::error_code>(std::error_code(-_result, std::system_category()));
+      if constexpr (std::is_void_v<T>) {
+        return result_type();
+      } else {
+        return result_type(std::in_place, static_cast<T>(_result));
+      }
+    }
+
+   private:
+    static auto on_complete(detail::io_completion *completion, std::int32_t result, std::uint32_t) noexcept -> void {
+      auto *self = static_cast<io_operation *>(completion);
+      self->_result = result;
+      self->_scheduler->enqueue(&self->_node);
+    }
+
+    Prepare _prepare;
+    detail::schedule_node _node{};
+    scheduler *_scheduler = nullptr;
+    std::int32_t _result = 0;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Returns an awaitable io_uring operation producing `T`, with `prepare` filling in the submission entry
+  template <class T, class Prepare>
+  [[nodiscard]] auto make_io_operation(Prepare prepare) -> io_operation<T, Prepare> {
+    return io_operation<T, Prepare>(AIO_MOV(prepare));
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Reads into `buffer` from `fd` at `offset`; produces the number of bytes read
+  [[nodiscard]] inline auto async_read(int fd, std::span<std::byte> buffer, std::uint64_t offset = current_position) {
+    return make_io_operation<std::size_t>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data());
+      sqe.len = detail::io_length(buffer.size());
+      sqe.off = offset;
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Writes `buffer` to `fd` at `offset`; produces the number of bytes written
+  [[nodiscard]] inline auto async_write(int fd, std::span<const std::byte> buffer, std::uint64_t offset = current_position) {
+    return make_io_operation<std::size_t>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_WRITE;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data());
+      sqe.len = detail::io_length(buffer.size());
+      sqe.off = offset;
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Writes the buffers in `buffers` in order to `fd` at `offset`; produces the number of bytes written
+  ///
+  /// `buffers` and the memory it points to must stay alive until the operation completes.
+  [[nodiscard]] inline auto async_writev(int fd, std::span<const iovec> buffers, std::uint64_t offset = current_position) {
+    return make_io_operation<std::size_t>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_WRITEV;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffers.data());
+      sqe.len = static_cast<std::uint32_t>(buffers.size());
+      sqe.off = offset;
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Waits until `fd` is ready for any of the poll(2) `events`; produces the returned events
+  [[nodiscard]] inline auto async_poll(int fd, short events) {
+    return make_io_operation<unsigned>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_POLL_ADD;
+      sqe.fd = fd;
+      sqe.poll32_events = static_cast<std::uint16_t>(events);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Flushes `fd` to stable storage; only its data (and the metadata needed to read it back) if `data_only`
+  [[nodiscard]] inline auto async_fsync(int fd, bool data_only = false) {
+    return make_io_operation<void>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_FSYNC;
+      sqe.fd = fd;
+      sqe.fsync_flags = data_only ? IORING_FSYNC_DATASYNC : 0;
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Opens `path` relative to the directory `dirfd` (or `AT_FDCWD`); produces the new descriptor
+  ///
+  /// `path` must stay alive until the operation completes.
+  [[nodiscard]] inline auto async_openat(int dirfd, const char *path, int flags, unsigned mode = 0) {
+    return make_io_operation<int>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_OPENAT;
+      sqe.fd = dirfd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(path);
+      sqe.len = mode;
+      sqe.open_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Fills `out` with the `STATX_*` fields in `mask` for `path`, relative to the directory `dirfd`
+  ///
+  /// `flags` takes the `AT_*` flags of statx(2). `path` and `out` must stay alive until the operation completes.
+  [[nodiscard]] inline auto async_statx(int dirfd, const char *path, int flags, unsigned mask, struct statx &out) {
+    return make_io_operation<void>([=, out = &out](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_STATX;
+      sqe.fd = dirfd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(path);
+      sqe.len = mask;
+      sqe.off = reinterpret_cast<std::uint64_t>(out);
+      sqe.statx_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Applies madvise(2) `advice` to the page-aligned range `[address, address + length)` from the ring's workers
+  ///
+  /// The length field of the request is 32 bits wide: a range of 4 GiB or more is advised up to
+  /// its first 4 GiB only.
+  [[nodiscard]] inline auto async_madvise(const void *address, std::size_t length, int advice) {
+    return make_io_operation<void>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_MADVISE;
+      sqe.fd = -1;
+      sqe.addr = reinterpret_cast<std::uint64_t>(address);
+      sqe.len = detail::io_length(length);
+      sqe.fadvise_advice = static_cast<std::uint32_t>(advice);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Receives into `buffer` from the socket `fd`; produces the number of bytes received, zero at the end of the stream
+  [[nodiscard]] inline auto async_recv(int fd, std::span<std::byte> buffer, int flags = 0) {
+    return make_io_operation<std::size_t>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_RECV;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data());
+      sqe.len = detail::io_length(buffer.size());
+      sqe.msg_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Sends `buffer` on the socket `fd`; produces the number of bytes sent
+  ///
+  /// `MSG_NOSIGNAL` is passed by default so that a peer that went away fails the send with
+  /// `EPIPE` instead of raising `SIGPIPE`.
+  [[nodiscard]] inline auto async_send(int fd, std::span<const std::byte> buffer, int flags = MSG_NOSIGNAL) {
+    return make_io_operation<std::size_t>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_SEND;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(buffer.data());
+      sqe.len = detail::io_length(buffer.size());
+      sqe.msg_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Gather-sends the buffers in `buffers` in order on the socket `fd`; produces the number of bytes sent
+  ///
+  /// The message header lives in the awaitable. `buffers` and the memory it points to must stay
+  /// alive until the operation completes.
+  [[nodiscard]] inline auto async_sendv(int fd, std::span<const iovec> buffers, int flags = MSG_NOSIGNAL) {
+    return make_io_operation<std::size_t>([=, message = msghdr{}](io_uring_sqe &sqe) mutable noexcept {
+      message.msg_iov = const_cast<iovec *>(buffers.data());
+      message.msg_iovlen = buffers.size();
+      sqe.opcode = IORING_OP_SENDMSG;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(&message);
+      sqe.len = 1;
+      sqe.msg_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Accepts one connection on the listening socket `fd`; produces the connected socket
+  ///
+  /// `flags` takes the `SOCK_*` flags of accept4(2).
+  [[nodiscard]] inline auto async_accept(int fd, int flags = SOCK_CLOEXEC) {
+    return make_io_operation<int>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_ACCEPT;
+      sqe.fd = fd;
+      sqe.accept_flags = static_cast<std::uint32_t>(flags);
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Connects the socket `fd` to `address`
+  ///
+  /// `address` must stay alive until the operation completes.
+  [[nodiscard]] inline auto async_connect(int fd, const sockaddr *address, socklen_t size) {
+    return make_io_operation<void>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_CONNECT;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<std::uint64_t>(address);
+      sqe.off = size;
+    });
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Closes `fd`
+  [[nodiscard]] inline auto async_close(int fd) {
+    return make_io_operation<void>([=](io_uring_sqe &sqe) noexcept {
+      sqe.opcode = IORING_OP_CLOSE;
+      sqe.fd = fd;
+    });
+  }
+}  // namespace aio
+
+#endif  // AIO_IO_HPP
@@ -0,0 +1,575 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_IPC_CHANNEL_HPP
+#define AIO_IPC_CHANNEL_HPP
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include "detail/futex.hpp"
+#include "detail/macros.hpp"
+#include "io.hpp"
+#include "lane.hpp"
+#include "result.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace aio {
+  namespace detail {
+    // Shared-memory layout of an ipc_channel: a header, then `capacity` slots of `slot_size` bytes.
+    // Every field that one side writes sits on its own cache line.
+    struct ipc_notification {
+      std::atomic<std::uint32_t> sequence{0};       // Futex word, bumped when futex sleepers are woken
+      std::atomic<std::uint32_t> futex_sleepers{0}; // Threads blocked in futex_wait on `sequence`
+      std::atomic<std::uint32_t> fd_sleepers{0};    // Waiters armed on the eventfd
+    };
+
+    struct ipc_header {
+      static constexpr std::uint64_t magic_value = 0x3163706f69616961; // "aioaipc1"
+
+      std::uint64_t magic;
+      std::uint32_t version;
+      std::uint32_t slot_size;
+      std::uint64_t capacity;
+      std::uint32_t multiple_producers;
+      std::atomic<std::uint32_t> closed{0};
+      alignas(64) std::atomic<std::uint64_t> tail{0};
+      alignas(64) std::atomic<std::uint64_t> head{0};
+      alignas(64) ipc_notification data{};
+      alignas(64) ipc_notification space{};
+    };
+
+    // A slot is free for the producer of position `p` when its sequence is `p`, and holds the
+    // message of position `p` when it is `p + 1` (Vyukov's bounded queue).
+    struct ipc_slot {
+      std::atomic<std::uint64_t> sequence;
+      std::uint32_t size;
+      std::uint32_t reserved;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+                  "shared-memory atomics must be lock-free");
+    static_assert(sizeof(ipc_header) % 64 == 0);
+
+    inline auto cpu_relax() noexcept -> void {
+#if defined(__x86_64__) || defined(__i386__)
+      _mm_pause();
+#endif
+    }
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Producers an ipc_channel admits
+  enum class ipc_producers : std::uint8_t { single, multiple };
+
+  /// \ingroup io
+  ///
+  /// \brief Shape of an ipc_channel, fixed when it is created
+  struct ipc_channel_options {
+    std::size_t slot_size = 256;  ///< Bytes per message slot, a multiple of 64; messages take up to 16 bytes less
+    std::size_t capacity = 1024;  ///< Number of slots, a power of two
+    ipc_producers producers = ipc_producers::single;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief The descriptors that make up an ipc_channel, to hand to another process
+  struct ipc_channel_descriptors {
+    int memory = -1;      ///< The memfd holding the ring
+    int data_event = -1;  ///< Eventfd signalled when a message arrives for a sleeping receiver
+    int space_event = -1; ///< Eventfd signalled when a slot frees up for a sleeping sender
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Message channel between processes on one host through shared memory
+  ///
+  /// The messages travel through a ring of fixed-size slots in a sealed `memfd` mapped by both
+  /// processes, so a hop costs a copy into the slot and out again, and no system call as long as
+  /// the other side is awake. A side that finds the ring empty (or full) goes to sleep in one of
+  /// two ways: threads block on a futex in the shared mapping (receive_blocking(),
+  /// send_blocking()), coroutines await an eventfd through the scheduler's io_uring (receive(),
+  /// send()). Either side announces sleeping in the shared header first, and the other side only
+  /// makes the wake-up system call when someone does. A configurable spin (set_spin()) keeps a
+  /// side polling a little while before it sleeps, which lets a busy peer hand over messages
+  /// without any system call at all.
+  ///
+  /// The eventfds also serve event loops other than aio's: arm the side, poll its notification
+  /// descriptor, then disarm and drain (see arm_receive()).
+  ///
+  /// A channel has one receiving process, in which receives must not run concurrently, and one
+  /// or (with ipc_producers::multiple) several sending processes and threads. create() sets up
+  /// a channel; the other processes open() it from its descriptors, inherited or passed with
+  /// send_descriptors(). The layout found in a mapping is validated on open(), and message sizes
+  /// are checked on receipt, so a misbehaving peer cannot make a process read out of bounds.
+  /// shutdown() ends the channel for all processes: sends fail and receives drain what is left.
+  class ipc_channel {
+   public:
+    using void_result = result<void, std::error_code>;
+    using size_result = result<std::size_t, std::error_code>;
+
+    ipc_channel() noexcept = default;
+
+    ipc_channel(const ipc_channel &) = delete;
+    ipc_channel(ipc_channel &&other) noexcept { *this = AIO_MOV(other); }
+
+    auto operator=(const ipc_channel &) -> ipc_channel & = delete;
+    auto operator=(ipc_channel &&other) noexcept -> ipc_channel & {
+      if (this != &other) {
+        reset();
+        _header = std::exchange(other._header, nullptr);
+        _mapped_size = std::exchange(other._mapped_size, 0);
+        _fds = std::exchange(other._fds, ipc_channel_descriptors{});
+        _slot_size = other._slot_size;
+        _mask = other._mask;
+        _multiple_producers = other._multiple_producers;
+        _spin = other._spin;
+      }
+      return *this;
+    }
+
+    ~ipc_channel() { reset(); }
+
+    /// \brief Creates a channel shaped by `options`
+    [[nodiscard]] static auto create(ipc_channel_options options = {}) -> result<ipc_channel, std::error_code> {
+      if (options.slot_size < 64 || options.slot_size % 64 != 0 || options.slot_size > UINT32_MAX || !std::has_single_bit(options.capacity)) {
+        return failure<std::error_code>(std::make_error_code(std::errc::invalid_argument));
+      }
+      ipc_channel channel;
+      channel._fds.memory = ::memfd_create("aio-ipc-channel", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+      if (channel._fds.memory < 0) return system_failure();
+      const auto size = sizeof(detail::ipc_header) + options.capacity * options.slot_size;
+      if (::ftruncate(channel._fds.memory, static_cast<off_t>(size)) != 0) return system_failure();
+      // Sealing the size keeps a peer from truncating the memory under the other's mapping.
+      if (::fcntl(channel._fds.memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) return system_failure();
+      if (auto opened = channel.open_events(); !opened) return failure<std::error_code>(opened.error());
+      if (auto mapped = channel.map(size); !mapped) return failure<std::error_code>(mapped.error());
+
+      auto *header = ::new (channel._header) detail::ipc_header{};
+      header->magic = detail::ipc_header::magic_value;
+      header->version = 1;
+      header->slot_size = static_cast<std::uint32_t>(options.slot_size);
+      header->capacity = options.capacity;
+      header->multiple_producers = options.producers == ipc_producers::multiple;
+      channel.adopt_layout();
+      for (std::size_t i = 0; i < options.capacity; ++i) {
+        ::new (channel.slot_at(i)) detail::ipc_slot{.sequence = i, .size = 0, .reserved = 0};
+      }
+      return channel;
+    }
+
+    /// \brief Opens the channel made of `descriptors`, taking ownership of them
+    [[nodiscard]] static auto open(ipc_channel_descriptors descriptors) -> result<ipc_channel, std::error_code> {
+      ipc_channel channel;
+      channel._fds = descriptors;
+      const auto seals = ::fcntl(descriptors.memory, F_GET_SEALS);
+      if (seals < 0) return system_failure();
+      struct stat info{};
+      if (::fstat(descriptors.memory, &info) != 0) return system_failure();
+      const auto size = static_cast<std::size_t>(info.st_size);
+      if ((seals & F_SEAL_SHRINK) == 0 || size < sizeof(detail::ipc_header)) return invalid_layout();
+      if (auto mapped = channel.map(size); !mapped) return failure<std::error_code>(mapped.error());
+
+      const auto &header = *channel._header;
+      const auto slots = size - sizeof(detail::ipc_header);
+      if (header.magic != detail::ipc_header::magic_value || header.version != 1 || header.slot_size < 64 || header.slot_size % 64 != 0 ||
+          !std::has_single_bit(header.capacity) || slots / header.slot_size != header.capacity || slots % header.slot_size != 0) {
+        return invalid_layout();
+      }
+      channel.adopt_layout();
+      return channel;
+    }
+
+    /// \brief Returns the descriptors of the channel, which stay owned by it
+    [[nodiscard]] auto descriptors() const noexcept -> const ipc_channel_descriptors & { return _fds; }
+
+    /// \brief Sends the channel's descriptors over the Unix domain socket `socket`
+    auto send_descriptors(int socket) const -> void_result {
+      const int fds[] = {_fds.memory, _fds.data_event, _fds.space_event};
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))]{};
+      char tag = 'c';
+      iovec payload{&tag, 1};
+      msghdr message{};
+      message.msg_iov = &payload;
+      message.msg_iovlen = 1;
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+      auto *rights = CMSG_FIRSTHDR(&message);
+      rights->cmsg_level = SOL_SOCKET;
+      rights->cmsg_type = SCM_RIGHTS;
+      rights->cmsg_len = CMSG_LEN(sizeof(fds));
+      std::memcpy(CMSG_DATA(rights), fds, sizeof(fds));
+      if (::sendmsg(socket, &message, MSG_NOSIGNAL) != 1) return system_failure();
+      return void_result();
+    }
+
+    /// \brief Receives descriptors sent with send_descriptors() from `socket`, to open()
+    [[nodiscard]] static auto receive_descriptors(int socket) -> result<ipc_channel_descriptors, std::error_code> {
+      int fds[3] = {-1, -1, -1};
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))]{};
+      char tag = 0;
+      iovec payload{&tag, 1};
+      msghdr message{};
+      message.msg_iov = &payload;
+      message.msg_iovlen = 1;
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+      const auto received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+      if (received < 0) return system_failure();
+      const auto *rights = CMSG_FIRSTHDR(&message);
+      const bool complete = received == 1 && tag == 'c' && (message.msg_flags & MSG_CTRUNC) == 0 && rights &&
+                            rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS && rights->cmsg_len == CMSG_LEN(sizeof(fds));
+      if (rights && rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS) {
+        std::memcpy(fds, CMSG_DATA(rights), std::min(sizeof(fds), rights->cmsg_len - CMSG_LEN(0)));
+      }
+      if (!complete) {
+        for (const int fd : fds) {
+          if (fd >= 0) ::close(fd);
+        }
+        return failure<std::error_code>(std::make_error_code(std::errc::bad_message));
+      }
+      return ipc_channel_descriptors{fds[0], fds[1], fds[2]};
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _header != nullptr; }
+
+    /// \brief Returns the size of the largest message
+    [[nodiscard]] auto max_message_size() const noexcept -> std::size_t { return _slot_size - sizeof(detail::ipc_slot); }
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return _mask + 1; }
+
+    /// \brief Sets how long a side polls the ring before it goes to sleep (none by default)
+    ///
+    /// Spinning trades CPU time for latency: worthwhile when both processes have cores of their
+    /// own, counterproductive when they share one. A coroutine spins on its scheduler's thread.
+    auto set_spin(clock::duration spin) noexcept -> void { _spin = spin; }
+
+    /// \brief Sends `message` if a slot is free; produces false if the channel is full
+    ///
+    /// Fails with `message_size` if `message` exceeds max_message_size() and with `broken_pipe`
+    /// once the channel was shut down.
+    auto try_send(std::span<const std::byte> message) -> result<bool, std::error_code> {
+      if (message.size() > max_message_size()) return failure<std::error_code>(std::make_error_code(std::errc::message_size));
+      if (_header->closed.load(std::memory_order_acquire)) return failure<std::error_code>(std::make_error_code(std::errc::broken_pipe));
+      auto position = _header->tail.load(std::memory_order_relaxed);
+      detail::ipc_slot *slot;
+      while (true) {
+        slot = slot_at(position & _mask);
+        const auto sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto lag = static_cast<std::int64_t>(sequence - position);
+        if (lag < 0) return false;
+        if (lag > 0) {
+          position = _header->tail.load(std::memory_order_relaxed);
+        } else if (!_multiple_producers) {
+          _header->tail.store(position + 1, std::memory_order_relaxed);
+          break;
+        } else if (_header->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      slot->size = static_cast<std::uint32_t>(message.size());
+      if (!message.empty()) std::memcpy(payload(slot), message.data(), message.size());
+      slot->sequence.store(position + 1, std::memory_order_release);
+      notify(_header->data, _fds.data_event);
+      return true;
+    }
+
+    /// \brief Takes the next message into `buffer`; produces its size, or nothing if the channel is empty
+    ///
+    /// Fails with `message_size`, leaving the message in place, if `buffer` is too small for it,
+    /// with `bad_message` if the sender wrote a corrupt slot, which is discarded so that the next
+    /// call goes on with the following message, and with stream_errc::end_of_stream once the
+    /// channel was shut down and is empty.
+    auto try_receive(std::span<std::byte> buffer) -> result<std::optional<std::size_t>, std::error_code> {
+      const auto position = _header->head.load(std::memory_order_relaxed);
+      auto *slot = slot_at(position & _mask);
+      if (slot->sequence.load(std::memory_order_acquire) != position + 1) {
+        if (_header->closed.load(std::memory_order_acquire)) {
+          // A send may have completed between the two loads.
+          if (slot->sequence.load(std::memory_order_acquire) != position + 1) {
+            return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+          }
+        } else {
+          return std::optional<std::size_t>();
+        }
+      }
+      const std::size_t size = slot->size;
+      if (size > max_message_size()) {
+        // Leaving the slot in place would report the same error forever.
+        release(slot, position);
+        return failure<std::error_code>(std::make_error_code(std::errc::bad_message));
+      }
+      if (size > buffer.size()) return failure<std::error_code>(std::make_error_code(std::errc::message_size));
+      if (size != 0) std::memcpy(buffer.data(), payload(slot), size);
+      release(slot, position);
+      return std::optional<std::size_t>(size);
+    }
+
+    /// \brief Sends `message`, suspending while the channel is full
+    [[nodiscard]] auto send(std::span<const std::byte> message) -> task<void_result> {
+      while (true) {
+        auto sent = spin_send(message);
+        if (!sent) co_return failure<std::error_code>(sent.error());
+        if (*sent) co_return void_result();
+        if (!arm(_header->space, [&] { return send_ready(); })) continue;
+        auto woken = co_await await_event(_fds.space_event);
+        _header->space.fd_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (!woken) co_return failure<std::error_code>(woken.error());
+      }
+    }
+
+    /// \brief Takes the next message into `buffer`, suspending while the channel is empty
+    [[nodiscard]] auto receive(std::span<std::byte> buffer) -> task<size_result> {
+      while (true) {
+        auto received = spin_receive(buffer);
+        if (!received) co_return failure<std::error_code>(received.error());
+        if (*received) co_return **received;
+        if (!arm(_header->data, [&] { return receive_ready(); })) continue;
+        auto woken = co_await await_event(_fds.data_event);
+        _header->data.fd_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (!woken) co_return failure<std::error_code>(woken.error());
+      }
+    }
+
+    /// \brief Sends `message`, blocking the calling thread while the channel is full
+    auto send_blocking(std::span<const std::byte> message) -> void_result {
+      while (true) {
+        auto sent = spin_send(message);
+        if (!sent) return failure<std::error_code>(sent.error());
+        if (*sent) return void_result();
+        sleep(_header->space, [&] { return send_ready(); });
+      }
+    }
+
+    /// \brief Takes the next message into `buffer`, blocking the calling thread while the channel is empty
+    auto receive_blocking(std::span<std::byte> buffer) -> size_result {
+      while (true) {
+        auto received = spin_receive(buffer);
+        if (!received) return failure<std::error_code>(received.error());
+        if (*received) return **received;
+        sleep(_header->data, [&] { return receive_ready(); });
+      }
+    }
+
+    /// \brief Returns the descriptor that becomes readable when the receiving side is armed and a message arrives
+    [[nodiscard]] auto receive_notification_fd() const noexcept -> int { return _fds.data_event; }
+
+    /// \brief Prepares the receiving side to sleep in a foreign event loop
+    ///
+    /// Produces false if there is no need: a message arrived, or the channel was shut down.
+    /// Otherwise poll receive_notification_fd() for readability and call disarm_receive() once
+    /// it is readable (or the wait is abandoned) before receiving with try_receive().
+    [[nodiscard]] auto arm_receive() noexcept -> bool {
+      return arm(_header->data, [&] { return receive_ready(); });
+    }
+
+    auto disarm_receive() noexcept -> void { disarm(_header->data, _fds.data_event); }
+
+    /// \brief Returns the descriptor that becomes readable when the sending side is armed and a slot frees up
+    [[nodiscard]] auto send_notification_fd() const noexcept -> int { return _fds.space_event; }
+
+    /// \brief Prepares a sender to sleep in a foreign event loop, like arm_receive()
+    [[nodiscard]] auto arm_send() noexcept -> bool {
+      return arm(_header->space, [&] { return send_ready(); });
+    }
+
+    auto disarm_send() noexcept -> void { disarm(_header->space, _fds.space_event); }
+
+    /// \brief Ends the channel for every process and wakes all sleepers
+    auto shutdown() noexcept -> void {
+      _header->closed.store(1, std::memory_order_release);
+      notify(_header->data, _fds.data_event);
+      notify(_header->space, _fds.space_event);
+    }
+
+    /// \brief Unmaps the channel and closes this process's descriptors
+    auto reset() noexcept -> void {
+      if (_header) ::munmap(_header, _mapped_size);
+      _header = nullptr;
+      _mapped_size = 0;
+      for (const int fd : {_fds.memory, _fds.data_event, _fds.space_event}) {
+        if (fd >= 0) ::close(fd);
+      }
+      _fds = {};
+    }
+
+   private:
+    static auto system_failure() -> failure<std::error_code> { return failure<std::error_code>(std::error_code(errno, std::system_category())); }
+    static auto invalid_layout() -> failure<std::error_code> { return failure<std::error_code>(std::make_error_code(std::errc::invalid_argument)); }
+
+    auto open_events() -> void_result {
+      _fds.data_event = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+      if (_fds.data_event < 0) return system_failure();
+      _fds.space_event = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+      if (_fds.space_event < 0) return system_failure();
+      return void_result();
+    }
+
+    auto map(std::size_t size) -> void_result {
+      void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fds.memory, 0);
+      if (memory == MAP_FAILED) return system_failure();
+      _header = static_cast<detail::ipc_header *>(memory);
+      _mapped_size = size;
+      return void_result();
+    }
+
+    // Takes the shape from the validated header once, so later changes by a peer cannot move
+    // accesses out of the mapping.
+    auto adopt_layout() noexcept -> void {
+      _slot_size = _header->slot_size;
+      _mask = _header->capacity - 1;
+      _multiple_producers = _header->multiple_producers != 0;
+    }
+
+    [[nodiscard]] auto slot_at(std::uint64_t index) const noexcept -> detail::ipc_slot * {
+      return reinterpret_cast<detail::ipc_slot *>(reinterpret_cast<std::byte *>(_header) + sizeof(detail::ipc_header) + index * _slot_size);
+    }
+
+    [[nodiscard]] static auto payload(detail::ipc_slot *slot) noexcept -> std::byte * { return reinterpret_cast<std::byte *>(slot + 1); }
+
+    // Hands the slot at `position` back to the producers and moves on to the next one.
+    auto release(detail::ipc_slot *slot, std::uint64_t position) noexcept -> void {
+      slot->sequence.store(position + _mask + 1, std::memory_order_release);
+      _header->head.store(position + 1, std::memory_order_relaxed);
+      notify(_header->space, _fds.space_event);
+    }
+
+    [[nodiscard]] auto receive_ready() const noexcept -> bool {
+      const auto position = _header->head.load(std::memory_order_relaxed);
+      return slot_at(position & _mask)->sequence.load(std::memory_order_acquire) == position + 1 || _header->closed.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] auto send_ready() const noexcept -> bool {
+      const auto position = _header->tail.load(std::memory_order_relaxed);
+      return slot_at(position & _mask)->sequence.load(std::memory_order_acquire) == position || _header->closed.load(std::memory_order_acquire);
+    }
+
+    // Retries for the spin duration before reporting the channel full or empty.
+    auto spin_send(std::span<const std::byte> message) -> result<bool, std::error_code> {
+      auto sent = try_send(message);
+      if (!sent || *sent || _spin <= clock::duration::zero()) return sent;
+      const auto until = clock::now() + _spin;
+      do {
+        for (int i = 0; i < 64 && !send_ready(); ++i) detail::cpu_relax();
+        sent = try_send(message);
+      } while (sent && !*sent && clock::now() < until);
+      return sent;
+    }
+
+    auto spin_receive(std::span<std::byte> buffer) -> result<std::optional<std::size_t>, std::error_code> {
+      auto received = try_receive(buffer);
+      if (!received || *received || _spin <= clock::duration::zero()) return received;
+      const auto until = clock::now() + _spin;
+      do {
+        for (int i = 0; i < 64 && !receive_ready(); ++i) detail::cpu_relax();
+        received = try_receive(buffer);
+      } while (received && !*received && clock::now() < until);
+      return received;
+    }
+
+    // The sleeper side of the wake-up protocol: announce the sleeper, then check the condition
+    // again. The full fences pair with the one in notify(), so either the sleeper sees the
+    // progress or the notifier sees the sleeper.
+    template <class Ready>
+    static auto arm(detail::ipc_notification &notification, Ready ready) noexcept -> bool {
+      notification.fd_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      if (!ready()) return true;
+      notification.fd_sleepers.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    static auto disarm(detail::ipc_notification &notification, int event) noexcept -> void {
+      notification.fd_sleepers.fetch_sub(1, std::memory_order_relaxed);
+      eventfd_t token;
+      (void)::eventfd_read(event, &token);
+    }
+
+    template <class Ready>
+    static auto sleep(detail::ipc_notification &notification, Ready ready) noexcept -> void {
+      notification.futex_sleepers.fetch_add(1, std::memory_order_seq_cst);
+      const auto sequence = notification.sequence.load(std::memory_order_acquire);
+      if (!ready()) detail::futex_wait(&notification.sequence, sequence, std::nullopt, true);
+      notification.futex_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Wakes the sleepers of `notification`, if any. Every eventfd sleeper gets a token of the
+    // semaphore; spare tokens only cause a spurious wake-up and another check.
+    static auto notify(detail::ipc_notification &notification, int event) noexcept -> void {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (notification.futex_sleepers.load(std::memory_order_relaxed) != 0) {
+        notification.sequence.fetch_add(1, std::memory_order_release);
+        detail::futex_wake(&notification.sequence, INT_MAX, true);
+      }
+      if (const auto sleepers = notification.fd_sleepers.load(std::memory_order_relaxed); sleepers != 0) {
+        (void)::eventfd_write(event, sleepers);
+      }
+    }
+
+    // Takes one token of the semaphore eventfd, waiting for it through the io_uring.
+    auto await_event(int event) -> task<void_result> {
+      eventfd_t token = 0;
+      auto read = co_await async_read(event, std::as_writable_bytes(std::span(&token, 1)));
+      if (!read) co_return failure<std::error_code>(read.error());
+      co_return void_result();
+    }
+
+    detail::ipc_header *_header = nullptr;
+    std::size_t _mapped_size = 0;
+    ipc_channel_descriptors _fds{};
+    std::size_t _slot_size = 0;
+    std::uint64_t _mask = 0;
+    bool _multiple_producers = false;
+    clock::duration _spin{};
+  };
+}  // namespace aio
+
+#endif  // AIO_IPC_CHANNEL_HPP
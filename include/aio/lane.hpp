@@ -0,0 +1,79 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+#ifndef AIO_LANE_HPP
+#define AIO_LANE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace aio {
+
+  /**
+   * \defgroup scheduling scheduling
+   * \brief The `scheduling` module provides tasks, the ready queue and the scheduler that drives them.
+   */
+
+  /// \ingroup scheduling
+  ///
+  /// \brief The clock used for deadlines, timers and scheduler accounting
+  using clock = std::chrono::steady_clock;
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Sentinel deadline for work that has no deadline
+  inline constexpr clock::time_point no_deadline = clock::time_point::max();
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Priority lane a unit of work is queued on
+  ///
+  /// Lanes are served in declaration order. Within every lane, work is ordered by earliest
+  /// deadline first, and work without a deadline runs in FIFO order after it (aging so that it is
+  /// not starved). The lower lanes are only served when all higher lanes are empty, or when they
+  /// have been passed over for longer than their fairness quota (see
+  /// scheduler_options::fairness_quota).
+  enum class lane : std::uint8_t {
+    critical = 0,  ///< Latency-critical work, e.g. RPC handlers
+    normal = 1,    ///< Default lane
+    background = 2 ///< Bulk work that only runs on spare capacity
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Number of lanes known to the scheduler
+  inline constexpr std::size_t lane_count = 3;
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Returns the index of the lane in per-lane arrays
+  [[nodiscard]] constexpr auto lane_index(lane l) noexcept -> std::size_t { return static_cast<std::size_t>(l); }
+}  // namespace aio
+
+#endif  // AIO_LANE_HPP
@@ -0,0 +1,129 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_LATCH_HPP
+#define AIO_LATCH_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+
+#include "coroutine.hpp"
+#include "detail/waiter.hpp"
+
+namespace aio {
+  /// \ingroup coroutine
+  ///
+  /// \brief Single-use countdown latch for coroutines
+  ///
+  /// Coroutines awaiting wait() suspend until the counter reaches zero. The counter is an atomic
+  /// and the waiters form a lock-free intrusive stack in their own frames; the arrival that brings
+  /// the counter to zero detaches the whole stack in one exchange and resumes it as one batch per
+  /// scheduler. count_down() may be called from any thread, including non-coroutine code.
+  class latch {
+   public:
+    class awaiter;
+
+    explicit latch(std::ptrdiff_t expected) noexcept : _count(expected) {
+      if (expected <= 0) _waiters.store(ready_tag(), std::memory_order_relaxed);
+    }
+
+    latch(const latch &) = delete;
+    auto operator=(const latch &) -> latch & = delete;
+
+    /// \brief Decrements the counter by `n`, releasing all waiters when it reaches zero
+    auto count_down(std::ptrdiff_t n = 1) noexcept -> void {
+      if (_count.fetch_sub(n, std::memory_order_acq_rel) - n == 0) {
+        auto *waiters = _waiters.exchange(ready_tag(), std::memory_order_acq_rel);
+        if (waiters) detail::resume_waiters(waiters);
+      }
+    }
+
+    /// \brief Returns true once the counter has reached zero
+    [[nodiscard]] auto try_wait() const noexcept -> bool {
+      return _waiters.load(std::memory_order_acquire) == ready_tag();
+    }
+
+    /// \brief Returns an awaitable that completes once the counter has reached zero
+    [[nodiscard]] auto wait() noexcept -> awaiter;
+
+    /// \brief Decrements the counter by `n` and waits for it to reach zero
+    [[nodiscard]] auto arrive_and_wait(std::ptrdiff_t n = 1) noexcept -> awaiter;
+
+   private:
+    [[nodiscard]] auto ready_tag() const noexcept -> detail::waiter * {
+      return reinterpret_cast<detail::waiter *>(const_cast<latch *>(this));
+    }
+
+    auto add_waiter(detail::waiter *waiter) noexcept -> bool {
+      auto *head = _waiters.load(std::memory_order_acquire);
+      do {
+        if (head == ready_tag()) return false;
+        waiter->next = head;
+      } while (!_waiters.compare_exchange_weak(head, waiter, std::memory_order_acq_rel, std::memory_order_acquire));
+      return true;
+    }
+
+    std::atomic<std::ptrdiff_t> _count;
+    std::atomic<detail::waiter *> _waiters{nullptr};
+  };
+
+  class latch::awaiter : detail::waiter {
+   public:
+    awaiter(latch &latch, std::ptrdiff_t arrivals) noexcept : _latch(&latch), _arrivals(arrivals) {}
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return _arrivals == 0 && _latch->try_wait(); }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+      prepare(coro);
+      // Register before arriving, so that the arrival completing the latch also releases us. Once
+      // registered this frame may be resumed (and destroyed) by another thread, so work on copies.
+      auto *target = _latch;
+      const auto arrivals = _arrivals;
+      const bool suspended = target->add_waiter(this);
+      if (arrivals != 0) target->count_down(arrivals);
+      return suspended;
+    }
+
+    constexpr auto await_resume() const noexcept -> void {}
+
+   private:
+    latch *_latch;
+    std::ptrdiff_t _arrivals;
+  };
+
+  inline auto latch::wait() noexcept -> awaiter { return awaiter(*this, 0); }
+
+  inline auto latch::arrive_and_wait(std::ptrdiff_t n) noexcept -> awaiter { return awaiter(*this, n); }
+
+  static_assert(aio::awaitable_of<latch::awaiter, void>);
+}  // namespace aio
+
+#endif  // AIO_LATCH_HPP
@@ -0,0 +1,477 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_LOGGER_HPP
+#define AIO_LOGGER_HPP
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "buffer_pool.hpp"
+#include "buffered_writer.hpp"
+#include "latch.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Severity of a log record
+  enum class log_level : std::uint8_t { trace, debug, info, warn, error, fatal };
+
+  /// \ingroup io
+  ///
+  /// \brief Format string of a log record; must be a string literal
+  ///
+  /// Records store the pointer, not the text, so the string must outlive the logger. The
+  /// consteval constructor rejects anything that is not a constant expression. `{}` is replaced by
+  /// the next argument; `{{` and `}}` produce literal braces.
+  struct log_format {
+    template <std::size_t N>
+    consteval log_format(const char (&text)[N]) noexcept : text(text) {}  // NOLINT(google-explicit-constructor)
+
+    const char *text;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Options of a logger
+  struct logger_options {
+    /// Bytes of each producer thread's ring; rounded up to a power of two.
+    std::size_t ring_size = 64 * 1024;
+
+    /// Records below this level are discarded by the producer.
+    log_level level = log_level::info;
+
+    /// How often the background loop drains the rings.
+    clock::duration drain_interval = std::chrono::milliseconds(1);
+
+    /// Upper bound on how long drained lines sit in the output buffer before being written.
+    clock::duration flush_interval = std::chrono::milliseconds(10);
+  };
+
+  namespace detail {
+    template <class T>
+    concept log_string = std::convertible_to<const T &, std::string_view> && !std::is_arithmetic_v<T>;
+
+    template <class T>
+    concept log_scalar = std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>;
+
+    // Wire form of an argument: scalars by value, strings as a length followed by their bytes.
+    template <class T>
+    struct log_stored {
+      using type = T;
+    };
+    template <log_string T>
+    struct log_stored<T> {
+      using type = std::string_view;
+    };
+    template <class T>
+      requires std::is_enum_v<T>
+    struct log_stored<T> {
+      using type = std::underlying_type_t<T>;
+    };
+    template <class T>
+    using log_stored_t = typename log_stored<T>::type;
+
+    template <class T>
+    [[nodiscard]] constexpr auto log_encoded_size(const T &value) noexcept -> std::size_t {
+      if constexpr (log_string<T>) {
+        return sizeof(std::uint32_t) + std::string_view(value).size();
+      } else {
+        return sizeof(log_stored_t<T>);
+      }
+    }
+
+    template <class T>
+    auto log_encode(std::byte *&out, const T &value) noexcept -> void {
+      if constexpr (log_string<T>) {
+        const std::string_view text(value);
+        const auto length = static_cast<std::uint32_t>(text.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), text.data(), text.size());
+        out += sizeof(length) + text.size();
+      } else {
+        const auto stored = static_cast<log_stored_t<T>>(value);
+        std::memcpy(out, &stored, sizeof(stored));
+        out += sizeof(stored);
+      }
+    }
+
+    template <class T>
+    auto log_decode(const std::byte *&in) noexcept -> T {
+      if constexpr (std::same_as<T, std::string_view>) {
+        std::uint32_t length;
+        std::memcpy(&length, in, sizeof(length));
+        const std::string_view text(reinterpret_cast<const char *>(in + sizeof(length)), length);
+        in += sizeof(length) + length;
+        return text;
+      } else {
+        T value;
+        std::memcpy(&value, in, sizeof(value));
+        in += sizeof(value);
+        return value;
+      }
+    }
+
+    template <class T>
+    auto log_append(std::string &out, const T &value) -> void {
+      if constexpr (std::same_as<T, std::string_view>) {
+        out += value;
+      } else if constexpr (std::same_as<T, bool>) {
+        out += value ? "true" : "false";
+      } else if constexpr (std::same_as<T, char>) {
+        out += value;
+      } else if constexpr (std::is_pointer_v<T>) {
+        char digits[2 + 2 * sizeof(void *)] = {'0', 'x'};
+        const auto end = std::to_chars(digits + 2, std::end(digits), reinterpret_cast<std::uintptr_t>(value), 16).ptr;
+        out.append(digits, end);
+      } else {
+        char digits[64];
+        const auto end = std::to_chars(digits, std::end(digits), value).ptr;
+        out.append(digits, end);
+      }
+    }
+
+    // Appends `format` with each `{}` replaced by the next argument.
+    template <class... Stored>
+    auto log_render(std::string &out, const char *format, const std::byte *payload) -> void {
+      void (*const emitters[])(std::string &, const std::byte *&) = {
+          +[](std::string &o, const std::byte *&p) { log_append(o, log_decode<Stored>(p)); }..., nullptr};
+      std::size_t argument = 0;
+      for (const char *c = format; *c; ++c) {
+        if ((c[0] == '{' && c[1] == '{') || (c[0] == '}' && c[1] == '}')) {
+          out += *c++;
+        } else if (c[0] == '{' && c[1] == '}' && argument < sizeof...(Stored)) {
+          emitters[argument++](out, payload);
+          ++c;
+        } else {
+          out += *c;
+        }
+      }
+    }
+
+    using log_renderer = void (*)(std::string &, const char *, const std::byte *);
+
+    struct log_record_header {
+      static constexpr std::uint32_t padding = 1u << 31; // flag in `size` of the filler before a wrap-around
+
+      std::uint32_t size; // whole record, 8-byte aligned
+      log_level level;
+      log_renderer render;
+      const char *format;
+      std::int64_t timestamp; // nanoseconds since the epoch
+    };
+
+    // Byte ring with one producer (the owning thread) and one consumer (the drain loop). Records
+    // are contiguous; one that does not fit before the end is preceded by a filler up to the end.
+    struct alignas(64) log_ring {
+      explicit log_ring(std::size_t size)
+          : capacity(std::bit_ceil(std::max<std::size_t>(size, 4096))), bytes(std::make_unique<std::byte[]>(capacity)) {}
+
+      // Returns space for a record of `size` bytes (8-byte aligned), or nullptr if the ring is full.
+      auto reserve(std::uint32_t size) noexcept -> std::byte * {
+        const auto position = tail.load(std::memory_order_relaxed);
+        const auto offset = position & (capacity - 1);
+        const auto padding = offset + size > capacity ? capacity - offset : 0;
+        if (position + padding + size - cached_head > capacity) {
+          cached_head = head.load(std::memory_order_acquire);
+          if (position + padding + size - cached_head > capacity) return nullptr;
+        }
+        if (padding != 0) {
+          const auto filler = static_cast<std::uint32_t>(padding) | log_record_header::padding;
+          std::memcpy(bytes.get() + offset, &filler, sizeof(filler));
+        }
+        pending = position + padding + size;
+        return bytes.get() + ((position + padding) & (capacity - 1));
+      }
+
+      auto commit() noexcept -> void { tail.store(pending, std::memory_order_release); }
+
+      const std::size_t capacity;
+      std::unique_ptr<std::byte[]> bytes;
+      std::uint64_t cached_head = 0;
+      std::uint64_t pending = 0;
+      alignas(64) std::atomic<std::uint64_t> tail{0};
+      alignas(64) std::atomic<std::uint64_t> head{0};
+      std::atomic<std::uint64_t> dropped{0};
+      std::atomic<bool> retired{false};   // the producer thread exited
+      std::atomic<bool> abandoned{false}; // the logger was destroyed; `bytes` is released
+    };
+
+    // The calling thread's rings, one per logger it has logged to. Rings are shared with their
+    // logger so that either side may go first; a thread exiting marks its rings for reclamation,
+    // and the entries of destroyed loggers are pruned the next time the thread adds a ring.
+    struct thread_log_rings {
+      thread_log_rings() = default;
+      thread_log_rings(const thread_log_rings &) = delete;
+      auto operator=(const thread_log_rings &) -> thread_log_rings & = delete;
+
+      ~thread_log_rings() {
+        for (auto &[id, ring] : rings) ring->retired.store(true, std::memory_order_release);
+      }
+
+      std::vector<std::pair<std::uint64_t, std::shared_ptr<log_ring>>> rings{};
+    };
+
+    inline thread_local thread_log_rings this_thread_log_rings{};
+
+    inline std::atomic<std::uint64_t> next_logger_id{1};
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Asynchronous logger writing through a buffered_writer
+  ///
+  /// Each producer thread appends binary records to its own single-producer ring: the level, a
+  /// timestamp, the format string's address and the raw argument bytes. Formatting is deferred
+  /// to a drain coroutine on the logger's scheduler, which renders the rings' records into text
+  /// and hands them to a buffered_writer, so lines reach the file in large io_uring writes. The
+  /// producer path performs no allocation, lock or system call (after the thread's first record,
+  /// which allocates its ring) and never blocks: when a ring is full the record is dropped and
+  /// counted, and the drain loop reports the count in the log.
+  ///
+  /// Arguments may be arithmetic values, enums, pointers (printed as addresses) and anything
+  /// convertible to `std::string_view`, whose bytes are copied into the record. Lines have the
+  /// form `2026-01-31T12:00:00.123456Z INFO message`. Records of one thread appear in order;
+  /// records of different threads are not interleaved by timestamp.
+  ///
+  /// close() must be awaited, on the logger's scheduler, before the logger is destroyed; it
+  /// drains every ring and syncs the file. Destroying the logger releases the rings' memory,
+  /// and each producer thread drops its remaining handle on them when it next starts logging
+  /// to another logger, or when it exits.
+  class logger {
+   public:
+    logger(scheduler &loop, int fd, buffer_pool &pool, logger_options options = {})
+        : _options(options),
+          _level(options.level),
+          _writer(loop, fd, pool, {.flush_interval = options.flush_interval}),
+          _id(detail::next_logger_id.fetch_add(1, std::memory_order_relaxed)) {
+      _line.reserve(64 * 1024);
+      loop.spawn(drain_loop());
+    }
+
+    logger(const logger &) = delete;
+    auto operator=(const logger &) -> logger & = delete;
+
+    ~logger() {
+      std::lock_guard lock(_rings_mutex);
+      for (auto &ring : _rings) {
+        ring->bytes.reset();
+        ring->abandoned.store(true, std::memory_order_release);
+      }
+    }
+
+    [[nodiscard]] auto level() const noexcept -> log_level { return _level.load(std::memory_order_relaxed); }
+    auto set_level(log_level level) noexcept -> void { _level.store(level, std::memory_order_relaxed); }
+    [[nodiscard]] auto enabled(log_level level) const noexcept -> bool { return level >= this->level(); }
+
+    /// \brief Records a log line if `level` is enabled; never blocks
+    ///
+    /// \return False if the record was dropped because the calling thread's ring was full
+    template <class... Args>
+      requires((detail::log_string<Args> || detail::log_scalar<Args>) && ...)
+    auto log(log_level level, log_format format, const Args &...args) noexcept -> bool {
+      if (!enabled(level)) return true;
+      const auto payload = (std::size_t{0} + ... + detail::log_encoded_size(args));
+      const auto size = static_cast<std::uint32_t>((sizeof(detail::log_record_header) + payload + 7) & ~std::size_t{7});
+      auto *ring = this_thread_ring();
+      if (!ring) return false;
+      auto *record = ring->reserve(size);
+      if (!record) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      timespec now;
+      ::clock_gettime(CLOCK_REALTIME, &now);
+      ::new (record) detail::log_record_header{size, level, &detail::log_render<detail::log_stored_t<Args>...>, format.text,
+                                                now.tv_sec * 1'000'000'000 + now.tv_nsec};
+      [[maybe_unused]] auto *out = record + sizeof(detail::log_record_header);
+      (detail::log_encode(out, args), ...);
+      ring->commit();
+      return true;
+    }
+
+    template <class... Args>
+    auto trace(log_format format, const Args &...args) noexcept -> bool { return log(log_level::trace, format, args...); }
+    template <class... Args>
+    auto debug(log_format format, const Args &...args) noexcept -> bool { return log(log_level::debug, format, args...); }
+    template <class... Args>
+    auto info(log_format format, const Args &...args) noexcept -> bool { return log(log_level::info, format, args...); }
+    template <class... Args>
+    auto warn(log_format format, const Args &...args) noexcept -> bool { return log(log_level::warn, format, args...); }
+    template <class... Args>
+    auto error(log_format format, const Args &...args) noexcept -> bool { return log(log_level::error, format, args...); }
+
+    /// \brief Returns the number of records dropped so far because a ring was full
+    [[nodiscard]] auto dropped() const noexcept -> std::uint64_t { return _dropped.load(std::memory_order_relaxed); }
+
+    /// \brief Stops the drain loop after a final drain and syncs the output
+    auto close() -> task<result<void, std::error_code>> {
+      _stopping.store(true, std::memory_order_relaxed);
+      co_await _stopped.wait();
+      co_return co_await _writer.sync();
+    }
+
+   private:
+    [[nodiscard]] auto this_thread_ring() noexcept -> detail::log_ring * {
+      auto &local = detail::this_thread_log_rings.rings;
+      for (auto &[id, ring] : local) {
+        if (id == _id) return ring.get();
+      }
+      std::erase_if(local, [](const auto &entry) { return entry.second->abandoned.load(std::memory_order_acquire); });
+      try {
+        auto ring = std::make_shared<detail::log_ring>(_options.ring_size);
+        {
+          std::lock_guard lock(_rings_mutex);
+          _rings.push_back(ring);
+        }
+        local.emplace_back(_id, ring);
+        return ring.get();
+      } catch (...) {
+        return nullptr;
+      }
+    }
+
+    auto drain_loop() -> task<void> {
+      std::vector<std::shared_ptr<detail::log_ring>> rings;
+      while (true) {
+        const bool last = _stopping.load(std::memory_order_relaxed);
+        {
+          std::lock_guard lock(_rings_mutex);
+          rings = _rings;
+        }
+        for (auto &ring : rings) co_await drain(*ring);
+        {
+          // Rings of exited threads go once empty; a retired ring gets no further records.
+          std::lock_guard lock(_rings_mutex);
+          std::erase_if(_rings, [](const auto &ring) {
+            return ring->retired.load(std::memory_order_acquire) &&
+                   ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire);
+          });
+        }
+        if (last) break;
+        co_await scheduler::current()->sleep_for(_options.drain_interval);
+      }
+      _stopped.count_down();
+    }
+
+    auto drain(detail::log_ring &ring) -> task<void> {
+      auto head = ring.head.load(std::memory_order_relaxed);
+      const auto tail = ring.tail.load(std::memory_order_acquire);
+      if (const auto lost = ring.dropped.exchange(0, std::memory_order_relaxed); lost != 0) {
+        _dropped.fetch_add(lost, std::memory_order_relaxed);
+        render_dropped(lost);
+      }
+      while (head != tail) {
+        const auto *record = ring.bytes.get() + (head & (ring.capacity - 1));
+        std::uint32_t size;
+        std::memcpy(&size, record, sizeof(size));
+        if (size & detail::log_record_header::padding) {
+          head += size & ~detail::log_record_header::padding;
+          continue;
+        }
+        detail::log_record_header header;
+        std::memcpy(&header, record, sizeof(header));
+        render_prefix(header);
+        header.render(_line, header.format, record + sizeof(header));
+        _line += '\n';
+        head += size;
+        if (_line.size() >= 32 * 1024) {
+          ring.head.store(head, std::memory_order_release);
+          (void)co_await _writer.write(_line);
+          _line.clear();
+        }
+      }
+      ring.head.store(head, std::memory_order_release);
+      if (!_line.empty()) {
+        (void)co_await _writer.write(_line);
+        _line.clear();
+      }
+    }
+
+    auto render_prefix(const detail::log_record_header &header) -> void {
+      static constexpr std::string_view names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+      const auto seconds = header.timestamp / 1'000'000'000;
+      if (seconds != _prefix_second) {
+        _prefix_second = seconds;
+        const time_t t = seconds;
+        tm parts{};
+        ::gmtime_r(&t, &parts);
+        _prefix_length = ::strftime(_prefix, sizeof(_prefix), "%Y-%m-%dT%H:%M:%S", &parts);
+      }
+      char micros[8] = {'.', '0', '0', '0', '0', '0', '0', 'Z'};
+      auto fraction = (header.timestamp / 1000) % 1'000'000;
+      for (int i = 6; i >= 1; --i, fraction /= 10) micros[i] = static_cast<char>('0' + fraction % 10);
+      _line.append(_prefix, _prefix_length);
+      _line.append(micros, sizeof(micros));
+      _line += ' ';
+      _line += names[static_cast<std::size_t>(header.level)];
+      _line += ' ';
+    }
+
+    auto render_dropped(std::uint64_t lost) -> void {
+      _line += "aio::logger dropped ";
+      detail::log_append(_line, lost);
+      _line += " records: ring full\n";
+    }
+
+    logger_options _options;
+    std::atomic<log_level> _level;
+    buffered_writer _writer;
+    std::uint64_t _id;
+    std::mutex _rings_mutex{};
+    std::vector<std::shared_ptr<detail::log_ring>> _rings{};
+    std::atomic<bool> _stopping{false};
+    std::atomic<std::uint64_t> _dropped{0};
+    latch _stopped{1};
+    std::string _line{};
+    std::int64_t _prefix_second = -1;
+    char _prefix[32] = {};
+    std::size_t _prefix_length = 0;
+  };
+}  // namespace aio
+
+#endif  // AIO_LOGGER_HPP
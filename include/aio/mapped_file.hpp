@@ -0,0 +1,248 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_MAPPED_FILE_HPP
+#define AIO_MAPPED_FILE_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include "async_generator.hpp"
+#include "detail/macros.hpp"
+#include "future.hpp"
+#include "io.hpp"
+#include "result.hpp"
+#include "task.hpp"
+#include "thread_pool.hpp"
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Expected access pattern of a mapping, passed to the kernel as madvise(2) advice
+  enum class access_pattern {
+    normal,     ///< Default readahead
+    sequential, ///< Aggressive readahead; pages behind the reader may be reclaimed early
+    random      ///< No readahead
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Options of mapped_file::open() and mapped_file::map()
+  struct mapped_file_options {
+    access_pattern pattern = access_pattern::normal;
+
+    /// Fault the whole file in while mapping (MAP_POPULATE). This blocks the calling thread for as
+    /// long as the file takes to read; prefer mapped_file::populate() from a scheduler.
+    bool populate = false;
+  };
+
+  namespace detail {
+    [[nodiscard]] inline auto page_size() noexcept -> std::size_t {
+      static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      return size;
+    }
+
+    // Faults a range in read-only without touching it from user space. Kernels without
+    // MADV_POPULATE_READ (before 5.14) get a WILLNEED hint instead.
+    inline auto populate_pages(const std::byte *address, std::size_t length) -> result<void, std::error_code> {
+      if (::madvise(const_cast<std::byte *>(address), length, MADV_POPULATE_READ) == 0) return {};
+      if (errno == EINVAL && ::madvise(const_cast<std::byte *>(address), length, MADV_WILLNEED) == 0) return {};
+      return failure<std::error_code>(std::error_code(errno, std::system_category()));
+    }
+
+    inline auto populate_job(const std::byte *address, std::size_t length, promise<void, std::error_code> done) -> task<void> {
+      done.set_result(populate_pages(address, length));
+      co_return;
+    }
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Read-only memory mapping of a file
+  ///
+  /// The contents are accessed as a span; the pages are faulted in by whichever thread touches
+  /// them first. To keep those faults off an I/O loop, warm the range before handing it out:
+  /// prefetch() starts kernel readahead from the io_uring workers, populate() faults the pages
+  /// in on a thread_pool, and sequential() does the latter one window ahead of its consumer.
+  ///
+  /// The mapping stays valid after the descriptor it was created from is closed. Truncating the
+  /// file underneath a mapping raises SIGBUS on access, as with any mmap.
+  class mapped_file {
+   public:
+    constexpr mapped_file() noexcept = default;
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file(mapped_file &&other) noexcept
+        : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)) {}
+
+    auto operator=(const mapped_file &) -> mapped_file & = delete;
+    auto operator=(mapped_file &&other) noexcept -> mapped_file & {
+      if (this != &other) {
+        unmap();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+      }
+      return *this;
+    }
+
+    ~mapped_file() { unmap(); }
+
+    /// \brief Maps the whole file at `path`
+    [[nodiscard]] static auto open(const char *path, mapped_file_options options = {}) -> result<mapped_file, std::error_code> {
+      const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      auto mapped = map(fd, options);
+      ::close(fd);
+      return mapped;
+    }
+
+    /// \brief Maps the whole file open as `fd`; the descriptor may be closed afterwards
+    [[nodiscard]] static auto map(int fd, mapped_file_options options = {}) -> result<mapped_file, std::error_code> {
+      struct stat info{};
+      if (::fstat(fd, &info) != 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      mapped_file file;
+      if (info.st_size == 0) return file;
+      const auto size = static_cast<std::size_t>(info.st_size);
+      void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED | (options.populate ? MAP_POPULATE : 0), fd, 0);
+      if (data == MAP_FAILED) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      file._data = static_cast<std::byte *>(data);
+      file._size = size;
+      if (options.pattern != access_pattern::normal) {
+        ::madvise(data, size, options.pattern == access_pattern::sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+      }
+      return file;
+    }
+
+    [[nodiscard]] auto data() const noexcept -> const std::byte * { return _data; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return _size; }
+    [[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte> { return {_data, _size}; }
+
+    /// \brief Returns the bytes in `[offset, offset + length)`, clamped to the file
+    [[nodiscard]] auto bytes(std::size_t offset, std::size_t length) const noexcept -> std::span<const std::byte> {
+      offset = std::min(offset, _size);
+      return {_data + offset, std::min(length, _size - offset)};
+    }
+
+    /// \brief Applies madvise(2) `advice` to the pages covering `[offset, offset + length)`
+    auto advise(std::size_t offset, std::size_t length, int advice) const -> result<void, std::error_code> {
+      const auto range = page_range(offset, length);
+      if (range.empty()) return {};
+      if (::madvise(const_cast<std::byte *>(range.data()), range.size(), advice) != 0) {
+        return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      }
+      return {};
+    }
+
+    /// \brief Starts readahead of `[offset, offset + length)` without blocking the awaiting scheduler
+    ///
+    /// Issues MADV_WILLNEED through the scheduler's io_uring, so the page-cache lookups run on
+    /// the ring's workers; completes once readahead has been started, not when it has finished.
+    [[nodiscard]] auto prefetch(std::size_t offset, std::size_t length) const {
+      const auto range = page_range(offset, length);
+      return async_madvise(range.data(), range.size(), MADV_WILLNEED);
+    }
+
+    /// \brief Faults `[offset, offset + length)` in on `pool`, resuming the caller once the pages are resident
+    [[nodiscard]] auto populate(thread_pool &pool, std::size_t offset, std::size_t length) const
+        -> task<result<void, std::error_code>> {
+      const auto range = page_range(offset, length);
+      if (range.empty()) co_return result<void, std::error_code>();
+      auto outcome = co_await pool.run([range] { return detail::populate_pages(range.data(), range.size()); });
+      if (!outcome) std::rethrow_exception(outcome.error());
+      co_return AIO_MOV(*outcome);
+    }
+
+    /// \brief Streams the file in `chunk_size` spans, keeping the next `window` bytes faulted in ahead of the consumer
+    ///
+    /// While the consumer works through one window, the following one is populated on `pool`;
+    /// the generator only moves on to a window once its population has finished, so the consumer
+    /// does not take major faults as long as it is not faster than the device. Population is
+    /// advisory: if it fails, the pages are faulted in on access as usual. The mapping must
+    /// outlive the generator and any population still running when it is destroyed.
+    [[nodiscard]] auto sequential(thread_pool &pool, std::size_t chunk_size, std::size_t window = 8 * 1024 * 1024) const
+        -> async_generator<std::span<const std::byte>> {
+      chunk_size = std::max<std::size_t>(chunk_size, 1);
+      window = std::max(window, chunk_size);
+      (void)advise(0, _size, MADV_SEQUENTIAL);
+      auto next = start_populate(pool, 0, window);
+      for (std::size_t start = 0; start < _size; start += window) {
+        (void)co_await AIO_MOV(next);
+        if (start + window < _size) next = start_populate(pool, start + window, window);
+        const auto end = std::min(start + window, _size);
+        for (auto offset = start; offset < end; offset += chunk_size) {
+          co_yield bytes(offset, std::min(chunk_size, end - offset));
+        }
+      }
+    }
+
+   private:
+    // Widens `[offset, offset + length)` to page boundaries, clamped to the mapping.
+    [[nodiscard]] auto page_range(std::size_t offset, std::size_t length) const noexcept -> std::span<const std::byte> {
+      const auto page = detail::page_size();
+      offset = std::min(offset, _size);
+      const auto end = offset + std::min(length, _size - offset);
+      const auto first = offset & ~(page - 1);
+      return {_data + first, end - first};
+    }
+
+    [[nodiscard]] auto start_populate(thread_pool &pool, std::size_t offset, std::size_t length) const
+        -> future<void, std::error_code> {
+      promise<void, std::error_code> done;
+      auto pending = done.get_future();
+      const auto range = page_range(offset, length);
+      pool.spawn(detail::populate_job(range.data(), range.size(), AIO_MOV(done)));
+      return pending;
+    }
+
+    auto unmap() noexcept -> void {
+      if (_data) ::munmap(_data, _size);
+      _data = nullptr;
+      _size = 0;
+    }
+
+    std::byte *_data = nullptr;
+    std::size_t _size = 0;
+  };
+}  // namespace aio
+
+#endif  // AIO_MAPPED_FILE_HPP
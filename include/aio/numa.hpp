@@ -0,0 +1,230 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_NUMA_HPP
+#define AIO_NUMA_HPP
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aio {
+
+  /**
+   * \defgroup numa numa
+   * \brief The `numa` module discovers the machine's NUMA topology and places threads and memory on nodes.
+   */
+
+  /// \ingroup numa
+  ///
+  /// \brief Identifier of a NUMA node as numbered by the kernel
+  using numa_node_id = std::int32_t;
+
+  /// \ingroup numa
+  ///
+  /// \brief Placement hint meaning "no preference"
+  inline constexpr numa_node_id any_node = -1;
+
+  /// \ingroup numa
+  ///
+  /// \brief A NUMA node and the CPUs of this process that belong to it
+  struct numa_node {
+    numa_node_id id = 0;
+    std::vector<unsigned> cpus{};
+  };
+
+  namespace detail {
+    // Parses a kernel cpulist such as "0-3,8,10-11".
+    inline auto parse_cpulist(const std::string &list) -> std::vector<unsigned> {
+      std::vector<unsigned> cpus;
+      std::size_t pos = 0;
+      while (pos < list.size()) {
+        auto end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        const auto range = list.substr(pos, end - pos);
+        if (!range.empty() && range.find_first_not_of(" \n") != std::string::npos) {
+          const auto dash = range.find('-');
+          const auto first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+          const auto last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+          for (auto cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        pos = end + 1;
+      }
+      return cpus;
+    }
+
+    inline auto read_first_line(const std::string &path) -> std::string {
+      std::ifstream in(path);
+      std::string line;
+      std::getline(in, line);
+      return line;
+    }
+
+    inline thread_local numa_node_id thread_home_node = any_node;
+  }  // namespace detail
+
+  /// \ingroup numa
+  ///
+  /// \brief The NUMA nodes of the machine, restricted to the CPUs this process may run on
+  ///
+  /// The topology is read from `/sys/devices/system/node`. Nodes without usable CPUs
+  /// (memory-only nodes, or nodes excluded by the process affinity mask) are omitted. On
+  /// machines without NUMA support in sysfs the topology degenerates to a single node 0
+  /// holding every online CPU.
+  class numa_topology {
+   public:
+    /// \brief Returns the topology of the running system, discovered once
+    [[nodiscard]] static auto system() -> const numa_topology & {
+      static const auto topology = discover();
+      return topology;
+    }
+
+    /// \brief Reads the topology from the given sysfs node directory
+    [[nodiscard]] static auto discover(const std::string &sysfs_root = "/sys/devices/system/node") -> numa_topology {
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      const bool have_affinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+      const auto usable = [&](unsigned cpu) { return !have_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+      numa_topology topology;
+      const auto online = detail::parse_cpulist(detail::read_first_line(sysfs_root + "/online"));
+      for (auto id : online) {
+        numa_node node{static_cast<numa_node_id>(id), {}};
+        for (auto cpu : detail::parse_cpulist(detail::read_first_line(sysfs_root + "/node" + std::to_string(id) + "/cpulist"))) {
+          if (usable(cpu)) node.cpus.push_back(cpu);
+        }
+        if (!node.cpus.empty()) topology._nodes.push_back(std::move(node));
+      }
+
+      if (topology._nodes.empty()) {
+        numa_node node{0, {}};
+        for (auto cpu : detail::parse_cpulist(detail::read_first_line("/sys/devices/system/cpu/online"))) {
+          if (usable(cpu)) node.cpus.push_back(cpu);
+        }
+        if (node.cpus.empty()) {
+          for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) node.cpus.push_back(cpu);
+        }
+        topology._nodes.push_back(std::move(node));
+      }
+      return topology;
+    }
+
+    [[nodiscard]] auto nodes() const noexcept -> const std::vector<numa_node> & { return _nodes; }
+    [[nodiscard]] auto node_count() const noexcept -> std::size_t { return _nodes.size(); }
+
+    [[nodiscard]] auto cpu_count() const noexcept -> std::size_t {
+      std::size_t count = 0;
+      for (const auto &node : _nodes) count += node.cpus.size();
+      return count;
+    }
+
+    /// \brief Returns the node the given CPU belongs to, or any_node if it is not part of the topology
+    [[nodiscard]] auto node_of_cpu(unsigned cpu) const noexcept -> numa_node_id {
+      for (const auto &node : _nodes) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) return node.id;
+      }
+      return any_node;
+    }
+
+    /// \brief Returns the position of the given node in nodes(), or `node_count()` if unknown
+    [[nodiscard]] auto index_of(numa_node_id id) const noexcept -> std::size_t {
+      for (std::size_t i = 0; i < _nodes.size(); ++i) {
+        if (_nodes[i].id == id) return i;
+      }
+      return _nodes.size();
+    }
+
+   private:
+    std::vector<numa_node> _nodes{};
+  };
+
+  /// \ingroup numa
+  ///
+  /// \brief Returns the node the calling thread is bound to, or the node it is currently running on
+  [[nodiscard]] inline auto this_thread_node() noexcept -> numa_node_id {
+    if (detail::thread_home_node != any_node) return detail::thread_home_node;
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::getcpu(&cpu, &node) != 0) return 0;
+    return static_cast<numa_node_id>(node);
+  }
+
+  /// \ingroup numa
+  ///
+  /// \brief Restricts the calling thread to the CPUs of a node and makes it the thread's home node
+  ///
+  /// The home node is used by node-aware allocators (coroutine frames, buffer pools) running on
+  /// this thread. Returns false if the affinity could not be applied; the home node is set anyway.
+  inline auto bind_this_thread(const numa_node &node) noexcept -> bool {
+    detail::thread_home_node = node.id;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : node.cpus) {
+      if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+  }
+
+  /// \ingroup numa
+  ///
+  /// \brief Maps `size` bytes of memory preferring the given node
+  ///
+  /// The memory is page aligned and zero-filled. The node preference is applied with `mbind`
+  /// before the pages are touched, so they are faulted in on that node; any_node leaves
+  /// placement to the kernel's default policy. Throws std::bad_alloc on failure.
+  [[nodiscard]] inline auto allocate_on_node(std::size_t size, numa_node_id node) -> void * {
+    auto *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    if (node >= 0 && node < 64) {
+      const unsigned long mask = 1ul << node;
+      // Best effort: kernels without NUMA support reject mbind, which leaves the default policy in place.
+      // The kernel reads one bit less than `maxnode`, hence the + 1.
+      (void)syscall(SYS_mbind, memory, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1, 0);
+    }
+    return memory;
+  }
+
+  /// \ingroup numa
+  ///
+  /// \brief Releases memory obtained from allocate_on_node()
+  inline auto deallocate_on_node(void *memory, std::size_t size) noexcept -> void { munmap(memory, size); }
+}  // namespace aio
+
+#endif  // AIO_NUMA_HPP
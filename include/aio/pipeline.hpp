@@ -0,0 +1,246 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_PIPELINE_HPP
+#define AIO_PIPELINE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "channel.hpp"
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "latch.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+namespace aio {
+  template <class Source, class... Stages>
+  class pipeline_builder;
+
+  namespace detail {
+    template <class Fn>
+    struct pipeline_stage {
+      std::size_t concurrency;
+      std::size_t capacity;
+      Fn fn;
+    };
+
+    // Channels in front of each stage: the first carries the source's items, each following one the
+    // results of the stage before it.
+    template <class In, class... Stages>
+    struct pipeline_channels;
+
+    template <class In, class Fn>
+    struct pipeline_channels<In, pipeline_stage<Fn>> {
+      using type = std::tuple<channel<In>>;
+    };
+
+    template <class In, class Fn, class Next, class... Rest>
+    struct pipeline_channels<In, pipeline_stage<Fn>, Next, Rest...> {
+      using out = std::remove_cvref_t<aio::await_result_t<std::invoke_result_t<Fn &, In>>>;
+      using type = decltype(std::tuple_cat(std::declval<std::tuple<channel<In>>>(),
+                                           std::declval<typename pipeline_channels<out, Next, Rest...>::type>()));
+    };
+
+    // Everything a running pipeline shares; channel I feeds stage I, and the source feeds channel 0.
+    template <class Source, class... Stages>
+    struct pipeline_state {
+      static constexpr std::size_t stage_count = sizeof...(Stages);
+
+      using channels_type = typename pipeline_channels<std::ranges::range_value_t<Source>, Stages...>::type;
+
+      pipeline_state(Source source, std::tuple<Stages...> stages, std::size_t tasks)
+          : source(AIO_MOV(source)),
+            stages(AIO_MOV(stages)),
+            channels(make_channels(this->stages, std::make_index_sequence<stage_count>())),
+            done(static_cast<std::ptrdiff_t>(tasks)) {}
+
+      template <std::size_t... I>
+      static auto make_channels(const std::tuple<Stages...> &stages, std::index_sequence<I...>) -> channels_type {
+        return channels_type(std::get<I>(stages).capacity...);
+      }
+
+      // Records the first error and closes every channel, so that all stages wind down.
+      auto fail(std::exception_ptr e) -> void {
+        if (!error) error = AIO_MOV(e);
+        std::apply([](auto &...ch) { (ch.close(), ...); }, channels);
+      }
+
+      Source source;
+      std::tuple<Stages...> stages;
+      channels_type channels;
+      std::array<std::size_t, stage_count> active{};
+      latch done;
+      std::exception_ptr error{};
+    };
+
+    template <class State>
+    auto pipeline_source(State &state) -> task<void> {
+      auto &out = std::get<0>(state.channels);
+      try {
+        for (auto &&item : state.source) {
+          if (state.error || !co_await out.send(std::ranges::range_value_t<decltype(state.source)>(AIO_FWD(item)))) break;
+        }
+      } catch (...) {
+        state.fail(std::current_exception());
+      }
+      out.close();
+      state.done.count_down();
+    }
+
+    template <std::size_t I, class State>
+    auto pipeline_worker(State &state) -> task<void> {
+      auto &in = std::get<I>(state.channels);
+      auto &stage = std::get<I>(state.stages);
+      try {
+        while (!state.error) {
+          auto item = co_await in.receive();
+          if (!item) break;
+          if constexpr (I + 1 < State::stage_count) {
+            auto result = co_await std::invoke(stage.fn, AIO_MOV(*item));
+            if (!co_await std::get<I + 1>(state.channels).send(AIO_MOV(result))) break;
+          } else {
+            co_await std::invoke(stage.fn, AIO_MOV(*item));
+          }
+        }
+      } catch (...) {
+        state.fail(std::current_exception());
+      }
+      // The last worker of a stage ends the stream of the next one.
+      if constexpr (I + 1 < State::stage_count) {
+        if (--state.active[I] == 0) std::get<I + 1>(state.channels).close();
+      }
+      state.done.count_down();
+    }
+
+    template <class Source, class... Stages>
+    auto run_pipeline(Source source, std::tuple<Stages...> stages) -> task<void> {
+      auto *sched = scheduler::current();
+      assert(sched && "pipelines must be awaited on a scheduler");
+      const auto tasks = std::apply([](const auto &...stage) { return (std::size_t{1} + ... + stage.concurrency); }, stages);
+      pipeline_state<Source, Stages...> state(AIO_MOV(source), AIO_MOV(stages), tasks);
+
+      // Every coroutine of the pipeline runs in the lane and with the deadline of the awaiting task.
+      const auto &self = co_await detail::this_promise{};
+      const auto spawn = [&](task<void> t) { sched->spawn(AIO_MOV(t).with_lane(self.lane()).with_deadline(self.deadline())); };
+      spawn(pipeline_source(state));
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((state.active[I] = std::get<I>(state.stages).concurrency), ...);
+        (
+            [&] {
+              for (std::size_t n = 0; n < std::get<I>(state.stages).concurrency; ++n) spawn(pipeline_worker<I>(state));
+            }(),
+            ...);
+      }(std::make_index_sequence<sizeof...(Stages)>());
+
+      co_await state.done.wait();
+      if (state.error) std::rethrow_exception(state.error);
+    }
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Builder for a staged, bounded-concurrency processing pipeline
+  ///
+  /// Each stage runs a fixed number of worker coroutines that receive items from a bounded channel,
+  /// await the stage function on them and send the results on to the next stage's channel. Full
+  /// channels suspend the stage feeding them, so a slow stage throttles everything upstream of it
+  /// down to the source, which is iterated lazily. Peak memory is therefore proportional to the
+  /// sum of the stage concurrencies and channel capacities, independent of the number of items;
+  /// per-item coroutine frames are recycled by the frame allocator.
+  ///
+  /// \code
+  /// co_await aio::pipeline(urls)
+  ///     .stage(64, 128, fetch)   // 64 concurrent fetches, up to 128 URLs queued
+  ///     .stage(4, 16, parse)
+  ///     .sink(1, 16, store);
+  /// \endcode
+  ///
+  /// All stages run in the lane and with the deadline of the task awaiting the pipeline. The first
+  /// exception thrown by a stage function or by the source closes all channels; the pipeline then
+  /// winds down and rethrows it. Pipelines must be awaited on a scheduler.
+  template <class Source, class... Stages>
+  class pipeline_builder {
+   public:
+    explicit pipeline_builder(Source source, std::tuple<Stages...> stages = {})
+        : _source(AIO_MOV(source)), _stages(AIO_MOV(stages)) {}
+
+    /// \brief Appends a stage transforming each item with `fn`
+    ///
+    /// \param concurrency Number of items the stage processes at once; zero is treated as one
+    /// \param capacity Number of items that may be queued in front of the stage
+    /// \param fn Callable taking an item by value and returning an awaitable of the next item type
+    template <class Fn>
+    [[nodiscard]] auto stage(std::size_t concurrency, std::size_t capacity, Fn fn) && {
+      return pipeline_builder<Source, Stages..., detail::pipeline_stage<Fn>>(
+          AIO_MOV(_source),
+          std::tuple_cat(AIO_MOV(_stages),
+                         std::tuple(detail::pipeline_stage<Fn>{std::max<std::size_t>(concurrency, 1), capacity, AIO_MOV(fn)})));
+    }
+
+    /// \brief Completes the pipeline with a stage consuming each item, and returns the task running it
+    ///
+    /// \param concurrency Number of items consumed at once; zero is treated as one
+    /// \param capacity Number of items that may be queued in front of the sink
+    /// \param fn Callable taking an item by value and returning an awaitable
+    template <class Fn>
+    [[nodiscard]] auto sink(std::size_t concurrency, std::size_t capacity, Fn fn) && -> task<void> {
+      auto complete = AIO_MOV(*this).stage(concurrency, capacity, AIO_MOV(fn));
+      return detail::run_pipeline(AIO_MOV(complete._source), AIO_MOV(complete._stages));
+    }
+
+   private:
+    template <class, class...>
+    friend class pipeline_builder;
+
+    Source _source;
+    std::tuple<Stages...> _stages;
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Starts building a pipeline fed by the items of `source`
+  ///
+  /// Lvalue ranges are referenced and must outlive the pipeline; rvalue ranges are moved into it.
+  template <std::ranges::viewable_range Source>
+  [[nodiscard]] auto pipeline(Source &&source) {
+    return pipeline_builder<std::views::all_t<Source>>(std::views::all(AIO_FWD(source)));
+  }
+}  // namespace aio
+
+#endif  // AIO_PIPELINE_HPP
@@ -0,0 +1,358 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_PROCESS_HPP
+#define AIO_PROCESS_HPP
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "detail/macros.hpp"
+#include "io.hpp"
+#include "result.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+extern char **environ;
+
+namespace aio {
+  namespace detail {
+    // Blocks SIGPIPE on the calling thread, once per thread. A write to a pipe whose reader is gone
+    // raises SIGPIPE at the thread that issued it, and io_uring issues writes inline on the submitting
+    // thread; blocked, the signal stays pending on that thread and the write fails with EPIPE.
+    inline auto block_sigpipe_on_this_thread() noexcept -> void {
+      static thread_local bool blocked = false;
+      if (blocked) return;
+      sigset_t set;
+      ::sigemptyset(&set);
+      ::sigaddset(&set, SIGPIPE);
+      ::pthread_sigmask(SIG_BLOCK, &set, nullptr);
+      blocked = true;
+    }
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Owning, move-only file descriptor of one end of a pipe, read and written through io_uring
+  ///
+  /// Writing to a pipe whose reading end was closed, e.g. the stdin of a child that exited, fails
+  /// with `EPIPE` (std::errc::broken_pipe). To that end the first write on a thread blocks SIGPIPE
+  /// for that thread for good, as the signal would otherwise terminate the process.
+  class pipe_stream {
+   public:
+    constexpr pipe_stream() noexcept = default;
+    explicit pipe_stream(int fd) noexcept : _fd(fd) {}
+
+    pipe_stream(pipe_stream &&other) noexcept : _fd(std::exchange(other._fd, -1)) {}
+    auto operator=(pipe_stream other) noexcept -> pipe_stream & {
+      std::swap(_fd, other._fd);
+      return *this;
+    }
+
+    ~pipe_stream() { close(); }
+
+    /// \brief Reads at most `buffer.size()` bytes straight into `buffer`; zero bytes means end of stream
+    [[nodiscard]] auto read_some(std::span<std::byte> buffer) const { return async_read(_fd, buffer); }
+
+    /// \brief Writes a prefix of `buffer`; produces the number of bytes written
+    [[nodiscard]] auto write_some(std::span<const std::byte> buffer) const {
+      detail::block_sigpipe_on_this_thread();
+      return async_write(_fd, buffer);
+    }
+
+    /// \brief Gather-writes a prefix of the concatenation of `buffers`; produces the number of bytes written
+    [[nodiscard]] auto write_some(std::span<const iovec> buffers) const {
+      detail::block_sigpipe_on_this_thread();
+      return async_writev(_fd, buffers);
+    }
+
+    /// \brief Closes the descriptor, signalling end of stream to the other side
+    auto close() noexcept -> void {
+      if (_fd >= 0) ::close(std::exchange(_fd, -1));
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _fd >= 0; }
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+    /// \brief Gives up ownership of the descriptor
+    [[nodiscard]] auto release() noexcept -> int { return std::exchange(_fd, -1); }
+
+   private:
+    int _fd = -1;
+  };
+
+  static_assert(aio::async_read_stream<pipe_stream> && aio::async_vectored_write_stream<pipe_stream>);
+
+  /// \ingroup io
+  ///
+  /// \brief What a child process's standard stream is connected to
+  enum class stdio : std::uint8_t {
+    inherit, ///< The parent's descriptor
+    pipe,    ///< A pipe, exposed as a pipe_stream of the process
+    null     ///< /dev/null
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Description of a child process to start
+  struct process_options {
+    /// Program to run. Looked up in `PATH` if it contains no slash.
+    std::string program;
+
+    /// Arguments, not including the program name, which is passed as `argv[0]`.
+    std::vector<std::string> args{};
+
+    /// Environment as `NAME=value` entries; the parent's environment if empty.
+    std::vector<std::string> env{};
+
+    /// Working directory; the parent's if empty.
+    std::string cwd{};
+
+    stdio in = stdio::inherit;
+    stdio out = stdio::inherit;
+    stdio err = stdio::inherit;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief How a child process ended
+  struct process_exit {
+    int code = 0;   ///< Exit status if the process exited normally
+    int signal = 0; ///< Terminating signal, or zero if the process exited normally
+
+    [[nodiscard]] auto success() const noexcept -> bool { return signal == 0 && code == 0; }
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Child process with asynchronous stdio and exit notification
+  ///
+  /// Processes are started with posix_spawn(3), which glibc implements with a vfork-style
+  /// clone(CLONE_VM | CLONE_VFORK): the parent only waits until the child has called exec, without
+  /// copying its address space, so spawning does not stall the loop. The child is then tracked
+  /// through a pidfd, which becomes readable when it exits; wait() polls it on the io_uring and
+  /// reaps the child without blocking. Piped stdio is read and written through io_uring as well,
+  /// directly into the caller's buffers, so no helper threads or intermediate copies are involved.
+  ///
+  /// Children start with an empty signal mask and the default action for SIGPIPE and for every
+  /// signal the spawning thread blocks, so neither the SIGPIPE blocking of pipe_stream nor a
+  /// signal_set of the parent keeps them from being killed.
+  ///
+  /// A process that is destroyed before wait() completed is killed with SIGKILL and reaped, which
+  /// blocks only for as long as the kernel takes to tear the child down.
+  class process {
+   public:
+    process(const process &) = delete;
+    auto operator=(const process &) -> process & = delete;
+
+    process(process &&other) noexcept
+        : _pid(std::exchange(other._pid, -1)),
+          _pidfd(std::exchange(other._pidfd, -1)),
+          _in(AIO_MOV(other._in)),
+          _out(AIO_MOV(other._out)),
+          _err(AIO_MOV(other._err)),
+          _exit(other._exit) {}
+
+    auto operator=(process &&other) noexcept -> process & {
+      if (this != &other) {
+        abandon();
+        _pid = std::exchange(other._pid, -1);
+        _pidfd = std::exchange(other._pidfd, -1);
+        _in = AIO_MOV(other._in);
+        _out = AIO_MOV(other._out);
+        _err = AIO_MOV(other._err);
+        _exit = other._exit;
+      }
+      return *this;
+    }
+
+    ~process() { abandon(); }
+
+    /// \brief Starts a child process
+    ///
+    /// Fails with the error of the failing system call, including the exec of the program.
+    [[nodiscard]] static auto spawn(const process_options &options) -> result<process, std::error_code> {
+      std::vector<char *> argv;
+      argv.push_back(const_cast<char *>(options.program.c_str()));
+      for (const auto &arg : options.args) argv.push_back(const_cast<char *>(arg.c_str()));
+      argv.push_back(nullptr);
+
+      std::vector<char *> envp;
+      for (const auto &entry : options.env) envp.push_back(const_cast<char *>(entry.c_str()));
+      envp.push_back(nullptr);
+
+      posix_spawn_file_actions_t actions;
+      ::posix_spawn_file_actions_init(&actions);
+      // The child starts with nothing blocked and default dispositions for whatever this thread
+      // blocks (SIGPIPE once a pipe was written, signal_set members) and for SIGPIPE itself, so
+      // it can be killed and dies of a broken pipe like any other program.
+      posix_spawnattr_t attributes;
+      ::posix_spawnattr_init(&attributes);
+      sigset_t signals;
+      ::pthread_sigmask(SIG_SETMASK, nullptr, &signals);
+      ::sigaddset(&signals, SIGPIPE);
+      ::posix_spawnattr_setsigdefault(&attributes, &signals);
+      ::sigemptyset(&signals);
+      ::posix_spawnattr_setsigmask(&attributes, &signals);
+      ::posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+      process child;
+      // Parent ends of the pipes; the child ends are closed once the child has them.
+      int child_ends[3] = {-1, -1, -1};
+      const auto cleanup = [&] {
+        ::posix_spawn_file_actions_destroy(&actions);
+        ::posix_spawnattr_destroy(&attributes);
+        for (auto fd : child_ends) {
+          if (fd >= 0) ::close(fd);
+        }
+      };
+
+      const stdio modes[3] = {options.in, options.out, options.err};
+      pipe_stream *parent_ends[3] = {&child._in, &child._out, &child._err};
+      for (int target = 0; target < 3; ++target) {
+        if (modes[target] == stdio::pipe) {
+          int fds[2];
+          if (::pipe2(fds, O_CLOEXEC) != 0) {
+            const auto error = errno;
+            cleanup();
+            return failure<std::error_code>(std::error_code(error, std::system_category()));
+          }
+          // fds[0] is the read end: the child reads its stdin, the parent reads stdout and stderr.
+          const bool child_reads = target == 0;
+          child_ends[target] = child_reads ? fds[0] : fds[1];
+          *parent_ends[target] = pipe_stream(child_reads ? fds[1] : fds[0]);
+          ::posix_spawn_file_actions_adddup2(&actions, child_ends[target], target);
+        } else if (modes[target] == stdio::null) {
+          ::posix_spawn_file_actions_addopen(&actions, target, "/dev/null", target == 0 ? O_RDONLY : O_WRONLY, 0);
+        }
+      }
+      if (!options.cwd.empty()) ::posix_spawn_file_actions_addchdir_np(&actions, options.cwd.c_str());
+
+      pid_t pid = -1;
+      auto *const env = options.env.empty() ? environ : envp.data();
+      const auto rc = options.program.find('/') == std::string::npos
+                          ? ::posix_spawnp(&pid, argv[0], &actions, &attributes, argv.data(), env)
+                          : ::posix_spawn(&pid, argv[0], &actions, &attributes, argv.data(), env);
+      cleanup();
+      if (rc != 0) return failure<std::error_code>(std::error_code(rc, std::system_category()));
+
+      child._pid = pid;
+      child._pidfd = static_cast<int>(::syscall(__NR_pidfd_open, pid, 0));
+      if (child._pidfd < 0) {
+        const auto error = errno;
+        ::kill(pid, SIGKILL);
+        ::waitpid(pid, nullptr, 0);
+        child._pid = -1;
+        return failure<std::error_code>(std::error_code(error, std::system_category()));
+      }
+      return result<process, std::error_code>(std::in_place, AIO_MOV(child));
+    }
+
+    /// \brief Waits for the child to terminate and reaps it
+    ///
+    /// Must be awaited on a scheduler. Awaiting again after the child was reaped produces the
+    /// same status immediately.
+    [[nodiscard]] auto wait() -> task<result<process_exit, std::error_code>> {
+      if (_exit) co_return *_exit;
+      while (true) {
+        siginfo_t info{};
+        if (::waitid(static_cast<idtype_t>(pidfd_id_type), static_cast<id_t>(_pidfd), &info, WEXITED | WNOHANG) != 0) {
+          co_return failure<std::error_code>(std::error_code(errno, std::system_category()));
+        }
+        if (info.si_pid != 0) {
+          _exit = info.si_code == CLD_EXITED ? process_exit{info.si_status, 0} : process_exit{0, info.si_status};
+          _pid = -1;
+          co_return *_exit;
+        }
+        if (auto ready = co_await async_poll(_pidfd, POLLIN); !ready) co_return failure<std::error_code>(ready.error());
+      }
+    }
+
+    /// \brief Sends `signal` to the child; fails with `ESRCH` once it has been reaped
+    auto kill(int signal = SIGTERM) const -> result<void, std::error_code> {
+      if (::syscall(__NR_pidfd_send_signal, _pidfd, signal, nullptr, 0) != 0) {
+        return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      }
+      return {};
+    }
+
+    [[nodiscard]] auto pid() const noexcept -> pid_t { return _pid; }
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _pidfd; }
+
+    /// \brief The write end of the child's stdin if it was created with stdio::pipe
+    [[nodiscard]] auto stdin_pipe() noexcept -> pipe_stream & { return _in; }
+
+    /// \brief The read end of the child's stdout if it was created with stdio::pipe
+    [[nodiscard]] auto stdout_pipe() noexcept -> pipe_stream & { return _out; }
+
+    /// \brief The read end of the child's stderr if it was created with stdio::pipe
+    [[nodiscard]] auto stderr_pipe() noexcept -> pipe_stream & { return _err; }
+
+   private:
+    // P_PIDFD is only declared by recent C libraries.
+    static constexpr int pidfd_id_type = 3;
+
+    process() noexcept = default;
+
+    auto abandon() noexcept -> void {
+      if (_pidfd < 0) return;
+      if (!_exit) {
+        ::syscall(__NR_pidfd_send_signal, _pidfd, SIGKILL, nullptr, 0);
+        siginfo_t info{};
+        // SIGKILL cannot be caught, so this completes promptly.
+        ::waitid(static_cast<idtype_t>(pidfd_id_type), static_cast<id_t>(_pidfd), &info, WEXITED);
+      }
+      ::close(std::exchange(_pidfd, -1));
+    }
+
+    pid_t _pid = -1;
+    int _pidfd = -1;
+    pipe_stream _in{};
+    pipe_stream _out{};
+    pipe_stream _err{};
+    std::optional<process_exit> _exit{};
+  };
+}  // namespace aio
+
+#endif  // AIO_PROCESS_HPP
@@ -0,0 +1,333 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_RATE_LIMITER_HPP
+#define AIO_RATE_LIMITER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "coroutine.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+#include "lane.hpp"
+#include "scheduler.hpp"
+#include "timer_wheel.hpp"
+
+namespace aio {
+  namespace detail {
+    // Cheap time source for hot paths: the dispatch timestamp of the calling thread's scheduler,
+    // or the clock itself off-scheduler.
+    [[nodiscard]] inline auto cached_now() noexcept -> clock::time_point {
+      if (auto *sched = scheduler::current()) return sched->now();
+      return clock::now();
+    }
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Token-bucket rate limiter with awaitable acquisition
+  ///
+  /// The bucket refills at `rate` tokens per second up to `burst` tokens. Its whole state is a
+  /// single atomic timestamp: the instant at which the bucket was (or will be) empty, as in the
+  /// generic cell rate algorithm. Acquiring therefore is one compare-exchange against the
+  /// scheduler's cached clock, with no lock and no refill bookkeeping.
+  ///
+  /// A request that cannot be granted suspends on an intrusive waiter queue ordered by request
+  /// size, smallest first, so that small calls are not held up behind a large one. While anyone
+  /// waits, a single timer is armed for the instant the head of the queue can be served, on the
+  /// timer wheel of the scheduler that head runs on; when it fires, every request that now fits
+  /// is granted and resumed as a batch. Under sustained over-subscription large requests may
+  /// therefore wait indefinitely.
+  ///
+  /// New requests do not overtake queued ones. A request for more than `burst` tokens is granted
+  /// once the bucket is full and leaves it in debt.
+  ///
+  /// acquire() must be awaited from a coroutine running on a scheduler. The limiter must outlive
+  /// all of its waiters.
+  class rate_limiter {
+   public:
+    class acquire_awaiter;
+
+    /// \param rate Tokens added per second; must be positive
+    /// \param burst Capacity of the bucket; the bucket starts full
+    rate_limiter(double rate, std::uint64_t burst) noexcept
+        : _interval(1e9 / rate),
+          _burst(std::max<std::uint64_t>(burst, 1)),
+          // Any instant before the bucket last filled reads as full, whichever clock reading is compared
+          // to it: try_acquire() uses the scheduler's cached time, which may predate construction.
+          _empty_at(std::numeric_limits<std::int64_t>::min()) {
+      assert(rate > 0);
+      _timer.fire = &on_timer;
+      _timer.owner = this;
+    }
+
+    rate_limiter(const rate_limiter &) = delete;
+    auto operator=(const rate_limiter &) -> rate_limiter & = delete;
+
+    /// \brief Takes `n` tokens if they are available right now and nobody is queued
+    [[nodiscard]] auto try_acquire(std::uint64_t n = 1) noexcept -> bool {
+      if (_waiting.load(std::memory_order_acquire) != 0) return false;
+      return try_take(n, nanoseconds_of(detail::cached_now()));
+    }
+
+    /// \brief Returns an awaitable that completes once `n` tokens have been taken
+    [[nodiscard]] auto acquire(std::uint64_t n = 1) noexcept -> acquire_awaiter;
+
+    /// \brief Returns the number of tokens that could be taken right now
+    [[nodiscard]] auto available() const noexcept -> std::uint64_t {
+      const auto now = nanoseconds_of(clock::now());
+      const auto empty_at = std::max(_empty_at.load(std::memory_order_acquire), now - cost_of(_burst));
+      return empty_at >= now ? 0 : static_cast<std::uint64_t>(static_cast<double>(now - empty_at) / _interval);
+    }
+
+    /// \brief Returns the number of suspended acquisitions
+    [[nodiscard]] auto waiting() const noexcept -> std::size_t { return _waiting.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] auto burst() const noexcept -> std::uint64_t { return _burst; }
+    [[nodiscard]] auto rate() const noexcept -> double { return 1e9 / _interval; }
+
+   private:
+    [[nodiscard]] static auto nanoseconds_of(clock::time_point t) noexcept -> std::int64_t {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    [[nodiscard]] auto cost_of(std::uint64_t n) const noexcept -> std::int64_t {
+      return static_cast<std::int64_t>(std::llround(static_cast<double>(n) * _interval));
+    }
+
+    // Instant at which `n` tokens become available, given the bucket's current state.
+    [[nodiscard]] auto ready_at(std::uint64_t n, std::int64_t now) const noexcept -> std::int64_t {
+      const auto empty_at = std::max(_empty_at.load(std::memory_order_acquire), now - cost_of(_burst));
+      return empty_at + cost_of(std::min(n, _burst));
+    }
+
+    auto try_take(std::uint64_t n, std::int64_t now) noexcept -> bool {
+      const auto full_at = now - cost_of(_burst);
+      const auto needed = cost_of(std::min(n, _burst));
+      const auto cost = cost_of(n);
+      auto empty_at = _empty_at.load(std::memory_order_acquire);
+      while (true) {
+        const auto base = std::max(empty_at, full_at);
+        if (base + needed > now) return false;
+        if (_empty_at.compare_exchange_weak(empty_at, base + cost, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          return true;
+        }
+      }
+    }
+
+    // Inserts behind all queued requests of the same or smaller size; called with `_mutex` held.
+    auto enqueue(acquire_awaiter *waiter) noexcept -> void;
+
+    struct refill_timer : timer_node {
+      rate_limiter *owner = nullptr;
+    };
+
+    // Arms the refill timer for the head of the queue; called with `_mutex` held on a scheduler thread.
+    auto arm(scheduler &sched, std::int64_t now) noexcept -> void;
+
+    static auto on_timer(timer_node *node) noexcept -> void;
+
+    double _interval;
+    std::uint64_t _burst;
+    std::atomic<std::int64_t> _empty_at;
+    std::atomic<std::size_t> _waiting{0};
+    std::mutex _mutex{};
+    acquire_awaiter *_queue = nullptr;
+    refill_timer _timer{};
+    scheduler *_timer_scheduler = nullptr;
+  };
+
+  class rate_limiter::acquire_awaiter : detail::waiter {
+   public:
+    acquire_awaiter(rate_limiter &limiter, std::uint64_t tokens) noexcept : _limiter(&limiter), _tokens(tokens) {}
+
+    [[nodiscard]] auto await_ready() noexcept -> bool { return _tokens == 0 || _limiter->try_acquire(_tokens); }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+      auto *sched = scheduler::current();
+      assert(sched && "rate_limiter::acquire() must be awaited on a scheduler");
+      std::lock_guard lock(_limiter->_mutex);
+      const auto now = nanoseconds_of(clock::now());
+      if (!_limiter->_queue && _limiter->try_take(_tokens, now)) return false;
+      prepare(coro);
+      _limiter->_waiting.fetch_add(1, std::memory_order_acq_rel);
+      _limiter->enqueue(this);
+      if (!_limiter->_timer_scheduler || _limiter->_queue == this) _limiter->arm(*sched, now);
+      return true;
+    }
+
+    constexpr auto await_resume() const noexcept -> void {}
+
+   private:
+    friend class rate_limiter;
+
+    rate_limiter *_limiter;
+    std::uint64_t _tokens;
+    acquire_awaiter *_queue_next = nullptr;
+  };
+
+  inline auto rate_limiter::acquire(std::uint64_t n) noexcept -> acquire_awaiter { return {*this, n}; }
+
+  static_assert(aio::awaitable_of<rate_limiter::acquire_awaiter, void>);
+
+  inline auto rate_limiter::enqueue(acquire_awaiter *waiter) noexcept -> void {
+    auto **link = &_queue;
+    while (*link && (*link)->_tokens <= waiter->_tokens) link = &(*link)->_queue_next;
+    waiter->_queue_next = *link;
+    *link = waiter;
+  }
+
+  inline auto rate_limiter::arm(scheduler &sched, std::int64_t now) noexcept -> void {
+    const auto at = clock::time_point(std::chrono::duration_cast<clock::duration>(
+        std::chrono::nanoseconds(std::max(ready_at(_queue->_tokens, now), now))));
+    if (!_timer_scheduler) {
+      _timer_scheduler = &sched;
+      sched.post_timer(&_timer, at);
+    } else if (_timer_scheduler == &sched && sched.running_in_this_thread() && _timer.armed()) {
+      // A new, smaller head may be served earlier. A timer still in flight to, or armed on, another
+      // scheduler cannot be moved; it serves whatever the head is when it fires.
+      sched.cancel_timer(&_timer);
+      sched.add_timer(&_timer, at);
+    }
+  }
+
+  inline auto rate_limiter::on_timer(timer_node *node) noexcept -> void {
+    auto *self = static_cast<refill_timer *>(node)->owner;
+    detail::node_queue wake;
+    {
+      std::lock_guard lock(self->_mutex);
+      self->_timer_scheduler = nullptr;
+      const auto now = nanoseconds_of(clock::now());
+      while (self->_queue && self->try_take(self->_queue->_tokens, now)) {
+        auto *granted = std::exchange(self->_queue, self->_queue->_queue_next);
+        self->_waiting.fetch_sub(1, std::memory_order_acq_rel);
+        wake.push_back(granted);
+      }
+      // Hand the timer to the scheduler of the new head, which stays alive at least until it is served.
+      if (self->_queue) self->arm(*self->_queue->owner, now);
+    }
+    detail::resume_waiters(wake);
+  }
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Rate limiter split into independent buckets to avoid contention across cores
+  ///
+  /// The configured rate and burst are divided evenly over the shards. A request is served by the
+  /// home shard of the thread it runs on; when that shard is short, the other shards are tried
+  /// before the request queues on its home shard. The aggregate rate is the configured one, but a single
+  /// CPU draining its shard may observe a lower burst than an unsharded limiter would allow.
+  class sharded_rate_limiter {
+   public:
+    /// \param rate Aggregate tokens added per second
+    /// \param burst Aggregate bucket capacity
+    /// \param shards Number of buckets; defaults to the number of hardware threads
+    sharded_rate_limiter(double rate, std::uint64_t burst, std::size_t shards = 0) {
+      if (shards == 0) shards = std::max(1u, std::thread::hardware_concurrency());
+      const auto shard_burst = std::max<std::uint64_t>(burst / shards, 1);
+      _shards.reserve(shards);
+      for (std::size_t i = 0; i < shards; ++i) {
+        _shards.push_back(std::make_unique<rate_limiter>(rate / static_cast<double>(shards), shard_burst));
+      }
+    }
+
+    [[nodiscard]] auto try_acquire(std::uint64_t n = 1) noexcept -> bool {
+      const auto home = home_shard();
+      for (std::size_t i = 0; i < _shards.size(); ++i) {
+        if (_shards[(home + i) % _shards.size()]->try_acquire(n)) return true;
+      }
+      return false;
+    }
+
+    class acquire_awaiter;
+
+    /// \brief Returns an awaitable that completes once `n` tokens have been taken
+    ///
+    /// Nothing is taken until the awaitable is awaited. Tokens are then taken from any shard that
+    /// has them right away; otherwise the request queues on the shard of the awaiting thread.
+    [[nodiscard]] auto acquire(std::uint64_t n = 1) noexcept -> acquire_awaiter;
+
+    [[nodiscard]] auto shard_count() const noexcept -> std::size_t { return _shards.size(); }
+
+   private:
+    // Threads are spread over the shards round-robin in order of first use, so that with one
+    // scheduler per core each core has a bucket of its own.
+    [[nodiscard]] auto home_shard() const noexcept -> std::size_t {
+      static std::atomic<std::size_t> next_slot{0};
+      thread_local const std::size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+      return slot % _shards.size();
+    }
+
+    std::vector<std::unique_ptr<rate_limiter>> _shards{};
+  };
+
+  class sharded_rate_limiter::acquire_awaiter {
+   public:
+    acquire_awaiter(sharded_rate_limiter &limiter, std::uint64_t tokens) noexcept : _limiter(&limiter), _tokens(tokens) {}
+
+    [[nodiscard]] auto await_ready() noexcept -> bool {
+      if (_tokens == 0 || _limiter->try_acquire(_tokens)) return true;
+      _home.emplace(*_limiter->_shards[_limiter->home_shard()], _tokens);
+      return false;
+    }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+      return _home->await_suspend(coro);
+    }
+
+    constexpr auto await_resume() const noexcept -> void {}
+
+   private:
+    sharded_rate_limiter *_limiter;
+    std::uint64_t _tokens;
+    // Waiter queued on the home shard; lives in the awaiting coroutine's frame.
+    std::optional<rate_limiter::acquire_awaiter> _home{};
+  };
+
+  inline auto sharded_rate_limiter::acquire(std::uint64_t n) noexcept -> acquire_awaiter { return {*this, n}; }
+
+  static_assert(aio::awaitable_of<sharded_rate_limiter::acquire_awaiter, void>);
+}  // namespace aio
+
+#endif  // AIO_RATE_LIMITER_HPP
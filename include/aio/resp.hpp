@@ -0,0 +1,533 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_RESP_HPP
+#define AIO_RESP_HPP
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/simd.hpp"
+#include "result.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief Errors reported by resp_parser
+  enum class resp_errc {
+    bad_type = 1,  ///< Unknown type marker
+    bad_line,      ///< Line not terminated by CRLF, or a malformed simple value
+    bad_integer,   ///< Malformed or out of range integer, length or count
+    too_large,     ///< Bulk string or aggregate larger than the limits of resp_parser_options
+    too_deep,      ///< Aggregates nested deeper than resp_parser_options::max_depth
+    unexpected_reply ///< Reply that no request is waiting for
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Returns the error category of aio::resp_errc
+  [[nodiscard]] inline auto resp_category() noexcept -> const std::error_category & {
+    static const struct : std::error_category {
+      [[nodiscard]] auto name() const noexcept -> const char * override { return "aio.resp"; }
+      [[nodiscard]] auto message(int value) const -> std::string override {
+        switch (static_cast<resp_errc>(value)) {
+          case resp_errc::bad_type: return "unknown RESP type";
+          case resp_errc::bad_line: return "malformed RESP line";
+          case resp_errc::bad_integer: return "malformed RESP integer";
+          case resp_errc::too_large: return "RESP value too large";
+          case resp_errc::too_deep: return "RESP aggregates nested too deeply";
+          case resp_errc::unexpected_reply: return "unexpected RESP reply";
+        }
+        return "unknown RESP error";
+      }
+    } category;
+    return category;
+  }
+
+  [[nodiscard]] inline auto make_error_code(resp_errc error) noexcept -> std::error_code {
+    return {static_cast<int>(error), resp_category()};
+  }
+}  // namespace aio
+
+template <>
+struct std::is_error_code_enum<aio::resp_errc> : std::true_type {};
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief Type of a RESP2 or RESP3 value
+  enum class resp_type : std::uint8_t {
+    simple_string,   ///< `+`
+    simple_error,    ///< `-`
+    integer,         ///< `:`
+    bulk_string,     ///< `$`
+    array,           ///< `*`
+    null,            ///< `_`, and the RESP2 null bulk string and null array
+    boolean,         ///< `#`
+    floating_point,  ///< `,`, kept as text
+    big_number,      ///< `(`, kept as text
+    bulk_error,      ///< `!`
+    verbatim_string, ///< `=`, with its three-letter format and colon
+    map,             ///< `%`
+    set,             ///< `~`
+    push             ///< `>`, out-of-band data such as pub/sub messages
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief A parsed RESP value
+  ///
+  /// Strings point into the parsed data and aggregates into storage of the parser (or of the
+  /// resp_reply that owns the value). Elements of a map alternate between keys and values.
+  struct resp_value {
+    resp_type type = resp_type::null;
+
+    /// Payload of strings, errors, floating point and big numbers.
+    std::string_view text{};
+
+    /// Value of integers and booleans; number of elements of aggregates.
+    std::int64_t integer = 0;
+
+    /// Elements of arrays, maps, sets and pushes.
+    std::span<const resp_value> elements{};
+
+    [[nodiscard]] auto is_error() const noexcept -> bool { return type == resp_type::simple_error || type == resp_type::bulk_error; }
+    [[nodiscard]] auto is_null() const noexcept -> bool { return type == resp_type::null; }
+    [[nodiscard]] auto is_aggregate() const noexcept -> bool {
+      return type == resp_type::array || type == resp_type::map || type == resp_type::set || type == resp_type::push;
+    }
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief A RESP value that owns its data, e.g. a reply handed to a client coroutine
+  ///
+  /// Made by resp_parser::take(); move-only, since its values point into its own storage.
+  class resp_reply {
+   public:
+    resp_reply() noexcept = default;
+    resp_reply(resp_reply &&) noexcept = default;
+    auto operator=(resp_reply &&) noexcept -> resp_reply & = default;
+
+    [[nodiscard]] auto value() const noexcept -> const resp_value & { return _root; }
+    [[nodiscard]] auto operator*() const noexcept -> const resp_value & { return _root; }
+    [[nodiscard]] auto operator->() const noexcept -> const resp_value * { return &_root; }
+
+   private:
+    friend class resp_parser;
+
+    std::unique_ptr<char[]> _data{};
+    std::vector<resp_value> _nodes{};
+    resp_value _root{};
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Limits enforced by resp_parser
+  struct resp_parser_options {
+    std::size_t max_bulk_length = 512 * 1024 * 1024; ///< Longest accepted bulk string, as in Redis
+    std::size_t max_elements = 1024 * 1024;          ///< Most elements of one aggregate
+    std::size_t max_depth = 64;                      ///< Deepest nesting of aggregates
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Incremental, zero-copy parser of RESP2 and RESP3
+  ///
+  /// parse() takes the received data starting at a value boundary and parses every complete
+  /// top-level value in it in one pass, so pipelined replies (or commands) that arrive together
+  /// come out as one batch. Strings are views into the data; the elements of all aggregates of a
+  /// batch share one array owned by the parser, each aggregate's elements contiguous in it. Line
+  /// ends are found with the SIMD byte search, and bulk strings are skipped by their length, so
+  /// a large bulk string that is still arriving costs O(1) per call. Any other incomplete value is
+  /// parsed again from its start once more data has arrived, including an aggregate whose count
+  /// is more than the rest of the data could hold, so the element storage reserved up front stays
+  /// proportional to the data. RESP3 attributes are skipped.
+  class resp_parser {
+   public:
+    explicit resp_parser(resp_parser_options options = {}) : _options(options) {}
+
+    /// \brief Parses all complete values at the start of `data`; produces the number of bytes they take up
+    ///
+    /// Once at least one value was parsed, an error in a later one ends the batch and is reported
+    /// by the next call instead. The values stay valid until the next call and as long as `data`.
+    auto parse(std::string_view data) -> result<std::size_t, std::error_code> {
+      _values.clear();
+      _value_children.clear();
+      _nodes.clear();
+      _node_children.clear();
+      _extents.clear();
+      std::size_t position = 0;
+      while (position != data.size()) {
+        const auto start = position;
+        const auto first_node = _nodes.size();
+        resp_value value{};
+        std::size_t children = 0;
+        auto parsed = parse_value(data, position, 0, value, children);
+        if (!parsed || !*parsed) {
+          _nodes.resize(first_node);
+          _node_children.resize(first_node);
+          if (!parsed && _values.empty()) return failure<std::error_code>(parsed.error());
+          position = start;
+          break;
+        }
+        _values.push_back(value);
+        _value_children.push_back(children);
+        _extents.push_back({start, position - start, first_node, _nodes.size()});
+      }
+      for (std::size_t i = 0; i < _nodes.size(); ++i) link(_nodes[i], _node_children[i]);
+      for (std::size_t i = 0; i < _values.size(); ++i) link(_values[i], _value_children[i]);
+      _data = data;
+      return position;
+    }
+
+    /// \brief Returns the values of the last parse()
+    [[nodiscard]] auto values() const noexcept -> std::span<const resp_value> { return _values; }
+
+    /// \brief Copies value `index` of the last parse() into a resp_reply that owns its data
+    ///
+    /// One allocation holds the value's wire bytes, which its strings are rebased onto, and one its elements.
+    [[nodiscard]] auto take(std::size_t index) const -> resp_reply {
+      const auto &extent = _extents[index];
+      resp_reply reply;
+      reply._data = std::make_unique_for_overwrite<char[]>(extent.size);
+      std::memcpy(reply._data.get(), _data.data() + extent.offset, extent.size);
+      reply._nodes.assign(_nodes.begin() + static_cast<std::ptrdiff_t>(extent.first_node),
+                          _nodes.begin() + static_cast<std::ptrdiff_t>(extent.last_node));
+
+      const auto *old_data = _data.data() + extent.offset;
+      const auto *old_nodes = _nodes.data() + extent.first_node;
+      const auto rebase = [&](resp_value &value) {
+        if (!value.text.empty()) value.text = {reply._data.get() + (value.text.data() - old_data), value.text.size()};
+        if (!value.elements.empty()) value.elements = {reply._nodes.data() + (value.elements.data() - old_nodes), value.elements.size()};
+      };
+      for (auto &node : reply._nodes) rebase(node);
+      reply._root = _values[index];
+      rebase(reply._root);
+      return reply;
+    }
+
+   private:
+    struct extent {
+      std::size_t offset;
+      std::size_t size;
+      std::size_t first_node;
+      std::size_t last_node;
+    };
+
+    [[nodiscard]] static auto as_bytes(const char *text) noexcept -> const std::byte * { return reinterpret_cast<const std::byte *>(text); }
+
+    auto link(resp_value &value, std::size_t first_child) noexcept -> void {
+      if (value.is_aggregate()) value.elements = {_nodes.data() + first_child, static_cast<std::size_t>(value.integer)};
+    }
+
+    // Returns the line starting at `position` without its CRLF and moves past it; nothing if incomplete.
+    [[nodiscard]] static auto read_line(std::string_view data, std::size_t &position) -> result<std::optional<std::string_view>, std::error_code> {
+      const auto *first = as_bytes(data.data() + position);
+      const auto *last = as_bytes(data.data() + data.size());
+      const auto *cr = detail::find_byte(first, last, std::byte{'\r'});
+      if (last - cr < 2) return std::optional<std::string_view>();
+      if (cr[1] != std::byte{'\n'}) return failure<std::error_code>(make_error_code(resp_errc::bad_line));
+      const auto line = data.substr(position, static_cast<std::size_t>(cr - first));
+      position += line.size() + 2;
+      return std::optional<std::string_view>(line);
+    }
+
+    [[nodiscard]] static auto parse_integer(std::string_view text) noexcept -> std::optional<std::int64_t> {
+      std::int64_t value = 0;
+      const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+      if (ec != std::errc() || end != text.data() + text.size()) return std::nullopt;
+      return value;
+    }
+
+    // Parses one value at `position` into `value`, moving past it; produces false if it is incomplete.
+    // `children` receives the index of an aggregate's first element in _nodes.
+    auto parse_value(std::string_view data, std::size_t &position, std::size_t depth, resp_value &value, std::size_t &children)
+        -> result<bool, std::error_code> {
+      if (position == data.size()) return false;
+      const auto marker = data[position++];
+      auto line = read_line(data, position);
+      if (!line) return failure<std::error_code>(line.error());
+      if (!*line) return false;
+      const auto text = **line;
+
+      switch (marker) {
+        case '+': value = {resp_type::simple_string, text}; return true;
+        case '-': value = {resp_type::simple_error, text}; return true;
+        case ',':
+        case '(':
+          if (text.empty()) return bad_line();
+          value = {marker == ',' ? resp_type::floating_point : resp_type::big_number, text};
+          return true;
+        case '_':
+          if (!text.empty()) return bad_line();
+          value = {resp_type::null};
+          return true;
+        case ':': {
+          const auto number = parse_integer(text);
+          if (!number) return failure<std::error_code>(make_error_code(resp_errc::bad_integer));
+          value = {resp_type::integer, {}, *number};
+          return true;
+        }
+        case '#':
+          if (text != "t" && text != "f") return failure<std::error_code>(make_error_code(resp_errc::bad_line));
+          value = {resp_type::boolean, {}, text == "t"};
+          return true;
+        case '$': return parse_bulk(data, position, text, resp_type::bulk_string, value);
+        case '!': return parse_bulk(data, position, text, resp_type::bulk_error, value);
+        case '=': return parse_bulk(data, position, text, resp_type::verbatim_string, value);
+        case '*': return parse_aggregate(data, position, depth, text, resp_type::array, 1, value, children);
+        case '~': return parse_aggregate(data, position, depth, text, resp_type::set, 1, value, children);
+        case '>': return parse_aggregate(data, position, depth, text, resp_type::push, 1, value, children);
+        case '%': return parse_aggregate(data, position, depth, text, resp_type::map, 2, value, children);
+        case '|': {
+          // An attribute map annotates the value that follows; parse it, then parse that value in its place.
+          auto attribute = parse_aggregate(data, position, depth, text, resp_type::map, 2, value, children);
+          if (!attribute || !*attribute) return attribute;
+          return parse_value(data, position, depth, value, children);
+        }
+        default: return failure<std::error_code>(make_error_code(resp_errc::bad_type));
+      }
+    }
+
+    [[nodiscard]] static auto bad_line() noexcept -> result<bool, std::error_code> {
+      return failure<std::error_code>(make_error_code(resp_errc::bad_line));
+    }
+
+    auto parse_length(std::string_view text, std::size_t limit) const -> result<std::optional<std::size_t>, std::error_code> {
+      const auto length = parse_integer(text);
+      if (!length || *length < -1) return failure<std::error_code>(make_error_code(resp_errc::bad_integer));
+      if (*length == -1) return std::optional<std::size_t>();
+      if (static_cast<std::uint64_t>(*length) > limit) return failure<std::error_code>(make_error_code(resp_errc::too_large));
+      return std::optional<std::size_t>(static_cast<std::size_t>(*length));
+    }
+
+    auto parse_bulk(std::string_view data, std::size_t &position, std::string_view header, resp_type type, resp_value &value) const
+        -> result<bool, std::error_code> {
+      auto length = parse_length(header, _options.max_bulk_length);
+      if (!length) return failure<std::error_code>(length.error());
+      if (!*length) {
+        value = {resp_type::null};
+        return true;
+      }
+      const auto size = **length;
+      if (data.size() - position < size + 2) return false;
+      if (data[position + size] != '\r' || data[position + size + 1] != '\n') return bad_line();
+      if (type == resp_type::verbatim_string && (size < 4 || data[position + 3] != ':')) return bad_line();
+      value = {type, data.substr(position, size)};
+      position += size + 2;
+      return true;
+    }
+
+    auto parse_aggregate(std::string_view data, std::size_t &position, std::size_t depth, std::string_view header, resp_type type,
+                         std::size_t per_entry, resp_value &value, std::size_t &children) -> result<bool, std::error_code> {
+      auto count = parse_length(header, _options.max_elements);
+      if (!count) return failure<std::error_code>(count.error());
+      if (!*count) {
+        value = {resp_type::null};
+        return true;
+      }
+      if (depth == _options.max_depth) return failure<std::error_code>(make_error_code(resp_errc::too_deep));
+      const auto size = **count * per_entry;
+      // Every element takes at least three bytes ("_\r\n"), so a count the unread data cannot hold
+      // is incomplete; checking first keeps the reservation below proportional to the data received.
+      if (size > (data.size() - position) / 3) return false;
+      // Reserve the elements' slots first so they are contiguous; nested aggregates get theirs after.
+      const auto first = _nodes.size();
+      _nodes.resize(first + size);
+      _node_children.resize(first + size);
+      for (std::size_t i = 0; i < size; ++i) {
+        resp_value element{};
+        std::size_t element_children = 0;
+        auto parsed = parse_value(data, position, depth + 1, element, element_children);
+        if (!parsed || !*parsed) return parsed;
+        _nodes[first + i] = element;
+        _node_children[first + i] = element_children;
+      }
+      value = {type, {}, static_cast<std::int64_t>(size)};
+      children = first;
+      return true;
+    }
+
+    resp_parser_options _options;
+    std::string_view _data{};
+    std::vector<resp_value> _values{};
+    std::vector<std::size_t> _value_children{};
+    std::vector<resp_value> _nodes{};
+    std::vector<std::size_t> _node_children{};
+    std::vector<extent> _extents{};
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Encoder of RESP commands and replies into a gather list
+  ///
+  /// Small strings are copied into an internal buffer. Bulk strings of at least
+  /// `reference_threshold` bytes are not copied: the gather list points at the caller's memory,
+  /// which must then stay alive and unchanged until the encoded data has been written. The
+  /// default threshold copies everything.
+  class resp_encoder {
+   public:
+    explicit resp_encoder(std::size_t reference_threshold = std::numeric_limits<std::size_t>::max()) noexcept
+        : _reference_threshold(reference_threshold) {}
+
+    /// \brief Appends a command: an array of bulk strings
+    auto command(std::span<const std::string_view> args) -> void {
+      aggregate(resp_type::array, args.size());
+      for (auto arg : args) bulk_string(arg);
+    }
+
+    auto command(std::initializer_list<std::string_view> args) -> void { command(std::span(args.begin(), args.size())); }
+
+    auto simple_string(std::string_view text) -> void { line('+', text); }
+    auto error(std::string_view text) -> void { line('-', text); }
+    auto integer(std::int64_t value) -> void { number(':', value); }
+
+    auto bulk_string(std::string_view text) -> void {
+      number('$', static_cast<std::int64_t>(text.size()));
+      if (text.size() >= _reference_threshold) {
+        _segments.push_back({text.data(), 0, text.size()});
+      } else {
+        append(text);
+      }
+      append("\r\n");
+    }
+
+    /// \brief Appends the RESP3 null
+    auto null() -> void { append("_\r\n"); }
+
+    /// \brief Appends the RESP2 null bulk string, which RESP2 clients expect for a missing value
+    auto null_bulk_string() -> void { append("$-1\r\n"); }
+
+    auto boolean(bool value) -> void { append(value ? "#t\r\n" : "#f\r\n"); }
+
+    /// \brief Appends the header of an array, set, push or map of `size` entries; maps count key-value pairs
+    auto aggregate(resp_type type, std::size_t size) -> void {
+      const char marker = type == resp_type::map ? '%' : type == resp_type::set ? '~' : type == resp_type::push ? '>' : '*';
+      number(marker, static_cast<std::int64_t>(size));
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return _segments.empty(); }
+
+    /// \brief Returns the number of encoded bytes
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+      std::size_t total = 0;
+      for (const auto &segment : _segments) total += segment.size;
+      return total;
+    }
+
+    /// \brief Returns the encoded data as a gather list, valid until the encoder is modified
+    [[nodiscard]] auto buffers() -> std::span<iovec> {
+      _iovecs.clear();
+      for (const auto &segment : _segments) {
+        const auto *base = segment.external ? segment.external : _bytes.data() + segment.offset;
+        _iovecs.push_back({const_cast<char *>(base), segment.size});
+      }
+      return _iovecs;
+    }
+
+    /// \brief Returns the encoded data if nothing was referenced, i.e. if it is one contiguous block
+    [[nodiscard]] auto contiguous() const noexcept -> std::optional<std::string_view> {
+      if (_segments.size() > 1 || (_segments.size() == 1 && _segments.front().external)) return std::nullopt;
+      return std::string_view(_bytes);
+    }
+
+    /// \brief Writes the encoded data to `stream` and clears the encoder
+    template <async_vectored_write_stream Stream>
+    auto write(Stream &stream) -> task<result<void, std::error_code>> {
+      result<void, std::error_code> written;
+      if (const auto bytes = contiguous()) {
+        written = co_await aio::write_all(stream, std::as_bytes(std::span(bytes->data(), bytes->size())));
+      } else {
+        written = co_await aio::write_all(stream, buffers());
+      }
+      clear();
+      co_return written;
+    }
+
+    auto clear() noexcept -> void {
+      _bytes.clear();
+      _segments.clear();
+    }
+
+   private:
+    struct segment {
+      const char *external;
+      std::size_t offset;
+      std::size_t size;
+    };
+
+    auto append(std::string_view text) -> void {
+      if (_segments.empty() || _segments.back().external) _segments.push_back({nullptr, _bytes.size(), 0});
+      _bytes += text;
+      _segments.back().size += text.size();
+    }
+
+    auto line(char marker, std::string_view text) -> void {
+      const char prefix[1] = {marker};
+      append(std::string_view(prefix, 1));
+      append(text);
+      append("\r\n");
+    }
+
+    auto number(char marker, std::int64_t value) -> void {
+      char text[24];
+      text[0] = marker;
+      auto *end = std::to_chars(text + 1, text + sizeof(text) - 2, value).ptr;
+      *end++ = '\r';
+      *end++ = '\n';
+      append(std::string_view(text, static_cast<std::size_t>(end - text)));
+    }
+
+    std::size_t _reference_threshold;
+    std::string _bytes{};
+    std::vector<segment> _segments{};
+    std::vector<iovec> _iovecs{};
+  };
+}  // namespace aio
+
+#endif  // AIO_RESP_HPP
@@ -0,0 +1,295 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_RESP_CLIENT_HPP
+#define AIO_RESP_CLIENT_HPP
+
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "detail/waiter.hpp"
+#include "resp.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "socket.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief Options of resp_client
+  struct resp_client_options {
+    /// Limits applied to replies. Aggregates are held to fewer elements and less nesting than the
+    /// parser's defaults allow; raise max_elements to read larger collections in one reply.
+    resp_parser_options parser{.max_elements = 64 * 1024, .max_depth = 16};
+
+    /// Initial size of the receive buffer; it grows to hold the largest reply received.
+    std::size_t read_buffer_size = 64 * 1024;
+
+    /// Arguments of at least this many bytes are sent straight from the caller's memory instead of being copied.
+    std::size_t reference_threshold = 1024;
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Client of a Redis-compatible server that pipelines the commands of concurrent coroutines
+  ///
+  /// Any number of coroutines may await execute() on one client at the same time. Each command is
+  /// encoded into the client's output buffer when its coroutine suspends, and the coroutine joins
+  /// an intrusive FIFO queue of waiters. A writer coroutine sends everything buffered in one
+  /// write, then everything that was buffered meanwhile, and so on; a reader coroutine parses the
+  /// replies as they arrive and hands them out in queue order, which is the order the server
+  /// answers in, resuming every waiter of a read as one batch. Both run only while there is work,
+  /// so an idle client has no operation in flight. Push messages (RESP3 `>`) are skipped.
+  ///
+  /// The first failure (an I/O error, the server closing the connection or a protocol error)
+  /// fails every waiting and later command with that error. execute() must always be awaited on
+  /// the same scheduler. The client is a handle: the connection stays open while commands it sent
+  /// are outstanding, even if the handle is destroyed.
+  class resp_client {
+    struct state;
+
+   public:
+    using reply_result = result<resp_reply, std::error_code>;
+
+    template <std::size_t Extent>
+    class command_awaiter;
+
+    resp_client() noexcept = default;
+
+    explicit resp_client(socket_stream socket, resp_client_options options = {}) : _state(std::make_shared<state>(AIO_MOV(socket), options)) {}
+
+    /// \brief Connects to the server at `address`
+    [[nodiscard]] static auto connect(socket_address address, resp_client_options options = {}) -> task<result<resp_client, std::error_code>> {
+      auto socket = co_await socket_stream::connect(address);
+      if (!socket) co_return failure<std::error_code>(socket.error());
+      co_return resp_client(AIO_MOV(*socket), options);
+    }
+
+    /// \brief Sends the command made of `args` and produces its reply
+    ///
+    /// The arguments are encoded when the awaiting coroutine suspends; those of at least
+    /// resp_client_options::reference_threshold bytes are sent from the caller's memory, so every
+    /// argument must stay alive until the awaitable completes. An error reply from the server is a
+    /// reply, not a failure.
+    template <class... Args>
+      requires(sizeof...(Args) > 0 && (std::convertible_to<const Args &, std::string_view> && ...))
+    [[nodiscard]] auto execute(const Args &...args) noexcept -> command_awaiter<sizeof...(Args)> {
+      assert(_state && "execute() on an empty resp_client");
+      return command_awaiter<sizeof...(Args)>(*_state, {std::string_view(args)...});
+    }
+
+    /// \brief Sends the command made of the arguments in `args`, which must outlive the awaitable
+    [[nodiscard]] auto execute(std::span<const std::string_view> args) noexcept -> command_awaiter<std::dynamic_extent>;
+
+    /// \brief Returns the number of commands sent or queued whose reply has not arrived yet
+    [[nodiscard]] auto pending() const noexcept -> std::size_t { return _state ? _state->pending : 0; }
+
+    /// \brief Shuts the connection down; waiting and later commands fail with `connection_aborted`
+    auto close() noexcept -> void {
+      if (_state) fail(*_state, std::make_error_code(std::errc::connection_aborted));
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _state != nullptr; }
+
+   private:
+    // Waiter with the slot its reply is written to.
+    struct request_waiter : detail::waiter {
+      reply_result reply{};
+    };
+
+    struct state : std::enable_shared_from_this<state> {
+      state(socket_stream stream, const resp_client_options &options)
+          : socket(AIO_MOV(stream)), parser(options.parser), output(options.reference_threshold), sending(options.reference_threshold),
+            capacity(std::max<std::size_t>(options.read_buffer_size, 64)), input(std::make_unique_for_overwrite<char[]>(capacity)) {}
+
+      socket_stream socket;
+      scheduler *loop = nullptr;
+      resp_parser parser;
+      resp_encoder output;
+      resp_encoder sending;
+      std::size_t capacity;
+      std::unique_ptr<char[]> input;
+      std::size_t begin = 0;
+      std::size_t end = 0;
+      detail::node_queue waiting{};
+      std::size_t pending = 0;
+      std::error_code error{};
+      bool writing = false;
+      bool reading = false;
+    };
+
+    // Records the first failure and stops the connection. Waiters are failed once no write is in
+    // flight, as a write may still be reading their arguments.
+    static auto fail(state &self, std::error_code error) noexcept -> void {
+      if (!self.error) self.error = error;
+      (void)self.socket.shutdown();
+      if (!self.writing) fail_waiters(self);
+    }
+
+    static auto fail_waiters(state &self) noexcept -> void {
+      detail::node_queue failed;
+      while (auto *waiter = static_cast<request_waiter *>(self.waiting.pop_front())) {
+        waiter->reply = failure<std::error_code>(self.error);
+        failed.push_back(waiter);
+      }
+      self.pending = 0;
+      self.output.clear();
+      detail::resume_waiters(failed);
+    }
+
+    static auto write_loop(std::shared_ptr<state> self) -> task<void> {
+      while (!self->output.empty() && !self->error) {
+        std::swap(self->output, self->sending);
+        auto written = co_await self->sending.write(self->socket);
+        if (!written) fail(*self, written.error());
+      }
+      self->writing = false;
+      if (self->error) fail_waiters(*self);
+    }
+
+    static auto read_loop(std::shared_ptr<state> self) -> task<void> {
+      while (!self->waiting.empty() && !self->error) {
+        auto parsed = self->parser.parse(std::string_view(self->input.get() + self->begin, self->end - self->begin));
+        if (!parsed) {
+          fail(*self, parsed.error());
+          break;
+        }
+        detail::node_queue answered;
+        bool unexpected = false;
+        const auto replies = self->parser.values();
+        for (std::size_t i = 0; i < replies.size() && !unexpected; ++i) {
+          if (replies[i].type == resp_type::push) continue;
+          auto *waiter = static_cast<request_waiter *>(self->waiting.pop_front());
+          if (!waiter) {
+            unexpected = true;
+            continue;
+          }
+          waiter->reply = self->parser.take(i);
+          --self->pending;
+          answered.push_back(waiter);
+        }
+        self->begin += *parsed;
+        detail::resume_waiters(answered);
+        if (unexpected) fail(*self, make_error_code(resp_errc::unexpected_reply));
+        if (!replies.empty()) continue;
+        if (!co_await receive(*self)) break;
+      }
+      self->reading = false;
+    }
+
+    // Reads more data, making room by compacting the buffer or, when it holds a single partial
+    // reply that fills it, by doubling it.
+    static auto receive(state &self) -> task<bool> {
+      if (self.end == self.capacity) {
+        if (self.begin == 0) {
+          auto grown = std::make_unique_for_overwrite<char[]>(self.capacity * 2);
+          std::memcpy(grown.get(), self.input.get(), self.end);
+          self.input = AIO_MOV(grown);
+          self.capacity *= 2;
+        } else {
+          std::memmove(self.input.get(), self.input.get() + self.begin, self.end - self.begin);
+          self.end -= self.begin;
+          self.begin = 0;
+        }
+      }
+      auto read = co_await self.socket.read_some(std::as_writable_bytes(std::span(self.input.get() + self.end, self.capacity - self.end)));
+      if (!read || *read == 0) {
+        fail(self, read ? make_error_code(stream_errc::end_of_stream) : read.error());
+        co_return false;
+      }
+      self.end += *read;
+      if (self.begin == self.end) self.begin = self.end = 0;
+      co_return true;
+    }
+
+    std::shared_ptr<state> _state{};
+  };
+
+  /// Awaiter of resp_client::execute(); owns the argument views of a fixed-size command.
+  template <std::size_t Extent>
+  class resp_client::command_awaiter : request_waiter {
+    using arguments = std::conditional_t<Extent == std::dynamic_extent, std::span<const std::string_view>, std::array<std::string_view, Extent>>;
+
+   public:
+    command_awaiter(state &self, arguments args) noexcept : _state(&self), _args(args) {}
+
+    [[nodiscard]] auto await_ready() noexcept -> bool {
+      if (!_state->error) return false;
+      reply = failure<std::error_code>(_state->error);
+      return true;
+    }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> void {
+      prepare(coro);
+      if (!_state->loop) _state->loop = owner;
+      assert(owner && owner == _state->loop && "resp_client::execute() must be awaited on one scheduler");
+      _state->output.command(std::span<const std::string_view>(_args));
+      _state->waiting.push_back(this);
+      ++_state->pending;
+      if (!_state->writing) {
+        _state->writing = true;
+        _state->loop->spawn(resp_client::write_loop(_state->shared_from_this()));
+      }
+      if (!_state->reading) {
+        _state->reading = true;
+        _state->loop->spawn(resp_client::read_loop(_state->shared_from_this()));
+      }
+    }
+
+    [[nodiscard]] auto await_resume() noexcept -> reply_result { return AIO_MOV(reply); }
+
+   private:
+    state *_state;
+    arguments _args;
+  };
+
+  inline auto resp_client::execute(std::span<const std::string_view> args) noexcept -> command_awaiter<std::dynamic_extent> {
+    assert(_state && "execute() on an empty resp_client");
+    return command_awaiter<std::dynamic_extent>(*_state, args);
+  }
+
+  static_assert(aio::awaitable_of<resp_client::command_awaiter<2>, resp_client::reply_result>);
+}  // namespace aio
+
+#endif  // AIO_RESP_CLIENT_HPP
@@ -0,0 +1,533 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_SCHEDULER_HPP
+#define AIO_SCHEDULER_HPP
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "detail/futex.hpp"
+#include "detail/io_ring.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "lane.hpp"
+#include "numa.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
+namespace aio {
+  class scheduler;
+
+  namespace detail {
+    inline thread_local scheduler *current_scheduler = nullptr;
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Tuning knobs for a scheduler
+  struct scheduler_options {
+    /// Resolution at which deadlines are bucketed; deadlines closer together than this are served FIFO.
+    clock::duration deadline_granularity = std::chrono::microseconds(250);
+
+    /// Number of consecutive dispatches from higher lanes a non-empty lane tolerates before it is
+    /// served once regardless of priority. Zero disables the quota for that lane (strict priority).
+    std::array<std::uint32_t, lane_count> fairness_quota{0, 8, 32};
+
+    /// Home NUMA node of the thread running the scheduler. When set, run() binds the thread to the
+    /// node's CPUs and node-aware allocators used on it (frames, buffer pools) take that node's memory.
+    numa_node_id node = any_node;
+
+    /// Tick length of the scheduler's timer wheel; timers fire at most this late.
+    clock::duration timer_resolution = std::chrono::microseconds(100);
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Per-lane accounting collected by a scheduler
+  struct lane_stats {
+    std::uint64_t dispatched = 0;       ///< Number of resumptions run on this lane
+    std::uint64_t quota_dispatches = 0; ///< Resumptions granted by the fairness quota rather than by priority
+    std::uint64_t deadline_misses = 0;  ///< Resumptions that started after their deadline had passed
+    clock::duration busy{};             ///< Wall time spent running work of this lane
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Single-threaded run loop with prioritized, deadline-aware ready queues
+  ///
+  /// The scheduler owns one bucketed earliest-deadline-first queue per lane (see aio::lane).
+  /// Each dispatch picks the highest non-empty lane, unless a lower lane has been passed over
+  /// for more than its fairness quota, in which case that lane is served once. Time spent in
+  /// each lane, dispatch counts and deadline misses are accounted per lane and available from
+  /// stats().
+  ///
+  /// Work is queued by co_awaiting schedule() or yield(), or by spawning a task. Both are safe
+  /// to call from any thread: work coming from a thread other than the one running the
+  /// scheduler goes through a lock-free inbox and wakes the loop if it is idle.
+  ///
+  /// The scheduler also owns a timer_wheel that is advanced on every loop iteration; when idle,
+  /// the loop sleeps until the next timer is due. Timers are armed with sleep_for(),
+  /// sleep_until(), or directly with add_timer() from the scheduler's own thread.
+  ///
+  /// I/O is submitted to an io_uring instance the scheduler creates on first use. Submissions are
+  /// batched into one system call per loop iteration, completions are reaped on every iteration,
+  /// and once the ring exists the idle loop waits on it, so that I/O completions, timers and
+  /// cross-thread wakeups all end the same wait.
+  class scheduler {
+   public:
+    explicit scheduler(scheduler_options options = {}) noexcept
+        : _options(options), _timers(options.timer_resolution) {
+      for (auto &queue : _lanes) queue = detail::lane_queue(options.deadline_granularity);
+    }
+
+    scheduler(const scheduler &) = delete;
+    auto operator=(const scheduler &) -> scheduler & = delete;
+
+    ~scheduler() {
+      _ring.reset();
+      if (const auto fd = _wake_fd.load(std::memory_order_relaxed); fd >= 0) ::close(fd);
+    }
+
+    /// \brief Returns the scheduler running on the calling thread, or `nullptr`
+    [[nodiscard]] static auto current() noexcept -> scheduler * { return detail::current_scheduler; }
+
+    /// \brief Returns true if called from the thread currently running this scheduler
+    [[nodiscard]] auto running_in_this_thread() const noexcept -> bool { return detail::current_scheduler == this; }
+
+    class schedule_awaiter {
+     public:
+      schedule_awaiter(scheduler &sched, std::optional<aio::lane> l, clock::time_point deadline) noexcept
+          : _scheduler(&sched), _lane(l), _deadline(deadline) {}
+
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+        _node.handle = coro;
+        _node.lane = _lane.value_or(aio::lane::normal);
+        _node.deadline = _deadline;
+        if constexpr (std::derived_from<Promise, detail::task_promise_base>) {
+          if (!_lane) _node.lane = coro.promise().lane();
+          if (_deadline == no_deadline) _node.deadline = coro.promise().deadline();
+        }
+        _scheduler->enqueue(&_node);
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+
+     private:
+      detail::schedule_node _node{};
+      scheduler *_scheduler;
+      std::optional<aio::lane> _lane;
+      clock::time_point _deadline;
+    };
+
+    /// \brief Returns an awaitable that resumes the awaiting coroutine on this scheduler
+    ///
+    /// When awaited from a task, the task's own lane and deadline are used.
+    [[nodiscard]] auto schedule() noexcept -> schedule_awaiter { return {*this, std::nullopt, no_deadline}; }
+
+    /// \brief Returns an awaitable that resumes the awaiting coroutine on the given lane
+    [[nodiscard]] auto schedule(aio::lane l, clock::time_point deadline = no_deadline) noexcept -> schedule_awaiter {
+      return {*this, l, deadline};
+    }
+
+    /// \brief Requeues the awaiting coroutine behind all runnable work of the same lane and urgency
+    [[nodiscard]] auto yield() noexcept -> schedule_awaiter { return schedule(); }
+
+    class sleep_awaiter : timer_node {
+     public:
+      sleep_awaiter(scheduler &sched, clock::time_point expiry) noexcept : _scheduler(&sched), _expiry(expiry) {
+        fire = &on_expiry;
+      }
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return _expiry <= clock::now(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+        _node.handle = coro;
+        if constexpr (std::derived_from<Promise, detail::task_promise_base>) {
+          _node.lane = coro.promise().lane();
+          _node.deadline = coro.promise().deadline();
+        }
+        _scheduler->add_timer(this, _expiry);
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+
+     private:
+      static auto on_expiry(timer_node *node) noexcept -> void {
+        auto *self = static_cast<sleep_awaiter *>(node);
+        self->_scheduler->enqueue(&self->_node);
+      }
+
+      detail::schedule_node _node{};
+      scheduler *_scheduler;
+      clock::time_point _expiry;
+    };
+
+    /// \brief Returns an awaitable that resumes the awaiting coroutine once `expiry` has passed
+    ///
+    /// Must be awaited on the scheduler's own thread.
+    [[nodiscard]] auto sleep_until(clock::time_point expiry) noexcept -> sleep_awaiter { return {*this, expiry}; }
+
+    /// \brief Returns an awaitable that resumes the awaiting coroutine after `duration`
+    ///
+    /// Must be awaited on the scheduler's own thread.
+    [[nodiscard]] auto sleep_for(clock::duration duration) noexcept -> sleep_awaiter {
+      return {*this, clock::now() + duration};
+    }
+
+    /// \brief Returns the time sampled when the current dispatch started
+    ///
+    /// Cheaper than clock::now() and at most one dispatch stale; must be called on the scheduler's
+    /// own thread.
+    [[nodiscard]] auto now() const noexcept -> clock::time_point { return _now; }
+
+    /// \brief Arms a timer on this scheduler's wheel; must be called on the scheduler's thread
+    auto add_timer(timer_node *node, clock::time_point expiry) noexcept -> void { _timers.schedule(node, expiry); }
+
+    /// \brief Arms a timer on this scheduler's wheel from any thread
+    ///
+    /// From another thread the timer is handed over through a lock-free inbox and inserted by the
+    /// run loop, which is woken if idle. It can only be cancelled once it is armed, i.e. from the
+    /// scheduler's thread after it has been picked up.
+    auto post_timer(timer_node *node, clock::time_point expiry) noexcept -> void {
+      if (running_in_this_thread()) {
+        add_timer(node, expiry);
+        return;
+      }
+      node->expiry = static_cast<std::uint64_t>(expiry.time_since_epoch().count());
+      auto *head = _timer_inbox.load(std::memory_order_relaxed);
+      do {
+        node->next = head;
+      } while (!_timer_inbox.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+      notify();
+    }
+
+    /// \brief Disarms a timer armed with add_timer(); must be called on the scheduler's thread
+    auto cancel_timer(timer_node *node) noexcept -> void { _timers.cancel(node); }
+
+    /// \brief Returns a zeroed io_uring submission entry, creating the ring on first use
+    ///
+    /// The caller fills in the entry and points its `user_data` at a detail::io_completion that
+    /// stays alive until it is invoked; the entry is submitted with everything else queued in the
+    /// same loop iteration, and the completion runs on the scheduler's thread. Must be called on
+    /// the scheduler's own thread.
+    [[nodiscard]] auto submission_entry() -> io_uring_sqe * { return ring().get_sqe(); }
+
+    /// \brief Starts a task on this scheduler without waiting for it
+    ///
+    /// The task's frame is destroyed when it completes. An exception escaping a spawned task
+    /// terminates the program.
+    template <class T>
+    auto spawn(task<T> &&t) noexcept -> void {
+      auto coro = t.release();
+      if (!coro) return;
+      auto &promise = coro.promise();
+      promise.set_detached();
+      auto &node = static_cast<detail::schedule_node &>(promise);
+      node.handle = coro;
+      enqueue(&node);
+    }
+
+    /// \brief Queues a ready-queue node; thread-safe
+    auto enqueue(detail::schedule_node *node) noexcept -> void {
+      if (running_in_this_thread()) {
+        _lanes[lane_index(node->lane)].push(node);
+      } else {
+        _inbox.push(node);
+        notify();
+      }
+    }
+
+    /// \brief Queues a whole chain of nodes at once; thread-safe
+    ///
+    /// Used by primitives that release a group of waiters, so they become runnable with one
+    /// splice into the inbox instead of one atomic operation per waiter.
+    auto enqueue_batch(detail::node_queue &nodes) noexcept -> void {
+      if (nodes.empty()) return;
+      if (running_in_this_thread()) {
+        while (auto *node = nodes.pop_front()) _lanes[lane_index(node->lane)].push(node);
+        return;
+      }
+      auto *first = nodes.front();
+      auto *last = first;
+      while (last->next) last = last->next;
+      // The inbox is a stack that is reversed on take_all(), so push the chain back to front.
+      reverse_chain(first);
+      _inbox.push_chain(last, first);
+      nodes = {};
+      notify();
+    }
+
+    /// \brief Runs ready work until request_stop() is called
+    ///
+    /// The stop request is consumed on return, so the scheduler can be run again afterwards.
+    auto run() -> void {
+      bind_home_node();
+      auto *previous = std::exchange(detail::current_scheduler, this);
+      while (!_stop.load(std::memory_order_acquire)) {
+        if (!run_one()) wait_for_work();
+      }
+      _stop.store(false, std::memory_order_relaxed);
+      detail::current_scheduler = previous;
+    }
+
+    /// \brief Runs ready work until no more work is queued
+    auto run_until_idle() -> void {
+      bind_home_node();
+      auto *previous = std::exchange(detail::current_scheduler, this);
+      while (run_one()) {
+      }
+      detail::current_scheduler = previous;
+    }
+
+    /// \brief Asks run() to return once the current dispatch completes; thread-safe
+    auto request_stop() noexcept -> void {
+      _stop.store(true, std::memory_order_release);
+      notify();
+    }
+
+    /// \brief Returns the accounting of the given lane
+    [[nodiscard]] auto stats(aio::lane l) const noexcept -> const lane_stats & { return _stats[lane_index(l)]; }
+
+    /// \brief Returns the number of queued resumptions on the given lane
+    [[nodiscard]] auto queued(aio::lane l) const noexcept -> std::size_t { return _lanes[lane_index(l)].size(); }
+
+    [[nodiscard]] auto options() const noexcept -> const scheduler_options & { return _options; }
+
+   private:
+    auto bind_home_node() noexcept -> void {
+      if (_options.node == any_node || detail::thread_home_node == _options.node) return;
+      const auto &topology = numa_topology::system();
+      const auto index = topology.index_of(_options.node);
+      if (index < topology.node_count()) bind_this_thread(topology.nodes()[index]);
+    }
+
+    static auto reverse_chain(detail::schedule_node *first) noexcept -> void {
+      detail::schedule_node *previous = nullptr;
+      while (first) {
+        auto *next = first->next;
+        first->next = previous;
+        previous = first;
+        first = next;
+      }
+    }
+
+    auto ring() -> detail::io_ring & {
+      if (!_ring) {
+        _ring = std::make_unique<detail::io_ring>();
+        const auto fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd < 0) throw std::system_error(errno, std::system_category(), "eventfd");
+        _wake_reader.complete = &on_wake;
+        _wake_reader.owner = this;
+        _wake_fd.store(fd, std::memory_order_release);
+        arm_wake_reader();
+      }
+      return *_ring;
+    }
+
+    // Keeps a read of the wake eventfd in flight, so that notify() can interrupt a wait on the ring.
+    struct wake_reader : detail::io_completion {
+      scheduler *owner = nullptr;
+      std::uint64_t value = 0;
+    };
+
+    auto arm_wake_reader() -> void {
+      auto *sqe = _ring->get_sqe();
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = _wake_fd.load(std::memory_order_relaxed);
+      sqe->addr = reinterpret_cast<std::uint64_t>(&_wake_reader.value);
+      sqe->len = sizeof(_wake_reader.value);
+      sqe->user_data = reinterpret_cast<std::uint64_t>(&_wake_reader);
+    }
+
+    static auto on_wake(detail::io_completion *completion, std::int32_t, std::uint32_t) noexcept -> void {
+      static_cast<wake_reader *>(completion)->owner->arm_wake_reader();
+    }
+
+    auto run_one() -> bool {
+      if (_ring) {
+        _ring->submit(0, std::nullopt);
+        _ring->reap();
+      }
+
+      if (!_inbox.empty()) {
+        auto incoming = _inbox.take_all();
+        while (auto *node = incoming.pop_front()) _lanes[lane_index(node->lane)].push(node);
+      }
+
+      for (auto *node = _timer_inbox.exchange(nullptr, std::memory_order_acquire); node;) {
+        auto *next = std::exchange(node->next, nullptr);
+        add_timer(node, clock::time_point(clock::duration(static_cast<clock::rep>(node->expiry))));
+        node = next;
+      }
+
+      auto start = clock::now();
+      _now = start;
+      if (!_timers.empty()) _timers.advance(start);
+
+      auto *node = pick();
+      if (!node) return false;
+
+      auto &stats = _stats[lane_index(node->lane)];
+      if (node->deadline < start) ++stats.deadline_misses;
+      ++stats.dispatched;
+      node->handle.resume();
+      stats.busy += clock::now() - start;
+      return true;
+    }
+
+    auto pick() noexcept -> detail::schedule_node * {
+      std::size_t highest = 0;
+      while (highest < lane_count && _lanes[highest].empty()) ++highest;
+      if (highest == lane_count) return nullptr;
+
+      // Serve the highest non-empty lane, unless a lower one has been passed over for its full quota.
+      auto chosen = highest;
+      for (auto l = highest + 1; l < lane_count; ++l) {
+        if (!_lanes[l].empty() && _options.fairness_quota[l] != 0 && _passed_over[l] >= _options.fairness_quota[l]) {
+          chosen = l;
+          ++_stats[l].quota_dispatches;
+          break;
+        }
+      }
+      for (auto l = highest + 1; l < lane_count; ++l) {
+        if (l != chosen && !_lanes[l].empty()) ++_passed_over[l];
+      }
+      _passed_over[chosen] = 0;
+      return _lanes[chosen].pop();
+    }
+
+    auto wait_for_work() -> void {
+      const auto epoch = _epoch.load(std::memory_order_acquire);
+      _sleeping.store(true, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_inbox.empty() && !_timer_inbox.load(std::memory_order_seq_cst) && !_stop.load(std::memory_order_seq_cst)) {
+        std::optional<std::chrono::nanoseconds> timeout;
+        if (const auto expiry = _timers.next_expiry()) timeout = *expiry - clock::now();
+        if (timeout && timeout->count() <= 0) {
+          // A timer is already due.
+        } else if (_ring) {
+          if (!_ring->has_completions()) _ring->submit(1, timeout);
+        } else {
+          detail::futex_wait(&_epoch, epoch, timeout);
+        }
+      }
+      _sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    auto notify() noexcept -> void {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_sleeping.load(std::memory_order_seq_cst)) {
+        _epoch.fetch_add(1, std::memory_order_release);
+        if (const auto fd = _wake_fd.load(std::memory_order_acquire); fd >= 0) {
+          ::eventfd_write(fd, 1);
+        } else {
+          detail::futex_wake(&_epoch);
+        }
+      }
+    }
+
+    scheduler_options _options;
+    std::array<detail::lane_queue, lane_count> _lanes{};
+    std::array<std::uint32_t, lane_count> _passed_over{};
+    std::array<lane_stats, lane_count> _stats{};
+    timer_wheel _timers;
+    clock::time_point _now = clock::now();
+    detail::atomic_node_stack _inbox{};
+    std::atomic<timer_node *> _timer_inbox{nullptr};
+    std::atomic<bool> _stop{false};
+    std::atomic<bool> _sleeping{false};
+    std::atomic<std::uint32_t> _epoch{0};
+    std::unique_ptr<detail::io_ring> _ring{};
+    wake_reader _wake_reader{};
+    std::atomic<int> _wake_fd{-1};
+  };
+
+  namespace detail {
+    template <class T>
+    struct sync_wait_state {
+      std::optional<std::conditional_t<std::is_void_v<T>, char, T>> value{};
+      std::exception_ptr exception{};
+    };
+
+    template <class T>
+    auto sync_wait_task(scheduler &sched, task<T> t, sync_wait_state<T> &state) -> task<void> {
+      try {
+        if constexpr (std::is_void_v<T>) {
+          co_await AIO_MOV(t);
+          state.value.emplace();
+        } else {
+          state.value.emplace(co_await AIO_MOV(t));
+        }
+      } catch (...) {
+        state.exception = std::current_exception();
+      }
+      sched.request_stop();
+    }
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Runs a task to completion on the given scheduler and returns its result
+  ///
+  /// The calling thread runs the scheduler until the task completes. Exceptions thrown by the
+  /// task are rethrown.
+  template <class T>
+  auto sync_wait(scheduler &sched, task<T> t) -> T {
+    detail::sync_wait_state<T> state;
+    const auto l = t ? t.handle().promise().lane() : aio::lane::normal;
+    const auto deadline = t ? t.handle().promise().deadline() : no_deadline;
+    auto wrapper = detail::sync_wait_task(sched, AIO_MOV(t), state);
+    wrapper.handle().promise().set_lane(l);
+    wrapper.handle().promise().set_deadline(deadline);
+    sched.spawn(AIO_MOV(wrapper));
+    sched.run();
+    if (state.exception) std::rethrow_exception(state.exception);
+    if constexpr (!std::is_void_v<T>) return AIO_MOV(*state.value);
+  }
+}  // namespace aio
+
+#endif  // AIO_SCHEDULER_HPP
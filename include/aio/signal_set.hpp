@@ -0,0 +1,190 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_SIGNAL_SET_HPP
+#define AIO_SIGNAL_SET_HPP
+
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <system_error>
+
+#include "coroutine.hpp"
+#include "detail/io_ring.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/waiter.hpp"
+#include "scheduler.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief A signal delivered through a signal_set
+  struct signal_event {
+    int number = 0;     ///< Signal number, e.g. `SIGHUP`
+    pid_t sender = 0;   ///< Process that sent the signal, if it was sent with kill(2) or sigqueue(3)
+    uid_t sender_uid = 0; ///< Real user ID of the sender
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Delivers POSIX signals to coroutines on a chosen scheduler
+  ///
+  /// The constructor blocks the signals in the calling thread and opens a signalfd for them, so
+  /// they are never delivered to a signal handler: all work happens in ordinary coroutine code on
+  /// the scheduler. To block the signals process-wide, construct the set on the main thread before
+  /// any other thread is started; threads inherit the signal mask of their creator.
+  ///
+  /// Each signal is consumed by one waiter, in the order the waiters arrived. While coroutines wait,
+  /// the scheduler polls the signalfd through its io_uring; every signal read in one go is handed to
+  /// a waiter and all of them are resumed as one batch. Signals arriving while nobody waits stay
+  /// pending in the kernel until the next wait() (as usual, repeated instances of a standard signal
+  /// are merged). The signals remain blocked after the set is destroyed.
+  ///
+  /// wait() must be awaited on the scheduler given to the constructor, and the set must not be
+  /// destroyed while a wait is pending.
+  class signal_set {
+   public:
+    class awaiter;
+
+    signal_set(scheduler &loop, std::initializer_list<int> signals) : _loop(&loop) {
+      ::sigemptyset(&_mask);
+      for (auto signal : signals) ::sigaddset(&_mask, signal);
+      if (const auto rc = ::pthread_sigmask(SIG_BLOCK, &_mask, nullptr); rc != 0) {
+        throw std::system_error(rc, std::system_category(), "pthread_sigmask");
+      }
+      _fd = ::signalfd(-1, &_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+      if (_fd < 0) throw std::system_error(errno, std::system_category(), "signalfd");
+      _poll.complete = &on_readable;
+      _poll.owner = this;
+    }
+
+    signal_set(const signal_set &) = delete;
+    auto operator=(const signal_set &) -> signal_set & = delete;
+
+    ~signal_set() {
+      assert(_waiters.empty() && "signal_set destroyed while coroutines wait on it");
+      ::close(_fd);
+    }
+
+    /// \brief Returns an awaitable producing the next signal of the set
+    [[nodiscard]] auto wait() noexcept -> awaiter;
+
+    /// \brief Returns true if `signal` is a member of the set
+    [[nodiscard]] auto contains(int signal) const noexcept -> bool { return ::sigismember(&_mask, signal) == 1; }
+
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+   private:
+    static constexpr std::size_t read_batch = 16;
+
+    struct poll_completion : detail::io_completion {
+      signal_set *owner = nullptr;
+    };
+
+    // Waiter with the slot the delivered signal is written to.
+    struct signal_waiter : detail::waiter {
+      signal_event event{};
+    };
+
+    auto arm() -> void {
+      if (_polling || _waiters.empty()) return;
+      _polling = true;
+      auto *sqe = _loop->submission_entry();
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = _fd;
+      sqe->poll32_events = POLLIN;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<detail::io_completion *>(&_poll));
+    }
+
+    // Runs on the loop when the signalfd is readable: reads as many signals as there are waiters
+    // (up to a batch) without blocking and resumes their waiters together.
+    static auto on_readable(detail::io_completion *completion, std::int32_t, std::uint32_t) noexcept -> void {
+      auto *self = static_cast<poll_completion *>(completion)->owner;
+      self->_polling = false;
+
+      std::size_t wanted = 0;
+      for (auto *node = self->_waiters.front(); node && wanted < read_batch; node = node->next) ++wanted;
+      std::array<signalfd_siginfo, read_batch> infos;
+      const auto bytes = ::read(self->_fd, infos.data(), wanted * sizeof(signalfd_siginfo));
+
+      detail::node_queue wake;
+      for (std::size_t i = 0; bytes > 0 && i < static_cast<std::size_t>(bytes) / sizeof(signalfd_siginfo); ++i) {
+        auto *waiter = static_cast<signal_waiter *>(self->_waiters.pop_front());
+        waiter->event = {static_cast<int>(infos[i].ssi_signo), static_cast<pid_t>(infos[i].ssi_pid),
+                         static_cast<uid_t>(infos[i].ssi_uid)};
+        wake.push_back(waiter);
+      }
+      self->arm();
+      detail::resume_waiters(wake);
+    }
+
+    scheduler *_loop;
+    sigset_t _mask{};
+    int _fd = -1;
+    bool _polling = false;
+    poll_completion _poll{};
+    detail::node_queue _waiters{};
+  };
+
+  class signal_set::awaiter : signal_waiter {
+   public:
+    explicit awaiter(signal_set &set) noexcept : _set(&set) {}
+
+    [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> void {
+      assert(_set->_loop->running_in_this_thread() && "signal_set::wait() must be awaited on its scheduler");
+      prepare(coro);
+      _set->_waiters.push_back(this);
+      _set->arm();
+    }
+
+    [[nodiscard]] auto await_resume() const noexcept -> signal_event { return event; }
+
+   private:
+    signal_set *_set;
+  };
+
+  inline auto signal_set::wait() noexcept -> awaiter { return awaiter(*this); }
+
+  static_assert(aio::awaitable_of<signal_set::awaiter, signal_event>);
+}  // namespace aio
+
+#endif  // AIO_SIGNAL_SET_HPP
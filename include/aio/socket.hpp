@@ -0,0 +1,488 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_SOCKET_HPP
+#define AIO_SOCKET_HPP
+
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "detail/io_ring.hpp"
+#include "detail/macros.hpp"
+#include "detail/waiter.hpp"
+#include "io.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Address of a TCP endpoint (IPv4 or IPv6) or a Unix domain socket
+  class socket_address {
+   public:
+    constexpr socket_address() noexcept = default;
+
+    /// \brief Returns the IPv4 loopback address with `port`
+    [[nodiscard]] static auto loopback(std::uint16_t port) noexcept -> socket_address {
+      socket_address address;
+      auto &in = address.as<sockaddr_in>();
+      in.sin_family = AF_INET;
+      in.sin_port = htons(port);
+      in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address._size = sizeof(sockaddr_in);
+      return address;
+    }
+
+    /// \brief Returns the Unix domain socket address `path`; a leading `@` selects the abstract namespace
+    [[nodiscard]] static auto local(std::string_view path) -> result<socket_address, std::error_code> {
+      socket_address address;
+      auto &un = address.as<sockaddr_un>();
+      if (path.empty()) return failure<std::error_code>(std::make_error_code(std::errc::invalid_argument));
+      if (path.size() >= sizeof(un.sun_path)) return failure<std::error_code>(std::make_error_code(std::errc::filename_too_long));
+      un.sun_family = AF_UNIX;
+      std::memcpy(un.sun_path, path.data(), path.size());
+      if (path.front() == '@') un.sun_path[0] = '\0';
+      // Abstract names are not NUL-terminated; their length is part of the address.
+      address._size = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + (path.front() == '@' ? 0 : 1));
+      return address;
+    }
+
+    /// \brief Parses `host:port` with a numeric IPv4 host, `[host]:port` with a numeric IPv6 host, or `unix:path`
+    [[nodiscard]] static auto parse(std::string_view text) -> result<socket_address, std::error_code> {
+      const auto invalid = [] { return failure<std::error_code>(std::make_error_code(std::errc::invalid_argument)); };
+      if (text.starts_with("unix:")) return local(text.substr(5));
+
+      const auto colon = text.rfind(':');
+      if (colon == std::string_view::npos) return invalid();
+      std::uint16_t port = 0;
+      const auto port_text = text.substr(colon + 1);
+      const auto [end, ec] = std::from_chars(port_text.data(), port_text.data() + port_text.size(), port);
+      if (ec != std::errc() || end != port_text.data() + port_text.size()) return invalid();
+
+      auto host = text.substr(0, colon);
+      const bool v6 = host.starts_with('[') && host.ends_with(']');
+      if (v6) host = host.substr(1, host.size() - 2);
+      char buffer[INET6_ADDRSTRLEN]{};
+      if (host.size() >= sizeof(buffer)) return invalid();
+      std::memcpy(buffer, host.data(), host.size());
+
+      socket_address address;
+      if (v6) {
+        auto &in6 = address.as<sockaddr_in6>();
+        if (::inet_pton(AF_INET6, buffer, &in6.sin6_addr) != 1) return invalid();
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+        address._size = sizeof(sockaddr_in6);
+      } else {
+        auto &in = address.as<sockaddr_in>();
+        if (::inet_pton(AF_INET, buffer, &in.sin_addr) != 1) return invalid();
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        address._size = sizeof(sockaddr_in);
+      }
+      return address;
+    }
+
+    /// \brief Returns the local address the socket `fd` is bound to
+    [[nodiscard]] static auto of_socket(int fd) -> result<socket_address, std::error_code> {
+      socket_address address;
+      address._size = sizeof(address._storage);
+      if (::getsockname(fd, address.data(), &address._size) != 0) {
+        return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      }
+      return address;
+    }
+
+    [[nodiscard]] auto data() noexcept -> sockaddr * { return reinterpret_cast<sockaddr *>(&_storage); }
+    [[nodiscard]] auto data() const noexcept -> const sockaddr * { return reinterpret_cast<const sockaddr *>(&_storage); }
+    [[nodiscard]] auto size() const noexcept -> socklen_t { return _size; }
+    [[nodiscard]] auto family() const noexcept -> int { return _storage.ss_family; }
+
+    /// \brief Returns the port of a TCP address, zero for a Unix domain socket address
+    [[nodiscard]] auto port() const noexcept -> std::uint16_t {
+      if (family() == AF_INET) return ntohs(as<sockaddr_in>().sin_port);
+      if (family() == AF_INET6) return ntohs(as<sockaddr_in6>().sin6_port);
+      return 0;
+    }
+
+    /// \brief Formats the address the way parse() accepts it
+    [[nodiscard]] auto to_string() const -> std::string {
+      char buffer[INET6_ADDRSTRLEN]{};
+      switch (family()) {
+        case AF_INET:
+          ::inet_ntop(AF_INET, &as<sockaddr_in>().sin_addr, buffer, sizeof(buffer));
+          return std::string(buffer) + ':' + std::to_string(port());
+        case AF_INET6:
+          ::inet_ntop(AF_INET6, &as<sockaddr_in6>().sin6_addr, buffer, sizeof(buffer));
+          return '[' + std::string(buffer) + "]:" + std::to_string(port());
+        case AF_UNIX: {
+          const auto &un = as<sockaddr_un>();
+          std::string path(un.sun_path, _size - offsetof(sockaddr_un, sun_path));
+          if (!path.empty() && path.front() == '\0') {
+            path.front() = '@';
+          } else if (!path.empty() && path.back() == '\0') {
+            path.pop_back();
+          }
+          return "unix:" + path;
+        }
+        default:
+          return {};
+      }
+    }
+
+   private:
+    template <class T>
+    [[nodiscard]] auto as() noexcept -> T & {
+      return *reinterpret_cast<T *>(&_storage);
+    }
+
+    template <class T>
+    [[nodiscard]] auto as() const noexcept -> const T & {
+      return *reinterpret_cast<const T *>(&_storage);
+    }
+
+    sockaddr_storage _storage{};
+    socklen_t _size = 0;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Owning, move-only connected stream socket, read and written through io_uring
+  class socket_stream {
+   public:
+    using void_result = result<void, std::error_code>;
+
+    constexpr socket_stream() noexcept = default;
+    explicit socket_stream(int fd) noexcept : _fd(fd) {}
+
+    socket_stream(socket_stream &&other) noexcept : _fd(std::exchange(other._fd, -1)) {}
+    auto operator=(socket_stream other) noexcept -> socket_stream & {
+      std::swap(_fd, other._fd);
+      return *this;
+    }
+
+    ~socket_stream() { close(); }
+
+    /// \brief Opens a stream socket and connects it to `address`; TCP sockets get `TCP_NODELAY`
+    [[nodiscard]] static auto connect(socket_address address) -> task<result<socket_stream, std::error_code>> {
+      socket_stream socket(::socket(address.family(), SOCK_STREAM | SOCK_CLOEXEC, 0));
+      if (!socket) co_return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      if (address.family() != AF_UNIX) {
+        if (auto set = socket.set_no_delay(true); !set) co_return failure<std::error_code>(set.error());
+      }
+      if (auto connected = co_await async_connect(socket.native_handle(), address.data(), address.size()); !connected) {
+        co_return failure<std::error_code>(connected.error());
+      }
+      co_return socket;
+    }
+
+    /// \brief Receives at most `buffer.size()` bytes straight into `buffer`; zero bytes means end of stream
+    [[nodiscard]] auto read_some(std::span<std::byte> buffer) const { return async_recv(_fd, buffer); }
+
+    /// \brief Sends a prefix of `buffer`; produces the number of bytes sent
+    [[nodiscard]] auto write_some(std::span<const std::byte> buffer) const { return async_send(_fd, buffer); }
+
+    /// \brief Gather-sends a prefix of the concatenation of `buffers`; produces the number of bytes sent
+    [[nodiscard]] auto write_some(std::span<const iovec> buffers) const { return async_sendv(_fd, buffers); }
+
+    /// \brief Shuts down the receiving and/or sending side; a pending receive completes with end of stream
+    auto shutdown(int how = SHUT_RDWR) const noexcept -> void_result {
+      if (::shutdown(_fd, how) != 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      return void_result();
+    }
+
+    /// \brief Enables or disables Nagle's algorithm on a TCP socket
+    auto set_no_delay(bool enabled) const noexcept -> void_result {
+      const int value = enabled ? 1 : 0;
+      if (::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) != 0) {
+        return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      }
+      return void_result();
+    }
+
+    /// \brief Closes the socket
+    auto close() noexcept -> void {
+      if (_fd >= 0) ::close(std::exchange(_fd, -1));
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _fd >= 0; }
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _fd; }
+
+    /// \brief Gives up ownership of the descriptor
+    [[nodiscard]] auto release() noexcept -> int { return std::exchange(_fd, -1); }
+
+   private:
+    int _fd = -1;
+  };
+
+  static_assert(aio::async_read_stream<socket_stream> && aio::async_vectored_write_stream<socket_stream>);
+
+  /// \ingroup io
+  ///
+  /// \brief Options of acceptor::listen()
+  struct listen_options {
+    /// Length of the kernel's queue of connections not accepted yet.
+    int backlog = SOMAXCONN;
+
+    /// Sets `SO_REUSEADDR` on TCP sockets, so the port can be bound again while old connections linger.
+    bool reuse_address = true;
+
+    /// Sets `SO_REUSEPORT` on TCP sockets: several listeners, typically one per thread, bind the same
+    /// address and the kernel spreads incoming connections over them.
+    bool reuse_port = false;
+
+    /// Sets `TCP_NODELAY` on TCP listeners; accepted connections inherit it.
+    bool no_delay = true;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Listening socket that accepts connections with one multishot io_uring request
+  ///
+  /// The first accept() that has to wait arms a multishot accept: from then on the kernel posts a
+  /// completion for every incoming connection without further submissions, and each is handed to
+  /// the next waiter. Connections that arrive while nobody waits are queued in the acceptor, so a
+  /// loop that accepts and spawns a handler takes them without suspending. The request is re-armed
+  /// when the kernel ends it; kernels without multishot accept get one accept per connection.
+  /// Failed accepts (e.g. `EMFILE`) are reported to the next accept() and do not stop the acceptor.
+  ///
+  /// close() stops listening at once; coroutines still waiting in accept() complete with
+  /// `ECANCELED` when the kernel has retired the request. accept() must always be awaited on the
+  /// same scheduler, and close() and the destructor run there too once it has been awaited.
+  class acceptor {
+    struct state;
+
+   public:
+    class awaiter;
+
+    constexpr acceptor() noexcept = default;
+
+    /// \brief Takes ownership of the listening socket `fd`
+    explicit acceptor(int fd) : _state(std::make_unique<state>()) {
+      _state->fd = fd;
+      _state->complete = &on_accept;
+    }
+
+    acceptor(acceptor &&) noexcept = default;
+    auto operator=(acceptor &&other) noexcept -> acceptor & {
+      if (this != &other) {
+        close();
+        _state = AIO_MOV(other._state);
+      }
+      return *this;
+    }
+
+    ~acceptor() { close(); }
+
+    /// \brief Opens a stream socket listening on `address`
+    [[nodiscard]] static auto listen(const socket_address &address, listen_options options = {}) -> result<acceptor, std::error_code> {
+      const int fd = ::socket(address.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if (fd < 0) return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      acceptor listener(fd);
+      const auto enable = [fd](int level, int name) { const int one = 1; return ::setsockopt(fd, level, name, &one, sizeof(one)) == 0; };
+      bool configured = true;
+      if (address.family() != AF_UNIX) {
+        if (options.reuse_address) configured = configured && enable(SOL_SOCKET, SO_REUSEADDR);
+        if (options.reuse_port) configured = configured && enable(SOL_SOCKET, SO_REUSEPORT);
+        if (options.no_delay) configured = configured && enable(IPPROTO_TCP, TCP_NODELAY);
+      }
+      if (!configured || ::bind(fd, address.data(), address.size()) != 0 || ::listen(fd, options.backlog) != 0) {
+        return failure<std::error_code>(std::error_code(errno, std::system_category()));
+      }
+      return listener;
+    }
+
+    /// \brief Returns an awaitable producing the next accepted connection
+    [[nodiscard]] auto accept() noexcept -> awaiter;
+
+    /// \brief Returns the address the socket listens on, e.g. to learn the port chosen for port 0
+    [[nodiscard]] auto local_address() const -> result<socket_address, std::error_code> { return socket_address::of_socket(native_handle()); }
+
+    /// \brief Stops listening and closes the connections accepted but not taken yet
+    auto close() noexcept -> void {
+      if (!_state) return;
+      auto *self = _state.release();
+      for (auto fd : self->ready) ::close(fd);
+      self->ready.clear();
+      // The ring holds its own reference to the socket until the armed request ends.
+      ::close(std::exchange(self->fd, -1));
+      if (!self->armed) {
+        assert(self->waiters.empty());
+        delete self;
+        return;
+      }
+      assert(self->loop->running_in_this_thread() && "acceptor closed away from its scheduler");
+      self->orphaned = true;
+      auto *sqe = self->loop->submission_entry();
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<std::uint64_t>(static_cast<detail::io_completion *>(self));
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return _state != nullptr; }
+    [[nodiscard]] auto native_handle() const noexcept -> int { return _state ? _state->fd : -1; }
+
+   private:
+    // Waiter with the slot the accepted descriptor, or the error, is written to.
+    struct accept_waiter : detail::waiter {
+      int fd = -1;
+      int error = 0;
+    };
+
+    // Lives on the heap so the armed request, which may outlive the acceptor, has a stable target.
+    struct state : detail::io_completion {
+      int fd = -1;
+      scheduler *loop = nullptr;
+      bool armed = false;
+      bool multishot = true;
+      bool accepted = false;
+      bool orphaned = false;
+      int error = 0;
+      std::deque<int> ready{};
+      detail::node_queue waiters{};
+    };
+
+    static auto arm(state &self) -> void {
+      self.armed = true;
+      auto *sqe = self.loop->submission_entry();
+      sqe->opcode = IORING_OP_ACCEPT;
+      sqe->fd = self.fd;
+      sqe->accept_flags = SOCK_CLOEXEC;
+      if (self.multishot) sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(static_cast<detail::io_completion *>(&self));
+    }
+
+    static auto wake_one(accept_waiter *waiter) noexcept -> void {
+      detail::node_queue wake;
+      wake.push_back(waiter);
+      detail::resume_waiters(wake);
+    }
+
+    static auto on_accept(detail::io_completion *completion, std::int32_t result, std::uint32_t flags) noexcept -> void {
+      auto *self = static_cast<state *>(completion);
+      if (!(flags & IORING_CQE_F_MORE)) self->armed = false;
+      if (self->orphaned) {
+        if (result >= 0) ::close(result);
+        if (self->armed) return;
+        detail::node_queue cancelled;
+        while (auto *waiter = static_cast<accept_waiter *>(self->waiters.pop_front())) {
+          waiter->error = ECANCELED;
+          cancelled.push_back(waiter);
+        }
+        delete self;
+        detail::resume_waiters(cancelled);
+        return;
+      }
+
+      if (result == -EINVAL && self->multishot && !self->accepted) {
+        // Kernels before 5.19 reject the multishot flag; fall back to one accept per connection.
+        self->multishot = false;
+      } else if (auto *waiter = static_cast<accept_waiter *>(self->waiters.pop_front())) {
+        if (result >= 0) {
+          waiter->fd = result;
+        } else {
+          waiter->error = -result;
+        }
+        wake_one(waiter);
+      } else if (result >= 0) {
+        self->ready.push_back(result);
+      } else {
+        self->error = -result;
+      }
+      if (result >= 0) self->accepted = true;
+      if (!self->armed && !self->waiters.empty()) arm(*self);
+    }
+
+    std::unique_ptr<state> _state{};
+  };
+
+  class acceptor::awaiter : accept_waiter {
+   public:
+    explicit awaiter(state &self) noexcept : _state(&self) {}
+
+    [[nodiscard]] auto await_ready() noexcept -> bool {
+      if (!_state->ready.empty()) {
+        fd = _state->ready.front();
+        _state->ready.pop_front();
+        return true;
+      }
+      error = std::exchange(_state->error, 0);
+      return error != 0;
+    }
+
+    template <class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> coro) -> void {
+      assert((!_state->loop || _state->loop->running_in_this_thread()) && "acceptor::accept() must be awaited on one scheduler");
+      prepare(coro);
+      _state->loop = owner;
+      assert(_state->loop && "acceptor::accept() must be awaited on a scheduler");
+      _state->waiters.push_back(this);
+      if (!_state->armed) acceptor::arm(*_state);
+    }
+
+    [[nodiscard]] auto await_resume() noexcept -> result<socket_stream, std::error_code> {
+      if (error != 0) return failure<std::error_code>(std::error_code(error, std::system_category()));
+      return socket_stream(fd);
+    }
+
+   private:
+    state *_state;
+  };
+
+  inline auto acceptor::accept() noexcept -> awaiter {
+    assert(_state && "accept() on a closed acceptor");
+    return awaiter(*_state);
+  }
+
+  static_assert(aio::awaitable_of<acceptor::awaiter, result<socket_stream, std::error_code>>);
+}  // namespace aio
+
+#endif  // AIO_SOCKET_HPP
@@ -0,0 +1,453 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_STREAM_HPP
+#define AIO_STREAM_HPP
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/macros.hpp"
+#include "detail/simd.hpp"
+#include "result.hpp"
+#include "task.hpp"
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Errors reported by stream algorithms and buffered streams
+  enum class stream_errc {
+    end_of_stream = 1,  ///< The stream ended before the requested data was complete
+    delimiter_not_found, ///< The buffer filled up without the delimiter appearing
+    frame_too_large      ///< A frame exceeds the codec's maximum frame size
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Returns the error category of aio::stream_errc
+  [[nodiscard]] inline auto stream_category() noexcept -> const std::error_category & {
+    static const struct : std::error_category {
+      [[nodiscard]] auto name() const noexcept -> const char * override { return "aio.stream"; }
+      [[nodiscard]] auto message(int value) const -> std::string override {
+        switch (static_cast<stream_errc>(value)) {
+          case stream_errc::end_of_stream: return "end of stream";
+          case stream_errc::delimiter_not_found: return "delimiter not found within the buffer";
+          case stream_errc::frame_too_large: return "frame too large";
+        }
+        return "unknown stream error";
+      }
+    } category;
+    return category;
+  }
+
+  [[nodiscard]] inline auto make_error_code(stream_errc error) noexcept -> std::error_code {
+    return {static_cast<int>(error), stream_category()};
+  }
+}  // namespace aio
+
+template <>
+struct std::is_error_code_enum<aio::stream_errc> : std::true_type {};
+
+namespace aio {
+  /// \ingroup io
+  ///
+  /// \brief Concept of a byte stream that can be read asynchronously
+  ///
+  /// `read_some(buffer)` returns an awaitable producing `aio::result<std::size_t, std::error_code>`:
+  /// the number of bytes read into a prefix of `buffer`, zero at the end of the stream.
+  template <class T>
+  concept async_read_stream = requires(T &stream, std::span<std::byte> buffer) {
+    { stream.read_some(buffer) } -> aio::awaitable;
+    requires std::same_as<std::remove_cvref_t<aio::await_result_t<decltype(stream.read_some(buffer))>>,
+                          aio::result<std::size_t, std::error_code>>;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Concept of a byte stream that can be written asynchronously
+  ///
+  /// `write_some(buffer)` returns an awaitable producing `aio::result<std::size_t, std::error_code>`:
+  /// the number of bytes of a prefix of `buffer` that were written.
+  template <class T>
+  concept async_write_stream = requires(T &stream, std::span<const std::byte> buffer) {
+    { stream.write_some(buffer) } -> aio::awaitable;
+    requires std::same_as<std::remove_cvref_t<aio::await_result_t<decltype(stream.write_some(buffer))>>,
+                          aio::result<std::size_t, std::error_code>>;
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Concept of an async_write_stream that can also gather-write several buffers at once
+  ///
+  /// `write_some(buffers)` writes a prefix of the concatenation of `buffers` and produces the
+  /// number of bytes written, like writev(2).
+  template <class T>
+  concept async_vectored_write_stream = async_write_stream<T> && requires(T &stream, std::span<const iovec> buffers) {
+    { stream.write_some(buffers) } -> aio::awaitable;
+    requires std::same_as<std::remove_cvref_t<aio::await_result_t<decltype(stream.write_some(buffers))>>,
+                          aio::result<std::size_t, std::error_code>>;
+  };
+
+  namespace detail {
+    // Awaitable that either already holds its result or runs a lazily started task for it. The
+    // buffered streams answer from their buffer without creating a coroutine frame and only fall
+    // back to a task when they have to wait for the underlying stream.
+    template <class T>
+    class ready_or_task {
+     public:
+      explicit ready_or_task(T value) noexcept(std::is_nothrow_move_constructible_v<T>) : _value(AIO_MOV(value)) {}
+      explicit ready_or_task(task<T> slow) noexcept : _task(AIO_MOV(slow)) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return _value.has_value(); }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> std::coroutine_handle<> {
+        _awaiter.emplace(AIO_MOV(*_task).operator co_await());
+        return _awaiter->await_suspend(coro);
+      }
+
+      auto await_resume() -> T {
+        if (_value) return AIO_MOV(*_value);
+        return _awaiter->await_resume();
+      }
+
+     private:
+      std::optional<T> _value{};
+      std::optional<task<T>> _task{};
+      std::optional<typename task<T>::awaiter> _awaiter{};
+    };
+  }  // namespace detail
+
+  /// \ingroup io
+  ///
+  /// \brief Reads until `buffer` is full; fails with stream_errc::end_of_stream if the stream ends first
+  template <async_read_stream Stream>
+  auto read_exact(Stream &stream, std::span<std::byte> buffer) -> task<result<void, std::error_code>> {
+    while (!buffer.empty()) {
+      auto read = co_await stream.read_some(buffer);
+      if (!read) co_return failure<std::error_code>(read.error());
+      if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+      buffer = buffer.subspan(*read);
+    }
+    co_return result<void, std::error_code>();
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Writes all of `buffer`, continuing after partial writes
+  template <async_write_stream Stream>
+  auto write_all(Stream &stream, std::span<const std::byte> buffer) -> task<result<void, std::error_code>> {
+    while (!buffer.empty()) {
+      auto written = co_await stream.write_some(buffer);
+      if (!written) co_return failure<std::error_code>(written.error());
+      if (*written == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+      buffer = buffer.subspan(*written);
+    }
+    co_return result<void, std::error_code>();
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Writes all of `buffers` in order, at most `IOV_MAX` per call, continuing after partial writes
+  ///
+  /// The entries of `buffers` are advanced past the bytes written, so their contents are unspecified afterwards.
+  template <async_vectored_write_stream Stream>
+  auto write_all(Stream &stream, std::span<iovec> buffers) -> task<result<void, std::error_code>> {
+    auto skip_empty = [&] {
+      while (!buffers.empty() && buffers.front().iov_len == 0) buffers = buffers.subspan(1);
+    };
+    skip_empty();
+    while (!buffers.empty()) {
+      const auto batch = std::span<const iovec>(buffers.data(), std::min<std::size_t>(buffers.size(), IOV_MAX));
+      auto written = co_await stream.write_some(batch);
+      if (!written) co_return failure<std::error_code>(written.error());
+      if (*written == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+      for (auto left = *written; left != 0; skip_empty()) {
+        auto &front = buffers.front();
+        const auto step = std::min(left, front.iov_len);
+        front.iov_base = static_cast<std::byte *>(front.iov_base) + step;
+        front.iov_len -= step;
+        left -= step;
+      }
+    }
+    co_return result<void, std::error_code>();
+  }
+
+  /// \ingroup io
+  ///
+  /// \brief Read buffer layered over an async_read_stream
+  ///
+  /// Reads from the underlying stream in buffer-sized chunks and serves smaller reads from the
+  /// buffer. read_until() scans for its delimiter with SSE2/AVX2 (single bytes and short
+  /// sequences alike), resuming each scan where the previous one for the same delimiter stopped,
+  /// so every byte is examined once however the data arrives. Results that are already buffered are produced
+  /// without suspending or allocating a coroutine frame.
+  ///
+  /// Views returned by read_until() and read_exact() point into the buffer and are valid until
+  /// the next operation on the stream. The buffered stream is itself an async_read_stream, so
+  /// layers compose. The underlying stream must outlive it.
+  template <async_read_stream Stream>
+  class buffered_read_stream {
+   public:
+    using view_result = result<std::string_view, std::error_code>;
+    using size_result = result<std::size_t, std::error_code>;
+
+    explicit buffered_read_stream(Stream &next, std::size_t capacity = 64 * 1024)
+        : _next(&next), _capacity(std::max<std::size_t>(capacity, 1)), _buffer(std::make_unique<std::byte[]>(_capacity)) {}
+
+    [[nodiscard]] auto next_layer() noexcept -> Stream & { return *_next; }
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t { return _capacity; }
+
+    /// \brief Returns the bytes buffered but not consumed yet
+    [[nodiscard]] auto buffered() const noexcept -> std::span<const std::byte> { return {_buffer.get() + _begin, _end - _begin}; }
+
+    /// \brief Discards the first `count` buffered bytes
+    auto consume(std::size_t count) noexcept -> void {
+      _begin += std::min(count, _end - _begin);
+      _scanned = 0;
+    }
+
+    /// \brief Reads into `buffer` from the buffer, or from the stream if the buffer is empty
+    ///
+    /// Reads of at least the buffer's capacity bypass the buffer when it is empty.
+    [[nodiscard]] auto read_some(std::span<std::byte> buffer) -> detail::ready_or_task<size_result> {
+      if (_begin != _end || buffer.empty()) return detail::ready_or_task<size_result>(size_result(std::in_place, take(buffer)));
+      return detail::ready_or_task<size_result>(read_some_slow(buffer));
+    }
+
+    /// \brief Reads up to and including the first occurrence of `delimiter`
+    ///
+    /// Fails with stream_errc::delimiter_not_found if the buffer fills up first, and with
+    /// stream_errc::end_of_stream if the stream ends first; in both cases the data stays buffered.
+    /// `delimiter` must stay alive until the operation completes.
+    [[nodiscard]] auto read_until(std::string_view delimiter) -> detail::ready_or_task<view_result> {
+      if (auto found = scan(delimiter)) return detail::ready_or_task<view_result>(view_result(std::in_place, *found));
+      return detail::ready_or_task<view_result>(read_until_slow(delimiter));
+    }
+
+    /// \brief Reads exactly `count` bytes, at most the buffer's capacity, and returns a view of them
+    [[nodiscard]] auto read_exact(std::size_t count) -> detail::ready_or_task<view_result> {
+      if (_end - _begin >= count) return detail::ready_or_task<view_result>(view_result(std::in_place, take_view(count)));
+      return detail::ready_or_task<view_result>(read_exact_slow(count));
+    }
+
+    /// \brief Reads more data into the buffer; produces the number of bytes added, zero at the end of the stream
+    auto fill() -> task<size_result> {
+      if (_end == _capacity) compact();
+      if (_end == _capacity) co_return failure<std::error_code>(make_error_code(stream_errc::delimiter_not_found));
+      auto read = co_await _next->read_some(std::span(_buffer.get() + _end, _capacity - _end));
+      if (read) _end += *read;
+      co_return read;
+    }
+
+   private:
+    auto compact() noexcept -> void {
+      if (_begin == 0) return;
+      std::memmove(_buffer.get(), _buffer.get() + _begin, _end - _begin);
+      _end -= _begin;
+      _begin = 0;
+    }
+
+    auto take(std::span<std::byte> buffer) noexcept -> std::size_t {
+      const auto count = std::min(buffer.size(), _end - _begin);
+      std::memcpy(buffer.data(), _buffer.get() + _begin, count);
+      _begin += count;
+      _scanned = 0;
+      return count;
+    }
+
+    auto take_view(std::size_t count) noexcept -> std::string_view {
+      const std::string_view view(reinterpret_cast<const char *>(_buffer.get() + _begin), count);
+      _begin += count;
+      _scanned = 0;
+      return view;
+    }
+
+    // Searches the unscanned part of the buffer; remembers how far it got when nothing matched.
+    // The offset only holds for the delimiter it was computed with, so a new one starts over.
+    auto scan(std::string_view delimiter) -> std::optional<std::string_view> {
+      if (delimiter != _delimiter) {
+        _delimiter.assign(delimiter);
+        _scanned = 0;
+      }
+      const auto *data = _buffer.get() + _begin;
+      const auto available = _end - _begin;
+      const auto *needle = reinterpret_cast<const std::byte *>(delimiter.data());
+      const auto *found = detail::find_sequence(data + _scanned, data + available, needle, delimiter.size());
+      if (found != data + available) return take_view(static_cast<std::size_t>(found - data) + delimiter.size());
+      // A partial match may straddle the end of the data; rescan the last `size - 1` bytes next time.
+      _scanned = available >= delimiter.size() ? available - delimiter.size() + 1 : 0;
+      return std::nullopt;
+    }
+
+    auto read_some_slow(std::span<std::byte> buffer) -> task<size_result> {
+      if (buffer.size() >= _capacity) co_return co_await _next->read_some(buffer);
+      auto read = co_await fill();
+      if (!read) co_return read;
+      co_return take(buffer);
+    }
+
+    auto read_until_slow(std::string_view delimiter) -> task<view_result> {
+      while (true) {
+        auto read = co_await fill();
+        if (!read) co_return failure<std::error_code>(read.error());
+        if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+        if (auto found = scan(delimiter)) co_return *found;
+      }
+    }
+
+    auto read_exact_slow(std::size_t count) -> task<view_result> {
+      if (count > _capacity) co_return failure<std::error_code>(std::make_error_code(std::errc::value_too_large));
+      if (_begin + count > _capacity) compact();
+      while (_end - _begin < count) {
+        auto read = co_await fill();
+        if (!read) co_return failure<std::error_code>(read.error());
+        if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+      }
+      co_return take_view(count);
+    }
+
+    Stream *_next;
+    std::size_t _capacity;
+    std::unique_ptr<std::byte[]> _buffer;
+    std::size_t _begin = 0;
+    std::size_t _end = 0;
+    std::size_t _scanned = 0;
+    std::string _delimiter{};
+  };
+
+  /// \ingroup io
+  ///
+  /// \brief Write buffer layered over an async_write_stream
+  ///
+  /// Small writes are copied into the buffer and complete without suspending; the buffer goes to
+  /// the underlying stream when it fills up or on flush(). Writes larger than the buffer are
+  /// passed through after flushing. The buffered stream is itself an async_write_stream; the
+  /// underlying stream must outlive it.
+  template <async_write_stream Stream>
+  class buffered_write_stream {
+   public:
+    using void_result = result<void, std::error_code>;
+    using size_result = result<std::size_t, std::error_code>;
+
+    explicit buffered_write_stream(Stream &next, std::size_t capacity = 64 * 1024)
+        : _next(&next), _capacity(std::max<std::size_t>(capacity, 1)), _buffer(std::make_unique<std::byte[]>(_capacity)) {}
+
+    [[nodiscard]] auto next_layer() noexcept -> Stream & { return *_next; }
+
+    /// \brief Returns the bytes written but not yet flushed
+    [[nodiscard]] auto buffered() const noexcept -> std::span<const std::byte> { return {_buffer.get(), _size}; }
+
+    /// \brief Buffers all of `bytes`, flushing as needed; `bytes` must stay alive until the operation completes
+    [[nodiscard]] auto write_all(std::span<const std::byte> bytes) -> detail::ready_or_task<void_result> {
+      if (bytes.size() <= _capacity - _size) {
+        append(bytes);
+        return detail::ready_or_task<void_result>(void_result());
+      }
+      return detail::ready_or_task<void_result>(write_all_slow(bytes));
+    }
+
+    [[nodiscard]] auto write_all(std::string_view text) -> detail::ready_or_task<void_result> {
+      return write_all(std::as_bytes(std::span(text.data(), text.size())));
+    }
+
+    /// \brief Buffers `bytes` as one write; satisfies async_write_stream
+    [[nodiscard]] auto write_some(std::span<const std::byte> bytes) -> detail::ready_or_task<size_result> {
+      if (bytes.size() <= _capacity - _size) {
+        append(bytes);
+        return detail::ready_or_task<size_result>(size_result(std::in_place, bytes.size()));
+      }
+      return detail::ready_or_task<size_result>(write_some_slow(bytes));
+    }
+
+    /// \brief Writes the buffered bytes to the underlying stream
+    ///
+    /// On failure the bytes that were not written stay buffered, so the flush can be retried.
+    auto flush() -> task<void_result> {
+      std::size_t flushed = 0;
+      while (flushed != _size) {
+        auto written = co_await _next->write_some(std::span<const std::byte>(_buffer.get() + flushed, _size - flushed));
+        if (!written || *written == 0) {
+          discard(flushed);
+          if (!written) co_return failure<std::error_code>(written.error());
+          co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+        }
+        flushed += *written;
+      }
+      _size = 0;
+      co_return void_result();
+    }
+
+   private:
+    auto append(std::span<const std::byte> bytes) noexcept -> void {
+      std::memcpy(_buffer.get() + _size, bytes.data(), bytes.size());
+      _size += bytes.size();
+    }
+
+    // Drops the first `count` buffered bytes, keeping the rest at the front of the buffer.
+    auto discard(std::size_t count) noexcept -> void {
+      std::memmove(_buffer.get(), _buffer.get() + count, _size - count);
+      _size -= count;
+    }
+
+    auto write_all_slow(std::span<const std::byte> bytes) -> task<void_result> {
+      if (auto flushed = co_await flush(); !flushed) co_return flushed;
+      if (bytes.size() >= _capacity) co_return co_await aio::write_all(*_next, bytes);
+      append(bytes);
+      co_return void_result();
+    }
+
+    auto write_some_slow(std::span<const std::byte> bytes) -> task<size_result> {
+      if (auto written = co_await write_all_slow(bytes); !written) co_return failure<std::error_code>(written.error());
+      co_return bytes.size();
+    }
+
+    Stream *_next;
+    std::size_t _capacity;
+    std::unique_ptr<std::byte[]> _buffer;
+    std::size_t _size = 0;
+  };
+}  // namespace aio
+
+#endif  // AIO_STREAM_HPP
@@ -0,0 +1,304 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_TASK_HPP
+#define AIO_TASK_HPP
+
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "coroutine.hpp"
+#include "detail/frame_allocator.hpp"
+#include "detail/macros.hpp"
+#include "detail/schedule_node.hpp"
+#include "lane.hpp"
+#include "numa.hpp"
+
+namespace aio {
+  template <class T = void>
+  class task;
+
+  namespace detail {
+    /// Promise state shared by every task, independent of its result type.
+    ///
+    /// The promise is itself the task's ready-queue node: the lane and deadline it carries are the ones
+    /// used whenever the task is queued on a scheduler, and they are inherited by child tasks that do not
+    /// set their own.
+    class task_promise_base : public schedule_node {
+     public:
+      struct final_awaiter {
+        [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+        template <class Promise>
+        auto await_suspend(std::coroutine_handle<Promise> coro) const noexcept -> std::coroutine_handle<> {
+          auto &promise = coro.promise();
+          if (promise._detached) {
+            if (promise._exception) std::terminate();
+            coro.destroy();
+            return std::noop_coroutine();
+          }
+          return promise._continuation ? promise._continuation : std::noop_coroutine();
+        }
+
+        constexpr auto await_resume() const noexcept -> void {}
+      };
+
+      task_promise_base() noexcept = default;
+
+      [[nodiscard]] static auto operator new(std::size_t size) -> void * { return frame_allocator::allocate(size); }
+      static auto operator delete(void *frame, std::size_t size) noexcept -> void { frame_allocator::deallocate(frame, size); }
+
+      [[nodiscard]] constexpr auto initial_suspend() const noexcept -> std::suspend_always { return {}; }
+      [[nodiscard]] constexpr auto final_suspend() const noexcept -> final_awaiter { return {}; }
+
+      auto unhandled_exception() noexcept -> void { _exception = std::current_exception(); }
+
+      [[nodiscard]] auto lane() const noexcept -> aio::lane { return this->schedule_node::lane; }
+      [[nodiscard]] auto deadline() const noexcept -> clock::time_point { return this->schedule_node::deadline; }
+
+      auto set_lane(aio::lane l) noexcept -> void {
+        this->schedule_node::lane = l;
+        _explicit_lane = true;
+      }
+
+      auto set_deadline(clock::time_point d) noexcept -> void { this->schedule_node::deadline = d; }
+
+      [[nodiscard]] auto node_hint() const noexcept -> numa_node_id { return _node_hint; }
+      auto set_node_hint(numa_node_id node) noexcept -> void { _node_hint = node; }
+
+      auto set_continuation(std::coroutine_handle<> continuation) noexcept -> void { _continuation = continuation; }
+      [[nodiscard]] auto continuation() const noexcept -> std::coroutine_handle<> { return _continuation; }
+      auto set_detached() noexcept -> void { _detached = true; }
+
+      // Called when this task is awaited from another task: adopt the parent's scheduling attributes
+      // unless they were set explicitly on this task.
+      auto inherit_from(const task_promise_base &parent) noexcept -> void {
+        if (!_explicit_lane) this->schedule_node::lane = parent.lane();
+        if (this->schedule_node::deadline == no_deadline) this->schedule_node::deadline = parent.deadline();
+      }
+
+     protected:
+      auto rethrow_if_exception() -> void {
+        if (_exception) std::rethrow_exception(_exception);
+      }
+
+     private:
+      std::coroutine_handle<> _continuation{};
+      std::exception_ptr _exception{};
+      numa_node_id _node_hint = any_node;
+      bool _explicit_lane = false;
+      bool _detached = false;
+    };
+
+    template <class T>
+    class task_promise final : public task_promise_base {
+     public:
+      auto get_return_object() noexcept -> task<T>;
+
+      template <class U = T>
+        requires std::constructible_from<T, U>
+      auto return_value(U &&value) noexcept(std::is_nothrow_constructible_v<T, U>) -> void {
+        _value.emplace(AIO_FWD(value));
+      }
+
+      auto result() & -> T & {
+        rethrow_if_exception();
+        return *_value;
+      }
+
+      auto result() && -> T && {
+        rethrow_if_exception();
+        return AIO_MOV(*_value);
+      }
+
+     private:
+      std::optional<T> _value{};
+    };
+
+    template <>
+    class task_promise<void> final : public task_promise_base {
+     public:
+      auto get_return_object() noexcept -> task<void>;
+
+      constexpr auto return_void() const noexcept -> void {}
+
+      auto result() -> void { rethrow_if_exception(); }
+    };
+
+    // Awaitable giving a running task access to its own promise, e.g. to hand its lane and deadline
+    // on to the tasks it spawns. Completes without suspending.
+    class this_promise {
+     public:
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      template <class Promise>
+        requires std::derived_from<Promise, task_promise_base>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> bool {
+        _promise = &coro.promise();
+        return false;
+      }
+
+      [[nodiscard]] auto await_resume() const noexcept -> task_promise_base & { return *_promise; }
+
+     private:
+      task_promise_base *_promise = nullptr;
+    };
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Lazily started coroutine producing a value of type T
+  ///
+  /// A task does not run until it is either awaited from another coroutine or handed to a
+  /// scheduler (see scheduler::spawn). Awaiting a task transfers control to it symmetrically
+  /// and resumes the awaiting coroutine once the task completes, rethrowing any exception
+  /// that escaped the task body.
+  ///
+  /// Every task carries the lane and deadline it is scheduled with in its promise. They can
+  /// be set before the task starts with with_lane() and with_deadline(); otherwise a task
+  /// awaited from another task inherits the attributes of its parent.
+  ///
+  /// Task frames are allocated from a recycling, NUMA-local frame allocator.
+  ///
+  /// \tparam T The result type of the task, `void` by default
+  template <class T>
+  class [[nodiscard]] task {
+   public:
+    using promise_type = detail::task_promise<T>;
+    using value_type = T;
+
+    constexpr task() noexcept = default;
+    constexpr explicit task(std::coroutine_handle<promise_type> coro) noexcept : _handle(coro) {}
+
+    task(const task &) = delete;
+    constexpr task(task &&other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+    auto operator=(const task &) -> task & = delete;
+    auto operator=(task &&other) noexcept -> task & {
+      if (this != &other) {
+        if (_handle) _handle.destroy();
+        _handle = std::exchange(other._handle, nullptr);
+      }
+      return *this;
+    }
+
+    ~task() {
+      if (_handle) _handle.destroy();
+    }
+
+    [[nodiscard]] constexpr explicit operator bool() const noexcept { return static_cast<bool>(_handle); }
+    [[nodiscard]] auto done() const noexcept -> bool { return !_handle || _handle.done(); }
+
+    /// \brief Sets the lane the task is queued on when scheduled
+    auto with_lane(aio::lane l) && noexcept -> task && {
+      _handle.promise().set_lane(l);
+      return AIO_MOV(*this);
+    }
+
+    /// \brief Sets the absolute deadline used to order the task within its lane
+    auto with_deadline(clock::time_point deadline) && noexcept -> task && {
+      _handle.promise().set_deadline(deadline);
+      return AIO_MOV(*this);
+    }
+
+    /// \brief Sets the deadline relative to now
+    auto with_timeout(clock::duration timeout) && noexcept -> task && {
+      _handle.promise().set_deadline(clock::now() + timeout);
+      return AIO_MOV(*this);
+    }
+
+    /// \brief Sets the NUMA node a thread pool should run the task on when it is spawned
+    ///
+    /// The hint is a preference: idle workers of other nodes may still steal the task.
+    auto with_node(numa_node_id node) && noexcept -> task && {
+      _handle.promise().set_node_hint(node);
+      return AIO_MOV(*this);
+    }
+
+    /// \brief Releases ownership of the coroutine frame
+    [[nodiscard]] constexpr auto release() noexcept -> std::coroutine_handle<promise_type> {
+      return std::exchange(_handle, nullptr);
+    }
+
+    [[nodiscard]] constexpr auto handle() const noexcept -> std::coroutine_handle<promise_type> { return _handle; }
+
+    class awaiter {
+     public:
+      constexpr explicit awaiter(std::coroutine_handle<promise_type> coro) noexcept : _coro(coro) {}
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool {
+        assert(_coro && "awaiting an empty task");
+        return _coro.done();
+      }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> continuation) noexcept -> std::coroutine_handle<> {
+        if constexpr (std::derived_from<Promise, detail::task_promise_base>) {
+          _coro.promise().inherit_from(continuation.promise());
+        }
+        _coro.promise().set_continuation(continuation);
+        return _coro;
+      }
+
+      // The result is moved out by value: the frame holding it is destroyed with the task, which
+      // may be a temporary that ends with the co_await expression.
+      auto await_resume() -> T {
+        if constexpr (std::is_void_v<T>) {
+          _coro.promise().result();
+        } else {
+          return AIO_MOV(_coro.promise()).result();
+        }
+      }
+
+     private:
+      std::coroutine_handle<promise_type> _coro;
+    };
+
+    auto operator co_await() && noexcept -> awaiter { return awaiter{_handle}; }
+
+   private:
+    std::coroutine_handle<promise_type> _handle{};
+  };
+
+  template <class T>
+  auto detail::task_promise<T>::get_return_object() noexcept -> task<T> {
+    return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+  }
+
+  inline auto detail::task_promise<void>::get_return_object() noexcept -> task<void> {
+    return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+  }
+}  // namespace aio
+
+#endif  // AIO_TASK_HPP
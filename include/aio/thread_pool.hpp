@@ -0,0 +1,390 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_THREAD_POOL_HPP
+#define AIO_THREAD_POOL_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "detail/macros.hpp"
+#include "detail/parallel.hpp"
+#include "detail/schedule_node.hpp"
+#include "detail/work_stealing_deque.hpp"
+#include "numa.hpp"
+#include "task.hpp"
+
+namespace aio {
+  class thread_pool;
+
+  namespace detail {
+    struct pool_worker_identity {
+      thread_pool *pool = nullptr;
+      std::size_t index = 0;
+    };
+
+    inline thread_local pool_worker_identity current_pool_worker{};
+  }  // namespace detail
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Construction options of a thread_pool
+  struct thread_pool_options {
+    /// Number of worker threads; zero starts one worker per CPU the process may run on.
+    std::size_t threads = 0;
+
+    /// Restrict each worker to the CPUs of its NUMA node.
+    bool pin_threads = true;
+
+    /// Capacity of each worker's local deque; overflow goes to the node's shared queue.
+    std::size_t local_queue_capacity = 1024;
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief NUMA-aware work-stealing thread pool
+  ///
+  /// Workers are organized in one group per NUMA node of the given topology and are bound to
+  /// their node's CPUs, so coroutine frames and pooled buffers allocated on them come from
+  /// node-local memory. Each worker owns a Chase-Lev deque; work submitted from outside the
+  /// pool goes to the shared queue of the target node's group.
+  ///
+  /// An idle worker looks for work in this order: its own deque, its node's shared queue, the
+  /// deques of workers on the same node, and only then the shared queues and deques of other
+  /// nodes, so work stays on the node it was placed on unless that node is saturated.
+  ///
+  /// Placement is controlled with node hints: schedule(node) and task::with_node(). Without a
+  /// hint, work goes to the caller's node. The pool does not interpret lanes or deadlines.
+  ///
+  /// CPU-bound work can be offloaded from any coroutine with run(), parallel_for() and
+  /// parallel_reduce(); the awaiting coroutine is resumed on the scheduler it awaited from.
+  ///
+  /// Destroying the pool drains it: every worker keeps running work until no queue it can reach
+  /// holds any, including work queued while draining, and only then exits. Work that suspends
+  /// without being rescheduled onto the pool is not waited for.
+  class thread_pool {
+   public:
+    explicit thread_pool(thread_pool_options options = {}, const numa_topology &topology = numa_topology::system())
+        : _options(options) {
+      for (const auto &node : topology.nodes()) _groups.push_back(std::make_unique<group>(node));
+      if (_groups.empty()) _groups.push_back(std::make_unique<group>(numa_node{0, {0}}));
+
+      std::size_t total_cpus = 0;
+      for (const auto &g : _groups) total_cpus += g->node.cpus.size();
+      const auto threads = options.threads == 0 ? total_cpus : options.threads;
+
+      // Deal workers out proportionally to the CPUs of each node.
+      for (std::size_t i = 0; i < threads; ++i) {
+        std::size_t cpu_slot = (i * total_cpus) / threads;
+        std::size_t g = 0;
+        while (g + 1 < _groups.size() && cpu_slot >= _groups[g]->node.cpus.size()) {
+          cpu_slot -= _groups[g]->node.cpus.size();
+          ++g;
+        }
+        _groups[g]->workers.push_back(_workers.size());
+        _workers.push_back(std::make_unique<worker>(g, options.local_queue_capacity, i));
+      }
+      for (std::size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i]->thread = std::thread([this, i] { worker_main(i); });
+      }
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    auto operator=(const thread_pool &) -> thread_pool & = delete;
+
+    /// \brief Runs all queued work to completion, then stops and joins the workers
+    ~thread_pool() {
+      _stop.store(true, std::memory_order_seq_cst);
+      for (auto &w : _workers) {
+        w->epoch.fetch_add(1, std::memory_order_release);
+        w->epoch.notify_one();
+      }
+      for (auto &w : _workers) {
+        if (w->thread.joinable()) w->thread.join();
+      }
+    }
+
+    /// \brief Returns the pool whose worker is the calling thread, or `nullptr`
+    [[nodiscard]] static auto current() noexcept -> thread_pool * { return detail::current_pool_worker.pool; }
+
+    [[nodiscard]] auto running_in_this_thread() const noexcept -> bool { return detail::current_pool_worker.pool == this; }
+
+    [[nodiscard]] auto thread_count() const noexcept -> std::size_t { return _workers.size(); }
+    [[nodiscard]] auto node_count() const noexcept -> std::size_t { return _groups.size(); }
+
+    class schedule_awaiter {
+     public:
+      schedule_awaiter(thread_pool &pool, numa_node_id node) noexcept : _pool(&pool), _hint(node) {}
+
+      [[nodiscard]] constexpr auto await_ready() const noexcept -> bool { return false; }
+
+      auto await_suspend(std::coroutine_handle<> coro) noexcept -> void {
+        _node.handle = coro;
+        _pool->enqueue(&_node, _hint);
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+
+     private:
+      detail::schedule_node _node{};
+      thread_pool *_pool;
+      numa_node_id _hint;
+    };
+
+    /// \brief Returns an awaitable that resumes the awaiting coroutine on a worker of this pool
+    ///
+    /// \param node Preferred NUMA node, or any_node for the caller's node
+    [[nodiscard]] auto schedule(numa_node_id node = any_node) noexcept -> schedule_awaiter { return {*this, node}; }
+
+    /// \brief Starts a task on the pool without waiting for it, honouring its node hint
+    template <class T>
+    auto spawn(task<T> &&t) noexcept -> void {
+      auto coro = t.release();
+      if (!coro) return;
+      auto &promise = coro.promise();
+      promise.set_detached();
+      auto &node = static_cast<detail::schedule_node &>(promise);
+      node.handle = coro;
+      enqueue(&node, promise.node_hint());
+    }
+
+    /// \brief Runs `fn()` on a worker and resumes the caller with its result
+    ///
+    /// The awaiting coroutine is resumed on the scheduler (or pool) it was running on when it
+    /// awaited, on the lane and deadline of the awaiting task. Exceptions thrown by `fn` are
+    /// returned as the error of the result.
+    ///
+    /// \return An awaitable producing `aio::result<R, std::exception_ptr>` where `R` is the
+    /// return type of `fn`
+    template <class F>
+      requires std::invocable<std::decay_t<F> &>
+    [[nodiscard]] auto run(F &&fn) -> detail::run_awaitable<thread_pool, std::decay_t<F>> {
+      return {*this, AIO_FWD(fn)};
+    }
+
+    /// \brief Calls `body(i)` for every `i` in `[first, last)` across the workers
+    ///
+    /// The range is chunked adaptively by lazy binary splitting: a worker only splits off half of
+    /// its remaining range when its local queue is empty, so the number of tasks tracks the
+    /// number of idle workers rather than the range size. The first exception thrown by `body`
+    /// stops further chunks from starting and is returned as the error.
+    ///
+    /// \return An awaitable producing `aio::result<void, std::exception_ptr>`
+    template <std::integral Index, class Body>
+      requires std::invocable<std::decay_t<Body> &, Index>
+    [[nodiscard]] auto parallel_for(Index first, Index last, Body &&body, parallel_options options = {})
+        -> detail::parallel_for_awaitable<thread_pool, Index, std::decay_t<Body>> {
+      return {*this, first, last, AIO_FWD(body), options};
+    }
+
+    /// \brief Folds `map(i)` for every `i` in `[first, last)` with `reduce` across the workers
+    ///
+    /// Chunking follows parallel_for(). Partial results are combined in completion order, so
+    /// `reduce` must be associative and commutative, and `identity` must be its neutral element.
+    ///
+    /// \return An awaitable producing `aio::result<T, std::exception_ptr>`
+    template <std::integral Index, class T, class Map, class Reduce>
+      requires std::invocable<std::decay_t<Map> &, Index> &&
+               std::invocable<std::decay_t<Reduce> &, T, std::invoke_result_t<std::decay_t<Map> &, Index>>
+    [[nodiscard]] auto parallel_reduce(Index first, Index last, T identity, Map &&map, Reduce &&reduce,
+                                       parallel_options options = {})
+        -> detail::parallel_reduce_awaitable<thread_pool, Index, T, std::decay_t<Map>, std::decay_t<Reduce>> {
+      return {*this, first, last, AIO_MOV(identity), AIO_FWD(map), AIO_FWD(reduce), options};
+    }
+
+    /// \brief Returns the number of nodes queued on the calling worker's deque, or zero off the pool
+    [[nodiscard]] auto local_backlog() const noexcept -> std::size_t {
+      if (!running_in_this_thread()) return 0;
+      return _workers[detail::current_pool_worker.index]->deque.size();
+    }
+
+    /// \brief Queues a ready-queue node on the given node's workers; thread-safe
+    auto enqueue(detail::schedule_node *node, numa_node_id hint = any_node) noexcept -> void {
+      if (running_in_this_thread()) {
+        auto &self = *_workers[detail::current_pool_worker.index];
+        if ((hint == any_node || _groups[self.group]->node.id == hint) && self.deque.push(node)) {
+          wake(self.group);
+          return;
+        }
+      }
+      const auto g = group_for(hint);
+      _groups[g]->inject.push(node);
+      wake(g);
+    }
+
+   private:
+    struct worker {
+      worker(std::size_t g, std::size_t capacity, std::size_t index)
+          : deque(capacity), group(g), rng(static_cast<std::uint32_t>(index * 2654435761u + 1)) {}
+
+      detail::work_stealing_deque deque;
+      std::size_t group;
+      std::uint32_t rng;
+      std::thread thread{};
+      alignas(64) std::atomic<bool> sleeping{false};
+      std::atomic<std::uint32_t> epoch{0};
+    };
+
+    struct group {
+      explicit group(numa_node n) : node(std::move(n)) {}
+
+      numa_node node;
+      std::vector<std::size_t> workers{};
+      detail::atomic_node_stack inject{};
+    };
+
+    [[nodiscard]] auto group_for(numa_node_id hint) const noexcept -> std::size_t {
+      if (hint == any_node) {
+        if (running_in_this_thread()) return _workers[detail::current_pool_worker.index]->group;
+        hint = this_thread_node();
+      }
+      for (std::size_t g = 0; g < _groups.size(); ++g) {
+        if (_groups[g]->node.id == hint && !_groups[g]->workers.empty()) return g;
+      }
+      for (std::size_t g = 0; g < _groups.size(); ++g) {
+        if (!_groups[g]->workers.empty()) return g;
+      }
+      return 0;
+    }
+
+    auto worker_main(std::size_t index) -> void {
+      auto &self = *_workers[index];
+      const auto &home = _groups[self.group]->node;
+      if (_options.pin_threads) {
+        bind_this_thread(home);
+      } else {
+        detail::thread_home_node = home.id;
+      }
+      detail::current_pool_worker = {this, index};
+
+      while (true) {
+        if (auto *node = find_work(self)) {
+          node->handle.resume();
+          continue;
+        }
+        if (_stop.load(std::memory_order_acquire)) break;
+        park(self);
+      }
+      detail::current_pool_worker = {};
+    }
+
+    auto find_work(worker &self) noexcept -> detail::schedule_node * {
+      if (auto *node = self.deque.pop()) return node;
+      if (auto *node = take_injected(self, self.group)) return node;
+      if (auto *node = steal_within(self, self.group)) return node;
+      for (std::size_t i = 1; i < _groups.size(); ++i) {
+        const auto g = (self.group + i) % _groups.size();
+        if (auto *node = take_injected(self, g)) return node;
+        if (auto *node = steal_within(self, g)) return node;
+      }
+      return nullptr;
+    }
+
+    // Takes the shared queue of a group: runs the first node and moves the rest to the local deque.
+    auto take_injected(worker &self, std::size_t g) noexcept -> detail::schedule_node * {
+      auto &inject = _groups[g]->inject;
+      if (inject.empty()) return nullptr;
+      auto nodes = inject.take_all();
+      auto *first = nodes.pop_front();
+      while (auto *node = nodes.pop_front()) {
+        if (!self.deque.push(node)) inject.push(node);
+      }
+      return first;
+    }
+
+    auto steal_within(worker &self, std::size_t g) noexcept -> detail::schedule_node * {
+      const auto &members = _groups[g]->workers;
+      if (members.empty()) return nullptr;
+      self.rng ^= self.rng << 13;
+      self.rng ^= self.rng >> 17;
+      self.rng ^= self.rng << 5;
+      const auto start = self.rng % members.size();
+      for (std::size_t i = 0; i < members.size(); ++i) {
+        auto &victim = *_workers[members[(start + i) % members.size()]];
+        if (&victim == &self) continue;
+        if (auto *node = victim.deque.steal()) return node;
+      }
+      return nullptr;
+    }
+
+    [[nodiscard]] auto has_visible_work() const noexcept -> bool {
+      for (const auto &g : _groups) {
+        if (!g->inject.empty()) return true;
+      }
+      for (const auto &w : _workers) {
+        if (!w->deque.empty()) return true;
+      }
+      return false;
+    }
+
+    auto park(worker &self) noexcept -> void {
+      const auto epoch = self.epoch.load(std::memory_order_acquire);
+      self.sleeping.store(true, std::memory_order_seq_cst);
+      _sleepers.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!has_visible_work() && !_stop.load(std::memory_order_seq_cst)) {
+        self.epoch.wait(epoch, std::memory_order_acquire);
+      }
+      self.sleeping.store(false, std::memory_order_relaxed);
+      _sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Wakes one sleeping worker, preferring the given group.
+    auto wake(std::size_t g) noexcept -> void {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_sleepers.load(std::memory_order_seq_cst) == 0) return;
+      const auto try_wake = [](worker &w) {
+        if (!w.sleeping.exchange(false, std::memory_order_acq_rel)) return false;
+        w.epoch.fetch_add(1, std::memory_order_release);
+        w.epoch.notify_one();
+        return true;
+      };
+      for (auto index : _groups[g]->workers) {
+        if (try_wake(*_workers[index])) return;
+      }
+      for (auto &w : _workers) {
+        if (try_wake(*w)) return;
+      }
+    }
+
+    thread_pool_options _options;
+    std::vector<std::unique_ptr<group>> _groups{};
+    std::vector<std::unique_ptr<worker>> _workers{};
+    std::atomic<bool> _stop{false};
+    std::atomic<std::size_t> _sleepers{0};
+  };
+}  // namespace aio
+
+#endif  // AIO_THREAD_POOL_HPP
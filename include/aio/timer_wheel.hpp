@@ -0,0 +1,264 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_TIMER_WHEEL_HPP
+#define AIO_TIMER_WHEEL_HPP
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "lane.hpp"
+
+namespace aio {
+  /// \ingroup scheduling
+  ///
+  /// \brief Intrusive timer entry for a timer_wheel
+  ///
+  /// The owner embeds the node (typically in an awaiter living in a coroutine frame) and sets
+  /// `fire`, which the wheel calls once the expiry has passed. A node must stay alive until it
+  /// has fired or has been cancelled.
+  struct timer_node {
+    using callback_type = void (*)(timer_node *) noexcept;
+
+    timer_node *prev = nullptr;
+    timer_node *next = nullptr;
+    std::uint64_t expiry = 0;
+    callback_type fire = nullptr;
+    std::uint16_t slot = 0;
+
+    [[nodiscard]] auto armed() const noexcept -> bool { return prev != nullptr; }
+  };
+
+  /// \ingroup scheduling
+  ///
+  /// \brief Hierarchical hashed timer wheel
+  ///
+  /// Time is divided into ticks of a fixed resolution. Timers are kept in six levels of 64
+  /// slots, each level covering 64 times the span of the one below; a timer lives on the
+  /// lowest level whose slot distinguishes its expiry from the current tick and cascades down
+  /// as time advances. Arming and cancelling are O(1); advancing costs O(1) per 64 ticks of
+  /// empty time plus the work of firing and cascading timers. Timers fire at the first
+  /// advance() at or after their expiry, rounded up to the resolution, in no particular order
+  /// within a tick.
+  ///
+  /// A timer_wheel is not thread-safe; each scheduler owns one, driven by its run loop.
+  class timer_wheel {
+   public:
+    static constexpr unsigned slot_bits = 6;
+    static constexpr std::size_t slots_per_level = std::size_t{1} << slot_bits;
+    static constexpr std::size_t level_count = 6;
+
+    explicit timer_wheel(clock::duration resolution = std::chrono::milliseconds(1), clock::time_point start = clock::now()) noexcept
+        : _resolution(resolution.count() > 0 ? resolution.count() : 1), _current(to_tick(start)) {
+      for (auto &level : _slots) {
+        for (auto &slot : level) slot.prev = slot.next = &slot;
+      }
+    }
+
+    timer_wheel(const timer_wheel &) = delete;
+    auto operator=(const timer_wheel &) -> timer_wheel & = delete;
+
+    /// Timers still armed are disarmed without firing, so their owners can tell from armed()
+    /// that the wheel no longer references them.
+    ~timer_wheel() {
+      for (auto &level : _slots) {
+        for (auto &head : level) {
+          for (auto *node = head.next; node != &head;) {
+            auto *next = node->next;
+            node->prev = node->next = nullptr;
+            node = next;
+          }
+        }
+      }
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return _count == 0; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return _count; }
+    [[nodiscard]] auto resolution() const noexcept -> clock::duration { return clock::duration(_resolution); }
+
+    /// \brief Arms `node` to fire at `expiry`; the node must not be armed already
+    auto schedule(timer_node *node, clock::time_point expiry) noexcept -> void {
+      auto tick = to_tick_ceil(expiry);
+      if (tick <= _current) tick = _current + 1;
+      node->expiry = tick;
+      insert(node);
+      ++_count;
+    }
+
+    /// \brief Disarms `node` if it is armed
+    auto cancel(timer_node *node) noexcept -> void {
+      if (!node->armed()) return;
+      unlink(node);
+      --_count;
+    }
+
+    /// \brief Fires every timer whose expiry is at or before `now`
+    ///
+    /// \return The number of timers fired
+    auto advance(clock::time_point now) noexcept -> std::size_t {
+      const auto target = to_tick(now);
+      std::size_t fired = 0;
+      while (_current < target) {
+        if (_count == 0) {
+          _current = target;
+          break;
+        }
+        // Skip to the end of the level-0 block if nothing is left in it.
+        const auto offset = static_cast<unsigned>(_current & (slots_per_level - 1));
+        const auto ahead = offset + 1 < slots_per_level ? _occupied[0] >> (offset + 1) : 0;
+        if (ahead == 0) {
+          const auto block_end = _current | (slots_per_level - 1);
+          if (block_end >= target) {
+            _current = target;
+            break;
+          }
+          _current = block_end;
+        }
+
+        const auto next = _current + 1;
+        _current = next;
+        cascade(next);
+        fired += fire_slot(static_cast<unsigned>(next & (slots_per_level - 1)));
+      }
+      return fired;
+    }
+
+    /// \brief Returns a time at or before the next expiry, or nothing if no timer is armed
+    ///
+    /// Waking up at the returned time is always safe: either a timer fires, or timers cascade
+    /// closer and a later call returns a more precise time.
+    [[nodiscard]] auto next_expiry() const noexcept -> std::optional<clock::time_point> {
+      if (_count == 0) return std::nullopt;
+      for (std::size_t level = 0; level < level_count; ++level) {
+        if (_occupied[level] == 0) continue;
+        const auto shift = static_cast<unsigned>(level * slot_bits);
+        const auto current_slot = static_cast<unsigned>((_current >> shift) & (slots_per_level - 1));
+        // Slots strictly after the current one belong to this rotation of the level, the rest to the next.
+        const auto rotated = std::rotr(_occupied[level], static_cast<int>(current_slot + 1));
+        const auto distance = static_cast<std::uint64_t>(std::countr_zero(rotated)) + 1;
+        const auto block = ((_current >> shift) + distance) << shift;
+        return to_time_point(block);
+      }
+      return std::nullopt;
+    }
+
+   private:
+    [[nodiscard]] auto to_tick(clock::time_point tp) const noexcept -> std::uint64_t {
+      const auto count = tp.time_since_epoch().count();
+      return count <= 0 ? 0 : static_cast<std::uint64_t>(count) / static_cast<std::uint64_t>(_resolution);
+    }
+
+    [[nodiscard]] auto to_tick_ceil(clock::time_point tp) const noexcept -> std::uint64_t {
+      if (tp == clock::time_point::max()) return ~std::uint64_t{0} >> 1;
+      const auto count = tp.time_since_epoch().count();
+      return count <= 0 ? 0
+                        : (static_cast<std::uint64_t>(count) + static_cast<std::uint64_t>(_resolution) - 1) /
+                              static_cast<std::uint64_t>(_resolution);
+    }
+
+    [[nodiscard]] auto to_time_point(std::uint64_t tick) const noexcept -> clock::time_point {
+      return clock::time_point(clock::duration(static_cast<clock::rep>(tick * static_cast<std::uint64_t>(_resolution))));
+    }
+
+    auto insert(timer_node *node) noexcept -> void {
+      const auto diff = node->expiry ^ _current;
+      auto level = diff == 0 ? std::size_t{0} : static_cast<std::size_t>((std::bit_width(diff) - 1) / slot_bits);
+      auto expiry = node->expiry;
+      if (level >= level_count) {
+        // Beyond the horizon: park in the farthest slot and let it cascade again.
+        level = level_count - 1;
+        expiry = _current + (std::uint64_t{1} << (level_count * slot_bits)) - 1;
+      }
+      const auto index = static_cast<unsigned>((expiry >> (level * slot_bits)) & (slots_per_level - 1));
+      auto &head = _slots[level][index];
+      node->prev = &head;
+      node->next = head.next;
+      head.next->prev = node;
+      head.next = node;
+      node->slot = static_cast<std::uint16_t>(level * slots_per_level + index);
+      _occupied[level] |= std::uint64_t{1} << index;
+    }
+
+    auto unlink(timer_node *node) noexcept -> void {
+      node->prev->next = node->next;
+      node->next->prev = node->prev;
+      node->prev = node->next = nullptr;
+      const auto level = node->slot / slots_per_level;
+      const auto index = node->slot % slots_per_level;
+      auto &head = _slots[level][index];
+      if (head.next == &head) _occupied[level] &= ~(std::uint64_t{1} << index);
+    }
+
+    // Redistributes the higher-level slots that start at `tick`, highest level first.
+    auto cascade(std::uint64_t tick) noexcept -> void {
+      for (auto level = level_count - 1; level > 0; --level) {
+        const auto shift = static_cast<unsigned>(level * slot_bits);
+        if ((tick & ((std::uint64_t{1} << shift) - 1)) != 0) continue;
+        const auto index = static_cast<unsigned>((tick >> shift) & (slots_per_level - 1));
+        auto &head = _slots[level][index];
+        if (head.next == &head) continue;
+        auto *node = head.next;
+        head.prev->next = nullptr;
+        head.prev = head.next = &head;
+        _occupied[level] &= ~(std::uint64_t{1} << index);
+        while (node) {
+          auto *next = node->next;
+          insert(node);
+          node = next;
+        }
+      }
+    }
+
+    // Fires the slot one timer at a time, so callbacks may freely arm or cancel other timers.
+    auto fire_slot(unsigned index) noexcept -> std::size_t {
+      auto &head = _slots[0][index];
+      std::size_t fired = 0;
+      while (head.next != &head) {
+        auto *node = head.next;
+        unlink(node);
+        --_count;
+        ++fired;
+        node->fire(node);
+      }
+      return fired;
+    }
+
+    std::array<std::array<timer_node, slots_per_level>, level_count> _slots{};
+    std::array<std::uint64_t, level_count> _occupied{};
+    clock::rep _resolution;
+    std::uint64_t _current;
+    std::size_t _count = 0;
+  };
+}  // namespace aio
+
+#endif  // AIO_TIMER_WHEEL_HPP
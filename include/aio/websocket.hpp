@@ -0,0 +1,701 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+#ifndef AIO_WEBSOCKET_HPP
+#define AIO_WEBSOCKET_HPP
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "buffer_pool.hpp"
+#include "detail/macros.hpp"
+#include "detail/simd.hpp"
+#include "detail/waiter.hpp"
+#include "result.hpp"
+#include "scheduler.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief Errors reported by websocket_stream
+  enum class websocket_errc {
+    bad_frame = 1,     ///< Reserved bits set, unknown opcode or invalid length
+    bad_control_frame, ///< Fragmented control frame, or one with more than 125 bytes of payload
+    bad_masking,       ///< Unmasked frame from a client or masked frame from a server
+    bad_continuation,  ///< Continuation frame outside a message, or a new message inside one
+    message_too_large, ///< A message exceeds websocket_options::max_message_size
+    bad_close_frame,   ///< Close frame with a one-byte payload or an invalid status code
+    closed,            ///< The closing handshake took place; see websocket_stream::close_code()
+    timed_out          ///< The peer stayed silent through a keepalive ping
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Returns the error category of aio::websocket_errc
+  [[nodiscard]] inline auto websocket_category() noexcept -> const std::error_category & {
+    static const struct : std::error_category {
+      [[nodiscard]] auto name() const noexcept -> const char * override { return "aio.websocket"; }
+      [[nodiscard]] auto message(int value) const -> std::string override {
+        switch (static_cast<websocket_errc>(value)) {
+          case websocket_errc::bad_frame: return "malformed WebSocket frame";
+          case websocket_errc::bad_control_frame: return "malformed WebSocket control frame";
+          case websocket_errc::bad_masking: return "WebSocket frame masked incorrectly";
+          case websocket_errc::bad_continuation: return "unexpected WebSocket continuation";
+          case websocket_errc::message_too_large: return "WebSocket message too large";
+          case websocket_errc::bad_close_frame: return "malformed WebSocket close frame";
+          case websocket_errc::closed: return "WebSocket closed";
+          case websocket_errc::timed_out: return "WebSocket keepalive timed out";
+        }
+        return "unknown WebSocket error";
+      }
+    } category;
+    return category;
+  }
+
+  [[nodiscard]] inline auto make_error_code(websocket_errc error) noexcept -> std::error_code {
+    return {static_cast<int>(error), websocket_category()};
+  }
+}  // namespace aio
+
+template <>
+struct std::is_error_code_enum<aio::websocket_errc> : std::true_type {};
+
+namespace aio {
+  /// \ingroup protocols
+  ///
+  /// \brief Frame opcodes (RFC 6455, section 5.2)
+  enum class websocket_opcode : std::uint8_t {
+    continuation = 0x0,
+    text = 0x1,
+    binary = 0x2,
+    close = 0x8,
+    ping = 0x9,
+    pong = 0xa
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Returns whether `opcode` is that of a control frame
+  [[nodiscard]] constexpr auto is_control(websocket_opcode opcode) noexcept -> bool { return (static_cast<std::uint8_t>(opcode) & 0x8) != 0; }
+
+  /// \ingroup protocols
+  ///
+  /// \brief Close status codes (RFC 6455, section 7.4.1); applications may use 3000 to 4999
+  enum class websocket_close_code : std::uint16_t {
+    normal = 1000,
+    going_away = 1001,
+    protocol_error = 1002,
+    unsupported_data = 1003,
+    no_status = 1005, ///< Reported when a close frame carries no code; never sent
+    invalid_payload = 1007,
+    policy_violation = 1008,
+    message_too_large = 1009,
+    internal_error = 1011
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Which end of the connection a websocket_stream is; clients mask what they send
+  enum class websocket_role : std::uint8_t { server, client };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Header of a WebSocket frame
+  struct websocket_frame_header {
+    static constexpr std::size_t max_size = 14;
+
+    bool fin = true;
+    std::uint8_t reserved = 0; ///< The RSV1 to RSV3 bits, in place (mask 0x70)
+    websocket_opcode opcode = websocket_opcode::binary;
+    bool masked = false;
+    std::uint32_t key = 0; ///< The masking key, its bytes in wire order
+    std::uint64_t length = 0;
+
+    /// \brief Decodes the header at the start of `data`; produces its size, or 0 if `data` holds only part of it
+    [[nodiscard]] static auto decode(std::span<const std::byte> data, websocket_frame_header &header) noexcept -> std::size_t {
+      if (data.size() < 2) return 0;
+      const auto first = std::to_integer<std::uint8_t>(data[0]);
+      const auto second = std::to_integer<std::uint8_t>(data[1]);
+      const auto short_length = second & 0x7fu;
+      const std::size_t extended = short_length == 126 ? 2 : short_length == 127 ? 8 : 0;
+      const bool masked = (second & 0x80) != 0;
+      const auto size = 2 + extended + (masked ? 4 : 0);
+      if (data.size() < size) return 0;
+
+      std::uint64_t length = short_length;
+      if (extended != 0) {
+        length = 0;
+        for (std::size_t i = 0; i < extended; ++i) length = length << 8 | std::to_integer<std::uint8_t>(data[2 + i]);
+      }
+      header.fin = (first & 0x80) != 0;
+      header.reserved = static_cast<std::uint8_t>(first & 0x70);
+      header.opcode = static_cast<websocket_opcode>(first & 0x0f);
+      header.masked = masked;
+      header.key = 0;
+      if (masked) std::memcpy(&header.key, data.data() + 2 + extended, sizeof(header.key));
+      header.length = length;
+      return size;
+    }
+
+    /// \brief Encodes the header into `out`; produces its size
+    [[nodiscard]] auto encode(std::span<std::byte, max_size> out) const noexcept -> std::size_t {
+      out[0] = static_cast<std::byte>((fin ? 0x80 : 0) | reserved | static_cast<std::uint8_t>(opcode));
+      const std::uint8_t mask_bit = masked ? 0x80 : 0;
+      std::size_t size = 2;
+      if (length < 126) {
+        out[1] = static_cast<std::byte>(mask_bit | length);
+      } else if (length <= 0xffff) {
+        out[1] = static_cast<std::byte>(mask_bit | 126);
+        out[2] = static_cast<std::byte>(length >> 8);
+        out[3] = static_cast<std::byte>(length);
+        size = 4;
+      } else {
+        out[1] = static_cast<std::byte>(mask_bit | 127);
+        for (std::size_t i = 0; i < 8; ++i) out[2 + i] = static_cast<std::byte>(length >> (56 - 8 * i));
+        size = 10;
+      }
+      if (masked) {
+        std::memcpy(out.data() + size, &key, sizeof(key));
+        size += sizeof(key);
+      }
+      return size;
+    }
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief XORs `payload` with the masking `key`, starting `offset` bytes into the frame's payload
+  ///
+  /// Masking is its own inverse, so this both masks and unmasks. Runs with AVX2 or SSE2 on x86.
+  inline auto websocket_mask(std::span<std::byte> payload, std::uint32_t key, std::uint64_t offset = 0) noexcept -> void {
+    (void)detail::xor_mask(payload.data(), payload.size(), detail::rotate_mask(key, static_cast<std::size_t>(offset % 4)));
+  }
+
+  template <class Stream>
+    requires async_read_stream<Stream> && async_write_stream<Stream>
+  class websocket_stream;
+
+  /// \ingroup protocols
+  ///
+  /// \brief A received WebSocket message: its payload as a chain of buffers from a buffer_pool
+  ///
+  /// The fragments of a message are unmasked straight into the chain as they arrive, filling
+  /// each buffer before taking the next, so a message is never copied to be reassembled. Every
+  /// segment but the last is a whole buffer. The buffers return to their pool with the message.
+  class websocket_message {
+   public:
+    websocket_message() noexcept = default;
+
+    /// \brief Returns websocket_opcode::text or websocket_opcode::binary
+    [[nodiscard]] auto opcode() const noexcept -> websocket_opcode { return _opcode; }
+    [[nodiscard]] auto is_text() const noexcept -> bool { return _opcode == websocket_opcode::text; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return _size; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return _size == 0; }
+
+    [[nodiscard]] auto segment_count() const noexcept -> std::size_t { return _buffers.size(); }
+
+    [[nodiscard]] auto segment(std::size_t index) const noexcept -> std::span<const std::byte> {
+      const auto capacity = _buffers.front().size();
+      return {_buffers[index].data(), std::min(capacity, _size - index * capacity)};
+    }
+
+    /// \brief Returns a copy of the payload in one string
+    [[nodiscard]] auto to_string() const -> std::string {
+      std::string text;
+      text.reserve(_size);
+      for (std::size_t i = 0; i < _buffers.size(); ++i) {
+        const auto piece = segment(i);
+        text.append(reinterpret_cast<const char *>(piece.data()), piece.size());
+      }
+      return text;
+    }
+
+   private:
+    template <class Stream>
+      requires async_read_stream<Stream> && async_write_stream<Stream>
+    friend class websocket_stream;
+
+    // Returns the free part of the last buffer, taking a new one from `pool` if it is full.
+    auto room(buffer_pool &pool) -> std::span<std::byte> {
+      const auto capacity = pool.buffer_size();
+      const auto used = _size - (_buffers.empty() ? 0 : (_buffers.size() - 1) * capacity);
+      if (_buffers.empty() || used == capacity) {
+        _buffers.push_back(pool.acquire());
+        return _buffers.back().span();
+      }
+      return _buffers.back().span().subspan(used);
+    }
+
+    std::vector<pooled_buffer> _buffers{};
+    std::size_t _size = 0;
+    websocket_opcode _opcode = websocket_opcode::binary;
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief Options of websocket_stream
+  struct websocket_options {
+    websocket_role role = websocket_role::server;
+    std::size_t max_message_size = 16 * 1024 * 1024; ///< Largest message read() accepts
+  };
+
+  /// \ingroup protocols
+  ///
+  /// \brief WebSocket framing over an established connection (RFC 6455, after the handshake)
+  ///
+  /// read() produces whole messages: fragments are reassembled into a websocket_message, and
+  /// control frames are handled on the way: pings are answered, pongs noted, and a close frame is
+  /// echoed before read() fails with websocket_errc::closed. Protocol violations fail the
+  /// connection with a close frame carrying the matching status code. Extensions are not
+  /// supported, and text payloads are not validated as UTF-8.
+  ///
+  /// Between messages a connection holds no buffer at all, only a small staging area for the
+  /// next frame header: payload goes straight from the stream into buffers of the pool, taken
+  /// when a frame arrives. start_keepalive() arms a timer on the scheduler's wheel rather than
+  /// keeping a coroutine per connection; it pings a peer that has been silent for an interval and
+  /// shuts the stream down if the peer stays silent for another.
+  ///
+  /// Writes are serialized by a FIFO lock so that pongs, pings and close frames never land in the
+  /// middle of another frame. Server frames go out with gathered writes, header and payload
+  /// in place; clients mask into a pooled buffer instead, as their payload must not change.
+  /// The sender of a fragmented message must not interleave other data frames with it.
+  ///
+  /// Everything runs on the scheduler that uses the stream, which also owns `pool`. Wait for
+  /// pending writes to complete, e.g. by awaiting close(), before destroying the stream.
+  template <class Stream>
+    requires async_read_stream<Stream> && async_write_stream<Stream>
+  class websocket_stream {
+   public:
+    using message_result = result<websocket_message, std::error_code>;
+    using void_result = result<void, std::error_code>;
+
+    /// Size of the area that takes in frame headers; a frame this small arrives in one read.
+    static constexpr std::size_t staging_size = 32;
+
+    /// \brief Frames `next`, reading payloads into buffers of `pool`, which must be at least 128 bytes
+    websocket_stream(Stream &next, buffer_pool &pool, websocket_options options = {}) noexcept
+        : _next(&next), _pool(&pool), _max_message_size(options.max_message_size), _role(options.role) {
+      assert(pool.buffer_size() >= 128 && "websocket_stream needs pool buffers of at least 128 bytes");
+      _keepalive.fire = &on_keepalive;
+      _keepalive.owner = this;
+    }
+
+    websocket_stream(const websocket_stream &) = delete;
+    auto operator=(const websocket_stream &) -> websocket_stream & = delete;
+
+    ~websocket_stream() {
+      stop_keepalive();
+      assert(!_writing && "websocket_stream destroyed during a write");
+    }
+
+    [[nodiscard]] auto next_layer() noexcept -> Stream & { return *_next; }
+
+    /// \brief Returns the status code of the peer's close frame, websocket_close_code::no_status until one arrived
+    [[nodiscard]] auto close_code() const noexcept -> std::uint16_t { return _close_code; }
+
+    /// \brief Produces the next message
+    ///
+    /// Fails with websocket_errc::closed once the peer closed the connection, with the protocol
+    /// error of an invalid frame, with websocket_errc::timed_out after a keepalive timeout and
+    /// otherwise with the stream's error. Failures are final.
+    [[nodiscard]] auto read() -> task<message_result> {
+      if (_error) co_return failure<std::error_code>(_error);
+      websocket_message message;
+      bool in_message = false;
+      while (true) {
+        websocket_frame_header header;
+        auto got_header = co_await read_header(header);
+        if (!got_header) co_return fail(got_header.error());
+        _activity = true;
+        if (const auto invalid = check(header, in_message, message.size())) co_return co_await fail_protocol(invalid);
+
+        if (is_control(header.opcode)) {
+          websocket_message control;
+          auto got_control = co_await read_payload(header, control);
+          if (!got_control) co_return fail(got_control.error());
+          const auto payload = control.empty() ? std::span<const std::byte>() : control.segment(0);
+          if (header.opcode == websocket_opcode::close) co_return co_await closed_by_peer(payload);
+          if (header.opcode == websocket_opcode::ping && !_close_sent) {
+            co_await lock_writes();
+            auto sent = co_await send_frame(websocket_opcode::pong, true, std::span(&payload, 1));
+            unlock_writes();
+            if (!sent) co_return fail(sent.error());
+          }
+          continue;
+        }
+
+        if (!in_message) {
+          message._opcode = header.opcode;
+          in_message = true;
+        }
+        auto got_payload = co_await read_payload(header, message);
+        if (!got_payload) co_return fail(got_payload.error());
+        if (header.fin) co_return message;
+      }
+    }
+
+    /// \brief Sends one frame; `fin = false` starts or continues a fragmented message
+    ///
+    /// Fragments after the first are sent with websocket_opcode::continuation.
+    [[nodiscard]] auto write(websocket_opcode opcode, std::span<const std::byte> payload, bool fin = true) -> task<void_result> {
+      co_return co_await locked_send(opcode, fin, std::span(&payload, 1));
+    }
+
+    /// \brief Sends a text message
+    [[nodiscard]] auto write(std::string_view text) -> task<void_result> {
+      const auto payload = std::as_bytes(std::span(text.data(), text.size()));
+      co_return co_await locked_send(websocket_opcode::text, true, std::span(&payload, 1));
+    }
+
+    /// \brief Sends `message` as one frame, straight from its buffers, e.g. to relay it
+    [[nodiscard]] auto write(const websocket_message &message) -> task<void_result> {
+      std::vector<std::span<const std::byte>> pieces;
+      pieces.reserve(message.segment_count());
+      for (std::size_t i = 0; i < message.segment_count(); ++i) pieces.push_back(message.segment(i));
+      co_return co_await locked_send(message.opcode(), true, pieces);
+    }
+
+    /// \brief Sends a ping with up to 125 bytes of `payload`
+    [[nodiscard]] auto ping(std::span<const std::byte> payload = {}) -> task<void_result> {
+      assert(payload.size() <= 125 && "control frame payloads are limited to 125 bytes");
+      co_return co_await locked_send(websocket_opcode::ping, true, std::span(&payload, 1));
+    }
+
+    /// \brief Starts the closing handshake with `code` and up to 123 bytes of `reason`
+    ///
+    /// Keep reading until read() fails with websocket_errc::closed, the peer's answer, before
+    /// closing the stream. Does nothing if a close frame was already sent.
+    [[nodiscard]] auto close(websocket_close_code code = websocket_close_code::normal, std::string_view reason = {}) -> task<void_result> {
+      co_await lock_writes();
+      auto sent = co_await send_close(static_cast<std::uint16_t>(code), reason);
+      unlock_writes();
+      co_return sent;
+    }
+
+    /// \brief Pings the peer after `interval` without a frame from it; gives up after another
+    ///
+    /// Must be called from the scheduler that runs the stream. A timeout shuts the stream down,
+    /// failing the read() in progress with websocket_errc::timed_out.
+    auto start_keepalive(clock::duration interval) -> void
+      requires requires(Stream &stream) { stream.shutdown(); }
+    {
+      stop_keepalive();
+      _loop = scheduler::current();
+      assert(_loop && "start_keepalive() must be called on a scheduler");
+      _interval = interval;
+      _activity = true;
+      _ping_outstanding = false;
+      _loop->add_timer(&_keepalive, _loop->now() + _interval);
+    }
+
+    auto stop_keepalive() noexcept -> void {
+      if (_keepalive.armed()) _loop->cancel_timer(&_keepalive);
+    }
+
+   private:
+    struct keepalive_timer : timer_node {
+      websocket_stream *owner = nullptr;
+    };
+
+    class write_lock_awaiter {
+     public:
+      explicit write_lock_awaiter(websocket_stream &self) noexcept : _self(&self) {}
+
+      [[nodiscard]] auto await_ready() noexcept -> bool {
+        if (_self->_writing) return false;
+        _self->_writing = true;
+        return true;
+      }
+
+      template <class Promise>
+      auto await_suspend(std::coroutine_handle<Promise> coro) noexcept -> void {
+        _node.prepare(coro);
+        _self->_writers.push_back(&_node);
+      }
+
+      constexpr auto await_resume() const noexcept -> void {}
+
+     private:
+      websocket_stream *_self;
+      detail::waiter _node{};
+    };
+
+    // Hands the write lock to the next writer in line, or releases it.
+    auto lock_writes() noexcept -> write_lock_awaiter { return write_lock_awaiter(*this); }
+
+    auto unlock_writes() noexcept -> void {
+      if (auto *next = _writers.pop_front()) {
+        detail::node_queue handoff;
+        handoff.push_back(next);
+        detail::resume_waiters(handoff);
+      } else {
+        _writing = false;
+      }
+    }
+
+    static auto on_keepalive(timer_node *node) noexcept -> void {
+      auto &self = *static_cast<keepalive_timer *>(node)->owner;
+      if (self._activity) {
+        self._activity = false;
+        self._ping_outstanding = false;
+      } else if (self._ping_outstanding) {
+        self._timed_out = true;
+        // Only armed by start_keepalive(), which requires shutdown(); other streams never get here.
+        if constexpr (requires { self._next->shutdown(); }) (void)self._next->shutdown();
+        return;
+      } else if (!self._close_sent) {
+        self._ping_outstanding = true;
+        self._loop->spawn(self.keepalive_ping());
+      }
+      self._loop->add_timer(node, self._loop->now() + self._interval);
+    }
+
+    auto keepalive_ping() -> task<void> { (void)co_await ping(); }
+
+    [[nodiscard]] auto check(const websocket_frame_header &header, bool in_message, std::size_t received) const noexcept -> std::error_code {
+      if (header.reserved != 0 || header.length >> 63 != 0) return make_error_code(websocket_errc::bad_frame);
+      switch (header.opcode) {
+        case websocket_opcode::continuation:
+          if (!in_message) return make_error_code(websocket_errc::bad_continuation);
+          break;
+        case websocket_opcode::text:
+        case websocket_opcode::binary:
+          if (in_message) return make_error_code(websocket_errc::bad_continuation);
+          break;
+        case websocket_opcode::close:
+        case websocket_opcode::ping:
+        case websocket_opcode::pong:
+          if (!header.fin || header.length > 125) return make_error_code(websocket_errc::bad_control_frame);
+          break;
+        default: return make_error_code(websocket_errc::bad_frame);
+      }
+      if (header.masked != (_role == websocket_role::server)) return make_error_code(websocket_errc::bad_masking);
+      if (!is_control(header.opcode) && header.length > _max_message_size - received) return make_error_code(websocket_errc::message_too_large);
+      return {};
+    }
+
+    auto fail(std::error_code error) noexcept -> failure<std::error_code> {
+      _error = _timed_out ? make_error_code(websocket_errc::timed_out) : error;
+      return failure<std::error_code>(_error);
+    }
+
+    // Fails the connection on a protocol violation, telling the peer why.
+    auto fail_protocol(std::error_code error) -> task<message_result> {
+      _error = error;
+      const auto code = error == websocket_errc::message_too_large ? websocket_close_code::message_too_large : websocket_close_code::protocol_error;
+      co_await lock_writes();
+      (void)co_await send_close(static_cast<std::uint16_t>(code), {});
+      unlock_writes();
+      co_return failure<std::error_code>(error);
+    }
+
+    // Takes in the peer's close frame and answers it with the same status code.
+    auto closed_by_peer(std::span<const std::byte> payload) -> task<message_result> {
+      auto code = static_cast<std::uint16_t>(websocket_close_code::no_status);
+      if (payload.size() == 1) co_return co_await fail_protocol(make_error_code(websocket_errc::bad_close_frame));
+      if (payload.size() >= 2) {
+        code = static_cast<std::uint16_t>(std::to_integer<std::uint16_t>(payload[0]) << 8 | std::to_integer<std::uint16_t>(payload[1]));
+        const bool valid = (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1014) || (code >= 3000 && code <= 4999);
+        if (!valid) co_return co_await fail_protocol(make_error_code(websocket_errc::bad_close_frame));
+      }
+      _close_code = code;
+      _error = make_error_code(websocket_errc::closed);
+      co_await lock_writes();
+      (void)co_await send_close(code, {});
+      unlock_writes();
+      co_return failure<std::error_code>(_error);
+    }
+
+    // Sends a close frame unless one was sent already; the write lock must be held.
+    auto send_close(std::uint16_t code, std::string_view reason) -> task<void_result> {
+      if (_close_sent) co_return void_result();
+      _close_sent = true;
+      std::array<std::byte, 125> payload;
+      std::size_t size = 0;
+      if (code != static_cast<std::uint16_t>(websocket_close_code::no_status)) {
+        payload[0] = static_cast<std::byte>(code >> 8);
+        payload[1] = static_cast<std::byte>(code);
+        const auto text = reason.substr(0, payload.size() - 2);
+        if (!text.empty()) std::memcpy(payload.data() + 2, text.data(), text.size());
+        size = 2 + text.size();
+      }
+      const auto piece = std::span<const std::byte>(payload.data(), size);
+      co_return co_await send_frame(websocket_opcode::close, true, std::span(&piece, 1));
+    }
+
+    auto locked_send(websocket_opcode opcode, bool fin, std::span<const std::span<const std::byte>> pieces) -> task<void_result> {
+      co_await lock_writes();
+      void_result sent;
+      if (_close_sent) {
+        sent = failure<std::error_code>(make_error_code(websocket_errc::closed));
+      } else {
+        sent = co_await send_frame(opcode, fin, pieces);
+      }
+      unlock_writes();
+      co_return sent;
+    }
+
+    // Sends one frame whose payload is the concatenation of `pieces`; the write lock must be held.
+    auto send_frame(websocket_opcode opcode, bool fin, std::span<const std::span<const std::byte>> pieces) -> task<void_result> {
+      websocket_frame_header header{.fin = fin, .opcode = opcode, .masked = _role == websocket_role::client};
+      for (const auto piece : pieces) header.length += piece.size();
+      if (header.masked) header.key = next_key();
+
+      if constexpr (async_vectored_write_stream<Stream>) {
+        if (!header.masked) {
+          std::array<std::byte, websocket_frame_header::max_size> head;
+          std::array<iovec, 4> few;
+          std::vector<iovec> many;
+          if (pieces.size() >= few.size()) many.resize(pieces.size() + 1);
+          auto *iov = many.empty() ? few.data() : many.data();
+          std::size_t count = 0;
+          iov[count++] = {head.data(), header.encode(head)};
+          for (const auto piece : pieces) {
+            if (!piece.empty()) iov[count++] = {const_cast<std::byte *>(piece.data()), piece.size()};
+          }
+          co_return co_await aio::write_all(*_next, std::span<iovec>(iov, count));
+        }
+      }
+      co_return co_await send_copied(header, pieces);
+    }
+
+    // Sends a frame through a pooled buffer, masking the payload as it is copied in. The header
+    // shares the first write with the start of the payload.
+    auto send_copied(const websocket_frame_header &header, std::span<const std::span<const std::byte>> pieces) -> task<void_result> {
+      auto scratch = _pool->acquire();
+      const auto capacity = scratch.size();
+      auto used = header.encode(scratch.span().template first<websocket_frame_header::max_size>());
+      auto key = header.key;
+      for (auto piece : pieces) {
+        while (!piece.empty()) {
+          const auto size = std::min(piece.size(), capacity - used);
+          std::memcpy(scratch.data() + used, piece.data(), size);
+          if (header.masked) key = detail::xor_mask(scratch.data() + used, size, key);
+          used += size;
+          piece = piece.subspan(size);
+          if (used == capacity) {
+            auto written = co_await aio::write_all(*_next, std::span<const std::byte>(scratch.data(), used));
+            if (!written) co_return written;
+            used = 0;
+          }
+        }
+      }
+      if (used == 0) co_return void_result();
+      co_return co_await aio::write_all(*_next, std::span<const std::byte>(scratch.data(), used));
+    }
+
+    // Decodes the next frame header, reading into the staging area as needed.
+    auto read_header(websocket_frame_header &header) -> task<void_result> {
+      while (true) {
+        const auto staged = std::span<const std::byte>(_staging.data() + _staged_begin, _staged_end - _staged_begin);
+        if (const auto size = websocket_frame_header::decode(staged, header); size != 0) {
+          _staged_begin = static_cast<std::uint8_t>(_staged_begin + size);
+          co_return void_result();
+        }
+        std::memmove(_staging.data(), staged.data(), staged.size());
+        _staged_begin = 0;
+        _staged_end = static_cast<std::uint8_t>(staged.size());
+        auto read = co_await _next->read_some(std::span(_staging).subspan(_staged_end));
+        if (!read) co_return failure<std::error_code>(read.error());
+        if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+        _staged_end = static_cast<std::uint8_t>(_staged_end + *read);
+      }
+    }
+
+    // Appends the frame's payload to `message`, unmasked: first what is staged, then read
+    // straight into the message's buffers, never past the end of the frame.
+    auto read_payload(const websocket_frame_header &header, websocket_message &message) -> task<void_result> {
+      auto remaining = header.length;
+      auto key = header.key;
+      while (remaining != 0) {
+        auto room = message.room(*_pool);
+        room = room.first(static_cast<std::size_t>(std::min<std::uint64_t>(room.size(), remaining)));
+        std::size_t size = 0;
+        if (_staged_begin != _staged_end) {
+          size = std::min<std::size_t>(room.size(), _staged_end - _staged_begin);
+          std::memcpy(room.data(), _staging.data() + _staged_begin, size);
+          _staged_begin = static_cast<std::uint8_t>(_staged_begin + size);
+        } else {
+          auto read = co_await _next->read_some(room);
+          if (!read) co_return failure<std::error_code>(read.error());
+          if (*read == 0) co_return failure<std::error_code>(make_error_code(stream_errc::end_of_stream));
+          size = *read;
+        }
+        if (header.masked) key = detail::xor_mask(room.data(), size, key);
+        message._size += size;
+        remaining -= size;
+      }
+      co_return void_result();
+    }
+
+    [[nodiscard]] static auto next_key() -> std::uint32_t {
+      thread_local std::mt19937 engine{std::random_device{}()};
+      return static_cast<std::uint32_t>(engine());
+    }
+
+    Stream *_next;
+    buffer_pool *_pool;
+    std::size_t _max_message_size;
+    scheduler *_loop = nullptr;
+    clock::duration _interval{};
+    keepalive_timer _keepalive{};
+    detail::node_queue _writers{};
+    std::error_code _error{};
+    std::array<std::byte, staging_size> _staging;
+    std::uint8_t _staged_begin = 0;
+    std::uint8_t _staged_end = 0;
+    std::uint16_t _close_code = static_cast<std::uint16_t>(websocket_close_code::no_status);
+    websocket_role _role;
+    bool _writing = false;
+    bool _close_sent = false;
+    bool _activity = false;
+    bool _ping_outstanding = false;
+    bool _timed_out = false;
+  };
+}  // namespace aio
+
+#endif  // AIO_WEBSOCKET_HPP
@@ -0,0 +1,151 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of async_cache: lookups, single-flight loads, TTL expiry and failing loaders.
+
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <aio/async_cache.hpp>
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+  using cache_type = aio::async_cache<int, std::string>;
+
+  auto load_slowly(aio::scheduler &scheduler, int key, int &calls, bool fail) -> aio::task<std::string> {
+    ++calls;
+    co_await scheduler.sleep_for(5ms);
+    if (fail) throw std::runtime_error("load failed");
+    co_return "value " + std::to_string(key);
+  }
+
+  // Loader counting its calls; optionally throws after suspending.
+  struct loader {
+    aio::scheduler *scheduler;
+    int *calls;
+    bool fail = false;
+
+    auto operator()(int key) const -> aio::task<std::string> { return load_slowly(*scheduler, key, *calls, fail); }
+  };
+
+  auto hit_and_miss(aio::scheduler &scheduler) -> aio::task<void> {
+    cache_type cache;
+    int calls = 0;
+    AIO_CHECK(!cache.try_get(1));
+    auto first = co_await cache.get(1, loader{&scheduler, &calls});
+    AIO_CHECK(first && *first == "value 1" && calls == 1);
+    auto second = co_await cache.get(1, loader{&scheduler, &calls});
+    AIO_CHECK(second && *second == "value 1" && calls == 1);
+    AIO_CHECK(cache.try_get(1) == "value 1");
+
+    cache.insert(2, "inserted");
+    auto inserted = co_await cache.get(2, loader{&scheduler, &calls});
+    AIO_CHECK(inserted && *inserted == "inserted" && calls == 1);
+    AIO_CHECK(cache.erase(2) && !cache.erase(2) && !cache.try_get(2));
+
+    const auto stats = cache.stats();
+    AIO_CHECK(stats.misses == 1 && stats.hits == 3 && cache.size() == 1);
+  }
+
+  auto get_into(cache_type &cache, loader load, std::optional<cache_type::result_type> &slot, aio::latch &done) -> aio::task<void> {
+    slot.emplace(co_await cache.get(7, load));
+    done.count_down();
+  }
+
+  // Concurrent misses for one key run the loader once and all see its result.
+  auto coalesced(aio::scheduler &scheduler) -> aio::task<void> {
+    cache_type cache;
+    int calls = 0;
+    std::optional<cache_type::result_type> results[4];
+    aio::latch done(4);
+    for (auto &slot : results) scheduler.spawn(get_into(cache, loader{&scheduler, &calls}, slot, done));
+    co_await done.wait();
+    AIO_CHECK(calls == 1);
+    for (auto &slot : results) AIO_CHECK(*slot && **slot == "value 7");
+    const auto stats = cache.stats();
+    AIO_CHECK(stats.misses == 1 && stats.coalesced == 3);
+  }
+
+  // A failed load reaches every waiter and is not cached: the next get() loads again.
+  auto failing_loader(aio::scheduler &scheduler) -> aio::task<void> {
+    cache_type cache;
+    int calls = 0;
+    std::optional<cache_type::result_type> results[2];
+    aio::latch done(2);
+    for (auto &slot : results) scheduler.spawn(get_into(cache, loader{&scheduler, &calls, true}, slot, done));
+    co_await done.wait();
+    AIO_CHECK(calls == 1);
+    for (auto &slot : results) AIO_CHECK(!*slot && (*slot).error() != nullptr);
+    AIO_CHECK(cache.size() == 0 && !cache.try_get(7));
+
+    auto retried = co_await cache.get(7, loader{&scheduler, &calls});
+    AIO_CHECK(retried && *retried == "value 7" && calls == 2);
+  }
+
+  // Expired entries are never returned, and the sweeper reclaims them without any lookup.
+  auto ttl_expiry(aio::scheduler &scheduler) -> aio::task<void> {
+    cache_type cache({.capacity = 16, .shards = 2, .ttl = 20ms}, &scheduler);
+    cache.insert(1, "one");
+    cache.insert(2, "two");
+    AIO_CHECK(cache.try_get(1) == "one");
+    co_await scheduler.sleep_for(30ms);
+    AIO_CHECK(!cache.try_get(1));
+    co_await scheduler.sleep_for(30ms);
+    AIO_CHECK(cache.size() == 0 && cache.stats().expirations == 2);
+  }
+
+  auto pause(aio::scheduler &scheduler) -> aio::task<void> { co_await scheduler.sleep_for(5ms); }
+}  // namespace
+
+int main() {
+  {
+    aio::scheduler scheduler;
+    aio::sync_wait(scheduler, hit_and_miss(scheduler));
+    aio::sync_wait(scheduler, coalesced(scheduler));
+    aio::sync_wait(scheduler, failing_loader(scheduler));
+    aio::sync_wait(scheduler, ttl_expiry(scheduler));
+
+    // Destroying the cache disarms its sweep timer on the scheduler that outlives it.
+    { cache_type cache({.ttl = 1s}, &scheduler); }
+    aio::sync_wait(scheduler, pause(scheduler));
+  }
+  {
+    // The scheduler may go first; nothing is left behind for the cache to release.
+    std::optional<aio::scheduler> scheduler(std::in_place);
+    cache_type cache({.ttl = 1s}, &*scheduler);
+    scheduler.reset();
+  }
+  return 0;
+}
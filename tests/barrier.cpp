@@ -0,0 +1,106 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of barrier: several phases, the completion function, and arrive_and_drop().
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <aio/barrier.hpp>
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  struct phase_log {
+    std::vector<int> completed_at{};
+    int arrivals = 0;
+  };
+
+  struct on_completion {
+    phase_log *log;
+    auto operator()() const noexcept -> void { log->completed_at.push_back(log->arrivals); }
+  };
+
+  using log_barrier = aio::barrier<on_completion>;
+
+  // Each participant works a different time per phase; none starts phase p + 1 before all finished p.
+  auto participant(aio::scheduler &scheduler, log_barrier &barrier, phase_log &log, int id, int phases, aio::latch &done)
+      -> aio::task<void> {
+    for (int phase = 0; phase < phases; ++phase) {
+      co_await scheduler.sleep_for(std::chrono::milliseconds((id + phase) % 3));
+      ++log.arrivals;
+      co_await barrier.arrive_and_wait();
+      AIO_CHECK(barrier.phase() == static_cast<std::uint64_t>(phase + 1));
+    }
+    done.count_down();
+  }
+
+  auto phases(aio::scheduler &scheduler) -> aio::task<void> {
+    constexpr int participants = 4;
+    constexpr int rounds = 5;
+    phase_log log;
+    log_barrier barrier(participants, on_completion{&log});
+    aio::latch done(participants);
+    for (int id = 0; id < participants; ++id) scheduler.spawn(participant(scheduler, barrier, log, id, rounds, done));
+    co_await done.wait();
+    AIO_CHECK(barrier.phase() == rounds);
+    // The completion ran once per phase, after exactly all participants of that phase arrived.
+    AIO_CHECK(log.completed_at == std::vector<int>({4, 8, 12, 16, 20}));
+  }
+
+  auto wait_phases(aio::barrier<> &barrier, int phases, aio::latch &done) -> aio::task<void> {
+    for (int i = 0; i < phases; ++i) co_await barrier.arrive_and_wait();
+    done.count_down();
+  }
+
+  // A participant that drops out completes the current phase and is not expected in later ones.
+  auto drop(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::barrier<> barrier(3);
+    aio::latch done(2);
+    scheduler.spawn(wait_phases(barrier, 3, done));
+    scheduler.spawn(wait_phases(barrier, 3, done));
+    co_await scheduler.sleep_for(2ms);
+    AIO_CHECK(barrier.phase() == 0);
+    barrier.arrive_and_drop();
+    co_await done.wait();
+    AIO_CHECK(barrier.phase() == 3);
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, phases(scheduler));
+  aio::sync_wait(scheduler, drop(scheduler));
+  return 0;
+}
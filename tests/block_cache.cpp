@@ -0,0 +1,180 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of block_cache: hits and misses, coalesced loads, S3-FIFO eviction and failed reads.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <aio/block_cache.hpp>
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  constexpr std::size_t block_size = 4096;
+  constexpr std::size_t block_count = 16;
+  constexpr std::size_t tail_size = 100;
+
+  // Every block is filled with its index; a short block follows the full ones.
+  auto make_file(std::string &path) -> int {
+    char name[] = "/tmp/aio-block-cache-test-XXXXXX";
+    const int fd = ::mkstemp(name);
+    AIO_CHECK(fd >= 0);
+    path = name;
+    std::vector<unsigned char> data(block_count * block_size + tail_size);
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i / block_size);
+    AIO_CHECK(::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    return fd;
+  }
+
+  auto small_cache(std::size_t blocks) -> aio::block_cache_options {
+    return {.block_size = block_size, .capacity = blocks * block_size, .shards = 1, .huge_pages = false};
+  }
+
+  auto holds(const aio::block_ref &block, std::size_t index) -> bool {
+    for (auto byte : block.bytes()) {
+      if (static_cast<std::size_t>(byte) != index) return false;
+    }
+    return true;
+  }
+
+  auto hits_and_misses(int fd) -> aio::task<void> {
+    aio::block_cache cache(small_cache(8));
+    const auto file = cache.attach(fd);
+    auto first = co_await file.read_block(3);
+    AIO_CHECK(first && first->bytes().size() == block_size && holds(*first, 3));
+    auto second = co_await file.read_block(3);
+    AIO_CHECK(second && second->bytes().data() == first->bytes().data());
+    auto tail = co_await file.read_block(block_count);
+    AIO_CHECK(tail && tail->bytes().size() == tail_size && holds(*tail, block_count));
+    const auto stats = cache.stats();
+    AIO_CHECK(stats.misses == 2 && stats.hits == 1 && stats.coalesced == 0 && stats.evictions == 0);
+
+    // A read across blocks copies from both.
+    std::vector<std::byte> out(block_size);
+    auto copied = co_await file.read(5 * block_size + block_size / 2, out);
+    AIO_CHECK(copied && *copied == block_size);
+    AIO_CHECK(static_cast<int>(out.front()) == 5 && static_cast<int>(out.back()) == 6);
+  }
+
+  using block_result = aio::result<aio::block_ref, std::error_code>;
+
+  auto read_into(aio::cached_file file, std::uint64_t index, std::optional<block_result> &slot, aio::latch &done)
+      -> aio::task<void> {
+    slot.emplace(co_await file.read_block(index));
+    done.count_down();
+  }
+
+  // Readers that miss on a block while it loads wait for that load instead of issuing their own.
+  auto coalesced_loads(int fd) -> aio::task<void> {
+    aio::block_cache cache(small_cache(8));
+    const auto file = cache.attach(fd);
+    std::optional<block_result> blocks[3];
+    aio::latch done(3);
+    for (auto &slot : blocks) aio::scheduler::current()->spawn(read_into(file, 7, slot, done));
+    co_await done.wait();
+    for (auto &block : blocks) AIO_CHECK(*block && holds(**block, 7) && (*block)->bytes().data() == (*blocks[0])->bytes().data());
+    const auto stats = cache.stats();
+    AIO_CHECK(stats.misses == 1 && stats.coalesced == 2);
+  }
+
+  // A block read twice survives a scan that is larger than the cache; the scanned blocks do not.
+  auto scan_resistance(int fd) -> aio::task<void> {
+    aio::block_cache cache(small_cache(8));
+    const auto file = cache.attach(fd);
+    for (std::uint64_t i = 0; i < 8; ++i) AIO_CHECK((co_await file.read_block(i)).has_value());
+    AIO_CHECK((co_await file.read_block(0)).has_value());
+    for (std::uint64_t i = 8; i < block_count; ++i) AIO_CHECK((co_await file.read_block(i)).has_value());
+    AIO_CHECK(cache.stats().evictions == 8);
+
+    const auto before = cache.stats();
+    auto hot = co_await file.read_block(0);
+    AIO_CHECK(hot && holds(*hot, 0) && cache.stats().hits == before.hits + 1);
+    auto cold = co_await file.read_block(1);
+    AIO_CHECK(cold && holds(*cold, 1) && cache.stats().misses == before.misses + 1);
+  }
+
+  // Pinned blocks cannot be evicted; with every frame pinned, new blocks have nowhere to go.
+  auto pinned_full(int fd) -> aio::task<void> {
+    aio::block_cache cache(small_cache(4));
+    const auto file = cache.attach(fd);
+    std::vector<aio::block_ref> pinned;
+    for (std::uint64_t i = 0; i < 4; ++i) {
+      auto block = co_await file.read_block(i);
+      AIO_CHECK(block.has_value());
+      pinned.push_back(AIO_MOV(*block));
+    }
+    auto refused = co_await file.read_block(4);
+    AIO_CHECK(!refused && refused.error() == std::errc::no_buffer_space);
+    pinned.pop_back();
+    auto admitted = co_await file.read_block(4);
+    AIO_CHECK(admitted && holds(*admitted, 4));
+  }
+
+  // A failed load reaches every coalesced reader, is not cached, and does not block later reads.
+  auto failing_read(const std::string &path) -> aio::task<void> {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    AIO_CHECK(fd >= 0);
+    aio::block_cache cache(small_cache(4));
+    const auto file = cache.attach(fd);
+    std::optional<block_result> blocks[3];
+    aio::latch done(3);
+    for (auto &slot : blocks) aio::scheduler::current()->spawn(read_into(file, 2, slot, done));
+    co_await done.wait();
+    for (auto &block : blocks) AIO_CHECK(!*block && block->error() == std::errc::bad_file_descriptor);
+    AIO_CHECK(cache.stats().coalesced == 2);
+
+    auto again = co_await file.read_block(2);
+    AIO_CHECK(!again && again.error() == std::errc::bad_file_descriptor && cache.stats().misses == 2);
+    ::close(fd);
+  }
+}  // namespace
+
+int main() {
+  std::string path;
+  const int fd = make_file(path);
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, hits_and_misses(fd));
+  aio::sync_wait(scheduler, coalesced_loads(fd));
+  aio::sync_wait(scheduler, scan_resistance(fd));
+  aio::sync_wait(scheduler, pinned_full(fd));
+  aio::sync_wait(scheduler, failing_read(path));
+  ::close(fd);
+  ::unlink(path.c_str());
+  return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of buffered_writer: coalescing, large writes under back-pressure, flushing, and errors.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <aio/buffer_pool.hpp>
+#include <aio/buffered_writer.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto temp_file(int flags = O_RDWR) -> int {
+    char path[] = "/tmp/aio-writer-test-XXXXXX";
+    const int fd = ::mkostemp(path, O_CLOEXEC);
+    AIO_CHECK(fd >= 0);
+    if ((flags & O_ACCMODE) != O_RDWR || (flags & O_APPEND)) {
+      const int reopened = ::open(path, flags | O_CLOEXEC);
+      AIO_CHECK(reopened >= 0);
+      ::close(fd);
+      ::unlink(path);
+      return reopened;
+    }
+    ::unlink(path);
+    return fd;
+  }
+
+  auto file_size(int fd) -> std::size_t {
+    struct stat info{};
+    AIO_CHECK(::fstat(fd, &info) == 0);
+    return static_cast<std::size_t>(info.st_size);
+  }
+
+  auto contents(int fd) -> std::string {
+    std::string text(file_size(fd), '\0');
+    AIO_CHECK(::pread(fd, text.data(), text.size(), 0) == static_cast<ssize_t>(text.size()));
+    return text;
+  }
+
+  auto record(int i) -> std::string {
+    auto text = "record " + std::to_string(i) + " ";
+    text.resize(100, '.');
+    return text;
+  }
+
+  // Small writes gather in a buffer and reach the file only when it fills or is flushed.
+  auto coalescing(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::buffer_pool pool(4096, 8);
+    const int fd = temp_file();
+    aio::buffered_writer writer(scheduler, fd, pool);
+    std::string expected;
+    for (int i = 0; i < 40; ++i) {
+      expected += record(i);
+      auto written = co_await writer.write(record(i));
+      AIO_CHECK(written);
+    }
+    co_await scheduler.sleep_for(5ms);
+    AIO_CHECK(writer.position() == 4000 && file_size(fd) == 0);
+
+    // The 41st record fills the buffer, which is written behind the caller.
+    for (int i = 40; i < 1000; ++i) {
+      expected += record(i);
+      auto written = co_await writer.write(record(i));
+      AIO_CHECK(written);
+    }
+    auto flushed = co_await writer.flush();
+    AIO_CHECK(flushed && contents(fd) == expected);
+    ::close(fd);
+  }
+
+  // A write much larger than the buffered bound suspends until writes complete, and lands intact.
+  auto large_write(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::buffer_pool pool(4096, 4);
+    const int fd = temp_file();
+    aio::buffered_writer writer(scheduler, fd, pool, {.max_in_flight = 2, .buffers_per_write = 2, .max_buffered = 2});
+    std::string large(1 << 20, '\0');
+    for (std::size_t i = 0; i < large.size(); ++i) large[i] = static_cast<char>('a' + i % 26);
+    auto head = co_await writer.write(std::string_view("head:"));
+    auto body = co_await writer.write(large);
+    AIO_CHECK(head && body && writer.position() == large.size() + 5);
+    auto synced = co_await writer.sync();
+    AIO_CHECK(synced && contents(fd) == "head:" + large);
+    // Memory stays within max_buffered + max_in_flight * buffers_per_write + 1 buffers.
+    AIO_CHECK(pool.allocated() <= 8);
+    ::close(fd);
+  }
+
+  // flush() with nothing pending completes at once; the flush interval writes a partial buffer.
+  auto flushing(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::buffer_pool pool(4096, 4);
+    const int fd = temp_file();
+    {
+      aio::buffered_writer writer(scheduler, fd, pool, {.flush_interval = 5ms, .offset = 10});
+      auto idle = co_await writer.flush();
+      AIO_CHECK(idle);
+      auto written = co_await writer.write(std::string_view("partial"));
+      AIO_CHECK(written && file_size(fd) == 0);
+      co_await scheduler.sleep_for(30ms);
+      AIO_CHECK(contents(fd) == std::string(10, '\0') + "partial");
+      auto flushed = co_await writer.flush();
+      AIO_CHECK(flushed);
+    }
+    // Descriptors opened with O_APPEND get one write at a time, in order.
+    const int appended = temp_file(O_WRONLY | O_APPEND);
+    {
+      aio::buffered_writer writer(scheduler, appended, pool, {.buffers_per_write = 1});
+      std::string expected;
+      for (int i = 0; i < 200; ++i) {
+        expected += record(i);
+        auto written = co_await writer.write(record(i));
+        AIO_CHECK(written);
+      }
+      auto flushed = co_await writer.flush();
+      AIO_CHECK(flushed && file_size(appended) == expected.size());
+    }
+    ::close(appended);
+    ::close(fd);
+  }
+
+  // The first write error sticks and is reported by every later operation.
+  auto errors(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::buffer_pool pool(4096, 4);
+    const int fd = temp_file(O_RDONLY);
+    aio::buffered_writer writer(scheduler, fd, pool);
+    auto accepted = co_await writer.write(std::string_view("never written"));
+    AIO_CHECK(accepted);
+    auto flushed = co_await writer.flush();
+    AIO_CHECK(!flushed && flushed.error() == std::errc::bad_file_descriptor);
+    AIO_CHECK(writer.error() == std::errc::bad_file_descriptor);
+    auto later = co_await writer.write(std::string_view("more"));
+    AIO_CHECK(!later && later.error() == std::errc::bad_file_descriptor);
+    auto synced = co_await writer.sync();
+    AIO_CHECK(!synced && synced.error() == std::errc::bad_file_descriptor);
+    ::close(fd);
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, coalescing(scheduler));
+  aio::sync_wait(scheduler, large_write(scheduler));
+  aio::sync_wait(scheduler, flushing(scheduler));
+  aio::sync_wait(scheduler, errors(scheduler));
+  return 0;
+}
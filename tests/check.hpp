@@ -0,0 +1,63 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Minimal checking support for the test executables: every test is a program that exits
+// non-zero on the first failed check, run through CTest.
+
+#ifndef AIO_TESTS_CHECK_HPP
+#define AIO_TESTS_CHECK_HPP
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#define AIO_CHECK(...)                                                                      \
+  do {                                                                                      \
+    if (!(__VA_ARGS__)) {                                                                   \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__); \
+      std::abort();                                                                         \
+    }                                                                                       \
+  } while (false)
+
+namespace aio::test {
+  // Resident set size of the process, for checks that memory stays bounded.
+  inline auto resident_bytes() -> std::size_t {
+    std::size_t size = 0;
+    std::size_t resident = 0;
+    if (auto *statm = std::fopen("/proc/self/statm", "r")) {
+      if (std::fscanf(statm, "%zu %zu", &size, &resident) != 2) resident = 0;
+      std::fclose(statm);
+    }
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  }
+}  // namespace aio::test
+
+#endif  // AIO_TESTS_CHECK_HPP
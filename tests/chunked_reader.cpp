@@ -0,0 +1,113 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of read_chunks(), including destroying the reader while its reads are in flight.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <vector>
+
+#include <aio/buffer_pool.hpp>
+#include <aio/chunked_reader.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  constexpr std::size_t chunk_size = 4096;
+  constexpr std::size_t chunk_count = 8;
+
+  // Runs eagerly up to its first suspension and is destroyed by its owner, like a consumer
+  // whose task is torn down mid-stream.
+  struct eager {
+    struct promise_type {
+      auto get_return_object() noexcept -> eager { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+      auto initial_suspend() const noexcept -> std::suspend_never { return {}; }
+      auto final_suspend() const noexcept -> std::suspend_always { return {}; }
+      auto return_void() const noexcept -> void {}
+      auto unhandled_exception() const noexcept -> void { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  auto make_file() -> int {
+    char path[] = "/tmp/aio-chunks-test-XXXXXX";
+    const int fd = ::mkstemp(path);
+    AIO_CHECK(fd >= 0);
+    ::unlink(path);
+    std::vector<unsigned char> data(chunk_size * chunk_count);
+    for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i / chunk_size);
+    AIO_CHECK(::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    return fd;
+  }
+
+  auto read_all(int fd, aio::buffer_pool &pool) -> aio::task<void> {
+    auto chunks = aio::read_chunks(fd, pool, {.initial_depth = 2, .max_depth = 4});
+    std::uint64_t expected = 0;
+    while (auto chunk = co_await chunks.next()) {
+      AIO_CHECK(chunk->offset == expected);
+      AIO_CHECK(chunk->size == chunk_size);
+      for (auto byte : chunk->bytes()) AIO_CHECK(static_cast<std::size_t>(byte) == expected / chunk_size);
+      expected += chunk->size;
+    }
+    AIO_CHECK(expected == chunk_size * chunk_count);
+  }
+
+  auto start_reading(int fd, aio::buffer_pool &pool) -> eager {
+    auto chunks = aio::read_chunks(fd, pool, {.initial_depth = 4, .max_depth = 4});
+    auto chunk = co_await chunks.next();
+    AIO_CHECK(!"the consumer is destroyed before any read completes");
+  }
+
+  // The reader suspends waiting for its reads; destroying it must leave the completions that
+  // arrive afterwards with nothing to resume.
+  auto abandon_reads(aio::scheduler &scheduler, int fd, aio::buffer_pool &pool) -> aio::task<void> {
+    auto consumer = start_reading(fd, pool);
+    consumer.handle.destroy();
+    for (int i = 0; i < 10; ++i) co_await scheduler.sleep_for(std::chrono::milliseconds(1));
+  }
+}  // namespace
+
+int main() {
+  const int fd = make_file();
+  aio::buffer_pool pool(chunk_size, 16);
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, read_all(fd, pool));
+  aio::sync_wait(scheduler, abandon_reads(scheduler, fd, pool));
+  ::close(fd);
+  return 0;
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of walk_directory(), with getdents64 on the loop and on a thread pool, and its errors.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cerrno>
+#include <set>
+#include <string>
+#include <system_error>
+
+#include <aio/directory_walk.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/thread_pool.hpp>
+
+#include "check.hpp"
+
+namespace {
+  // Builds root/d{0..3}/f{0..49} and returns the number of entries below root.
+  auto make_tree(const std::string &root) -> std::size_t {
+    std::size_t count = 0;
+    for (int d = 0; d < 4; ++d) {
+      const auto directory = root + "/d" + std::to_string(d);
+      AIO_CHECK(::mkdir(directory.c_str(), 0700) == 0);
+      ++count;
+      for (int f = 0; f < 50; ++f) {
+        const int fd = ::open((directory + "/f" + std::to_string(f)).c_str(), O_CREAT | O_WRONLY, 0600);
+        AIO_CHECK(fd >= 0);
+        ::close(fd);
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  auto remove_tree(const std::string &root) -> void {
+    for (int d = 0; d < 4; ++d) {
+      const auto directory = root + "/d" + std::to_string(d);
+      for (int f = 0; f < 50; ++f) ::unlink((directory + "/f" + std::to_string(f)).c_str());
+      ::rmdir(directory.c_str());
+    }
+    ::rmdir(root.c_str());
+  }
+
+  auto walk(const std::string &root, aio::directory_walk_options options) -> aio::task<std::size_t> {
+    std::set<std::string> seen;
+    auto batches = aio::walk_directory(root, options);
+    while (auto batch = co_await batches.next()) {
+      for (const auto &entry : *batch) {
+        AIO_CHECK(entry.error == 0);
+        AIO_CHECK(entry.depth == (entry.name[0] == 'd' ? 0u : 1u));
+        AIO_CHECK(entry.is_directory() == (entry.name[0] == 'd'));
+        AIO_CHECK(seen.insert(std::string(entry.directory) + "/" + std::string(entry.name)).second);
+      }
+    }
+    co_return seen.size();
+  }
+
+  // A root that cannot be walked fails the walk instead of producing nothing.
+  auto walk_fails(const std::string &root, aio::directory_walk_options options) -> aio::task<void> {
+    auto batches = aio::walk_directory(root, options);
+    bool failed = false;
+    try {
+      while (co_await batches.next()) {
+      }
+    } catch (const std::system_error &error) {
+      failed = error.code().value() == ENOENT;
+    }
+    AIO_CHECK(failed);
+  }
+
+  // getdents64 reports its errno from whichever thread it runs on.
+  auto read_errors(aio::thread_pool &pool) -> aio::task<void> {
+    const int fd = ::open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    AIO_CHECK(fd >= 0);
+    std::byte buffer[4096];
+    AIO_CHECK(aio::detail::read_directory(fd, buffer, sizeof(buffer)) == -ENOTDIR);
+    auto read = co_await pool.run([&] { return aio::detail::read_directory(fd, buffer, sizeof(buffer)); });
+    AIO_CHECK(read && *read == -ENOTDIR);
+    ::close(fd);
+  }
+}  // namespace
+
+int main() {
+  char root[] = "/tmp/aio-walk-test-XXXXXX";
+  AIO_CHECK(::mkdtemp(root) != nullptr);
+  const auto expected = make_tree(root);
+
+  aio::scheduler scheduler;
+  AIO_CHECK(aio::sync_wait(scheduler, walk(root, {.buffer_size = 4096})) == expected);
+  aio::thread_pool pool({.threads = 2, .pin_threads = false});
+  AIO_CHECK(aio::sync_wait(scheduler, walk(root, {.buffer_size = 4096, .pool = &pool})) == expected);
+
+  const auto missing = std::string(root) + "/missing";
+  aio::sync_wait(scheduler, walk_fails(missing, {}));
+  aio::sync_wait(scheduler, walk_fails(missing, {.pool = &pool}));
+  aio::sync_wait(scheduler, read_errors(pool));
+
+  remove_tree(root);
+  return 0;
+}
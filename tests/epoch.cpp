@@ -0,0 +1,112 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of epoch-based reclamation, in particular a thread using several domains.
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include <aio/detail/epoch.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using aio::detail::epoch_domain;
+
+  std::atomic<std::size_t> freed{0};
+
+  auto count_free(void *object) noexcept -> void {
+    delete static_cast<int *>(object);
+    freed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Retires `count` objects into `domain` from another thread.
+  auto retire_elsewhere(epoch_domain &domain, std::size_t count) -> void {
+    std::thread([&] {
+      for (std::size_t i = 0; i < count; ++i) domain.retire(new int(0), count_free);
+    }).join();
+  }
+
+  // A reader pinned in the second domain a thread uses must hold back reclamation in that domain.
+  auto pins_are_per_domain() -> void {
+    epoch_domain first;
+    epoch_domain second;
+    { auto guard = first.pin(); }
+    freed = 0;
+    {
+      auto guard = second.pin();
+      retire_elsewhere(second, 1000);
+      AIO_CHECK(freed.load() == 0);
+    }
+    for (int round = 0; round < 10 && freed.load() == 0; ++round) retire_elsewhere(second, 1000);
+    AIO_CHECK(freed.load() > 0);
+
+    // ... and must not hold back the first domain.
+    freed = 0;
+    {
+      auto guard = second.pin();
+      for (int round = 0; round < 10 && freed.load() == 0; ++round) retire_elsewhere(first, 1000);
+      AIO_CHECK(freed.load() > 0);
+    }
+  }
+
+  auto destruction_frees_retired() -> void {
+    freed = 0;
+    {
+      epoch_domain domain;
+      auto guard = domain.pin();
+      for (int i = 0; i < 100; ++i) domain.retire(new int(0), count_free);
+      retire_elsewhere(domain, 100);
+      AIO_CHECK(freed.load() == 0);
+    }
+    AIO_CHECK(freed.load() == 200);
+  }
+
+  // A domain destroyed while the thread is registered in it, and another made in its place.
+  auto destroyed_domains() -> void {
+    for (int i = 0; i < 100; ++i) {
+      auto domain = std::make_unique<epoch_domain>();
+      { auto guard = domain->pin(); }
+    }
+    std::thread([] {
+      auto domain = std::make_unique<epoch_domain>();
+      { auto guard = domain->pin(); }
+      domain.reset();
+    }).join();
+  }
+}  // namespace
+
+int main() {
+  pins_are_per_domain();
+  destruction_frees_retired();
+  destroyed_domains();
+  return 0;
+}
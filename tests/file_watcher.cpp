@@ -0,0 +1,107 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the inotify file_watcher: event batches, buffer validation and read errors.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <system_error>
+
+#include <aio/file_watcher.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto watch_directory(const std::string &directory) -> aio::task<void> {
+    aio::file_watcher watcher;
+    auto watch = watcher.add(directory.c_str());
+    AIO_CHECK(watch.has_value());
+    auto events = watcher.events();
+
+    const auto path = directory + "/file";
+    const int fd = ::open(path.c_str(), O_CREAT | O_WRONLY, 0600);
+    AIO_CHECK(fd >= 0);
+    AIO_CHECK(::write(fd, "x", 1) == 1);
+    ::close(fd);
+
+    bool created = false;
+    bool written = false;
+    while (!(created && written)) {
+      auto batch = co_await events.next();
+      AIO_CHECK(batch.has_value());
+      for (const auto &event : *batch) {
+        AIO_CHECK(event.watch == *watch && event.name == "file");
+        created = created || (event.mask & IN_CREATE);
+        written = written || (event.mask & IN_CLOSE_WRITE);
+      }
+    }
+    ::unlink(path.c_str());
+  }
+
+  // A failing read ends the stream, and error() says why.
+  auto read_error(const std::string &directory) -> aio::task<void> {
+    aio::file_watcher watcher;
+    AIO_CHECK(watcher.add(directory.c_str()).has_value());
+    const int replacement = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    AIO_CHECK(replacement >= 0);
+    // Reading a directory fails with EISDIR.
+    AIO_CHECK(::dup2(replacement, watcher.native_handle()) == watcher.native_handle());
+    ::close(replacement);
+    auto events = watcher.events();
+    auto batch = co_await events.next();
+    AIO_CHECK(!batch.has_value());
+    AIO_CHECK(watcher.error() == std::errc::is_a_directory);
+  }
+
+  auto small_buffer_rejected() -> void {
+    bool rejected = false;
+    try {
+      aio::file_watcher watcher({.buffer_size = sizeof(inotify_event)});
+    } catch (const std::system_error &error) {
+      rejected = error.code() == std::errc::invalid_argument;
+    }
+    AIO_CHECK(rejected);
+    aio::file_watcher smallest({.buffer_size = aio::file_watcher::min_buffer_size});
+  }
+}  // namespace
+
+int main() {
+  char directory[] = "/tmp/aio-watch-test-XXXXXX";
+  AIO_CHECK(::mkdtemp(directory) != nullptr);
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, watch_directory(directory));
+  aio::sync_wait(scheduler, read_error(directory));
+  small_buffer_rejected();
+  ::rmdir(directory);
+  return 0;
+}
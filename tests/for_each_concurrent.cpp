@@ -0,0 +1,123 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of for_each_concurrent() and pipelines: lane propagation and exception propagation.
+
+#include <cstddef>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include <aio/for_each_concurrent.hpp>
+#include <aio/pipeline.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto current_lane() -> aio::task<aio::lane> {
+    auto &self = co_await aio::detail::this_promise{};
+    co_return self.lane();
+  }
+
+  auto check_lane(aio::lane expected, std::size_t &count) -> aio::task<void> {
+    const auto l = co_await current_lane();
+    AIO_CHECK(l == expected);
+    ++count;
+  }
+
+  auto for_each_in_lane() -> aio::task<std::size_t> {
+    std::size_t count = 0;
+    std::vector<int> items(100);
+    co_await aio::for_each_concurrent(items, 8, [&](int) { return check_lane(aio::lane::background, count); });
+    co_return count;
+  }
+
+  auto pipeline_in_lane() -> aio::task<std::size_t> {
+    std::size_t count = 0;
+    co_await aio::pipeline(std::views::iota(0, 100))
+        .stage(4, 8,
+               [&](int i) -> aio::task<int> {
+                 co_await check_lane(aio::lane::background, count);
+                 co_return i;
+               })
+        .sink(2, 8, [&](int) { return check_lane(aio::lane::background, count); });
+    co_return count;
+  }
+
+  auto throws_from_fn() -> aio::task<bool> {
+    std::vector<int> items(100);
+    try {
+      // Thrown while creating the awaitable, before any coroutine frame exists.
+      co_await aio::for_each_concurrent(items, 4, [](int) -> aio::task<void> { throw std::runtime_error("fn"); });
+    } catch (const std::runtime_error &) {
+      co_return true;
+    }
+    co_return false;
+  }
+
+  auto throws_from_range() -> aio::task<bool> {
+    auto items = std::views::iota(0, 100) | std::views::transform([](int i) {
+                   if (i == 50) throw std::runtime_error("range");
+                   return i;
+                 });
+    std::size_t count = 0;
+    try {
+      co_await aio::for_each_concurrent(items, 4, [&](int) { return check_lane(aio::lane::normal, count); });
+    } catch (const std::runtime_error &) {
+      co_return count == 50;
+    }
+    co_return false;
+  }
+
+  auto throws_from_stage() -> aio::task<bool> {
+    try {
+      co_await aio::pipeline(std::views::iota(0, 1000))
+          .stage(4, 8,
+                 [](int i) -> aio::task<int> {
+                   if (i == 500) throw std::runtime_error("stage");
+                   co_return i;
+                 })
+          .sink(2, 8, [](int) -> aio::task<void> { co_return; });
+    } catch (const std::runtime_error &) {
+      co_return true;
+    }
+    co_return false;
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  AIO_CHECK(aio::sync_wait(scheduler, for_each_in_lane().with_lane(aio::lane::background)) == 100);
+  AIO_CHECK(aio::sync_wait(scheduler, pipeline_in_lane().with_lane(aio::lane::background)) == 200);
+  AIO_CHECK(aio::sync_wait(scheduler, throws_from_fn()));
+  AIO_CHECK(aio::sync_wait(scheduler, throws_from_range()));
+  AIO_CHECK(aio::sync_wait(scheduler, throws_from_stage()));
+  return 0;
+}
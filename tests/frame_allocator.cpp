@@ -0,0 +1,109 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the coroutine frame allocator: frames allocated on one thread and freed on another
+// must be recycled rather than accumulate on the freeing thread.
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <aio/detail/frame_allocator.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using aio::detail::frame_allocator;
+
+  // Hands batches of frames from a producer thread to a consumer thread, which frees them.
+  class handoff {
+   public:
+    auto put(std::vector<void *> frames) -> void {
+      std::unique_lock lock(_mutex);
+      _ready.wait(lock, [&] { return _frames.empty(); });
+      _frames = std::move(frames);
+      _ready.notify_all();
+    }
+
+    auto take() -> std::vector<void *> {
+      std::unique_lock lock(_mutex);
+      _ready.wait(lock, [&] { return !_frames.empty(); });
+      auto frames = std::move(_frames);
+      _frames.clear();
+      _ready.notify_all();
+      return frames;
+    }
+
+   private:
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::vector<void *> _frames;
+  };
+
+  auto run_rounds(handoff &channel, std::size_t rounds, std::size_t frames_per_round, std::size_t frame_size) -> void {
+    std::thread consumer([&] {
+      for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto *frame : channel.take()) frame_allocator::deallocate(frame, frame_size);
+      }
+    });
+    for (std::size_t round = 0; round < rounds; ++round) {
+      std::vector<void *> frames(frames_per_round);
+      for (auto &frame : frames) frame = frame_allocator::allocate(frame_size);
+      channel.put(std::move(frames));
+    }
+    consumer.join();
+  }
+
+  auto cross_thread_frees_stay_bounded() -> void {
+    constexpr std::size_t frame_size = 200;
+    handoff channel;
+    run_rounds(channel, 20, 1000, frame_size);
+    const auto before = aio::test::resident_bytes();
+    run_rounds(channel, 400, 1000, frame_size);
+    const auto after = aio::test::resident_bytes();
+    // 400k frames of 256 bytes would be 100 MiB if cross-thread frees were never reused.
+    AIO_CHECK(after < before + 8 * 1024 * 1024);
+  }
+
+  auto same_thread_reuse() -> void {
+    auto *first = frame_allocator::allocate(100);
+    frame_allocator::deallocate(first, 100);
+    auto *second = frame_allocator::allocate(100);
+    AIO_CHECK(first == second);
+    frame_allocator::deallocate(second, 100);
+  }
+}  // namespace
+
+int main() {
+  same_thread_reuse();
+  cross_thread_frees_stay_bounded();
+  return 0;
+}
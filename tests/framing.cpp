@@ -0,0 +1,188 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of frame_reader and frame_writer with the length-prefix and delimiter codecs.
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <aio/framing.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/stream.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using size_result = aio::result<std::size_t, std::error_code>;
+
+  // Hands out `input` at most `step` bytes per read and collects what is written.
+  struct trickle_stream {
+    std::string input;
+    std::size_t step = 4096;
+    std::size_t position = 0;
+    std::string output{};
+
+    auto read_some(std::span<std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      const auto size = std::min({buffer.size(), step, input.size() - position});
+      std::memcpy(buffer.data(), input.data() + position, size);
+      position += size;
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, size));
+    }
+
+    auto write_some(std::span<const std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      output.append(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, buffer.size()));
+    }
+  };
+
+  auto prefixed(std::string_view payload) -> std::string {
+    const auto length = static_cast<std::uint32_t>(payload.size());
+    std::string frame;
+    for (int shift = 24; shift >= 0; shift -= 8) frame += static_cast<char>(length >> shift);
+    return frame + std::string(payload);
+  }
+
+  auto text(aio::frame frame) -> std::string { return {reinterpret_cast<const char *>(frame.data()), frame.size()}; }
+
+  // Reads frames until the stream ends; produces them and the error that ended the stream.
+  template <class Codec>
+  auto read_frames(trickle_stream &wire, std::size_t capacity, Codec codec, std::error_code &error) -> aio::task<std::vector<std::string>> {
+    aio::buffered_read_stream buffered(wire, capacity);
+    aio::frame_reader reader(buffered, AIO_MOV(codec));
+    std::vector<std::string> frames;
+    while (true) {
+      auto batch = co_await reader.read();
+      if (!batch) {
+        error = batch.error();
+        co_return frames;
+      }
+      for (auto frame : *batch) frames.push_back(text(frame));
+    }
+  }
+
+  auto length_prefixed_split() -> aio::task<void> {
+    const std::string payloads[] = {"", "a", "hello", std::string(40, 'x'), std::string(100, 'y')};
+    std::string input;
+    for (const auto &payload : payloads) input += prefixed(payload);
+    for (const std::size_t step : {std::size_t{1}, std::size_t{3}, std::size_t{7}, std::size_t{4096}}) {
+      // A 32-byte buffer takes the small frames in place; the 100-byte one goes to the side buffer.
+      trickle_stream wire{input, step};
+      std::error_code error;
+      const auto frames = co_await read_frames(wire, 32, aio::length_prefix_codec(), error);
+      AIO_CHECK(error == aio::stream_errc::end_of_stream);
+      AIO_CHECK(std::equal(frames.begin(), frames.end(), std::begin(payloads), std::end(payloads)));
+    }
+  }
+
+  auto delimited_split() -> aio::task<void> {
+    const std::string_view input = "one\r\ntwo\r\n\r\nthree\r\n";
+    for (std::size_t step = 1; step <= input.size(); ++step) {
+      trickle_stream wire{std::string(input), step};
+      std::error_code error;
+      const auto frames = co_await read_frames(wire, 16, aio::delimiter_codec("\r\n"), error);
+      AIO_CHECK(error == aio::stream_errc::end_of_stream);
+      AIO_CHECK((frames == std::vector<std::string>{"one", "two", "", "three"}));
+    }
+  }
+
+  // Frames decoded before a rejected one are still produced; then the error is reported.
+  auto oversize_frames() -> aio::task<void> {
+    trickle_stream prefixed_wire{prefixed("ok") + prefixed("way too long for the codec")};
+    std::error_code error;
+    auto frames = co_await read_frames(prefixed_wire, 64, aio::length_prefix_codec(8), error);
+    AIO_CHECK(error == aio::stream_errc::frame_too_large);
+    AIO_CHECK((frames == std::vector<std::string>{"ok"}));
+
+    trickle_stream delimited_wire{"short\n" + std::string(40, 'z') + "\n"};
+    frames = co_await read_frames(delimited_wire, 64, aio::delimiter_codec("\n", 16), error);
+    AIO_CHECK(error == aio::stream_errc::frame_too_large);
+    AIO_CHECK((frames == std::vector<std::string>{"short"}));
+
+    // Without a delimiter in a full buffer, the frame cannot fit either.
+    trickle_stream unterminated{std::string(100, 'z'), 10};
+    frames = co_await read_frames(unterminated, 32, aio::delimiter_codec("\n"), error);
+    AIO_CHECK(error == aio::stream_errc::frame_too_large && frames.empty());
+  }
+
+  auto truncated_frame() -> aio::task<void> {
+    trickle_stream wire{prefixed("complete") + prefixed("cut off").substr(0, 6), 2};
+    std::error_code error;
+    const auto frames = co_await read_frames(wire, 64, aio::length_prefix_codec(), error);
+    AIO_CHECK(error == aio::stream_errc::end_of_stream);
+    AIO_CHECK((frames == std::vector<std::string>{"complete"}));
+  }
+
+  auto small_capacity_rejected() -> void {
+    trickle_stream wire;
+    aio::buffered_read_stream buffered(wire, 3);
+    bool rejected = false;
+    try {
+      aio::frame_reader reader(buffered, aio::length_prefix_codec());
+    } catch (const std::system_error &error) {
+      rejected = error.code() == std::errc::invalid_argument;
+    }
+    AIO_CHECK(rejected);
+  }
+
+  auto write_frames() -> aio::task<void> {
+    trickle_stream prefixed_wire;
+    aio::frame_writer writer(prefixed_wire, aio::length_prefix_codec(8));
+    AIO_CHECK(writer.push(std::string_view("ab")).has_value());
+    AIO_CHECK(writer.push(std::string_view("")).has_value());
+    AIO_CHECK(!writer.push(std::string_view("too long!")).has_value());
+    AIO_CHECK(writer.pending() == 2);
+    auto flushed = co_await writer.flush();
+    AIO_CHECK(flushed.has_value() && writer.pending() == 0);
+    AIO_CHECK(prefixed_wire.output == prefixed("ab") + prefixed(""));
+
+    trickle_stream delimited_wire;
+    aio::frame_writer lines(delimited_wire, aio::delimiter_codec("\r\n"));
+    const std::string_view payload = "line";
+    flushed = co_await lines.write(std::as_bytes(std::span(payload)));
+    AIO_CHECK(flushed.has_value() && delimited_wire.output == "line\r\n");
+  }
+}  // namespace
+
+int main() {
+  small_capacity_rejected();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, length_prefixed_split());
+  aio::sync_wait(scheduler, delimited_split());
+  aio::sync_wait(scheduler, oversize_frames());
+  aio::sync_wait(scheduler, truncated_frame());
+  aio::sync_wait(scheduler, write_frames());
+  return 0;
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of promise, future and shared_future.
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <aio/future.hpp>
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto is_broken_promise(const std::exception_ptr &error) -> bool {
+    try {
+      std::rethrow_exception(error);
+    } catch (const std::future_error &e) {
+      return e.code() == std::future_errc::broken_promise;
+    } catch (...) {
+      return false;
+    }
+  }
+
+  auto validity() -> void {
+    aio::future<int> empty;
+    AIO_CHECK(!empty.valid() && !empty && !empty.ready());
+    aio::promise<int> promise;
+    auto future = promise.get_future();
+    AIO_CHECK(future.valid() && !future.ready());
+    auto shared = AIO_MOV(future).share();
+    AIO_CHECK(shared.valid() && !future.valid());
+    promise.set_value(1);
+    AIO_CHECK(shared.ready());
+  }
+
+  // The value is already there: awaiting does not suspend.
+  auto set_before_await() -> aio::task<void> {
+    aio::promise<std::string> promise;
+    auto future = promise.get_future();
+    promise.set_value("ready");
+    AIO_CHECK(future.ready());
+    auto value = co_await AIO_MOV(future);
+    AIO_CHECK(value && *value == "ready");
+  }
+
+  auto complete_later(aio::scheduler &scheduler, aio::promise<int> &promise) -> aio::task<void> {
+    co_await scheduler.sleep_for(5ms);
+    promise.set_value(7);
+  }
+
+  // A coroutine on the same scheduler completes the promise after the await suspended.
+  auto set_after_await(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::promise<int> promise;
+    auto future = promise.get_future();
+    scheduler.spawn(complete_later(scheduler, promise));
+    auto value = co_await AIO_MOV(future);
+    AIO_CHECK(value && *value == 7);
+  }
+
+  // A thread outside the scheduler completes the promise; the waiter resumes on its scheduler.
+  auto set_from_thread(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::promise<int> promise;
+    auto future = promise.get_future();
+    std::thread producer([&] {
+      std::this_thread::sleep_for(5ms);
+      promise.set_value(11);
+    });
+    auto value = co_await AIO_MOV(future);
+    AIO_CHECK(value && *value == 11);
+    AIO_CHECK(aio::scheduler::current() == &scheduler);
+    producer.join();
+  }
+
+  // Dropping an uncompleted promise completes the future with broken_promise.
+  auto broken_promise() -> aio::task<void> {
+    aio::future<int> future;
+    {
+      aio::promise<int> promise;
+      future = promise.get_future();
+    }
+    auto value = co_await AIO_MOV(future);
+    AIO_CHECK(!value && is_broken_promise(value.error()));
+
+    aio::future<int, std::error_code> coded;
+    { coded = aio::promise<int, std::error_code>().get_future(); }
+    auto code = co_await AIO_MOV(coded);
+    AIO_CHECK(!code && code.error() == std::future_errc::broken_promise);
+  }
+
+  auto await_shared(aio::shared_future<int> future, int &seen, aio::latch &done) -> aio::task<void> {
+    const auto &value = co_await future;
+    seen = *value;
+    done.count_down();
+  }
+
+  // Every copy of a shared_future sees the one result.
+  auto shared_waiters(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::promise<int> promise;
+    auto shared = promise.get_future().share();
+    int seen[3] = {};
+    aio::latch done(3);
+    for (auto &slot : seen) scheduler.spawn(await_shared(shared, slot, done));
+    co_await scheduler.sleep_for(5ms);
+    promise.set_value(5);
+    co_await done.wait();
+    AIO_CHECK(seen[0] == 5 && seen[1] == 5 && seen[2] == 5);
+  }
+
+  // An embedded future_state hands out non-owning handles.
+  auto embedded_state() -> aio::task<void> {
+    aio::future_state<int, std::error_code> state;
+    auto future = state.get_future();
+    state.get_promise().set_error(std::make_error_code(std::errc::timed_out));
+    auto value = co_await AIO_MOV(future);
+    AIO_CHECK(!value && value.error() == std::errc::timed_out);
+  }
+}  // namespace
+
+int main() {
+  validity();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, set_before_await());
+  aio::sync_wait(scheduler, set_after_await(scheduler));
+  aio::sync_wait(scheduler, set_from_thread(scheduler));
+  aio::sync_wait(scheduler, broken_promise());
+  aio::sync_wait(scheduler, shared_waiters(scheduler));
+  aio::sync_wait(scheduler, embedded_state());
+  return 0;
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the HTTP/1.x parsers and the chunked decoder, fed in pieces of every size.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <aio/http.hpp>
+
+#include "check.hpp"
+
+namespace {
+  struct seen_request {
+    std::string method;
+    std::string target;
+    std::string host;
+    std::string body;
+    bool keep_alive;
+  };
+
+  // Feeds `wire` to a request parser `step` bytes at a time, as a server reading a connection
+  // would: unconsumed bytes stay at the front of the buffer, new ones are appended, and a body
+  // that did not arrive with its head is collected separately.
+  auto parse_requests(std::string_view wire, std::size_t step) -> std::vector<seen_request> {
+    aio::http_request_parser parser;
+    std::vector<seen_request> seen;
+    std::string buffer;
+    std::size_t body_left = 0;
+    for (std::size_t position = 0; position < wire.size(); position += step) {
+      buffer.append(wire.substr(position, step));
+      while (!buffer.empty()) {
+        if (body_left != 0) {
+          const auto size = std::min(body_left, buffer.size());
+          seen.back().body.append(buffer, 0, size);
+          buffer.erase(0, size);
+          body_left -= size;
+          continue;
+        }
+        auto parsed = parser.parse(buffer);
+        AIO_CHECK(parsed.has_value());
+        if (*parsed == 0) break;
+        for (const auto &request : parser.messages()) {
+          seen.push_back({std::string(request.method), std::string(request.target), std::string(request.header("Host").value_or("")),
+                          std::string(request.body), request.keep_alive});
+          body_left = request.body_pending;
+        }
+        buffer.erase(0, *parsed);
+      }
+    }
+    AIO_CHECK(buffer.empty() && body_left == 0);
+    return seen;
+  }
+
+  auto check_split_requests() -> void {
+    const std::string_view wire =
+        "\r\nGET /a HTTP/1.1\r\nHost: one\r\n\r\n"
+        "POST /b HTTP/1.1\r\nhost:  two \r\nContent-Length: 11\r\n\r\nhello world"
+        "GET /c HTTP/1.0\r\nHOST: three\r\nConnection: keep-alive\r\n\r\n"
+        "GET /d HTTP/1.1\r\nHost: four\r\nConnection: close\r\n\r\n";
+    for (std::size_t step = 1; step <= wire.size(); ++step) {
+      const auto seen = parse_requests(wire, step);
+      AIO_CHECK(seen.size() == 4);
+      AIO_CHECK(seen[0].method == "GET" && seen[0].target == "/a" && seen[0].host == "one" && seen[0].keep_alive);
+      AIO_CHECK(seen[1].method == "POST" && seen[1].host == "two" && seen[1].body == "hello world");
+      AIO_CHECK(seen[2].target == "/c" && seen[2].host == "three" && seen[2].keep_alive);
+      AIO_CHECK(seen[3].target == "/d" && !seen[3].keep_alive);
+    }
+  }
+
+  // A chunked response body, decoded from pieces of every size into the same payload.
+  auto check_split_chunked_response() -> void {
+    const std::string_view head = "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\n\r\n";
+    const std::string_view body = "5;name=value\r\nhello\r\n6\r\n world\r\n0\r\nTrailer: x\r\n\r\n";
+    aio::http_response_parser parser;
+    auto parsed = parser.parse(head);
+    AIO_CHECK(parsed && *parsed == head.size() && parser.messages().size() == 1);
+    const auto &response = parser.messages()[0];
+    AIO_CHECK(response.status == 200 && response.reason == "OK" && response.chunked && !response.until_close);
+
+    for (std::size_t step = 1; step <= body.size(); ++step) {
+      aio::http_chunked_decoder decoder;
+      std::vector<std::string_view> pieces;
+      for (std::size_t position = 0; position < body.size(); position += step) {
+        const auto piece = body.substr(position, step);
+        auto decoded = decoder.decode(piece, pieces);
+        AIO_CHECK(decoded && *decoded == piece.size());
+      }
+      AIO_CHECK(decoder.done());
+      std::string payload;
+      for (auto piece : pieces) payload += piece;
+      AIO_CHECK(payload == "hello world");
+    }
+  }
+
+  auto check_responses() -> void {
+    aio::http_response_parser parser;
+    auto parsed = parser.parse("HTTP/1.1 204 No Content\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nhiHTTP/1.0 200\r\n\r\n");
+    AIO_CHECK(parsed.has_value() && parser.messages().size() == 3);
+    AIO_CHECK(parser.messages()[0].status == 204 && parser.messages()[0].body.empty());
+    AIO_CHECK(parser.messages()[1].body == "hi");
+    AIO_CHECK(parser.messages()[2].until_close && !parser.messages()[2].keep_alive && parser.messages()[2].reason.empty());
+  }
+
+  template <class Message>
+  auto check_error(std::string_view wire, aio::http_errc error, aio::http_parser_options options = {}) -> void {
+    aio::http_parser<Message> parser(options);
+    auto parsed = parser.parse(wire);
+    AIO_CHECK(!parsed && parsed.error() == aio::make_error_code(error));
+  }
+
+  auto check_errors() -> void {
+    using aio::http_errc;
+    check_error<aio::http_request>("GET/HTTP/1.1\r\n\r\n", http_errc::bad_start_line);
+    check_error<aio::http_request>("GET / HTTP/2.0\r\n\r\n", http_errc::bad_version);
+    check_error<aio::http_request>("GET / HTTP/1.1\r\nbad header\r\n\r\n", http_errc::bad_header);
+    check_error<aio::http_request>("GET / HTTP/1.1\r\nA: 1\r\n folded\r\n\r\n", http_errc::bad_header);
+    check_error<aio::http_request>("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\n\r\n", http_errc::too_many_headers, {.max_headers = 1});
+    check_error<aio::http_request>("GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", http_errc::bad_content_length);
+    check_error<aio::http_request>("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", http_errc::bad_transfer_encoding);
+    check_error<aio::http_response>("HTTP/1.1 99 Early\r\n\r\n", http_errc::bad_start_line);
+
+    // An incomplete head larger than the limit fails as soon as it is seen, even when split.
+    aio::http_request_parser parser({.max_head_size = 64});
+    const std::string head = "GET / HTTP/1.1\r\nX: " + std::string(100, 'x');
+    std::size_t size = 1;
+    for (; size <= head.size(); ++size) {
+      auto parsed = parser.parse(std::string_view(head).substr(0, size));
+      if (!parsed) {
+        AIO_CHECK(parsed.error() == aio::http_errc::head_too_large);
+        break;
+      }
+    }
+    AIO_CHECK(size == 65);
+  }
+}  // namespace
+
+int main() {
+  check_split_requests();
+  check_split_chunked_response();
+  check_responses();
+  check_errors();
+  return 0;
+}
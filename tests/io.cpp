@@ -0,0 +1,83 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the io_uring operations on a scheduler.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <aio/io.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  static_assert(aio::detail::io_length(100) == 100);
+  static_assert(aio::detail::io_length(std::size_t{1} << 32) == UINT32_MAX);
+  static_assert(aio::detail::io_length((std::size_t{1} << 32) + 5) == UINT32_MAX);
+
+  auto write_then_read(int fd) -> aio::task<void> {
+    constexpr std::string_view text = "hello, ring";
+    auto written = co_await aio::async_write(fd, std::as_bytes(std::span(text)), 0);
+    AIO_CHECK(written && *written == text.size());
+    std::vector<std::byte> buffer(64);
+    auto read = co_await aio::async_read(fd, buffer, 0);
+    AIO_CHECK(read && *read == text.size());
+    AIO_CHECK(std::string_view(reinterpret_cast<const char *>(buffer.data()), *read) == text);
+
+    // Enough operations to wrap the submission and completion queues several times.
+    for (int i = 0; i < 1000; ++i) {
+      auto again = co_await aio::async_read(fd, buffer, 0);
+      AIO_CHECK(again && *again == text.size());
+    }
+    auto failed = co_await aio::async_read(-1, buffer, 0);
+    AIO_CHECK(!failed && failed.error() == std::errc::bad_file_descriptor);
+  }
+}  // namespace
+
+int main() {
+  char path[] = "/tmp/aio-io-test-XXXXXX";
+  const int fd = ::mkstemp(path);
+  AIO_CHECK(fd >= 0);
+  ::unlink(path);
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, write_then_read(fd));
+  // The ring is not tied to the thread that first submitted to it.
+  std::thread([&] { aio::sync_wait(scheduler, write_then_read(fd)); }).join();
+  aio::sync_wait(scheduler, write_then_read(fd));
+  ::close(fd);
+  return 0;
+}
@@ -0,0 +1,244 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of ipc_channel: the ring, its error cases, both wake-up paths, and use across fork().
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include <aio/ipc_channel.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto bytes_of(std::string_view text) -> std::span<const std::byte> { return std::as_bytes(std::span(text)); }
+
+  auto text_of(std::span<const std::byte> bytes, std::size_t size) -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), size};
+  }
+
+  auto make_channel(std::size_t capacity = 4) -> aio::ipc_channel {
+    auto channel = aio::ipc_channel::create({.slot_size = 64, .capacity = capacity});
+    AIO_CHECK(channel);
+    return AIO_MOV(*channel);
+  }
+
+  auto invalid_options() -> void {
+    AIO_CHECK(aio::ipc_channel::create({.slot_size = 100}).error() == std::errc::invalid_argument);
+    AIO_CHECK(aio::ipc_channel::create({.slot_size = 32}).error() == std::errc::invalid_argument);
+    AIO_CHECK(aio::ipc_channel::create({.capacity = 3}).error() == std::errc::invalid_argument);
+  }
+
+  // try_send reports a full ring and try_receive an empty one; messages keep their order.
+  auto full_and_empty() -> void {
+    auto channel = make_channel();
+    AIO_CHECK(channel.capacity() == 4 && channel.max_message_size() == 48);
+    std::byte buffer[64];
+    auto empty = channel.try_receive(buffer);
+    AIO_CHECK(empty && !*empty);
+
+    const std::string_view messages[] = {"zero", "one", "", "three"};
+    for (const auto message : messages) AIO_CHECK(channel.try_send(bytes_of(message)).value());
+    auto full = channel.try_send(bytes_of("four"));
+    AIO_CHECK(full && !*full);
+
+    for (const auto message : messages) {
+      auto received = channel.try_receive(buffer);
+      AIO_CHECK(received && *received && text_of(buffer, **received) == message);
+    }
+    empty = channel.try_receive(buffer);
+    AIO_CHECK(empty && !*empty);
+    // The ring wraps around.
+    AIO_CHECK(channel.try_send(bytes_of("again")).value());
+    AIO_CHECK(channel.try_receive(buffer).value() == 5u);
+  }
+
+  // Oversized messages are refused; a buffer too small leaves the message in place.
+  auto message_size() -> void {
+    auto channel = make_channel();
+    const std::byte large[49]{};
+    AIO_CHECK(channel.try_send(large).error() == std::errc::message_size);
+    AIO_CHECK(channel.try_send(std::span(large, 48)).value());
+    std::byte small[16];
+    AIO_CHECK(channel.try_receive(small).error() == std::errc::message_size);
+    std::byte buffer[48];
+    AIO_CHECK(channel.try_receive(buffer).value() == 48u);
+  }
+
+  // After shutdown() sends fail, and receives drain what is left before reporting the end.
+  auto shutdown_drains() -> void {
+    auto channel = make_channel();
+    AIO_CHECK(channel.try_send(bytes_of("a")).value() && channel.try_send(bytes_of("b")).value());
+    channel.shutdown();
+    AIO_CHECK(channel.try_send(bytes_of("c")).error() == std::errc::broken_pipe);
+    std::byte buffer[64];
+    AIO_CHECK(channel.try_receive(buffer).value() == 1u && buffer[0] == std::byte{'a'});
+    AIO_CHECK(channel.receive_blocking(buffer).value() == 1u && buffer[0] == std::byte{'b'});
+    AIO_CHECK(channel.try_receive(buffer).error() == aio::stream_errc::end_of_stream);
+    AIO_CHECK(channel.receive_blocking(buffer).error() == aio::stream_errc::end_of_stream);
+  }
+
+  // A slot whose size a peer corrupted is reported once and skipped.
+  auto corrupt_slot() -> void {
+    auto channel = make_channel();
+    AIO_CHECK(channel.try_send(bytes_of("bad")).value() && channel.try_send(bytes_of("good")).value());
+    const auto size = sizeof(aio::detail::ipc_header) + 4 * 64;
+    void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, channel.descriptors().memory, 0);
+    AIO_CHECK(memory != MAP_FAILED);
+    auto *first = reinterpret_cast<aio::detail::ipc_slot *>(static_cast<std::byte *>(memory) + sizeof(aio::detail::ipc_header));
+    first->size = 1000;
+    ::munmap(memory, size);
+
+    std::byte buffer[64];
+    AIO_CHECK(channel.try_receive(buffer).error() == std::errc::bad_message);
+    auto next = channel.try_receive(buffer);
+    AIO_CHECK(next && *next && text_of(buffer, **next) == "good");
+  }
+
+  // open() validates what it maps before trusting it.
+  auto bad_layout() -> void {
+    const auto size = static_cast<off_t>(sizeof(aio::detail::ipc_header) + 4 * 64);
+    // Not sealed: a peer could truncate it under the mapping.
+    int unsealed = ::memfd_create("aio-ipc-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    AIO_CHECK(unsealed >= 0 && ::ftruncate(unsealed, size) == 0);
+    AIO_CHECK(aio::ipc_channel::open({.memory = unsealed}).error() == std::errc::invalid_argument);
+
+    // Sealed, but no channel header in it.
+    int blank = ::memfd_create("aio-ipc-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    AIO_CHECK(blank >= 0 && ::ftruncate(blank, size) == 0 && ::fcntl(blank, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0);
+    AIO_CHECK(aio::ipc_channel::open({.memory = blank}).error() == std::errc::invalid_argument);
+
+    // A real header over a mapping one slot short.
+    auto channel = make_channel();
+    int truncated = ::memfd_create("aio-ipc-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    AIO_CHECK(truncated >= 0 && ::ftruncate(truncated, size - 64) == 0);
+    void *header = ::mmap(nullptr, sizeof(aio::detail::ipc_header), PROT_READ, MAP_SHARED, channel.descriptors().memory, 0);
+    AIO_CHECK(header != MAP_FAILED);
+    AIO_CHECK(::pwrite(truncated, header, sizeof(aio::detail::ipc_header), 0) == static_cast<ssize_t>(sizeof(aio::detail::ipc_header)));
+    ::munmap(header, sizeof(aio::detail::ipc_header));
+    AIO_CHECK(::fcntl(truncated, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0);
+    AIO_CHECK(aio::ipc_channel::open({.memory = truncated}).error() == std::errc::invalid_argument);
+  }
+
+  // Threads sleep on the futex: a blocked receiver wakes on a send, a blocked sender on a receive.
+  auto futex_wake_ups() -> void {
+    auto channel = make_channel(2);
+    std::thread receiver([&] {
+      std::byte buffer[64];
+      for (const auto expected : {"first", "second", "third", "fourth"}) {
+        auto received = channel.receive_blocking(buffer);
+        AIO_CHECK(received && text_of(buffer, *received) == expected);
+        std::this_thread::sleep_for(2ms);
+      }
+    });
+    std::this_thread::sleep_for(10ms);
+    for (const auto message : {"first", "second", "third", "fourth"}) AIO_CHECK(channel.send_blocking(bytes_of(message)));
+    receiver.join();
+  }
+
+  auto receive_one(aio::ipc_channel &channel, std::optional<std::string_view> &seen, std::byte (&buffer)[64]) -> aio::task<void> {
+    auto received = co_await channel.receive(buffer);
+    AIO_CHECK(received);
+    seen = text_of(buffer, *received);
+  }
+
+  // A coroutine sleeps on the eventfd through the scheduler and wakes on a send from another thread.
+  auto eventfd_wake_up() -> void {
+    auto channel = make_channel();
+    aio::scheduler scheduler;
+    std::optional<std::string_view> seen;
+    std::byte buffer[64];
+    std::thread sender([&] {
+      std::this_thread::sleep_for(10ms);
+      AIO_CHECK(channel.send_blocking(bytes_of("evented")));
+    });
+    aio::sync_wait(scheduler, receive_one(channel, seen, buffer));
+    sender.join();
+    AIO_CHECK(seen == "evented");
+  }
+
+  // The descriptors cross a Unix socket to a forked child, which opens the channel and sends back.
+  auto across_fork() -> void {
+    auto channel = make_channel();
+    int sockets[2];
+    AIO_CHECK(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == 0);
+    const pid_t child = ::fork();
+    AIO_CHECK(child >= 0);
+    if (child == 0) {
+      ::close(sockets[0]);
+      auto descriptors = aio::ipc_channel::receive_descriptors(sockets[1]);
+      if (!descriptors) ::_exit(1);
+      auto opened = aio::ipc_channel::open(*descriptors);
+      if (!opened) ::_exit(2);
+      for (const auto message : {"from", "the", "child"}) {
+        if (!opened->send_blocking(bytes_of(message))) ::_exit(3);
+      }
+      opened->shutdown();
+      ::_exit(0);
+    }
+    ::close(sockets[1]);
+    AIO_CHECK(channel.send_descriptors(sockets[0]));
+    ::close(sockets[0]);
+    std::byte buffer[64];
+    for (const auto expected : {"from", "the", "child"}) {
+      auto received = channel.receive_blocking(buffer);
+      AIO_CHECK(received && text_of(buffer, *received) == expected);
+    }
+    AIO_CHECK(channel.receive_blocking(buffer).error() == aio::stream_errc::end_of_stream);
+    int status = 0;
+    AIO_CHECK(::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+}  // namespace
+
+int main() {
+  invalid_options();
+  full_and_empty();
+  message_size();
+  shutdown_drains();
+  corrupt_slot();
+  bad_layout();
+  futex_wake_ups();
+  eventfd_wake_up();
+  across_fork();
+  return 0;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the per-lane ready queue: deadline order and aging of work without a deadline.
+
+#include <chrono>
+#include <vector>
+
+#include <aio/detail/schedule_node.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto no_deadline_work_ages() -> void {
+    using aio::detail::lane_queue;
+    using aio::detail::schedule_node;
+    lane_queue queue(std::chrono::microseconds(250));
+    std::vector<schedule_node> deadline_nodes(1000);
+    schedule_node background;
+    const auto start = aio::clock::now();
+    queue.push(&background);
+    for (std::size_t i = 0; i < deadline_nodes.size(); ++i) {
+      deadline_nodes[i].deadline = start + std::chrono::microseconds(i);
+      queue.push(&deadline_nodes[i]);
+    }
+    std::size_t served_at = 0;
+    for (std::size_t pops = 1; auto *node = queue.pop(); ++pops) {
+      if (node == &background) served_at = pops;
+    }
+    AIO_CHECK(served_at == lane_queue::fifo_interval + 1);
+    AIO_CHECK(queue.empty());
+  }
+
+  auto deadline_order() -> void {
+    using aio::detail::schedule_node;
+    aio::detail::lane_queue queue(std::chrono::microseconds(1));
+    std::vector<schedule_node> nodes(200);
+    const auto start = aio::clock::now();
+    // Pushed in an order that forces both overflow and moving the ring back.
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+      const auto rank = (i * 37) % nodes.size();
+      nodes[i].deadline = start + std::chrono::microseconds(rank);
+      queue.push(&nodes[i]);
+    }
+    auto previous = aio::clock::time_point::min();
+    std::size_t count = 0;
+    while (auto *node = queue.pop()) {
+      AIO_CHECK(node->deadline >= previous);
+      previous = node->deadline;
+      ++count;
+    }
+    AIO_CHECK(count == nodes.size());
+  }
+}  // namespace
+
+int main() {
+  no_deadline_work_ages();
+  deadline_order();
+  return 0;
+}
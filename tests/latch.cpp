@@ -0,0 +1,109 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of latch: counting down, waiting, and arrivals from other threads.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto counting() -> void {
+    aio::latch open(0);
+    AIO_CHECK(open.try_wait());
+    aio::latch latch(3);
+    AIO_CHECK(!latch.try_wait());
+    latch.count_down();
+    latch.count_down(2);
+    AIO_CHECK(latch.try_wait());
+  }
+
+  auto wait_into(aio::latch &latch, int &released) -> aio::task<void> {
+    co_await latch.wait();
+    ++released;
+  }
+
+  // Every waiter is released by the arrival that brings the count to zero, not before.
+  auto waiters_released(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::latch latch(2);
+    int released = 0;
+    for (int i = 0; i < 3; ++i) scheduler.spawn(wait_into(latch, released));
+    co_await scheduler.sleep_for(2ms);
+    latch.count_down();
+    co_await scheduler.sleep_for(2ms);
+    AIO_CHECK(released == 0);
+    latch.count_down();
+    co_await scheduler.sleep_for(2ms);
+    AIO_CHECK(released == 3);
+    // A completed latch does not suspend.
+    co_await latch.wait();
+  }
+
+  auto arrive(aio::latch &latch, int &arrived) -> aio::task<void> {
+    ++arrived;
+    co_await latch.arrive_and_wait();
+  }
+
+  // arrive_and_wait() counts the caller in; the last arrival does not suspend.
+  auto arrive_and_wait(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::latch latch(3);
+    int arrived = 0;
+    scheduler.spawn(arrive(latch, arrived));
+    scheduler.spawn(arrive(latch, arrived));
+    co_await scheduler.sleep_for(2ms);
+    AIO_CHECK(arrived == 2 && !latch.try_wait());
+    co_await latch.arrive_and_wait();
+    AIO_CHECK(latch.try_wait());
+  }
+
+  // Threads that are not coroutines count down a latch a coroutine waits on.
+  auto from_threads() -> aio::task<void> {
+    aio::latch latch(8);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) threads.emplace_back([&latch] { latch.count_down(); });
+    co_await latch.wait();
+    for (auto &thread : threads) thread.join();
+  }
+}  // namespace
+
+int main() {
+  counting();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, waiters_released(scheduler));
+  aio::sync_wait(scheduler, arrive_and_wait(scheduler));
+  aio::sync_wait(scheduler, from_threads());
+  return 0;
+}
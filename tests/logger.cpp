@@ -0,0 +1,169 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of logger: rendering, per-thread ordering, close() draining, and ring reclamation.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <aio/buffer_pool.hpp>
+#include <aio/logger.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto temp_file() -> int {
+    char path[] = "/tmp/aio-logger-test-XXXXXX";
+    const int fd = ::mkstemp(path);
+    AIO_CHECK(fd >= 0);
+    ::unlink(path);
+    return fd;
+  }
+
+  auto contents(int fd) -> std::string {
+    std::string text(1 << 20, '\0');
+    const auto read = ::pread(fd, text.data(), text.size(), 0);
+    AIO_CHECK(read >= 0);
+    text.resize(static_cast<std::size_t>(read));
+    return text;
+  }
+
+  auto lines_of(std::string_view text) -> std::vector<std::string_view> {
+    std::vector<std::string_view> lines;
+    while (!text.empty()) {
+      const auto end = text.find('\n');
+      AIO_CHECK(end != std::string_view::npos);
+      lines.push_back(text.substr(0, end));
+      text.remove_prefix(end + 1);
+    }
+    return lines;
+  }
+
+  // The message after the `<timestamp> <LEVEL> ` prefix.
+  auto message_of(std::string_view line) -> std::string_view {
+    const auto level = line.find(' ');
+    return line.substr(line.find(' ', level + 1) + 1);
+  }
+
+  enum class colour : int { red = 3 };
+
+  auto formatting(aio::buffer_pool &pool, int fd) -> aio::task<void> {
+    {
+      aio::logger log(*aio::scheduler::current(), fd, pool, {.level = aio::log_level::debug});
+      const std::string owned = "owned";
+      AIO_CHECK(log.info("plain"));
+      AIO_CHECK(log.warn("{} + {} = {}", 1, 2u, 3.5));
+      AIO_CHECK(log.error("{} {} {} {}", std::string_view("view"), owned, true, 'c'));
+      AIO_CHECK(log.debug("{{}} {} {}", colour::red, static_cast<const void *>(nullptr)));
+      AIO_CHECK(log.trace("filtered out"));
+      AIO_CHECK(log.info("missing {} {}", 1));
+      auto closed = co_await log.close();
+      AIO_CHECK(closed);
+    }
+    const auto text = contents(fd);
+    const auto lines = lines_of(text);
+    AIO_CHECK(lines.size() == 5);
+    AIO_CHECK(lines[0].size() > 28 && lines[0][4] == '-' && lines[0][10] == 'T' && lines[0][26] == 'Z');
+    AIO_CHECK(lines[0].substr(28) == "INFO plain");
+    AIO_CHECK(message_of(lines[1]) == "1 + 2 = 3.5" && lines[1].substr(28, 4) == "WARN");
+    AIO_CHECK(message_of(lines[2]) == "view owned true c");
+    AIO_CHECK(message_of(lines[3]) == "{} 3 0x0");
+    AIO_CHECK(message_of(lines[4]) == "missing 1 {}");
+  }
+
+  // Records of one thread keep their order, and close() drains what every thread logged.
+  auto ordering(aio::buffer_pool &pool, int fd) -> aio::task<void> {
+    constexpr int per_thread = 2000;
+    {
+      aio::logger log(*aio::scheduler::current(), fd, pool, {.ring_size = 1 << 20});
+      std::vector<std::thread> producers;
+      for (int t = 0; t < 3; ++t) {
+        producers.emplace_back([&log, t] {
+          for (int i = 0; i < per_thread; ++i) AIO_CHECK(log.info("thread {} record {}", t, i));
+        });
+      }
+      for (auto &producer : producers) producer.join();
+      auto closed = co_await log.close();
+      AIO_CHECK(closed && log.dropped() == 0);
+    }
+    int next[3] = {};
+    const auto text = contents(fd);
+    for (auto line : lines_of(text)) {
+      const auto message = std::string(message_of(line));
+      const int thread = message[7] - '0';
+      AIO_CHECK(thread >= 0 && thread < 3);
+      AIO_CHECK(message == "thread " + std::to_string(thread) + " record " + std::to_string(next[thread]));
+      ++next[thread];
+    }
+    AIO_CHECK(next[0] == per_thread && next[1] == per_thread && next[2] == per_thread);
+  }
+
+  // A thread's handle on the ring of a destroyed logger goes when it next adds a ring.
+  auto reclamation(aio::buffer_pool &pool, int fd) -> aio::task<void> {
+    auto &local = aio::detail::this_thread_log_rings.rings;
+    local.clear();
+    {
+      aio::logger first(*aio::scheduler::current(), fd, pool);
+      AIO_CHECK(first.info("first"));
+      AIO_CHECK(local.size() == 1 && !local[0].second->abandoned);
+      auto closed = co_await first.close();
+      AIO_CHECK(closed);
+    }
+    AIO_CHECK(local.size() == 1 && local[0].second->abandoned && !local[0].second->bytes);
+    {
+      aio::logger second(*aio::scheduler::current(), fd, pool);
+      AIO_CHECK(second.info("second"));
+      AIO_CHECK(local.size() == 1 && !local[0].second->abandoned);
+      auto closed = co_await second.close();
+      AIO_CHECK(closed);
+    }
+  }
+
+  auto run(aio::task<void> (*check)(aio::buffer_pool &, int)) -> void {
+    aio::scheduler scheduler;
+    aio::buffer_pool pool(64 * 1024, 8);
+    const int fd = temp_file();
+    aio::sync_wait(scheduler, check(pool, fd));
+    ::close(fd);
+  }
+}  // namespace
+
+int main() {
+  run(formatting);
+  run(ordering);
+  run(reclamation);
+  return 0;
+}
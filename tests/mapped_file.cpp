@@ -0,0 +1,159 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of mapped_file: mapping, range access, warming the pages, and the error paths.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+#include <aio/mapped_file.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/thread_pool.hpp>
+
+#include "check.hpp"
+
+namespace {
+  // A temporary file holding `contents`, removed on destruction.
+  struct temp_file {
+    explicit temp_file(const std::vector<std::byte> &contents) {
+      fd = ::mkstemp(path);
+      AIO_CHECK(fd >= 0);
+      AIO_CHECK(::pwrite(fd, contents.data(), contents.size(), 0) == static_cast<ssize_t>(contents.size()));
+    }
+
+    temp_file(const temp_file &) = delete;
+    auto operator=(const temp_file &) -> temp_file & = delete;
+
+    ~temp_file() {
+      ::close(fd);
+      ::unlink(path);
+    }
+
+    char path[32] = "/tmp/aio-mapped-test-XXXXXX";
+    int fd = -1;
+  };
+
+  // Not a multiple of the page size, so the last page is partial.
+  auto pattern(std::size_t size) -> std::vector<std::byte> {
+    std::vector<std::byte> bytes(size);
+    for (std::size_t i = 0; i < size; ++i) bytes[i] = static_cast<std::byte>(i * 31 + i / 4096);
+    return bytes;
+  }
+
+  auto equal(std::span<const std::byte> a, std::span<const std::byte> b) -> bool {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  auto map_and_read() -> void {
+    const auto contents = pattern(3 * 4096 + 123);
+    temp_file file(contents);
+    auto mapped = aio::mapped_file::open(file.path, {.pattern = aio::access_pattern::sequential});
+    AIO_CHECK(mapped && mapped->size() == contents.size());
+    AIO_CHECK(equal(mapped->bytes(), contents));
+
+    // Ranges are clamped to the file.
+    AIO_CHECK(equal(mapped->bytes(4000, 200), std::span(contents).subspan(4000, 200)));
+    AIO_CHECK(mapped->bytes(contents.size() - 3, 100).size() == 3);
+    AIO_CHECK(mapped->bytes(contents.size() + 10, 5).empty());
+    AIO_CHECK(mapped->advise(100, 5000, MADV_RANDOM));
+
+    // The mapping outlives the descriptor and moves with its owner.
+    auto from_fd = aio::mapped_file::map(file.fd, {.populate = true});
+    AIO_CHECK(from_fd && equal(from_fd->bytes(), contents));
+    aio::mapped_file moved = AIO_MOV(*from_fd);
+    AIO_CHECK(!from_fd->data() && from_fd->size() == 0 && equal(moved.bytes(), contents));
+  }
+
+  // An empty file maps to an empty span rather than failing.
+  auto empty_file() -> void {
+    temp_file file({});
+    auto mapped = aio::mapped_file::open(file.path);
+    AIO_CHECK(mapped && mapped->size() == 0 && mapped->bytes().empty() && mapped->bytes(0, 10).empty());
+    AIO_CHECK(mapped->advise(0, 10, MADV_WILLNEED));
+  }
+
+  auto errors() -> void {
+    AIO_CHECK(aio::mapped_file::open("/nonexistent/aio-mapped-file").error() == std::errc::no_such_file_or_directory);
+    AIO_CHECK(aio::mapped_file::map(-1).error() == std::errc::bad_file_descriptor);
+
+    // A descriptor opened for writing only cannot back a read mapping.
+    temp_file file(pattern(100));
+    const int write_only = ::open(file.path, O_WRONLY | O_CLOEXEC);
+    AIO_CHECK(write_only >= 0);
+    AIO_CHECK(aio::mapped_file::map(write_only).error() == std::errc::permission_denied);
+    ::close(write_only);
+
+    // Directories have no pages to map.
+    const int directory = ::open("/tmp", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    AIO_CHECK(directory >= 0);
+    AIO_CHECK(!aio::mapped_file::map(directory));
+    ::close(directory);
+  }
+
+  // prefetch(), populate() and sequential() warm the pages from the ring and the pool.
+  auto warming(aio::thread_pool &pool) -> aio::task<void> {
+    const auto contents = pattern(5 * 4096 + 7);
+    temp_file file(contents);
+    auto mapped = aio::mapped_file::open(file.path);
+    AIO_CHECK(mapped);
+
+    auto prefetched = co_await mapped->prefetch(0, mapped->size());
+    AIO_CHECK(prefetched);
+    auto populated = co_await mapped->populate(pool, 4096, 8192);
+    AIO_CHECK(populated);
+    auto nothing = co_await mapped->populate(pool, mapped->size(), 10);
+    AIO_CHECK(nothing);
+
+    // Chunks cover the file in order, across window boundaries that do not align with them.
+    std::vector<std::byte> streamed;
+    auto chunks = mapped->sequential(pool, 1000, 4096);
+    while (auto chunk = co_await chunks.next()) {
+      AIO_CHECK(!chunk->empty() && chunk->size() <= 1000);
+      streamed.insert(streamed.end(), chunk->begin(), chunk->end());
+    }
+    AIO_CHECK(equal(streamed, contents));
+  }
+}  // namespace
+
+int main() {
+  map_and_read();
+  empty_file();
+  errors();
+  aio::thread_pool pool({.threads = 2, .pin_threads = false});
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, warming(pool));
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of child processes: piped stdio, exit status, writing to a child that has exited, and
+// the signal state children start with.
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <aio/process.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/stream.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto read_all(aio::pipe_stream &pipe) -> aio::task<std::string> {
+    std::string text;
+    std::vector<std::byte> buffer(4096);
+    while (true) {
+      auto read = co_await pipe.read_some(buffer);
+      AIO_CHECK(read.has_value());
+      if (*read == 0) break;
+      text.append(reinterpret_cast<const char *>(buffer.data()), *read);
+    }
+    co_return text;
+  }
+
+  auto echo_through_cat() -> aio::task<void> {
+    auto child = aio::process::spawn({.program = "cat", .in = aio::stdio::pipe, .out = aio::stdio::pipe});
+    AIO_CHECK(child.has_value());
+    constexpr std::string_view text = "through the child and back";
+    auto written = co_await aio::write_all(child->stdin_pipe(), std::as_bytes(std::span(text)));
+    AIO_CHECK(written.has_value());
+    child->stdin_pipe().close();
+    const auto echoed = co_await read_all(child->stdout_pipe());
+    AIO_CHECK(echoed == text);
+    auto status = co_await child->wait();
+    AIO_CHECK(status && status->success());
+  }
+
+  auto write_after_exit() -> aio::task<void> {
+    auto child = aio::process::spawn({.program = "true", .in = aio::stdio::pipe});
+    AIO_CHECK(child.has_value());
+    auto status = co_await child->wait();
+    AIO_CHECK(status && status->success());
+    // The reading end died with the child: the write must fail instead of raising SIGPIPE.
+    constexpr std::string_view text = "nobody reads this";
+    auto written = co_await child->stdin_pipe().write_some(std::as_bytes(std::span(text)));
+    AIO_CHECK(!written && written.error() == std::errc::broken_pipe);
+  }
+
+  auto exit_code() -> aio::task<void> {
+    auto child = aio::process::spawn({.program = "sh", .args = {"-c", "exit 3"}});
+    AIO_CHECK(child.has_value());
+    auto status = co_await child->wait();
+    AIO_CHECK(status && status->code == 3 && status->signal == 0);
+  }
+
+  // Blocked signals of the spawning thread (SIGPIPE from pipe writes, SIGTERM as a signal_set
+  // would block it) must not carry over into the child.
+  auto child_signal_mask() -> aio::task<void> {
+    auto child = aio::process::spawn({.program = "grep", .args = {"^SigBlk", "/proc/self/status"}, .out = aio::stdio::pipe});
+    AIO_CHECK(child.has_value());
+    const auto line = co_await read_all(child->stdout_pipe());
+    AIO_CHECK(line == "SigBlk:\t0000000000000000\n");
+    auto status = co_await child->wait();
+    AIO_CHECK(status && status->success());
+  }
+
+  auto kill_terminates() -> aio::task<void> {
+    auto child = aio::process::spawn({.program = "sleep", .args = {"30"}});
+    AIO_CHECK(child.has_value());
+    AIO_CHECK(child->kill().has_value());
+    auto status = co_await child->wait();
+    AIO_CHECK(status && status->signal == SIGTERM);
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, echo_through_cat());
+  aio::sync_wait(scheduler, write_after_exit());
+  aio::sync_wait(scheduler, exit_code());
+
+  sigset_t blocked;
+  ::sigemptyset(&blocked);
+  ::sigaddset(&blocked, SIGTERM);
+  ::pthread_sigmask(SIG_BLOCK, &blocked, nullptr);
+  aio::sync_wait(scheduler, child_signal_mask());
+  aio::sync_wait(scheduler, kill_terminates());
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of rate_limiter and sharded_rate_limiter.
+
+#include <chrono>
+#include <cstdint>
+
+#include <aio/latch.hpp>
+#include <aio/rate_limiter.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  // The bucket starts full with `burst` tokens and refills far too slowly to matter here.
+  auto burst() -> void {
+    aio::rate_limiter limiter(0.001, 5);
+    AIO_CHECK(limiter.available() == 5);
+    for (int i = 0; i < 5; ++i) AIO_CHECK(limiter.try_acquire());
+    AIO_CHECK(!limiter.try_acquire() && limiter.available() == 0);
+
+    // More than the burst is granted from a full bucket and leaves it in debt.
+    aio::rate_limiter oversized(0.001, 5);
+    AIO_CHECK(oversized.try_acquire(6));
+    AIO_CHECK(!oversized.try_acquire() && oversized.available() == 0);
+  }
+
+  // Past the burst, acquisitions are spaced by the refill interval.
+  auto steady_rate() -> aio::task<void> {
+    constexpr int tokens = 40;
+    aio::rate_limiter limiter(1000.0, 1);
+    const auto start = aio::clock::now();
+    for (int i = 0; i < tokens; ++i) co_await limiter.acquire();
+    const auto elapsed = aio::clock::now() - start;
+    // The first token comes from the full bucket, each of the others takes 1 ms.
+    AIO_CHECK(elapsed >= std::chrono::milliseconds(tokens - 2));
+    AIO_CHECK(elapsed < std::chrono::milliseconds(tokens * 20));
+  }
+
+  auto acquire_then_count(aio::rate_limiter &limiter, std::uint64_t n, int &finished, int &position, aio::latch &done) -> aio::task<void> {
+    co_await limiter.acquire(n);
+    position = ++finished;
+    done.count_down();
+  }
+
+  // Queued requests are served smallest first.
+  auto smaller_first(aio::scheduler &scheduler) -> aio::task<void> {
+    aio::rate_limiter limiter(200.0, 4);
+    AIO_CHECK(limiter.try_acquire(4));
+    int finished = 0;
+    int large = 0;
+    int small = 0;
+    aio::latch done(2);
+    scheduler.spawn(acquire_then_count(limiter, 4, finished, large, done));
+    co_await scheduler.sleep_for(1ms);
+    scheduler.spawn(acquire_then_count(limiter, 1, finished, small, done));
+    co_await done.wait();
+    AIO_CHECK(small == 1 && large == 2);
+  }
+
+  // Building the awaitable takes nothing; tokens are taken when it is awaited.
+  auto sharded_lazy() -> aio::task<void> {
+    aio::sharded_rate_limiter limiter(0.001, 8, 4);
+    AIO_CHECK(limiter.shard_count() == 4);
+    {
+      auto unused = limiter.acquire(2);
+      (void)unused;
+    }
+    // Each shard holds two tokens; a request spills over to the other shards when its own is empty.
+    for (int i = 0; i < 8; ++i) co_await limiter.acquire();
+    AIO_CHECK(!limiter.try_acquire());
+  }
+
+  // With every shard empty the request queues on its home shard and is granted on refill.
+  auto sharded_waits() -> aio::task<void> {
+    aio::sharded_rate_limiter limiter(400.0, 4, 4);
+    for (int i = 0; i < 4; ++i) AIO_CHECK(limiter.try_acquire());
+    AIO_CHECK(!limiter.try_acquire());
+    const auto start = aio::clock::now();
+    co_await limiter.acquire();
+    // Each shard refills at 100 tokens per second.
+    AIO_CHECK(aio::clock::now() - start >= 5ms);
+  }
+}  // namespace
+
+int main() {
+  burst();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, steady_rate());
+  aio::sync_wait(scheduler, smaller_first(scheduler));
+  aio::sync_wait(scheduler, sharded_lazy());
+  aio::sync_wait(scheduler, sharded_waits());
+  return 0;
+}
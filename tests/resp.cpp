@@ -0,0 +1,117 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of resp_parser: split and pipelined input, limits and hostile lengths.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <aio/resp.hpp>
+
+#include "check.hpp"
+
+namespace {
+  // Feeds `wire` one byte more at a time; nothing parses until the last byte has arrived.
+  auto check_split_feed() -> void {
+    const std::string_view wire = "*3\r\n$3\r\nfoo\r\n%1\r\n+k\r\n:-42\r\n|1\r\n+a\r\n#t\r\n_\r\n";
+    aio::resp_parser parser;
+    for (std::size_t size = 0; size < wire.size(); ++size) {
+      auto parsed = parser.parse(wire.substr(0, size));
+      AIO_CHECK(parsed && *parsed == 0);
+    }
+    auto parsed = parser.parse(wire);
+    AIO_CHECK(parsed && *parsed == wire.size());
+    AIO_CHECK(parser.values().size() == 1);
+    const auto &array = parser.values()[0];
+    AIO_CHECK(array.type == aio::resp_type::array && array.elements.size() == 3);
+    AIO_CHECK(array.elements[0].text == "foo");
+    AIO_CHECK(array.elements[1].type == aio::resp_type::map && array.elements[1].elements.size() == 2);
+    AIO_CHECK(array.elements[1].elements[1].integer == -42);
+    AIO_CHECK(array.elements[2].is_null());  // the value the attribute annotates
+
+    const auto reply = parser.take(0);
+    AIO_CHECK(reply->elements[0].text == "foo");
+  }
+
+  auto check_pipelined() -> void {
+    const std::string_view wire = "+OK\r\n:1\r\n$-1\r\n$5\r\nhel";
+    aio::resp_parser parser;
+    auto parsed = parser.parse(wire);
+    AIO_CHECK(parsed && *parsed == 14);
+    AIO_CHECK(parser.values().size() == 3);
+    AIO_CHECK(parser.values()[0].text == "OK");
+    AIO_CHECK(parser.values()[2].is_null());
+  }
+
+  auto check_error(std::string_view wire, aio::resp_errc error, aio::resp_parser_options options = {}) -> void {
+    aio::resp_parser parser(options);
+    auto parsed = parser.parse(wire);
+    AIO_CHECK(!parsed && parsed.error() == aio::make_error_code(error));
+  }
+
+  auto check_limits() -> void {
+    check_error("*-2\r\n", aio::resp_errc::bad_integer);
+    check_error("$x\r\n", aio::resp_errc::bad_integer);
+    check_error("$99999999999\r\n", aio::resp_errc::too_large);
+    check_error("*99999999999999999999\r\n", aio::resp_errc::bad_integer);
+    check_error("*1048577\r\n", aio::resp_errc::too_large);
+    check_error("*1\r\n*1\r\n*1\r\n:1\r\n", aio::resp_errc::too_deep, {.max_depth = 2});
+    check_error("?\r\n", aio::resp_errc::bad_type);
+    check_error("+OK\rx", aio::resp_errc::bad_line);
+  }
+
+  // Counts the data cannot hold are incomplete values, not allocations: nested maximal headers
+  // used to reserve the elements of every level before looking at a byte of them.
+  auto check_hostile_counts() -> void {
+    std::string wire;
+    for (int i = 0; i < 64; ++i) wire += "*1048576\r\n";
+    const auto before = aio::test::resident_bytes();
+    aio::resp_parser parser;
+    for (int i = 0; i < 16; ++i) {
+      auto parsed = parser.parse(wire);
+      AIO_CHECK(parsed && *parsed == 0);
+    }
+    AIO_CHECK(aio::test::resident_bytes() < before + 64 * 1024 * 1024);
+
+    // The check is exact: three bytes per element is enough.
+    auto parsed = parser.parse("*2\r\n_\r\n_\r\n");
+    AIO_CHECK(parsed && *parsed == 10 && parser.values()[0].elements.size() == 2);
+    parsed = parser.parse("%2\r\n_\r\n_\r\n_\r\n");
+    AIO_CHECK(parsed && *parsed == 0);
+  }
+}  // namespace
+
+int main() {
+  check_split_feed();
+  check_pipelined();
+  check_limits();
+  check_hostile_counts();
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of rwlock: writer exclusion, reader sharing, and the preference between them.
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <aio/latch.hpp>
+#include <aio/rwlock.hpp>
+#include <aio/scheduler.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto try_locks() -> void {
+    aio::rwlock lock;
+    AIO_CHECK(lock.try_lock_shared() && lock.try_lock_shared());
+    AIO_CHECK(!lock.try_lock());
+    lock.unlock_shared();
+    lock.unlock_shared();
+    AIO_CHECK(lock.try_lock());
+    AIO_CHECK(!lock.try_lock() && !lock.try_lock_shared());
+    lock.unlock();
+  }
+
+  struct state {
+    aio::rwlock lock;
+    int readers = 0;
+    int max_readers = 0;
+    bool writing = false;
+  };
+
+  auto reader(aio::scheduler &scheduler, state &s, aio::latch &done) -> aio::task<void> {
+    auto guard = co_await s.lock.scoped_lock_shared();
+    AIO_CHECK(guard.owns_lock() && !s.writing);
+    s.max_readers = std::max(s.max_readers, ++s.readers);
+    co_await scheduler.sleep_for(5ms);
+    AIO_CHECK(!s.writing);
+    --s.readers;
+    done.count_down();
+  }
+
+  auto writer(aio::scheduler &scheduler, state &s, aio::latch &done) -> aio::task<void> {
+    auto guard = co_await s.lock.scoped_lock();
+    AIO_CHECK(!s.writing && s.readers == 0);
+    s.writing = true;
+    co_await scheduler.sleep_for(2ms);
+    s.writing = false;
+    done.count_down();
+  }
+
+  // Readers hold the lock together across suspensions; a writer holds it alone.
+  auto sharing_and_exclusion(aio::scheduler &scheduler) -> aio::task<void> {
+    state s;
+    aio::latch done(7);
+    for (int i = 0; i < 3; ++i) scheduler.spawn(reader(scheduler, s, done));
+    scheduler.spawn(writer(scheduler, s, done));
+    scheduler.spawn(writer(scheduler, s, done));
+    for (int i = 0; i < 2; ++i) scheduler.spawn(reader(scheduler, s, done));
+    co_await done.wait();
+    AIO_CHECK(s.max_readers >= 2 && s.readers == 0 && !s.writing);
+  }
+
+  auto record(aio::rwlock &lock, bool shared, std::vector<char> &order, char tag, aio::latch &done) -> aio::task<void> {
+    if (shared) {
+      co_await lock.lock_shared();
+      order.push_back(tag);
+      lock.unlock_shared();
+    } else {
+      co_await lock.lock();
+      order.push_back(tag);
+      lock.unlock();
+    }
+    done.count_down();
+  }
+
+  // While a writer holds the lock, a reader and a writer queue; the preference picks who goes next.
+  auto preference(aio::scheduler &scheduler, aio::rwlock_preference preferred) -> aio::task<std::vector<char>> {
+    aio::rwlock lock(preferred);
+    std::vector<char> order;
+    aio::latch done(2);
+    AIO_CHECK(lock.try_lock());
+    scheduler.spawn(record(lock, true, order, 'r', done));
+    scheduler.spawn(record(lock, false, order, 'w', done));
+    co_await scheduler.sleep_for(2ms);
+    AIO_CHECK(order.empty());
+    lock.unlock();
+    co_await done.wait();
+    co_return order;
+  }
+
+  auto increment(aio::rwlock &lock, long &counter, int rounds, aio::latch &done) -> aio::task<void> {
+    for (int i = 0; i < rounds; ++i) {
+      auto guard = co_await lock.scoped_lock();
+      ++counter;
+    }
+    done.count_down();
+  }
+
+  auto wait_for(aio::latch &done) -> aio::task<void> { co_await done.wait(); }
+
+  // Coroutines on two schedulers in different threads never lose an update made under the lock.
+  auto across_threads() -> void {
+    constexpr int rounds = 20000;
+    aio::rwlock lock;
+    long counter = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&] {
+        aio::scheduler scheduler;
+        aio::latch done(2);
+        scheduler.spawn(increment(lock, counter, rounds, done));
+        scheduler.spawn(increment(lock, counter, rounds, done));
+        aio::sync_wait(scheduler, wait_for(done));
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    AIO_CHECK(counter == 4L * rounds);
+  }
+}  // namespace
+
+int main() {
+  try_locks();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, sharing_and_exclusion(scheduler));
+  AIO_CHECK(aio::sync_wait(scheduler, preference(scheduler, aio::rwlock_preference::writers)) == std::vector<char>({'w', 'r'}));
+  AIO_CHECK(aio::sync_wait(scheduler, preference(scheduler, aio::rwlock_preference::readers)) == std::vector<char>({'r', 'w'}));
+  across_threads();
+  return 0;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of signal_set: blocked signals delivered to coroutines through the signalfd.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/signal_set.hpp>
+
+#include "check.hpp"
+
+namespace {
+  // A signal raised before anyone waits stays pending until the next wait().
+  auto raised_before_wait(aio::signal_set &signals) -> aio::task<void> {
+    AIO_CHECK(::kill(::getpid(), SIGUSR1) == 0);
+    const auto event = co_await signals.wait();
+    AIO_CHECK(event.number == SIGUSR1 && event.sender == ::getpid() && event.sender_uid == ::getuid());
+  }
+
+  auto wait_into(aio::signal_set &signals, int &signal, aio::latch &done) -> aio::task<void> {
+    signal = (co_await signals.wait()).number;
+    done.count_down();
+  }
+
+  // Signals raised while coroutines wait go to the waiters in the order they arrived.
+  auto raised_while_waiting(aio::scheduler &scheduler, aio::signal_set &signals) -> aio::task<void> {
+    int first = 0;
+    int second = 0;
+    aio::latch done(2);
+    scheduler.spawn(wait_into(signals, first, done));
+    scheduler.spawn(wait_into(signals, second, done));
+    co_await scheduler.sleep_for(std::chrono::milliseconds(5));
+    AIO_CHECK(first == 0 && second == 0);
+    AIO_CHECK(::kill(::getpid(), SIGUSR2) == 0);
+    co_await scheduler.sleep_for(std::chrono::milliseconds(5));
+    AIO_CHECK(::kill(::getpid(), SIGUSR1) == 0);
+    co_await done.wait();
+    AIO_CHECK(first == SIGUSR2 && second == SIGUSR1);
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  aio::signal_set signals(scheduler, {SIGUSR1, SIGUSR2});
+  AIO_CHECK(signals.contains(SIGUSR1) && signals.contains(SIGUSR2) && !signals.contains(SIGTERM));
+
+  // The constructor blocked the set in this thread.
+  sigset_t blocked;
+  ::pthread_sigmask(SIG_SETMASK, nullptr, &blocked);
+  AIO_CHECK(::sigismember(&blocked, SIGUSR1) == 1 && ::sigismember(&blocked, SIGUSR2) == 1);
+
+  aio::sync_wait(scheduler, raised_before_wait(signals));
+  aio::sync_wait(scheduler, raised_while_waiting(scheduler, signals));
+  return 0;
+}
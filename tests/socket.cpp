@@ -0,0 +1,183 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of socket_stream and acceptor over loopback TCP.
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <aio/latch.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/socket.hpp>
+#include <aio/stream.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using namespace std::chrono_literals;
+
+  auto as_text(std::span<const std::byte> bytes) -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+  auto listen_loopback() -> aio::acceptor {
+    auto listener = aio::acceptor::listen(aio::socket_address::loopback(0));
+    AIO_CHECK(listener);
+    return AIO_MOV(*listener);
+  }
+
+  auto port_of(const aio::acceptor &listener) -> std::uint16_t {
+    auto address = listener.local_address();
+    AIO_CHECK(address && address->port() != 0);
+    return address->port();
+  }
+
+  auto echo_once(aio::acceptor &listener, aio::latch &done) -> aio::task<void> {
+    auto accepted = co_await listener.accept();
+    AIO_CHECK(accepted);
+    std::vector<std::byte> buffer(64);
+    auto read = co_await accepted->read_some(buffer);
+    AIO_CHECK(read && *read > 0);
+    auto written = co_await aio::write_all(*accepted, std::span<const std::byte>(buffer.data(), *read));
+    AIO_CHECK(written);
+    done.count_down();
+  }
+
+  // A client connects, the server accepts and echoes one message back.
+  auto connect_and_echo(aio::scheduler &scheduler) -> aio::task<void> {
+    auto listener = listen_loopback();
+    aio::latch done(1);
+    scheduler.spawn(echo_once(listener, done));
+
+    auto client = co_await aio::socket_stream::connect(aio::socket_address::loopback(port_of(listener)));
+    AIO_CHECK(client);
+    constexpr std::string_view text = "ping";
+    auto written = co_await aio::write_all(*client, std::as_bytes(std::span(text)));
+    AIO_CHECK(written);
+    std::vector<std::byte> buffer(64);
+    auto read = co_await client->read_some(buffer);
+    AIO_CHECK(read && as_text(std::span(buffer).first(*read)) == text);
+    co_await done.wait();
+  }
+
+  auto accept_into(aio::acceptor &listener, std::optional<aio::result<aio::socket_stream, std::error_code>> &slot, aio::latch &done)
+      -> aio::task<void> {
+    slot.emplace(co_await listener.accept());
+    done.count_down();
+  }
+
+  // One armed multishot request hands several connections over: the first to the waiter, the rest
+  // to the acceptor's queue, from which later accept() calls take them without suspending.
+  auto multishot_accept(aio::scheduler &scheduler) -> aio::task<void> {
+    constexpr int clients = 5;
+    auto listener = listen_loopback();
+    const auto address = aio::socket_address::loopback(port_of(listener));
+    std::optional<aio::result<aio::socket_stream, std::error_code>> first;
+    aio::latch done(1);
+    scheduler.spawn(accept_into(listener, first, done));
+
+    std::vector<aio::socket_stream> connected;
+    for (int i = 0; i < clients; ++i) {
+      auto client = co_await aio::socket_stream::connect(address);
+      AIO_CHECK(client);
+      connected.push_back(AIO_MOV(*client));
+    }
+    co_await done.wait();
+    AIO_CHECK(*first);
+    co_await scheduler.sleep_for(10ms);
+    for (int i = 1; i < clients; ++i) {
+      auto accepted = co_await listener.accept();
+      AIO_CHECK(accepted && accepted->native_handle() >= 0);
+    }
+  }
+
+  // Shutting down the writing side reads as end of stream on the other one.
+  auto shutdown_ends_stream(aio::scheduler &scheduler) -> aio::task<void> {
+    auto listener = listen_loopback();
+    std::optional<aio::result<aio::socket_stream, std::error_code>> server;
+    aio::latch done(1);
+    scheduler.spawn(accept_into(listener, server, done));
+    auto client = co_await aio::socket_stream::connect(aio::socket_address::loopback(port_of(listener)));
+    AIO_CHECK(client);
+    co_await done.wait();
+    AIO_CHECK(*server);
+
+    AIO_CHECK((*server)->shutdown(SHUT_WR));
+    std::vector<std::byte> buffer(16);
+    auto read = co_await client->read_some(buffer);
+    AIO_CHECK(read && *read == 0);
+  }
+
+  // Closing the acceptor cancels the coroutines waiting in accept().
+  auto close_cancels_waiters(aio::scheduler &scheduler) -> aio::task<void> {
+    auto listener = listen_loopback();
+    std::optional<aio::result<aio::socket_stream, std::error_code>> waiting;
+    aio::latch done(1);
+    scheduler.spawn(accept_into(listener, waiting, done));
+    co_await scheduler.sleep_for(5ms);
+    AIO_CHECK(!waiting);
+    listener.close();
+    AIO_CHECK(!listener);
+    co_await done.wait();
+    AIO_CHECK(!*waiting && (*waiting).error() == std::errc::operation_canceled);
+  }
+
+  auto connect_refused() -> aio::task<void> {
+    // Bind a port and close it again, so nothing listens there.
+    const auto port = port_of(listen_loopback());
+    auto client = co_await aio::socket_stream::connect(aio::socket_address::loopback(port));
+    AIO_CHECK(!client && client.error() == std::errc::connection_refused);
+  }
+
+  auto addresses() -> void {
+    auto v4 = aio::socket_address::parse("127.0.0.1:8080");
+    AIO_CHECK(v4 && v4->family() == AF_INET && v4->port() == 8080 && v4->to_string() == "127.0.0.1:8080");
+    auto v6 = aio::socket_address::parse("[::1]:443");
+    AIO_CHECK(v6 && v6->family() == AF_INET6 && v6->port() == 443);
+    AIO_CHECK(!aio::socket_address::parse("127.0.0.1"));
+    AIO_CHECK(!aio::socket_address::parse("127.0.0.1:http"));
+  }
+}  // namespace
+
+int main() {
+  addresses();
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, connect_and_echo(scheduler));
+  aio::sync_wait(scheduler, multishot_accept(scheduler));
+  aio::sync_wait(scheduler, shutdown_ends_stream(scheduler));
+  aio::sync_wait(scheduler, close_cancels_waiters(scheduler));
+  aio::sync_wait(scheduler, connect_refused());
+  return 0;
+}
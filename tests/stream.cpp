@@ -0,0 +1,141 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the buffered stream adapters.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <aio/scheduler.hpp>
+#include <aio/stream.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using size_result = aio::result<std::size_t, std::error_code>;
+
+  // Produces its pieces one read_some() at a time, then the end of the stream.
+  struct scripted_reader {
+    std::vector<std::string> pieces;
+    std::size_t next = 0;
+
+    auto read_some(std::span<std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      if (next == pieces.size()) return aio::detail::ready_or_task<size_result>(size_result(std::in_place, 0));
+      const auto &piece = pieces[next++];
+      AIO_CHECK(piece.size() <= buffer.size());
+      std::memcpy(buffer.data(), piece.data(), piece.size());
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, piece.size()));
+    }
+  };
+
+  // Accepts at most `chunk` bytes per write and fails with EPIPE once `limit` bytes are in.
+  struct failing_writer {
+    std::size_t chunk;
+    std::size_t limit;
+    std::string written{};
+
+    auto write_some(std::span<const std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      if (written.size() >= limit) {
+        return aio::detail::ready_or_task<size_result>(size_result(aio::failure<std::error_code>(std::make_error_code(std::errc::broken_pipe))));
+      }
+      const auto count = std::min({buffer.size(), chunk, limit - written.size()});
+      written.append(reinterpret_cast<const char *>(buffer.data()), count);
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, count));
+    }
+  };
+
+  auto text(std::span<const std::byte> bytes) -> std::string_view {
+    return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+  }
+
+  auto read_until_across_pieces() -> aio::task<void> {
+    scripted_reader reader{{"GET / HT", "TP/1.1\r", "\nHost: x\r\n\r\n"}};
+    aio::buffered_read_stream stream(reader, 64);
+    auto line = co_await stream.read_until("\r\n");
+    AIO_CHECK(line && *line == "GET / HTTP/1.1\r\n");
+    line = co_await stream.read_until("\r\n");
+    AIO_CHECK(line && *line == "Host: x\r\n");
+    line = co_await stream.read_until("\r\n");
+    AIO_CHECK(line && *line == "\r\n");
+    line = co_await stream.read_until("\r\n");
+    AIO_CHECK(!line && line.error() == aio::stream_errc::end_of_stream);
+  }
+
+  // A failed search must not make a later search for a different delimiter skip bytes.
+  auto read_until_changes_delimiter() -> aio::task<void> {
+    scripted_reader reader{{"ab-cd"}};
+    aio::buffered_read_stream stream(reader, 64);
+    auto line = co_await stream.read_until("\n");
+    AIO_CHECK(!line && line.error() == aio::stream_errc::end_of_stream);
+    line = co_await stream.read_until("-");
+    AIO_CHECK(line && *line == "ab-");
+    AIO_CHECK(text(stream.buffered()) == "cd");
+  }
+
+  auto read_until_full_buffer() -> aio::task<void> {
+    scripted_reader reader{{"0123", "4567", "89"}};
+    aio::buffered_read_stream stream(reader, 8);
+    auto line = co_await stream.read_until("\n");
+    AIO_CHECK(!line && line.error() == aio::stream_errc::delimiter_not_found);
+    AIO_CHECK(text(stream.buffered()) == "01234567");
+  }
+
+  // Bytes the underlying stream did not take stay buffered, and a later flush sends them.
+  auto flush_keeps_unwritten_bytes() -> aio::task<void> {
+    failing_writer writer{.chunk = 3, .limit = 5};
+    aio::buffered_write_stream stream(writer, 64);
+    auto buffered = co_await stream.write_all(std::string_view("hello world"));
+    AIO_CHECK(buffered.has_value());
+    auto flushed = co_await stream.flush();
+    AIO_CHECK(!flushed && flushed.error() == std::errc::broken_pipe);
+    AIO_CHECK(writer.written == "hello");
+    AIO_CHECK(text(stream.buffered()) == " world");
+
+    writer.limit = 64;
+    flushed = co_await stream.flush();
+    AIO_CHECK(flushed.has_value());
+    AIO_CHECK(writer.written == "hello world");
+    AIO_CHECK(stream.buffered().empty());
+  }
+}  // namespace
+
+int main() {
+  aio::scheduler scheduler;
+  aio::sync_wait(scheduler, read_until_across_pieces());
+  aio::sync_wait(scheduler, read_until_changes_delimiter());
+  aio::sync_wait(scheduler, read_until_full_buffer());
+  aio::sync_wait(scheduler, flush_keeps_unwritten_bytes());
+  return 0;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of awaiting tasks and of their results.
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <aio/scheduler.hpp>
+#include <aio/task.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto make_string(std::size_t size) -> aio::task<std::string> { co_return std::string(size, 'x'); }
+
+  auto make_vector() -> aio::task<std::vector<int>> { co_return std::vector<int>{1, 2, 3, 4}; }
+
+  // The awaited tasks are temporaries: their frames end with the full co_await expression.
+  auto await_temporaries() -> aio::task<std::size_t> {
+    auto &&text = co_await make_string(1000);
+    std::size_t sum = text.size();
+    for (const int value : co_await make_vector()) sum += static_cast<std::size_t>(value);
+    co_return sum;
+  }
+
+  auto task_results() -> void {
+    aio::scheduler scheduler;
+    AIO_CHECK(aio::sync_wait(scheduler, await_temporaries()) == 1010);
+  }
+
+  auto fail() -> aio::task<int> {
+    throw std::runtime_error("fail");
+    co_return 0;
+  }
+
+  auto exceptions() -> void {
+    aio::scheduler scheduler;
+    bool caught = false;
+    try {
+      (void)aio::sync_wait(scheduler, fail());
+    } catch (const std::runtime_error &) {
+      caught = true;
+    }
+    AIO_CHECK(caught);
+  }
+}  // namespace
+
+int main() {
+  task_results();
+  exceptions();
+  return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of the thread pool's offload awaitables, including that a long run of offloads, whose
+// frames are allocated on one thread and freed on another, leaves memory flat.
+
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include <aio/scheduler.hpp>
+#include <aio/thread_pool.hpp>
+
+#include "check.hpp"
+
+namespace {
+  auto offload_results(aio::thread_pool &pool) -> aio::task<void> {
+    auto value = co_await pool.run([] { return 42; });
+    AIO_CHECK(value && *value == 42);
+
+    std::vector<int> values(10'000);
+    auto filled = co_await pool.parallel_for(std::size_t{0}, values.size(), [&](std::size_t i) { values[i] = static_cast<int>(i); });
+    AIO_CHECK(filled.has_value());
+    AIO_CHECK(std::accumulate(values.begin(), values.end(), 0LL) == 10'000LL * 9'999 / 2);
+
+    auto sum = co_await pool.parallel_reduce(
+        std::size_t{0}, std::size_t{100'000}, 0LL, [](std::size_t i) { return static_cast<long long>(i); }, std::plus<>{});
+    AIO_CHECK(sum && *sum == 100'000LL * 99'999 / 2);
+
+    auto failed = co_await pool.run([]() -> int { throw 7; });
+    AIO_CHECK(!failed);
+  }
+
+  auto offload_loop(aio::thread_pool &pool, std::size_t rounds) -> aio::task<void> {
+    std::atomic<std::size_t> count{0};
+    for (std::size_t i = 0; i < rounds; ++i) {
+      auto done = co_await pool.run([&] { count.fetch_add(1, std::memory_order_relaxed); });
+      AIO_CHECK(done.has_value());
+      if (i % 64 == 0) {
+        auto spread = co_await pool.parallel_for(0, 256, [&](int) { count.fetch_add(1, std::memory_order_relaxed); });
+        AIO_CHECK(spread.has_value());
+      }
+    }
+    AIO_CHECK(count.load() >= rounds);
+  }
+
+  auto offload_memory_stays_flat() -> void {
+    aio::scheduler scheduler;
+    aio::thread_pool pool({.threads = 2, .pin_threads = false});
+    aio::sync_wait(scheduler, offload_loop(pool, 20'000));
+    const auto before = aio::test::resident_bytes();
+    aio::sync_wait(scheduler, offload_loop(pool, 200'000));
+    const auto after = aio::test::resident_bytes();
+    AIO_CHECK(after < before + 8 * 1024 * 1024);
+  }
+}  // namespace
+
+int main() {
+  {
+    aio::scheduler scheduler;
+    aio::thread_pool pool({.threads = 2, .pin_threads = false});
+    aio::sync_wait(scheduler, offload_results(pool));
+  }
+  offload_memory_stays_flat();
+  return 0;
+}
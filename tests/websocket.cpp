@@ -0,0 +1,160 @@
+// Copyright (c) 2025 - present, Yoram Janssen
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// --- Optional exception to the license ---
+//
+// As an exception, if, as a result of your compiling your source code, portions
+// of this Software are embedded into a machine-executable object form of such
+// source code, you may redistribute such embedded portions in such object form
+// without including the above copyright and permission notices.
+
+
+// Tests of websocket_stream reading frames that arrive in pieces of every size.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <aio/buffer_pool.hpp>
+#include <aio/scheduler.hpp>
+#include <aio/websocket.hpp>
+
+#include "check.hpp"
+
+namespace {
+  using size_result = aio::result<std::size_t, std::error_code>;
+
+  // Hands out `input` at most `step` bytes per read and collects what is written.
+  struct trickle_stream {
+    std::string input;
+    std::size_t step;
+    std::size_t position = 0;
+    std::string output{};
+
+    auto read_some(std::span<std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      const auto size = std::min({buffer.size(), step, input.size() - position});
+      std::memcpy(buffer.data(), input.data() + position, size);
+      position += size;
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, size));
+    }
+
+    auto write_some(std::span<const std::byte> buffer) -> aio::detail::ready_or_task<size_result> {
+      output.append(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+      return aio::detail::ready_or_task<size_result>(size_result(std::in_place, buffer.size()));
+    }
+  };
+
+  // Encodes a frame as a client sends it: masked.
+  auto client_frame(aio::websocket_opcode opcode, std::string_view payload, bool fin = true) -> std::string {
+    aio::websocket_frame_header header{.fin = fin, .opcode = opcode, .masked = true, .key = 0x12345678, .length = payload.size()};
+    std::array<std::byte, aio::websocket_frame_header::max_size> head;
+    const auto size = header.encode(head);
+    std::string frame(reinterpret_cast<const char *>(head.data()), size);
+    std::string masked(payload);
+    aio::websocket_mask(std::as_writable_bytes(std::span(masked.data(), masked.size())), header.key);
+    return frame + masked;
+  }
+
+  // Decodes the server frame at `position` of `wire`, moving past it.
+  auto server_frame(std::string_view wire, std::size_t &position, aio::websocket_frame_header &header) -> std::string_view {
+    const auto bytes = std::as_bytes(std::span(wire.data() + position, wire.size() - position));
+    const auto size = aio::websocket_frame_header::decode(bytes, header);
+    AIO_CHECK(size != 0 && !header.masked);
+    AIO_CHECK(bytes.size() >= size + header.length);
+    const auto payload = wire.substr(position + size, static_cast<std::size_t>(header.length));
+    position += size + payload.size();
+    return payload;
+  }
+
+  auto read_messages(std::size_t step) -> aio::task<void> {
+    const std::string large(300, 'x');  // needs the 16-bit length and three 128-byte buffers
+    const std::string close_payload("\x03\xe8", 2);
+    trickle_stream wire{
+        client_frame(aio::websocket_opcode::text, "Hello") + client_frame(aio::websocket_opcode::binary, "frag", false) +
+            client_frame(aio::websocket_opcode::ping, "are you there") + client_frame(aio::websocket_opcode::continuation, "mented") +
+            client_frame(aio::websocket_opcode::binary, large) + client_frame(aio::websocket_opcode::close, close_payload),
+        step};
+    aio::buffer_pool pool(128, 8);
+    aio::websocket_stream stream(wire, pool);
+
+    auto message = co_await stream.read();
+    AIO_CHECK(message && message->is_text() && message->to_string() == "Hello");
+    message = co_await stream.read();
+    AIO_CHECK(message && !message->is_text() && message->to_string() == "fragmented");
+    message = co_await stream.read();
+    AIO_CHECK(message && message->size() == large.size() && message->segment_count() == 3);
+    AIO_CHECK(message->to_string() == large);
+    message = co_await stream.read();
+    AIO_CHECK(!message && message.error() == aio::websocket_errc::closed);
+    AIO_CHECK(stream.close_code() == 1000);
+
+    // The ping was answered in the middle of the fragmented message, and the close echoed.
+    std::size_t position = 0;
+    aio::websocket_frame_header header;
+    AIO_CHECK(server_frame(wire.output, position, header) == "are you there");
+    AIO_CHECK(header.opcode == aio::websocket_opcode::pong && header.fin);
+    AIO_CHECK(server_frame(wire.output, position, header) == close_payload);
+    AIO_CHECK(header.opcode == aio::websocket_opcode::close);
+    AIO_CHECK(position == wire.output.size());
+  }
+
+  // Headers decode only once all of their bytes are there, whatever the length encoding.
+  auto check_header_split() -> void {
+    for (const std::size_t length : {std::size_t{5}, std::size_t{300}, std::size_t{70000}}) {
+      aio::websocket_frame_header header{.opcode = aio::websocket_opcode::binary, .masked = true, .key = 0xa1b2c3d4, .length = length};
+      std::array<std::byte, aio::websocket_frame_header::max_size> head;
+      const auto size = header.encode(head);
+      aio::websocket_frame_header decoded;
+      for (std::size_t prefix = 0; prefix < size; ++prefix) {
+        AIO_CHECK(aio::websocket_frame_header::decode(std::span(head.data(), prefix), decoded) == 0);
+      }
+      AIO_CHECK(aio::websocket_frame_header::decode(std::span(head.data(), size), decoded) == size);
+      AIO_CHECK(decoded.length == length && decoded.key == header.key && decoded.masked && decoded.fin);
+    }
+  }
+
+  auto reject_unmasked() -> aio::task<void> {
+    aio::websocket_frame_header header{.opcode = aio::websocket_opcode::text, .length = 2};
+    std::array<std::byte, aio::websocket_frame_header::max_size> head;
+    const auto size = header.encode(head);
+    trickle_stream wire{std::string(reinterpret_cast<const char *>(head.data()), size) + "hi", 1};
+    aio::buffer_pool pool(128, 2);
+    aio::websocket_stream stream(wire, pool);
+    auto message = co_await stream.read();
+    AIO_CHECK(!message && message.error() == aio::websocket_errc::bad_masking);
+    std::size_t position = 0;
+    AIO_CHECK(server_frame(wire.output, position, header) == std::string_view("\x03\xea", 2));  // 1002, protocol error
+  }
+}  // namespace
+
+int main() {
+  check_header_split();
+  aio::scheduler scheduler;
+  for (const std::size_t step : {std::size_t{1}, std::size_t{2}, std::size_t{3}, std::size_t{7}, std::size_t{31}, std::size_t{4096}}) {
+    aio::sync_wait(scheduler, read_messages(step));
+  }
+  aio::sync_wait(scheduler, reject_unmasked());
+  return 0;
+}